@@ -0,0 +1,152 @@
+#include "Benchmarks.h"
+#include "../include/AdmissionControl.h"
+#include "../include/Logger.h"
+#include <algorithm>
+#include <ctime>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+constexpr size_t BOOK_COUNT = 1000;
+constexpr size_t CLIENTS = 256;
+constexpr std::chrono::microseconds PURCHASE_WORK{200};
+constexpr std::chrono::milliseconds RUN_TIME{1000};
+constexpr std::chrono::milliseconds REQUEST_BUDGET{10};
+constexpr size_t READ_EVERY = 5;  // one arrival in five is a lookup
+
+using Clock = std::chrono::steady_clock;
+
+std::string isbnFor(size_t i) {
+    return "978-" + std::to_string(1000000000 + i);
+}
+
+// Checkout whose delivery costs PURCHASE_WORK of CPU, so the store has a
+// fixed capacity to overload
+class CostlyBook : public Book {
+public:
+    explicit CostlyBook(const std::string& isbn) : Book(isbn, "Costly Book", 2024, 10.0, "Author") {}
+    void processPurchase(const std::string&, const std::string&) const override {
+        timespec begin;
+        clock_gettime(CLOCK_THREAD_CPUTIME_ID, &begin);
+        timespec now = begin;
+        while ((now.tv_sec - begin.tv_sec) * 1000000000L + (now.tv_nsec - begin.tv_nsec) <
+               std::chrono::nanoseconds(PURCHASE_WORK).count()) {
+            clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+        }
+    }
+    bool canBeSold() const override { return true; }
+    std::string getType() const override { return "Costly Book"; }
+};
+
+struct OverloadResult {
+    std::vector<double> purchaseMicros;  // admitted purchases, from scheduled arrival
+    std::vector<double> readMicros;
+    size_t shedPurchases = 0;
+    size_t shedReads = 0;
+};
+
+// Open-loop arrivals at purchaseRate (plus lookups), each timed from when
+// it was due, so a client falling behind shows up as latency
+OverloadResult runOverload(QuantumBookstore& store, StoreGate* gate, double purchaseRate) {
+    double arrivalRate = purchaseRate * READ_EVERY / (READ_EVERY - 1);
+    size_t arrivals = static_cast<size_t>(arrivalRate * RUN_TIME.count() / 1000.0);
+    Clock::time_point start = Clock::now() + std::chrono::milliseconds(20);
+    std::vector<OverloadResult> perClient(CLIENTS);
+    std::vector<std::thread> clients;
+    for (size_t client = 0; client < CLIENTS; ++client) {
+        clients.emplace_back([&, client]() {
+            OverloadResult& result = perClient[client];
+            for (size_t i = client; i < arrivals; i += CLIENTS) {
+                auto due = start + std::chrono::duration_cast<Clock::duration>(
+                                       std::chrono::duration<double>(i / arrivalRate));
+                std::this_thread::sleep_until(due);
+                std::string isbn = isbnFor(i % BOOK_COUNT);
+                bool read = i % READ_EVERY == READ_EVERY - 1;
+                bool admitted = true;
+                if (read) {
+                    admitted = gate ? gate->tryFindBook(isbn, due + REQUEST_BUDGET).ok() : store.findBook(isbn) != nullptr;
+                } else if (gate) {
+                    admitted = gate->tryBuyBook(isbn, 1, "buyer@example.com", "Cairo", due + REQUEST_BUDGET).ok();
+                } else {
+                    admitted = store.tryBuyBook(isbn, 1, "buyer@example.com", "Cairo").ok();
+                }
+                double micros = std::chrono::duration<double, std::micro>(Clock::now() - due).count();
+                if (!admitted) {
+                    ++(read ? result.shedReads : result.shedPurchases);
+                } else {
+                    (read ? result.readMicros : result.purchaseMicros).push_back(micros);
+                }
+            }
+        });
+    }
+    for (std::thread& client : clients) {
+        client.join();
+    }
+    OverloadResult merged;
+    for (OverloadResult& result : perClient) {
+        merged.purchaseMicros.insert(merged.purchaseMicros.end(), result.purchaseMicros.begin(), result.purchaseMicros.end());
+        merged.readMicros.insert(merged.readMicros.end(), result.readMicros.begin(), result.readMicros.end());
+        merged.shedPurchases += result.shedPurchases;
+        merged.shedReads += result.shedReads;
+    }
+    return merged;
+}
+
+BenchStats latencyStats(std::vector<double> micros) {
+    if (micros.empty()) {
+        return BenchStats{0.0, 0.0, 0.0};
+    }
+    std::sort(micros.begin(), micros.end());
+    auto at = [&micros](double fraction) {
+        return micros[std::min(micros.size() - 1, static_cast<size_t>(fraction * micros.size()))] / 1000.0;
+    };
+    BenchStats stats{at(0.5), micros.front() / 1000.0, micros.back() / 1000.0};
+    if (micros.size() >= BenchStats::MIN_P99_SAMPLES) {
+        stats.p99 = at(0.99);
+    }
+    return stats;
+}
+
+void report(const std::string& label, const OverloadResult& result) {
+    reportStats("admission/buy at 2x, " + label, latencyStats(result.purchaseMicros), 1);
+    reportStats("admission/lookup at 2x, " + label, latencyStats(result.readMicros), 1);
+    std::cout << "  " << result.purchaseMicros.size() << " purchases served, " << result.shedPurchases
+              << " shed; " << result.readMicros.size() << " lookups served, " << result.shedReads << " shed"
+              << std::endl;
+}
+
+} // namespace
+
+void runAdmissionBenchmarks() {
+    std::cout << "--- Admission control (" << PURCHASE_WORK.count() << " us of CPU per purchase, "
+              << CLIENTS << " open-loop clients) ---" << std::endl;
+    LogLevel previousLevel = Logger::global().getLevel();
+    Logger::global().setLevel(LogLevel::Warning);
+    QuantumBookstore store;
+    for (size_t i = 0; i < BOOK_COUNT; ++i) {
+        store.addBook(std::make_unique<CostlyBook>(isbnFor(i)));
+    }
+
+    // Peak capacity: back-to-back purchases with the CPU to themselves
+    constexpr size_t CAPACITY_PURCHASES = 2000;
+    double millis = timeBestOf(3, [&store]() {
+        for (size_t i = 0; i < CAPACITY_PURCHASES; ++i) {
+            store.buyBook(isbnFor(i % BOOK_COUNT), 1, "buyer@example.com", "Cairo");
+        }
+    });
+    reportResult("admission/buy capacity", millis, CAPACITY_PURCHASES);
+    double capacity = CAPACITY_PURCHASES / (millis / 1000.0) * std::max(1u, std::thread::hardware_concurrency());
+
+    // Twice that, straight into the store and then through a gate
+    report("no gate", runOverload(store, nullptr, capacity * 2));
+    StoreGate gate(store);
+    report("gated", runOverload(store, &gate, capacity * 2));
+    AdmissionStats stats = gate.getStats(RequestClass::Purchase);
+    std::cout << "  purchase limit settled at " << stats.limit << "; shed " << stats.shedOverloaded
+              << " on a full queue, " << stats.shedDeadline << " past their deadline" << std::endl;
+
+    Logger::global().setLevel(previousLevel);
+}
@@ -0,0 +1,68 @@
+#include "Benchmarks.h"
+#include "../include/Logger.h"
+#include "../include/QuantumBookstore.h"
+#include <iostream>
+#include <memory>
+#include <string>
+
+namespace {
+
+constexpr size_t BOOK_COUNT = 2000000;
+
+void benchQuery(QuantumBookstore& store, const std::string& name, const CatalogQuery& query) {
+    const BenchOptions& options = benchOptions();
+    for (size_t threads : options.threads) {
+        CatalogQuery limited = CatalogQuery(query).threads(threads);
+        BenchStats stats = measure(options.warmups, options.runs, [&]() {
+            AnalyticsResult result = store.analyze(limited);
+            if (result.groups.empty()) {
+                std::cerr << "analytics query returned no groups" << std::endl;
+            }
+        });
+        reportStats("analytics/" + name + "/t=" + std::to_string(threads), stats, BOOK_COUNT);
+    }
+}
+
+} // namespace
+
+void runAnalyticsBenchmarks() {
+    std::cout << "--- Catalog analytics (" << BOOK_COUNT << " books) ---" << std::endl;
+    LogLevel previousLevel = Logger::global().getLevel();
+    Logger::global().setLevel(LogLevel::Warning);
+    auto store = std::make_unique<QuantumBookstore>();
+    for (size_t i = 0; i < BOOK_COUNT; ++i) {
+        std::string isbn = "978-" + std::to_string(1000000000 + i);
+        std::string author = "Author " + std::to_string(i % 20000);
+        int year = 1950 + static_cast<int>(i % 75);
+        double price = 5.0 + static_cast<double>(i * 37 % 5000) / 100;
+        if (i % 10 < 6) {
+            store->addPaperBook(isbn, "Title", year, price, author, static_cast<int>(i % 40));
+        } else if (i % 10 < 9) {
+            store->addEBook(isbn, "Title", year, price, author, "EPUB");
+        } else {
+            store->addShowcaseBook(isbn, "Title", year, 0.0, author);
+        }
+    }
+
+    // The hand-written report this replaces: one thread, a pass over a view
+    BenchStats loop = measure(benchOptions().warmups, benchOptions().runs, [&]() {
+        double value = 0;
+        for (const Book* book : store->readView()) {
+            if (const PaperBook* paper = asPaperBook(book)) {
+                value += paper->getPrice() * paper->getStock();
+            }
+        }
+        if (value < 0) {
+            std::cerr << "negative inventory value" << std::endl;
+        }
+    });
+    reportStats("analytics/inventoryValue/view-loop", loop, BOOK_COUNT);
+
+    benchQuery(*store, "count", CatalogQuery().count());
+    benchQuery(*store, "inventoryValue", CatalogQuery().ofKind(BookKind::Paper).sum(BookMeasure::InventoryValue));
+    benchQuery(*store, "stockByAuthor", CatalogQuery().groupBy(GroupBy::Author).sum(BookMeasure::Stock));
+    benchQuery(*store, "countByKindDecade", CatalogQuery().groupBy(GroupBy::Kind).groupBy(GroupBy::Decade).count());
+    benchQuery(*store, "pricePercentiles", CatalogQuery().quantile(BookMeasure::Price, 0.5)
+                                               .quantile(BookMeasure::Price, 0.9).quantile(BookMeasure::Price, 0.99));
+    Logger::global().setLevel(previousLevel);
+}
@@ -0,0 +1,81 @@
+#include "Benchmarks.h"
+#include "../include/BookArena.h"
+#include <iostream>
+#include <malloc.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+
+constexpr size_t BOOK_COUNT = 1000000;
+constexpr size_t AUTHOR_COUNT = 20000;
+constexpr int ROUNDS = 2;  // the first round warms up the allocator
+const char* const FILE_TYPES[] = {"PDF", "EPUB", "MOBI"};
+
+// Bytes currently handed out by malloc, including mmap'ed blocks
+size_t heapInUse() {
+    struct mallinfo2 info = mallinfo2();
+    return info.uordblks + info.hblkhd;
+}
+
+// Load the catalog with books made by makeBook(i, isbn, title, author, arena)
+// and tear it down again, reporting time and resident bytes per book.
+// useArena gives every round a fresh arena, destroyed after its books.
+template <typename MakeBook>
+void loadCatalog(const std::string& name, const std::vector<std::string>& authors, 
+                 bool useArena, MakeBook makeBook) {
+    double loadMs = 0.0;
+    double teardownMs = 0.0;
+    size_t bytes = 0;
+    for (int round = 0; round < ROUNDS; ++round) {
+        size_t before = heapInUse();
+        std::unique_ptr<BookArena> arena = useArena ? std::make_unique<BookArena>() : nullptr;
+        std::vector<BookPtr> books;
+        books.reserve(BOOK_COUNT);
+        loadMs = timeBestOf(1, [&]() {
+            std::string isbn;
+            std::string title;
+            for (size_t i = 0; i < BOOK_COUNT; ++i) {
+                isbn = "978-" + std::to_string(1000000000 + i);
+                title = "The Collected Works of Volume " + std::to_string(i);
+                books.push_back(makeBook(i, isbn, title, authors[i % AUTHOR_COUNT], arena.get()));
+            }
+        });
+        bytes = heapInUse() - before;
+        teardownMs = timeBestOf(1, [&]() {
+            books.clear();
+            arena.reset();
+        });
+    }
+    reportResult(name + "/load", loadMs, BOOK_COUNT);
+    reportResult(name + "/teardown", teardownMs, BOOK_COUNT);
+    std::cout << name << ": " << (static_cast<double>(bytes) / BOOK_COUNT) << " bytes per book" << std::endl;
+}
+
+} // namespace
+
+void runArenaBenchmarks() {
+    std::cout << "--- Book storage (" << BOOK_COUNT << " books, half paper, half ebook) ---" << std::endl;
+    
+    std::vector<std::string> authors;
+    for (size_t i = 0; i < AUTHOR_COUNT; ++i) {
+        authors.push_back("Author Person Number " + std::to_string(i));
+    }
+    
+    loadCatalog("books/heap", authors, false, [](size_t i, const std::string& isbn, const std::string& title, 
+                                                 const std::string& author, BookArena*) -> BookPtr {
+        if (i % 2) {
+            return std::make_unique<PaperBook>(isbn, title, 2000, 10.0, author, 5);
+        }
+        return std::make_unique<EBook>(isbn, title, 2000, 10.0, author, FILE_TYPES[i % 3]);
+    });
+    
+    loadCatalog("books/arena", authors, true, [](size_t i, const std::string& isbn, const std::string& title, 
+                                                 const std::string& author, BookArena* arena) {
+        if (i % 2) {
+            return arena->makePaperBook(isbn, title, 2000, 10.0, author, 5);
+        }
+        return arena->makeEBook(isbn, title, 2000, 10.0, author, FILE_TYPES[i % 3]);
+    });
+}
@@ -0,0 +1,291 @@
+#include "Benchmarks.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+
+namespace {
+
+struct BenchRecord {
+    std::string name;
+    double medianMs;
+    double minMs;
+    double maxMs;
+    double p99Ms;  // 0 when there were too few samples
+    double opsPerSecond;
+    size_t items;
+};
+
+BenchOptions options;
+std::vector<BenchRecord> records;
+
+struct Group {
+    const char* name;
+    void (*run)();
+};
+
+const Group GROUPS[] = {
+    {"store", runStoreBenchmarks},
+    {"dispatch", runDispatchBenchmarks},
+    {"scan", runCatalogScanBenchmarks},
+    {"search", runSearchBenchmarks},
+    {"arena", runArenaBenchmarks},
+    {"isbn", runIsbnLookupBenchmarks},
+    {"snapshot", runSnapshotBenchmarks},
+    {"wal", runWalBenchmarks},
+    {"import", runImportBenchmarks},
+    {"export", runExportBenchmarks},
+    {"rpc", runRpcBenchmarks},
+    {"analytics", runAnalyticsBenchmarks},
+    {"feed", runChangeFeedBenchmarks},
+    {"admission", runAdmissionBenchmarks},
+    {"fulfillment", runFulfillmentBenchmarks},
+};
+
+double elapsedMs(const std::function<void()>& fn) {
+    auto start = std::chrono::steady_clock::now();
+    fn();
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Nearest-rank percentile of sorted samples
+double percentile(const std::vector<double>& sorted, double fraction) {
+    size_t rank = static_cast<size_t>(std::ceil(fraction * sorted.size()));
+    return sorted[std::min(sorted.size(), std::max<size_t>(rank, 1)) - 1];
+}
+
+std::vector<size_t> parseList(const char* text) {
+    std::vector<size_t> values;
+    std::stringstream stream(text);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        values.push_back(std::stoull(item));
+    }
+    return values;
+}
+
+std::string jsonEscape(const std::string& text) {
+    std::string escaped;
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            escaped += '\\';
+        }
+        escaped += c;
+    }
+    return escaped;
+}
+
+// One result object per line, so baselines can be read back line by line
+void writeJson(const std::string& path) {
+    std::ofstream out(path);
+    out << "{\"results\": [\n" << std::setprecision(6);
+    for (size_t i = 0; i < records.size(); ++i) {
+        const BenchRecord& record = records[i];
+        out << "  {\"name\": \"" << jsonEscape(record.name) << "\", \"median_ms\": " << record.medianMs
+            << ", \"min_ms\": " << record.minMs << ", \"max_ms\": " << record.maxMs;
+        if (record.p99Ms > 0.0) {
+            out << ", \"p99_ms\": " << record.p99Ms;
+        }
+        out << ", \"ops_per_sec\": " << record.opsPerSecond
+            << ", \"items\": " << record.items << "}" << (i + 1 < records.size() ? "," : "") << "\n";
+    }
+    out << "]}\n";
+    if (!out) {
+        throw std::runtime_error("Cannot write " + path);
+    }
+}
+
+// Median times by name from a file written by --json
+std::map<std::string, double> readBaseline(const std::string& path) {
+    std::ifstream in(path);
+    if (!in) {
+        throw std::runtime_error("Cannot read baseline " + path);
+    }
+    std::map<std::string, double> medians;
+    std::string line;
+    while (std::getline(in, line)) {
+        size_t nameStart = line.find("\"name\": \"");
+        size_t medianStart = line.find("\"median_ms\": ");
+        if (nameStart == std::string::npos || medianStart == std::string::npos) {
+            continue;
+        }
+        nameStart += 9;
+        std::string name;
+        for (size_t i = nameStart; i < line.size() && line[i] != '"'; ++i) {
+            if (line[i] == '\\' && i + 1 < line.size()) {
+                ++i;
+            }
+            name += line[i];
+        }
+        medians[name] = std::strtod(line.c_str() + medianStart + 13, nullptr);
+    }
+    return medians;
+}
+
+// Print current vs baseline medians; returns the number of regressions
+int compareWithBaseline(const std::string& path, double tolerance) {
+    std::map<std::string, double> baseline = readBaseline(path);
+    int regressions = 0;
+    std::cout << "\n=== Comparison with " << path << " (tolerance " << tolerance * 100 << "%) ===" << std::endl;
+    for (const BenchRecord& record : records) {
+        auto it = baseline.find(record.name);
+        if (it == baseline.end() || it->second <= 0.0) {
+            std::cout << std::left << std::setw(48) << record.name << "  (no baseline)" << std::endl;
+            continue;
+        }
+        double change = record.medianMs / it->second - 1.0;
+        bool regressed = change > tolerance;
+        regressions += regressed;
+        std::cout << std::left << std::setw(48) << record.name << std::right << std::fixed
+                  << std::setprecision(2) << std::setw(10) << it->second << " -> "
+                  << std::setw(10) << record.medianMs << " ms  " << std::showpos
+                  << std::setprecision(1) << std::setw(7) << change * 100 << "%" << std::noshowpos
+                  << (regressed ? "  REGRESSION" : "") << std::endl;
+    }
+    return regressions;
+}
+
+void printUsage() {
+    std::cout << "Usage: quantum_bookstore_bench [options]\n"
+                 "  --filter=a,b        run only groups whose name contains one of these\n"
+                 "                      (store, dispatch, scan, search, arena, isbn, snapshot, wal, import)\n"
+                 "  --sizes=1000,...    catalog sizes for the store group (default 1000,100000)\n"
+                 "  --threads=1,...     thread counts for concurrent store operations (default 1,4)\n"
+                 "  --runs=N            timed runs per store benchmark (default 7)\n"
+                 "  --warmup=N          untimed runs before them (default 1)\n"
+                 "  --json=FILE         write results as JSON\n"
+                 "  --baseline=FILE     compare medians with a saved --json file; exit 1 on regression\n"
+                 "  --tolerance=F       allowed slowdown before a regression is flagged (default 0.10)\n";
+}
+
+} // namespace
+
+const BenchOptions& benchOptions() {
+    return options;
+}
+
+BenchStats measure(int warmups, int runs, const std::function<void()>& fn) {
+    return measure(warmups, runs, [] {}, fn);
+}
+
+BenchStats measure(int warmups, int runs, const std::function<void()>& setup,
+                   const std::function<void()>& fn) {
+    for (int run = 0; run < warmups; ++run) {
+        setup();
+        fn();
+    }
+    std::vector<double> samples;
+    for (int run = 0; run < std::max(runs, 1); ++run) {
+        setup();
+        samples.push_back(elapsedMs(fn));
+    }
+    std::sort(samples.begin(), samples.end());
+    BenchStats stats{percentile(samples, 0.5), samples.front(), samples.back()};
+    if (samples.size() >= BenchStats::MIN_P99_SAMPLES) {
+        stats.p99 = percentile(samples, 0.99);
+    }
+    return stats;
+}
+
+double timeBestOf(int runs, const std::function<void()>& fn) {
+    double best = 0.0;
+    for (int run = 0; run < runs; ++run) {
+        double elapsed = elapsedMs(fn);
+        if (run == 0 || elapsed < best) {
+            best = elapsed;
+        }
+    }
+    return best;
+}
+
+void reportResult(const std::string& name, double millis, size_t items) {
+    reportStats(name, BenchStats{millis, millis, millis}, items);
+}
+
+void reportStats(const std::string& name, const BenchStats& stats, size_t items) {
+    double itemsPerSecond = stats.median > 0.0 ? items / (stats.median / 1000.0) : 0.0;
+    records.push_back({name, stats.median, stats.min, stats.max, stats.p99, itemsPerSecond, items});
+    std::cout << std::left << std::setw(40) << name
+              << std::right << std::fixed << std::setprecision(2)
+              << std::setw(10) << stats.median << " ms  ";
+    if (stats.min != stats.max) {
+        std::cout << "(" << std::setw(8) << stats.min << " .. " << std::setw(8) << stats.max;
+        if (stats.p99 > 0.0) {
+            std::cout << ", p99 " << std::setw(8) << stats.p99;
+        }
+        std::cout << ")  ";
+    }
+    std::cout << std::setw(14) << std::setprecision(0) << itemsPerSecond << " items/s" << std::endl;
+}
+
+int main(int argc, char** argv) {
+    std::vector<std::string> filters;
+    std::string jsonPath;
+    std::string baselinePath;
+    double tolerance = 0.10;
+    try {
+        for (int i = 1; i < argc; ++i) {
+            const char* arg = argv[i];
+            const char* value = std::strchr(arg, '=');
+            value = value ? value + 1 : "";
+            if (std::strncmp(arg, "--filter=", 9) == 0) {
+                std::stringstream stream(value);
+                for (std::string item; std::getline(stream, item, ',');) {
+                    filters.push_back(item);
+                }
+            } else if (std::strncmp(arg, "--sizes=", 8) == 0) {
+                options.sizes = parseList(value);
+            } else if (std::strncmp(arg, "--threads=", 10) == 0) {
+                options.threads = parseList(value);
+            } else if (std::strncmp(arg, "--runs=", 7) == 0) {
+                options.runs = std::max(1, std::atoi(value));
+            } else if (std::strncmp(arg, "--warmup=", 9) == 0) {
+                options.warmups = std::max(0, std::atoi(value));
+            } else if (std::strncmp(arg, "--json=", 7) == 0) {
+                jsonPath = value;
+            } else if (std::strncmp(arg, "--baseline=", 11) == 0) {
+                baselinePath = value;
+            } else if (std::strncmp(arg, "--tolerance=", 12) == 0) {
+                tolerance = std::atof(value);
+            } else {
+                printUsage();
+                return std::strcmp(arg, "--help") == 0 ? 0 : 2;
+            }
+        }
+    } catch (const std::exception&) {
+        printUsage();
+        return 2;
+    }
+
+    std::cout << "=== Quantum Bookstore Benchmarks ===" << std::endl;
+    for (const Group& group : GROUPS) {
+        bool selected = filters.empty();
+        for (const std::string& filter : filters) {
+            selected |= std::string(group.name).find(filter) != std::string::npos;
+        }
+        if (selected) {
+            group.run();
+        }
+    }
+
+    try {
+        if (!jsonPath.empty()) {
+            writeJson(jsonPath);
+            std::cout << "Results written to " << jsonPath << std::endl;
+        }
+        if (!baselinePath.empty() && compareWithBaseline(baselinePath, tolerance) > 0) {
+            return 1;
+        }
+    } catch (const std::exception& error) {
+        std::cerr << error.what() << std::endl;
+        return 2;
+    }
+    return 0;
+}
@@ -0,0 +1,58 @@
+#pragma once
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+
+// Command-line settings shared by the benchmark groups
+struct BenchOptions {
+    std::vector<size_t> sizes{1000, 100000};   // catalog sizes for the store benchmarks
+    std::vector<size_t> threads{1, 4};         // thread counts for concurrent operations
+    int warmups = 1;
+    int runs = 7;
+};
+
+const BenchOptions& benchOptions();
+
+// Timing of repeated runs, in milliseconds per run. A handful of runs
+// says nothing about a tail, so p99 is only given (non-zero) for sample
+// sets of MIN_P99_SAMPLES or more.
+struct BenchStats {
+    static constexpr size_t MIN_P99_SAMPLES = 100;
+    
+    double median;
+    double min;
+    double max;
+    double p99 = 0.0;
+};
+
+// Run fn warmups times untimed, then time it runs times
+BenchStats measure(int warmups, int runs, const std::function<void()>& fn);
+// Same, calling setup (untimed) before every run
+BenchStats measure(int warmups, int runs, const std::function<void()>& setup,
+                   const std::function<void()>& fn);
+
+// Best-of-N wall time of fn in milliseconds
+double timeBestOf(int runs, const std::function<void()>& fn);
+
+// Print one result line (name, time and throughput over the given item
+// count) and record it for --json output and --baseline comparison
+void reportResult(const std::string& name, double millis, size_t items);
+void reportStats(const std::string& name, const BenchStats& stats, size_t items);
+
+// Benchmark groups
+void runStoreBenchmarks();
+void runDispatchBenchmarks();
+void runCatalogScanBenchmarks();
+void runSearchBenchmarks();
+void runArenaBenchmarks();
+void runIsbnLookupBenchmarks();
+void runSnapshotBenchmarks();
+void runWalBenchmarks();
+void runImportBenchmarks();
+void runExportBenchmarks();
+void runRpcBenchmarks();
+void runAnalyticsBenchmarks();
+void runChangeFeedBenchmarks();
+void runAdmissionBenchmarks();
+void runFulfillmentBenchmarks();
@@ -0,0 +1,98 @@
+#include "Benchmarks.h"
+#include "../include/CatalogReplica.h"
+#include "../include/Logger.h"
+#include <cstdio>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <unistd.h>
+
+namespace {
+
+constexpr size_t BOOK_COUNT = 100000;
+constexpr size_t PUBLISHES = 1000000;
+constexpr size_t PURCHASES = 200000;
+constexpr int ROUND_TRIPS = 2000;
+
+std::string isbnFor(size_t i) {
+    return "978-" + std::to_string(1000000000 + i);
+}
+
+void addCatalog(QuantumBookstore& store) {
+    for (size_t i = 0; i < BOOK_COUNT; ++i) {
+        store.addPaperBook(isbnFor(i), "Replicated Book", 2020, 10.0, "Author " + std::to_string(i % 1000), 1000000);
+    }
+}
+
+double timePurchases(QuantumBookstore& store) {
+    return timeBestOf(3, [&store]() {
+        for (size_t i = 0; i < PURCHASES; ++i) {
+            store.buyBook(isbnFor(i % BOOK_COUNT), 1, "buyer@example.com", "Cairo");
+        }
+    });
+}
+
+} // namespace
+
+void runChangeFeedBenchmarks() {
+    std::cout << "--- Change feed (" << BOOK_COUNT << " books) ---" << std::endl;
+    LogLevel previousLevel = Logger::global().getLevel();
+    Logger::global().setLevel(LogLevel::Warning);
+    std::string feedName = "/quantum_bookstore_bench_feed_" + std::to_string(getpid());
+    std::string snapshotPath = (std::filesystem::temp_directory_path() / "quantum_bookstore_bench_feed.snapshot").string();
+
+    {
+        ChangeFeed feed(feedName);
+        WalSaleLine line{IsbnCodec::pack(isbnFor(0)), 1};
+        double millis = timeBestOf(3, [&]() {
+            for (size_t i = 0; i < PUBLISHES; ++i) {
+                feed.publishSale(&line, 1);
+            }
+        });
+        reportResult("feed/publish sale record", millis, PUBLISHES);
+    }
+
+    // What publishing adds to checkout
+    {
+        QuantumBookstore store;
+        addCatalog(store);
+        reportResult("feed/buyBook, no feed", timePurchases(store), PURCHASES);
+    }
+    QuantumBookstore primary;
+    primary.openChangeFeed(feedName);
+    addCatalog(primary);
+    reportResult("feed/buyBook, publishing", timePurchases(primary), PURCHASES);
+
+    // Snapshot load plus the changes since, as a new replica would
+    primary.saveSnapshot(snapshotPath);
+    for (size_t i = 0; i < 10000; ++i) {
+        primary.buyBook(isbnFor(i), 1, "buyer@example.com", "Cairo");
+    }
+    double millis = timeBestOf(1, [&]() {
+        CatalogReplica replica(feedName, snapshotPath);
+        replica.bootstrap();
+        replica.poll();
+    });
+    reportResult("feed/replica bootstrap + 10000 changes", millis, BOOK_COUNT);
+
+    // Sale on the primary until the tailing replica has applied it
+    CatalogReplica replica(feedName, snapshotPath);
+    replica.bootstrap();
+    replica.start();
+    size_t next = 0;
+    BenchStats stats = measure(100, ROUND_TRIPS, [&]() {
+        primary.buyBook(isbnFor(next++ % BOOK_COUNT), 1, "buyer@example.com", "Cairo");
+        if (!replica.waitFor(primary.getChangeFeedPosition(), std::chrono::seconds(10))) {
+            std::cerr << "replica did not catch up" << std::endl;
+        }
+    });
+    replica.stop();
+    reportStats("feed/sale visible on replica", stats, 1);
+    ReplicaStats lag = replica.getStats();
+    std::cout << "  publish-to-apply lag: last " << lag.lastLag.count() / 1000.0 << " us, max "
+              << lag.maxLag.count() / 1000.0 << " us (bootstrap catch-up included), " << lag.gaps << " gap(s)"
+              << std::endl;
+
+    std::remove(snapshotPath.c_str());
+    Logger::global().setLevel(previousLevel);
+}
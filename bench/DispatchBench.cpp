@@ -0,0 +1,86 @@
+#include "Benchmarks.h"
+#include "../include/BookTypes.h"
+#include <iostream>
+#include <memory>
+#include <vector>
+
+namespace {
+
+constexpr size_t BOOK_COUNT = 1000000;
+constexpr int RUNS = 5;
+
+std::vector<std::unique_ptr<Book>> makeCatalog() {
+    std::vector<std::unique_ptr<Book>> books;
+    books.reserve(BOOK_COUNT);
+    for (size_t i = 0; i < BOOK_COUNT; ++i) {
+        std::string isbn = "978-" + std::to_string(1000000000 + i);
+        switch (i % 3) {
+            case 0:
+                books.push_back(std::make_unique<PaperBook>(isbn, "Title", 2000, 10.0, "Author", static_cast<int>(i % 50)));
+                break;
+            case 1:
+                books.push_back(std::make_unique<EBook>(isbn, "Title", 2000, 10.0, "Author", "PDF"));
+                break;
+            default:
+                books.push_back(std::make_unique<ShowcaseBook>(isbn, "Title", 2000, 10.0, "Author"));
+                break;
+        }
+    }
+    return books;
+}
+
+// The scan printInventory used to do: two dynamic_casts and a getType() string per row
+size_t scanWithRtti(const std::vector<std::unique_ptr<Book>>& books) {
+    size_t checksum = 0;
+    for (const auto& book : books) {
+        checksum += book->getType().size();
+        if (const PaperBook* paperBook = dynamic_cast<const PaperBook*>(book.get())) {
+            checksum += paperBook->getStock();
+        }
+        if (const EBook* ebook = dynamic_cast<const EBook*>(book.get())) {
+            checksum += ebook->getFileType().size();
+        }
+    }
+    return checksum;
+}
+
+// Same scan through the kind tag: one switch, no RTTI, no allocation
+size_t scanWithTag(const std::vector<std::unique_ptr<Book>>& books) {
+    size_t checksum = 0;
+    for (const auto& book : books) {
+        const Book& ref = *book;
+        checksum += visitBook(ref, BookVisitor{
+            [](const PaperBook& paperBook) -> size_t {
+                return bookKindName(BookKind::Paper).size() + paperBook.getStock();
+            },
+            [](const EBook& ebook) -> size_t {
+                return bookKindName(BookKind::EBook).size() + ebook.getFileType().size();
+            },
+            [](const ShowcaseBook&) -> size_t {
+                return bookKindName(BookKind::Showcase).size();
+            },
+            [](const Book& other) -> size_t {
+                return other.getType().size();
+            }
+        });
+    }
+    return checksum;
+}
+
+} // namespace
+
+void runDispatchBenchmarks() {
+    std::cout << "--- Book dispatch (" << BOOK_COUNT << " books) ---" << std::endl;
+    auto books = makeCatalog();
+    
+    size_t rttiChecksum = 0;
+    size_t tagChecksum = 0;
+    double rttiMs = timeBestOf(RUNS, [&]() { rttiChecksum = scanWithRtti(books); });
+    double tagMs = timeBestOf(RUNS, [&]() { tagChecksum = scanWithTag(books); });
+    
+    reportResult("scan/dynamic_cast+getType", rttiMs, BOOK_COUNT);
+    reportResult("scan/kind-tag", tagMs, BOOK_COUNT);
+    if (rttiChecksum != tagChecksum) {
+        std::cout << "checksum mismatch: " << rttiChecksum << " vs " << tagChecksum << std::endl;
+    }
+}
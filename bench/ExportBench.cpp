@@ -0,0 +1,78 @@
+#include "Benchmarks.h"
+#include "../include/Logger.h"
+#include "../include/QuantumBookstore.h"
+#include <fcntl.h>
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <unistd.h>
+
+namespace {
+
+constexpr size_t BOOK_COUNT = 1000000;
+constexpr size_t PAGE_ROWS = 10000;
+
+// Time one export into the file at path and print its byte rate
+void benchExport(QuantumBookstore& store, ExportFormat format, const char* name,
+                 const std::string& path, size_t pageRows) {
+    size_t bytes = 0;
+    double millis = timeBestOf(3, [&]() {
+        int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        FdSink sink(fd);
+        for (ExportCursor cursor; !cursor.finished;) {
+            cursor = store.exportPage(sink, format, pageRows, cursor);
+        }
+        bytes = static_cast<size_t>(::lseek(fd, 0, SEEK_END));
+        ::close(fd);
+    });
+    std::string label = std::string("export/") + name + (pageRows == SIZE_MAX ? "" : "/pages=" + std::to_string(pageRows));
+    reportResult(label, millis, BOOK_COUNT);
+    std::cout << "  " << bytes / (1024 * 1024) << " MiB at "
+              << static_cast<size_t>(static_cast<double>(bytes) / (1024 * 1024) / (millis / 1000)) << " MiB/s" << std::endl;
+}
+
+} // namespace
+
+void runExportBenchmarks() {
+    std::cout << "--- Catalog export (" << BOOK_COUNT << " books) ---" << std::endl;
+    LogLevel previousLevel = Logger::global().getLevel();
+    Logger::global().setLevel(LogLevel::Warning);
+    auto store = std::make_unique<QuantumBookstore>();
+    for (size_t i = 0; i < BOOK_COUNT; ++i) {
+        std::string isbn = "978-" + std::to_string(1000000000 + i);
+        std::string title = "The Collected Works, Volume " + std::to_string(i);
+        std::string author = "Author Person Number " + std::to_string(i % 20000);
+        int year = 1950 + static_cast<int>(i % 75);
+        if (i % 2) {
+            store->addPaperBook(isbn, title, year, 10.5 + static_cast<double>(i % 100) / 100, author, 5);
+        } else {
+            store->addEBook(isbn, title, year, 7.25, author, "EPUB");
+        }
+    }
+    std::string path = (std::filesystem::temp_directory_path() / "quantum_bookstore_bench.export").string();
+
+    // Raw write of a buffer of the same size, for the disk-bound limit
+    std::string csv;
+    {
+        BufferSink sink;
+        store->exportCatalog(sink, ExportFormat::Csv);
+        csv = sink.data();
+    }
+    double rawMs = timeBestOf(3, [&]() {
+        int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        for (size_t done = 0; done < csv.size();) {
+            done += static_cast<size_t>(::write(fd, csv.data() + done, csv.size() - done));
+        }
+        ::close(fd);
+    });
+    reportResult("export/raw write of the CSV bytes", rawMs, BOOK_COUNT);
+
+    benchExport(*store, ExportFormat::Csv, "csv", path, SIZE_MAX);
+    benchExport(*store, ExportFormat::Csv, "csv", path, PAGE_ROWS);
+    benchExport(*store, ExportFormat::JsonLines, "jsonl", path, SIZE_MAX);
+    benchExport(*store, ExportFormat::Binary, "binary", path, SIZE_MAX);
+
+    std::filesystem::remove(path);
+    Logger::global().setLevel(previousLevel);
+}
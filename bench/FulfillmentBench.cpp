@@ -0,0 +1,98 @@
+#include "Benchmarks.h"
+#include "../include/FulfillmentPipeline.h"
+#include "../include/Logger.h"
+#include "../include/QuantumBookstore.h"
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+constexpr size_t BOOK_COUNT = 1000;
+constexpr size_t CHECKOUTS = 1000;
+constexpr std::chrono::milliseconds CARRIER_CALL{2};
+
+using Clock = std::chrono::steady_clock;
+
+std::string isbnFor(size_t i) {
+    return "978-" + std::to_string(1000000000 + i);
+}
+
+// Stand-in carrier: every call costs CARRIER_CALL, whatever the batch size
+std::vector<size_t> slowShipBatch(const std::vector<std::string>&) {
+    std::this_thread::sleep_for(CARRIER_CALL);
+    return {};
+}
+
+// Paper book shipped through the stand-in carrier at checkout, one call per
+// sale, as the store delivers without a pipeline
+class SlowShippedBook : public Book {
+public:
+    explicit SlowShippedBook(const std::string& isbn) : Book(isbn, "Shipped Book", 2024, 10.0, "Author") {}
+    void processPurchase(const std::string&, const std::string& shippingAddress) const override {
+        slowShipBatch({shippingAddress});
+    }
+    bool canBeSold() const override { return true; }
+    std::string getType() const override { return "Shipped Book"; }
+};
+
+BenchStats latencyStats(std::vector<double> millis) {
+    std::sort(millis.begin(), millis.end());
+    auto at = [&millis](double fraction) {
+        return millis[std::min(millis.size() - 1, static_cast<size_t>(fraction * millis.size()))];
+    };
+    BenchStats stats{at(0.5), millis.front(), millis.back()};
+    if (millis.size() >= BenchStats::MIN_P99_SAMPLES) {
+        stats.p99 = at(0.99);
+    }
+    return stats;
+}
+
+// Time each checkout on its own, so the tail shows
+BenchStats timeCheckouts(QuantumBookstore& store) {
+    std::vector<double> millis;
+    millis.reserve(CHECKOUTS);
+    for (size_t i = 0; i < CHECKOUTS; ++i) {
+        Clock::time_point start = Clock::now();
+        store.buyBook(isbnFor(i % BOOK_COUNT), 1, "buyer@example.com", "Cairo");
+        millis.push_back(std::chrono::duration<double, std::milli>(Clock::now() - start).count());
+    }
+    return latencyStats(std::move(millis));
+}
+
+} // namespace
+
+void runFulfillmentBenchmarks() {
+    std::cout << "--- Fulfillment (" << CARRIER_CALL.count() << " ms stand-in carrier call) ---" << std::endl;
+    LogLevel previousLevel = Logger::global().getLevel();
+    Logger::global().setLevel(LogLevel::Warning);
+
+    // Delivery inline: every checkout waits for its carrier call
+    QuantumBookstore direct;
+    for (size_t i = 0; i < BOOK_COUNT; ++i) {
+        direct.addBook(std::make_unique<SlowShippedBook>(isbnFor(i)));
+    }
+    BenchStats sync = timeCheckouts(direct);
+    reportStats("fulfillment/checkout, synchronous", sync, 1);
+
+    // Through the pipeline: checkout only enqueues, and workers batch the calls
+    QuantumBookstore piped;
+    FulfillmentBackend backend;
+    backend.shipBatch = slowShipBatch;
+    backend.sendEmailBatch = [](const std::vector<std::string>&) { return std::vector<size_t>(); };
+    piped.enableAsyncFulfillment(FulfillmentConfig(), backend);
+    for (size_t i = 0; i < BOOK_COUNT; ++i) {
+        piped.addPaperBook(isbnFor(i), "Shipped Book", 2024, 10.0, "Author", 1000000);
+    }
+    BenchStats async = timeCheckouts(piped);
+    reportStats("fulfillment/checkout, async pipeline", async, 1);
+    piped.waitForFulfillment();
+    std::cout << std::setprecision(3) << "  checkout p99 " << async.p99 << " ms async vs " << sync.p99 << " ms synchronous" << std::endl;
+
+    Logger::global().setLevel(previousLevel);
+}
@@ -0,0 +1,50 @@
+#include "Benchmarks.h"
+#include "../include/Logger.h"
+#include "../include/QuantumBookstore.h"
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+
+namespace {
+
+constexpr size_t ROW_COUNT = 2000000;
+constexpr size_t AUTHOR_COUNT = 20000;
+
+void writeCatalog(const std::string& path) {
+    std::ofstream out(path, std::ios::binary);
+    out << "type,isbn,title,author,year,price,stock,file_type\n";
+    for (size_t i = 0; i < ROW_COUNT; ++i) {
+        out << (i % 2 ? "paper," : "ebook,") << "978-" << (1000000000 + i) 
+            << ",\"The Collected Works, Volume " << i << "\",Author Person Number " << (i % AUTHOR_COUNT) 
+            << ',' << (1950 + i % 75) << ",10.5," << (i % 2 ? "5," : ",EPUB") << '\n';
+    }
+}
+
+} // namespace
+
+void runImportBenchmarks() {
+    std::cout << "--- Bulk CSV import (" << ROW_COUNT << " rows) ---" << std::endl;
+    LogLevel previousLevel = Logger::global().getLevel();
+    Logger::global().setLevel(LogLevel::Warning);
+    std::string path = (std::filesystem::temp_directory_path() / "quantum_bookstore_bench.csv").string();
+    writeCatalog(path);
+    std::cout << "catalog file: " << (std::filesystem::file_size(path) / (1024 * 1024)) << " MiB" << std::endl;
+    
+    auto store = std::make_unique<QuantumBookstore>();
+    ImportReport report;
+    double importMs = timeBestOf(1, [&]() {
+        report = store->importCatalog(path);
+    });
+    reportResult("import/parse + insert", importMs, report.booksAdded);
+    double indexMs = timeBestOf(1, [&]() {
+        store->findBooksByAuthor("Author Person Number 7").size();
+    });
+    reportResult("import/+ indexes ready", importMs + indexMs, report.booksAdded);
+    store.reset();
+    
+    std::remove(path.c_str());
+    Logger::global().setLevel(previousLevel);
+}
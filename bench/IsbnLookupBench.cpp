@@ -0,0 +1,124 @@
+#include "Benchmarks.h"
+#include "../include/FlatHashMap.h"
+#include "../include/IsbnCodec.h"
+#include "../include/QuantumBookstore.h"
+#include <iostream>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+constexpr size_t CATALOG_SIZE = 10000000;
+constexpr size_t STORE_CATALOG_SIZE = 1000000;  // the store's indexes make 10M impractical here
+constexpr size_t LOOKUPS = 2000000;
+
+// Same shape as an inventory entry: the book handle and its column row
+struct Entry {
+    const void* book;
+    size_t row;
+};
+
+std::string isbnFor(size_t i) {
+    return "978-" + std::to_string(1000000000 + i);
+}
+
+// Independent lookups measure throughput; in the chained run each query
+// depends on the previous result, which measures the latency of one call
+template <typename Find>
+void timeLookups(const std::string& name, const std::vector<std::string>& queries, 
+                 size_t& found, Find find) {
+    double independentMs = timeBestOf(3, [&]() {
+        for (const auto& isbn : queries) {
+            found += find(isbn) & 1;
+        }
+    });
+    reportResult(name + " find", independentMs, queries.size());
+    double chainedMs = timeBestOf(3, [&]() {
+        size_t previous = 0;
+        for (size_t i = 0; i < queries.size(); ++i) {
+            previous = find(queries[(i + previous) % queries.size()]) & 1;
+            found += previous;
+        }
+    });
+    reportResult(name + " find (chained)", chainedMs, queries.size());
+}
+
+} // namespace
+
+void runIsbnLookupBenchmarks() {
+    std::cout << "--- ISBN lookup (" << CATALOG_SIZE << " entries) ---" << std::endl;
+    
+    std::mt19937_64 rng(11);
+    std::uniform_int_distribution<size_t> pick(0, CATALOG_SIZE - 1);
+    std::vector<std::string> queries;
+    queries.reserve(LOOKUPS);
+    for (size_t i = 0; i < LOOKUPS; ++i) {
+        queries.push_back(isbnFor(pick(rng)));
+    }
+    
+    size_t found = 0;
+    {
+        std::unordered_map<std::string, Entry> byString;
+        byString.reserve(CATALOG_SIZE);
+        double buildMs = timeBestOf(1, [&]() {
+            for (size_t i = 0; i < CATALOG_SIZE; ++i) {
+                byString.emplace(isbnFor(i), Entry{&byString, i});
+            }
+        });
+        reportResult("isbn/unordered_map build", buildMs, CATALOG_SIZE);
+        timeLookups("isbn/unordered_map", queries, found, [&](const std::string& isbn) -> size_t {
+            auto it = byString.find(isbn);
+            return (it != byString.end()) ? it->second.row : 0;
+        });
+    }
+    {
+        FlatHashMap<Entry> byKey;
+        byKey.reserve(CATALOG_SIZE);
+        double buildMs = timeBestOf(1, [&]() {
+            for (size_t i = 0; i < CATALOG_SIZE; ++i) {
+                byKey.tryEmplace(IsbnCodec::pack(isbnFor(i)), Entry{&byKey, i});
+            }
+        });
+        reportResult("isbn/flat map build", buildMs, CATALOG_SIZE);
+        // Includes packing the query string, as ShardedInventory::find does
+        timeLookups("isbn/flat map", queries, found, [&](const std::string& isbn) -> size_t {
+            const Entry* entry = byKey.find(IsbnCodec::pack(isbn));
+            return entry ? entry->row : 0;
+        });
+    }
+    
+    // The map alone is only part of a lookup: findBook adds the shard's
+    // shared lock and the metrics timer. Same-size map for comparison.
+    std::vector<std::string> storeQueries;
+    storeQueries.reserve(LOOKUPS);
+    std::uniform_int_distribution<size_t> pickStored(0, STORE_CATALOG_SIZE - 1);
+    for (size_t i = 0; i < LOOKUPS; ++i) {
+        storeQueries.push_back(isbnFor(pickStored(rng)));
+    }
+    {
+        FlatHashMap<Entry> byKey;
+        byKey.reserve(STORE_CATALOG_SIZE);
+        for (size_t i = 0; i < STORE_CATALOG_SIZE; ++i) {
+            byKey.tryEmplace(IsbnCodec::pack(isbnFor(i)), Entry{&byKey, i});
+        }
+        timeLookups("isbn/flat map 1M", storeQueries, found, [&](const std::string& isbn) -> size_t {
+            const Entry* entry = byKey.find(IsbnCodec::pack(isbn));
+            return entry ? entry->row : 0;
+        });
+    }
+    {
+        LogLevel previousLevel = Logger::global().getLevel();
+        Logger::global().setLevel(LogLevel::Warning);
+        QuantumBookstore store;
+        for (size_t i = 0; i < STORE_CATALOG_SIZE; ++i) {
+            store.addPaperBook(isbnFor(i), "Title", 2020, 10.0, "Author", 1);
+        }
+        Logger::global().setLevel(previousLevel);
+        timeLookups("isbn/store findBook 1M", storeQueries, found, [&](const std::string& isbn) -> size_t {
+            return store.findBook(isbn) != nullptr;
+        });
+    }
+    std::cout << "(" << found << " odd rows)" << std::endl;
+}
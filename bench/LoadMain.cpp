@@ -0,0 +1,150 @@
+#include "../include/LoadGenerator.h"
+#include "../include/Logger.h"
+#include "../include/QuantumBookstore.h"
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+
+void printUsage() {
+    std::cout << "Usage: quantum_bookstore_load [options]\n"
+                 "  --catalog=N         books in the initial catalog (default 100000)\n"
+                 "  --clients=N         client threads (default 4)\n"
+                 "  --ops=N             operations in total (default 1000000)\n"
+                 "  --rate=R            open loop at R operations/s in total; 0 = closed loop (default)\n"
+                 "  --theta=F           Zipfian popularity skew in [0, 1) (default 0.99)\n"
+                 "  --stock=N           initial stock per paper book (default 20)\n"
+                 "  --paper=F --ebook=F catalog shares of paper books and ebooks (default 0.6, 0.3)\n"
+                 "  --mix=a,b,c,d,e,f   weights of paper, ebook and showcase purchases, lookups,\n"
+                 "                      inserts and removeOutdated sweeps (default 45,22,3,25,4.9,0.1)\n"
+                 "  --seed=N            random seed (default 42)\n"
+                 "  --record=FILE       save the generated operations as a trace\n"
+                 "  --replay=FILE       run the operations of a saved trace instead\n";
+}
+
+std::vector<double> parseWeights(const char* text) {
+    std::vector<double> weights;
+    std::stringstream stream(text);
+    for (std::string item; std::getline(stream, item, ',');) {
+        weights.push_back(std::stod(item));
+    }
+    if (weights.size() != 6) {
+        throw std::invalid_argument("--mix takes six weights");
+    }
+    return weights;
+}
+
+double micros(uint64_t nanos) {
+    return static_cast<double>(nanos) / 1000.0;
+}
+
+void printReport(const LoadReport& report, const LoadTrace& trace, const MetricsSnapshot& metrics) {
+    bool openLoop = trace.config.ratePerSecond > 0;
+    std::cout << "\n" << report.totalCompleted() << " operations in " << std::fixed << std::setprecision(2)
+              << report.elapsedSeconds << " s (" << std::setprecision(0)
+              << report.totalCompleted() / report.elapsedSeconds << " ops/s, "
+              << (openLoop ? "open loop" : "closed loop") << ")" << std::endl;
+    if (openLoop) {
+        std::cout << report.lateOps << " operation(s) started more than 1 ms behind schedule" << std::endl;
+    }
+    std::cout << "\nLatency in us, " << (openLoop ? "from the scheduled start (coordinated-omission corrected)"
+                                                  : "per call")
+              << "\n" << std::left << std::setw(8) << "op" << std::right << std::setw(10) << "count"
+              << std::setw(10) << "rejected" << std::setw(10) << "p50" << std::setw(10) << "p99"
+              << std::setw(10) << "p99.9" << std::setw(12) << "max" << std::endl;
+    for (size_t type = 0; type < LOAD_OP_TYPE_COUNT; ++type) {
+        const LoadOpStats& stats = report.byType[type];
+        if (stats.completed == 0) {
+            continue;
+        }
+        const LatencyHistogram& latency = stats.response;
+        std::cout << std::left << std::setw(8) << loadOpTypeName(static_cast<LoadOpType>(type)) << std::right
+                  << std::setw(10) << stats.completed << std::setw(10) << stats.rejected << std::setprecision(1)
+                  << std::setw(10) << micros(latency.percentile(0.5)) << std::setw(10) << micros(latency.percentile(0.99))
+                  << std::setw(10) << micros(latency.percentile(0.999)) << std::setw(12) << micros(latency.maxNanos())
+                  << std::endl;
+    }
+    std::cout << "\nRejections:";
+    for (size_t failure = 0; failure < STORE_FAILURE_COUNT; ++failure) {
+        uint64_t count = metrics.failures[failure];
+        if (count > 0) {
+            std::cout << " " << storeFailureName(static_cast<StoreFailure>(failure)) << "=" << count;
+        }
+    }
+    std::cout << "\nSold: paper=" << metrics.soldOf(BookKind::Paper) << " ebook=" << metrics.soldOf(BookKind::EBook)
+              << ", removed " << metrics.booksRemoved << ", inventory " << metrics.inventorySize
+              << " book(s) with " << metrics.totalStock << " paper copies" << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    LoadConfig config;
+    std::string recordPath;
+    std::string replayPath;
+    try {
+        for (int i = 1; i < argc; ++i) {
+            const char* arg = argv[i];
+            const char* value = std::strchr(arg, '=');
+            value = value ? value + 1 : "";
+            if (std::strncmp(arg, "--catalog=", 10) == 0) {
+                config.catalogSize = std::stoull(value);
+            } else if (std::strncmp(arg, "--clients=", 10) == 0) {
+                config.clients = std::stoull(value);
+            } else if (std::strncmp(arg, "--ops=", 6) == 0) {
+                config.operations = std::stoull(value);
+            } else if (std::strncmp(arg, "--rate=", 7) == 0) {
+                config.ratePerSecond = std::stod(value);
+            } else if (std::strncmp(arg, "--theta=", 8) == 0) {
+                config.zipfTheta = std::stod(value);
+            } else if (std::strncmp(arg, "--stock=", 8) == 0) {
+                config.initialStock = std::stoi(value);
+            } else if (std::strncmp(arg, "--paper=", 8) == 0) {
+                config.paperShare = std::stod(value);
+            } else if (std::strncmp(arg, "--ebook=", 8) == 0) {
+                config.ebookShare = std::stod(value);
+            } else if (std::strncmp(arg, "--mix=", 6) == 0) {
+                std::vector<double> weights = parseWeights(value);
+                config.mix = LoadMix{weights[0], weights[1], weights[2], weights[3], weights[4], weights[5]};
+            } else if (std::strncmp(arg, "--seed=", 7) == 0) {
+                config.seed = std::stoull(value);
+            } else if (std::strncmp(arg, "--record=", 9) == 0) {
+                recordPath = value;
+            } else if (std::strncmp(arg, "--replay=", 9) == 0) {
+                replayPath = value;
+            } else {
+                printUsage();
+                return std::strcmp(arg, "--help") == 0 ? 0 : 2;
+            }
+        }
+    } catch (const std::exception&) {
+        printUsage();
+        return 2;
+    }
+
+    try {
+        LoadTrace trace = replayPath.empty() ? LoadGenerator::generate(config) : LoadGenerator::readTrace(replayPath);
+        if (!recordPath.empty()) {
+            LoadGenerator::writeTrace(recordPath, trace);
+            std::cout << "Trace written to " << recordPath << std::endl;
+        }
+
+        Logger::global().setLevel(LogLevel::Warning);
+        QuantumBookstore store;
+        LoadGenerator::buildCatalog(store, trace.config);
+        std::cout << "Catalog of " << store.getInventorySize() << " book(s); running " << trace.ops.size()
+                  << " operation(s) on " << trace.config.clients << " client(s)"
+                  << (replayPath.empty() ? "" : " from " + replayPath) << std::endl;
+        LoadReport report = LoadGenerator::run(store, trace);
+        printReport(report, trace, store.getMetrics());
+    } catch (const std::exception& error) {
+        std::cerr << error.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
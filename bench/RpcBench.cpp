@@ -0,0 +1,118 @@
+#include "Benchmarks.h"
+#include "../include/Logger.h"
+#include "../include/QuantumBookstore.h"
+#include "../include/StoreClient.h"
+#include "../include/StoreServer.h"
+#include <algorithm>
+#include <filesystem>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+constexpr size_t BOOK_COUNT = 100000;
+constexpr size_t UNPIPELINED_REQUESTS = 20000;
+constexpr size_t PIPELINED_REQUESTS = 400000;
+
+std::string isbnOf(size_t i) {
+    return "978-" + std::to_string(1000000000 + i);
+}
+
+// ISBNs in random order, so pipelined lookups spread over every shard
+std::vector<std::string> randomIsbns(size_t count, uint64_t seed) {
+    std::mt19937_64 rng(seed);
+    std::vector<std::string> isbns;
+    isbns.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        isbns.push_back(isbnOf(rng() % BOOK_COUNT));
+    }
+    return isbns;
+}
+
+// Time clients lookups of requests ISBNs in total, depth per flush
+void benchFinds(const std::string& label, const std::function<StoreClient()>& connect, size_t clients,
+                size_t requests, size_t depth) {
+    std::vector<std::vector<std::string>> isbns;
+    for (size_t c = 0; c < clients; ++c) {
+        isbns.push_back(randomIsbns(requests / clients, c + 1));
+    }
+    double millis = timeBestOf(3, [&]() {
+        std::vector<std::thread> threads;
+        for (size_t c = 0; c < clients; ++c) {
+            threads.emplace_back([&, c]() {
+                StoreClient client = connect();
+                std::vector<RpcReply> replies;
+                const std::vector<std::string>& mine = isbns[c];
+                for (size_t i = 0; i < mine.size(); i += depth) {
+                    if (depth == 1) {
+                        client.findBook(mine[i]);
+                        continue;
+                    }
+                    for (size_t j = i; j < std::min(i + depth, mine.size()); ++j) {
+                        client.queueFindBook(mine[j]);
+                    }
+                    client.flush(replies);
+                }
+            });
+        }
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+    });
+    reportResult(label, millis, requests / clients * clients);
+}
+
+} // namespace
+
+void runRpcBenchmarks() {
+    std::cout << "--- RPC server (" << BOOK_COUNT << " books) ---" << std::endl;
+    LogLevel previousLevel = Logger::global().getLevel();
+    Logger::global().setLevel(LogLevel::Warning);
+    QuantumBookstore store;
+    for (size_t i = 0; i < BOOK_COUNT; ++i) {
+        store.addPaperBook(isbnOf(i), "Title " + std::to_string(i), 2000 + static_cast<int>(i % 25), 12.5,
+                           "Author " + std::to_string(i % 5000), 1000000);
+    }
+    StoreServer server(store);
+    std::string socketPath = (std::filesystem::temp_directory_path() / "quantum_bookstore_bench.sock").string();
+    server.listenUnix(socketPath);
+    uint16_t port = server.listenTcp();
+    server.start();
+    std::cout << "  " << server.reactorCount() << " reactor(s)" << std::endl;
+    auto overUnix = [&socketPath]() { return StoreClient::connectUnix(socketPath); };
+    auto overTcp = [port]() { return StoreClient::connectTcp(port); };
+
+    // One request in flight per client: bound by the round trip
+    benchFinds("rpc/find/unix/depth=1", overUnix, 1, UNPIPELINED_REQUESTS, 1);
+    benchFinds("rpc/find/tcp/depth=1", overTcp, 1, UNPIPELINED_REQUESTS, 1);
+    // Pipelined: one read and one write per batch, lookups shard-batched
+    for (size_t clients : benchOptions().threads) {
+        for (size_t depth : {16, 64, 256}) {
+            benchFinds("rpc/find/unix/clients=" + std::to_string(clients) + "/depth=" + std::to_string(depth),
+                       overUnix, clients, PIPELINED_REQUESTS, depth);
+        }
+        benchFinds("rpc/find/tcp/clients=" + std::to_string(clients) + "/depth=64", overTcp, clients,
+                   PIPELINED_REQUESTS, 64);
+    }
+
+    // Pipelined purchases take the write path of every request
+    std::vector<std::string> isbns = randomIsbns(PIPELINED_REQUESTS / 4, 99);
+    double millis = timeBestOf(3, [&]() {
+        StoreClient client = overUnix();
+        std::vector<RpcReply> replies;
+        for (size_t i = 0; i < isbns.size(); ++i) {
+            client.queueBuyBook(isbns[i], 1, "bench@example.com", "1 Bench Road");
+            if (client.queued() == 64) {
+                client.flush(replies);
+            }
+        }
+        client.flush(replies);
+    });
+    reportResult("rpc/buy/unix/depth=64", millis, PIPELINED_REQUESTS / 4);
+    server.stop();
+    Logger::global().setLevel(previousLevel);
+}
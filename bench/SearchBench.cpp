@@ -0,0 +1,74 @@
+#include "Benchmarks.h"
+#include "../include/BookTypes.h"
+#include "../include/SearchIndex.h"
+#include <iostream>
+#include <memory>
+#include <random>
+#include <vector>
+
+namespace {
+
+constexpr size_t BOOK_COUNT = 1000000;
+constexpr size_t VOCABULARY_SIZE = 20000;
+constexpr size_t AUTHOR_COUNT = 50000;
+constexpr int QUERIES = 2000;
+
+// Synthetic word like "w1234x": unique per index, alphanumeric
+std::string word(size_t index) {
+    return "w" + std::to_string(index) + "x";
+}
+
+} // namespace
+
+void runSearchBenchmarks() {
+    std::cout << "--- Full-text search (" << BOOK_COUNT << " titles) ---" << std::endl;
+    
+    // Skewed word popularity, like real titles
+    std::mt19937_64 rng(42);
+    std::discrete_distribution<size_t> popularity([]() {
+        std::vector<double> weights(VOCABULARY_SIZE);
+        for (size_t i = 0; i < VOCABULARY_SIZE; ++i) {
+            weights[i] = 1.0 / static_cast<double>(i + 1);
+        }
+        return std::discrete_distribution<size_t>(weights.begin(), weights.end());
+    }());
+    std::uniform_int_distribution<size_t> authorPick(0, AUTHOR_COUNT - 1);
+    
+    std::vector<std::unique_ptr<Book>> books;
+    books.reserve(BOOK_COUNT);
+    SearchIndex index;
+    double buildMs = timeBestOf(1, [&]() {
+        for (size_t i = 0; i < BOOK_COUNT; ++i) {
+            std::string title = word(popularity(rng)) + " " + word(popularity(rng)) + " " + word(popularity(rng));
+            std::string author = "Author " + word(authorPick(rng));
+            books.push_back(std::make_unique<EBook>("978-" + std::to_string(1000000000 + i), 
+                                                    title, 2000, 10.0, author, "PDF"));
+            index.add(books.back().get());
+        }
+    });
+    reportResult("search/build", buildMs, BOOK_COUNT);
+    
+    // Two-term AND queries mixing common and rare words, and prefix queries
+    std::vector<std::string> andQueries;
+    std::vector<std::string> prefixQueries;
+    for (int q = 0; q < QUERIES; ++q) {
+        andQueries.push_back(word(popularity(rng)) + " " + word(100 + popularity(rng) % (VOCABULARY_SIZE - 100)));
+        prefixQueries.push_back(word(1000 + popularity(rng) % (VOCABULARY_SIZE - 1000)).substr(0, 5) + "*");
+    }
+    
+    size_t matched = 0;
+    double andMs = timeBestOf(3, [&]() {
+        for (const auto& query : andQueries) {
+            matched += index.search(query, 10).size();
+        }
+    });
+    double prefixMs = timeBestOf(3, [&]() {
+        for (const auto& query : prefixQueries) {
+            matched += index.search(query, 10).size();
+        }
+    });
+    reportResult("search/two-term AND top-10", andMs, QUERIES);
+    reportResult("search/prefix top-10", prefixMs, QUERIES);
+    std::cout << "mean latency: AND " << (andMs * 1000.0 / QUERIES) << " us, prefix " 
+              << (prefixMs * 1000.0 / QUERIES) << " us (" << matched << " hits)" << std::endl;
+}
@@ -0,0 +1,67 @@
+#include "Benchmarks.h"
+#include "../include/Logger.h"
+#include "../include/QuantumBookstore.h"
+#include <cstdio>
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <string>
+
+namespace {
+
+constexpr size_t BOOK_COUNT = 1000000;
+constexpr size_t AUTHOR_COUNT = 20000;
+const char* const FILE_TYPES[] = {"PDF", "EPUB", "MOBI"};
+
+void fillStore(QuantumBookstore& store) {
+    std::string isbn;
+    std::string title;
+    std::string author;
+    for (size_t i = 0; i < BOOK_COUNT; ++i) {
+        isbn = "978-" + std::to_string(1000000000 + i);
+        title = "The Collected Works of Volume " + std::to_string(i);
+        author = "Author Person Number " + std::to_string(i % AUTHOR_COUNT);
+        if (i % 2) {
+            store.addPaperBook(isbn, title, 1950 + static_cast<int>(i % 75), 10.0, author, 5);
+        } else {
+            store.addEBook(isbn, title, 1950 + static_cast<int>(i % 75), 10.0, author, FILE_TYPES[i % 3]);
+        }
+    }
+}
+
+} // namespace
+
+void runSnapshotBenchmarks() {
+    std::cout << "--- Catalog snapshots (" << BOOK_COUNT << " books, warm page cache) ---" << std::endl;
+    // Keep a million "Added book" lines out of the measurements
+    LogLevel previousLevel = Logger::global().getLevel();
+    Logger::global().setLevel(LogLevel::Warning);
+    std::string path = (std::filesystem::temp_directory_path() / "quantum_bookstore_bench.snapshot").string();
+    
+    {
+        auto store = std::make_unique<QuantumBookstore>();
+        double rebuildMs = timeBestOf(1, [&]() {
+            fillStore(*store);
+        });
+        reportResult("startup/addBook", rebuildMs, BOOK_COUNT);
+        double saveMs = timeBestOf(1, [&]() {
+            store->saveSnapshot(path);
+        });
+        reportResult("snapshot/save", saveMs, BOOK_COUNT);
+    }
+    std::cout << "snapshot file: " << (std::filesystem::file_size(path) / (1024 * 1024)) << " MiB" << std::endl;
+    
+    auto store = std::make_unique<QuantumBookstore>();
+    double loadMs = timeBestOf(1, [&]() {
+        store->loadSnapshot(path);
+    });
+    reportResult("snapshot/load (lookups ready)", loadMs, BOOK_COUNT);
+    double indexMs = timeBestOf(1, [&]() {
+        store->findBooksByAuthor("Author Person Number 7").size();
+    });
+    reportResult("snapshot/load (+ indexes ready)", loadMs + indexMs, BOOK_COUNT);
+    store.reset();
+    
+    std::remove(path.c_str());
+    Logger::global().setLevel(previousLevel);
+}
@@ -0,0 +1,320 @@
+#include "Benchmarks.h"
+#include "../include/Logger.h"
+#include "../include/QuantumBookstore.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+constexpr size_t LOOKUPS_PER_RUN = 1000000;
+constexpr size_t PURCHASES_PER_RUN = 100000;
+constexpr size_t QUERY_POOL = 65536;
+constexpr int PAPER_STOCK = 1000000000;
+
+// Paper only, or half paper, 40% ebooks and 10% showcase books
+enum class Mix { Paper, Mixed };
+
+const char* mixName(Mix mix) {
+    return mix == Mix::Paper ? "paper" : "mixed";
+}
+
+bool isPaper(size_t i, Mix mix) {
+    return mix == Mix::Paper || i % 10 < 5;
+}
+
+std::string isbnFor(size_t i) {
+    return "978-" + std::to_string(1000000000 + i);
+}
+
+// Years spread over 1950-2024, so removeOutdated(2025, 65) drops about 13%
+BookPtr makeBook(size_t i, Mix mix) {
+    std::string isbn = isbnFor(i);
+    std::string title = "Benchmark Title Number " + std::to_string(i);
+    std::string author = "Author " + std::to_string(i % 1000);
+    int year = 1950 + static_cast<int>(i % 75);
+    if (isPaper(i, mix)) {
+        return std::make_unique<PaperBook>(isbn, title, year, 20.0, author, PAPER_STOCK);
+    }
+    if (i % 10 < 9) {
+        return std::make_unique<EBook>(isbn, title, year, 10.0, author, "EPUB");
+    }
+    return std::make_unique<ShowcaseBook>(isbn, title, year, 0.0, author);
+}
+
+std::vector<BookPtr> makeBooks(size_t count, Mix mix) {
+    std::vector<BookPtr> books;
+    books.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        books.push_back(makeBook(i, mix));
+    }
+    return books;
+}
+
+std::unique_ptr<QuantumBookstore> makeStore(size_t count, Mix mix) {
+    auto store = std::make_unique<QuantumBookstore>();
+    for (BookPtr& book : makeBooks(count, mix)) {
+        store->addBook(std::move(book));
+    }
+    return store;
+}
+
+// Random ISBNs of the catalog, paper books only if requested
+std::vector<std::string> makeQueries(size_t count, Mix mix, bool paperOnly) {
+    std::mt19937_64 random(42);
+    std::vector<std::string> queries;
+    queries.reserve(QUERY_POOL);
+    while (queries.size() < QUERY_POOL) {
+        size_t i = random() % count;
+        if (!paperOnly || isPaper(i, mix)) {
+            queries.push_back(isbnFor(i));
+        }
+    }
+    return queries;
+}
+
+// Split ops over threads; fn(begin, end) runs on each
+template <typename Fn>
+void runSplit(size_t threads, size_t ops, Fn fn) {
+    std::vector<std::thread> workers;
+    for (size_t t = 0; t < threads; ++t) {
+        workers.emplace_back([&fn, t, threads, ops]() {
+            fn(ops * t / threads, ops * (t + 1) / threads);
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+std::string label(const std::string& operation, size_t size, const char* detail) {
+    return "store/" + operation + "/n=" + std::to_string(size) + "/" + detail;
+}
+
+void benchAddBook(size_t size, Mix mix) {
+    const BenchOptions& options = benchOptions();
+    std::unique_ptr<QuantumBookstore> store;
+    std::vector<BookPtr> books;
+    BenchStats stats = measure(options.warmups, options.runs, [&]() {
+        store.reset();
+        store = std::make_unique<QuantumBookstore>();
+        books = makeBooks(size, mix);
+    }, [&]() {
+        for (BookPtr& book : books) {
+            store->addBook(std::move(book));
+        }
+    });
+    reportStats(label("addBook", size, mixName(mix)), stats, size);
+}
+
+void benchRemoveOutdated(size_t size, Mix mix) {
+    const BenchOptions& options = benchOptions();
+    std::unique_ptr<QuantumBookstore> store;
+    size_t removed = 0;
+    BenchStats stats = measure(options.warmups, options.runs, [&]() {
+        store.reset();
+        store = makeStore(size, mix);
+    }, [&]() {
+        removed = store->removeOutdated(2025, 65).size();
+    });
+    reportStats(label("removeOutdated", size, mixName(mix)), stats, removed);
+}
+
+// Streamed removal; the longest gap between batches bounds how long the
+// year index stays busy at a time
+void benchRemoveOutdatedBatched(size_t size, size_t batchSize) {
+    const BenchOptions& options = benchOptions();
+    std::unique_ptr<QuantumBookstore> store;
+    size_t removed = 0;
+    double longestBatchMs = 0;
+    BenchStats stats = measure(options.warmups, options.runs, [&]() {
+        store.reset();
+        store = makeStore(size, Mix::Mixed);
+    }, [&]() {
+        auto batchStart = std::chrono::steady_clock::now();
+        removed = store->removeOutdated(2025, 65, [&](std::vector<BookPtr>&) {
+            auto now = std::chrono::steady_clock::now();
+            longestBatchMs = std::max(longestBatchMs, std::chrono::duration<double, std::milli>(now - batchStart).count());
+            batchStart = now;
+        }, batchSize);
+    });
+    std::string detail = "batch=" + std::to_string(batchSize);
+    reportStats(label("removeOutdated", size, detail.c_str()), stats, removed);
+    std::cout << "  longest batch " << longestBatchMs << " ms" << std::endl;
+}
+
+void benchPrintInventory(QuantumBookstore& store, size_t size) {
+    const BenchOptions& options = benchOptions();
+    std::FILE* sink = std::fopen("/dev/null", "w");
+    Logger::global().setOutput(sink);
+    Logger::global().setLevel(LogLevel::Info);
+    BenchStats stats = measure(options.warmups, options.runs, [&]() {
+        store.printInventory();
+    });
+    Logger::global().setLevel(LogLevel::Warning);
+    Logger::global().setOutput(stdout);
+    std::fclose(sink);
+    reportStats(label("printInventory", size, "mixed"), stats, size);
+}
+
+// Snapshot merge, stock scan and text rendering of a scrape
+void benchExportMetrics(QuantumBookstore& store, size_t size) {
+    const BenchOptions& options = benchOptions();
+    size_t bytes = 0;
+    BenchStats stats = measure(options.warmups, options.runs, [&]() {
+        bytes = store.exportMetrics().size();
+    });
+    reportStats(label("exportMetrics", size, (std::to_string(bytes) + "B").c_str()), stats, 1);
+}
+
+void benchFindBook(QuantumBookstore& store, size_t size, size_t threads) {
+    const BenchOptions& options = benchOptions();
+    std::vector<std::string> queries = makeQueries(size, Mix::Mixed, false);
+    BenchStats stats = measure(options.warmups, options.runs, [&]() {
+        runSplit(threads, LOOKUPS_PER_RUN, [&](size_t begin, size_t end) {
+            size_t found = 0;
+            for (size_t i = begin; i < end; ++i) {
+                found += store.findBook(queries[i % QUERY_POOL]) != nullptr;
+            }
+            if (found != end - begin) {
+                std::cerr << "findBook missed a book" << std::endl;
+            }
+        });
+    });
+    reportStats(label("findBook", size, ("t=" + std::to_string(threads)).c_str()), stats, LOOKUPS_PER_RUN);
+}
+
+void benchBuyBook(QuantumBookstore& store, size_t size, size_t threads) {
+    const BenchOptions& options = benchOptions();
+    std::vector<std::string> queries = makeQueries(size, Mix::Mixed, true);
+    BenchStats stats = measure(options.warmups, options.runs, [&]() {
+        runSplit(threads, PURCHASES_PER_RUN, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                store.buyBook(queries[i % QUERY_POOL], 1, "bench@example.com", "Cairo");
+            }
+        });
+    });
+    reportStats(label("buyBook", size, ("t=" + std::to_string(threads)).c_str()), stats, PURCHASES_PER_RUN);
+}
+
+// Checkout while a report thread scans catalog views back to back; the
+// scans hold no locks, so buyBook should stay close to its plain rate
+void benchBuyDuringScan(QuantumBookstore& store, size_t size, size_t threads) {
+    const BenchOptions& options = benchOptions();
+    std::vector<std::string> queries = makeQueries(size, Mix::Mixed, true);
+    std::atomic<bool> done{false};
+    std::atomic<size_t> scans{0};
+    std::thread scanner([&]() {
+        while (!done.load(std::memory_order_relaxed)) {
+            CatalogView view = store.readView();
+            double total = 0;
+            for (const Book* book : view) {
+                total += book->getPrice();
+            }
+            scans.fetch_add(total >= 0, std::memory_order_relaxed);
+        }
+    });
+    BenchStats stats = measure(options.warmups, options.runs, [&]() {
+        runSplit(threads, PURCHASES_PER_RUN, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                store.buyBook(queries[i % QUERY_POOL], 1, "bench@example.com", "Cairo");
+            }
+        });
+    });
+    done.store(true);
+    scanner.join();
+    std::string detail = "t=" + std::to_string(threads) + "+scan/" + std::to_string(scans.load()) + "scans";
+    reportStats(label("buyBook", size, detail.c_str()), stats, PURCHASES_PER_RUN);
+}
+
+// Refused purchases against sales: with tryBuyBook a sold-out or unknown
+// book should cost about as much as a sale, while buyBook pays for
+// formatting the message and unwinding
+void benchBuyOutcomes(QuantumBookstore& store, size_t size) {
+    const BenchOptions& options = benchOptions();
+    std::vector<std::string> queries = makeQueries(size, Mix::Paper, true);
+    std::vector<std::string> unknown;
+    for (size_t i = 0; i < QUERY_POOL; ++i) {
+        unknown.push_back(isbnFor(size + i));
+    }
+    QuantumBookstore soldOut;
+    for (size_t i = 0; i < size; ++i) {
+        soldOut.addBook(std::make_unique<PaperBook>(isbnFor(i), "Sold Out", 2020, 20.0, "Author", 0));
+    }
+    
+    auto run = [&](const char* detail, QuantumBookstore& target, const std::vector<std::string>& isbns,
+                   bool throwing) {
+        size_t refused = 0;
+        BenchStats stats = measure(options.warmups, options.runs, [&]() {
+            refused = 0;
+            for (size_t i = 0; i < PURCHASES_PER_RUN; ++i) {
+                const std::string& isbn = isbns[i % QUERY_POOL];
+                if (throwing) {
+                    try {
+                        target.buyBook(isbn, 1, "bench@example.com", "Cairo");
+                    } catch (const std::runtime_error&) {
+                        ++refused;
+                    }
+                } else {
+                    refused += !target.tryBuyBook(isbn, 1, "bench@example.com", "Cairo");
+                }
+            }
+        });
+        reportStats(label("buyOutcome", size, detail), stats, PURCHASES_PER_RUN);
+        return refused;
+    };
+    run("sold/buyBook", store, queries, true);
+    run("sold/tryBuyBook", store, queries, false);
+    run("soldOut/buyBook", soldOut, queries, true);
+    size_t refused = run("soldOut/tryBuyBook", soldOut, queries, false);
+    run("unknown/buyBook", store, unknown, true);
+    refused += run("unknown/tryBuyBook", store, unknown, false);
+    if (refused != 2 * PURCHASES_PER_RUN) {
+        std::cerr << "tryBuyBook sold a book it should have refused" << std::endl;
+    }
+}
+
+} // namespace
+
+void runStoreBenchmarks() {
+    const BenchOptions& options = benchOptions();
+    std::cout << "--- Store operations (" << options.warmups << " warm-up + " << options.runs
+              << " timed runs, median and range) ---" << std::endl;
+    // Per-operation messages would dominate the timings
+    LogLevel previousLevel = Logger::global().getLevel();
+    Logger::global().setLevel(LogLevel::Warning);
+
+    for (size_t size : options.sizes) {
+        for (Mix mix : {Mix::Paper, Mix::Mixed}) {
+            benchAddBook(size, mix);
+        }
+        std::unique_ptr<QuantumBookstore> store = makeStore(size, Mix::Mixed);
+        for (size_t threads : options.threads) {
+            benchFindBook(*store, size, threads);
+        }
+        for (size_t threads : options.threads) {
+            benchBuyBook(*store, size, threads);
+        }
+        for (size_t threads : options.threads) {
+            benchBuyDuringScan(*store, size, threads);
+        }
+        benchBuyOutcomes(*store, size);
+        benchPrintInventory(*store, size);
+        benchExportMetrics(*store, size);
+        store.reset();
+        for (Mix mix : {Mix::Paper, Mix::Mixed}) {
+            benchRemoveOutdated(size, mix);
+        }
+        benchRemoveOutdatedBatched(size, 1024);
+    }
+
+    Logger::global().setLevel(previousLevel);
+}
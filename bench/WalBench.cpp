@@ -0,0 +1,68 @@
+#include "Benchmarks.h"
+#include "../include/Logger.h"
+#include "../include/QuantumBookstore.h"
+#include <cstdio>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+constexpr size_t BOOK_COUNT = 1000;
+constexpr size_t PURCHASES = 100000;
+
+std::string isbnFor(size_t i) {
+    return "978-" + std::to_string(1000000000 + i);
+}
+
+// Durable single-copy purchases from the given number of buyer threads
+void timePurchases(const std::string& name, const std::string& path, size_t threads, WalConfig config) {
+    std::remove(path.c_str());
+    QuantumBookstore store;
+    for (size_t i = 0; i < BOOK_COUNT; ++i) {
+        store.addPaperBook(isbnFor(i), "Durable Book", 2020, 10.0, "Some Author", 1000000);
+    }
+    store.openWriteAheadLog(path, config);
+    
+    size_t perThread = PURCHASES / threads;
+    double millis = timeBestOf(1, [&]() {
+        std::vector<std::thread> buyers;
+        for (size_t t = 0; t < threads; ++t) {
+            buyers.emplace_back([&store, t, perThread]() {
+                for (size_t i = 0; i < perThread; ++i) {
+                    store.buyBook(isbnFor((t * perThread + i) % BOOK_COUNT), 1, "buyer@example.com", "Cairo");
+                }
+            });
+        }
+        for (auto& buyer : buyers) {
+            buyer.join();
+        }
+    });
+    reportResult(name, millis, perThread * threads);
+}
+
+} // namespace
+
+void runWalBenchmarks() {
+    std::cout << "--- Write-ahead log (" << PURCHASES << " durable purchases, fdatasync per batch) ---" << std::endl;
+    LogLevel previousLevel = Logger::global().getLevel();
+    Logger::global().setLevel(LogLevel::Warning);
+    std::string path = (std::filesystem::temp_directory_path() / "quantum_bookstore_bench.wal").string();
+    
+    WalConfig immediate;
+    WalConfig delayed;
+    delayed.commitDelay = std::chrono::microseconds(500);
+    WalConfig unsynced;
+    unsynced.syncToDisk = false;
+    
+    timePurchases("wal/1 buyer (sync per sale)", path, 1, immediate);
+    timePurchases("wal/16 buyers", path, 16, immediate);
+    timePurchases("wal/64 buyers", path, 64, immediate);
+    timePurchases("wal/64 buyers, 500us budget", path, 64, delayed);
+    timePurchases("wal/64 buyers, no fdatasync", path, 64, unsynced);
+    
+    std::remove(path.c_str());
+    Logger::global().setLevel(previousLevel);
+}
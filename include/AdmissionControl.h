@@ -0,0 +1,175 @@
+#pragma once
+#include "QuantumBookstore.h"
+#include "StoreResult.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Request classes admitted separately, so reads keep flowing while
+// purchases queue
+enum class RequestClass : uint8_t {
+    Read,
+    Purchase,
+    Count
+};
+
+constexpr size_t REQUEST_CLASS_COUNT = static_cast<size_t>(RequestClass::Count);
+
+// Admission limits of one request class
+struct ClassLimits {
+    // Concurrent calls allowed. The limit adapts between minLimit and
+    // maxLimit: a call that finishes within latencyTarget while the class
+    // is busy adds 1/limit, and one that takes longer multiplies it by
+    // backoff (at most once per latencyTarget).
+    size_t initialLimit = 16;
+    size_t minLimit = 1;
+    size_t maxLimit = 256;
+    std::chrono::microseconds latencyTarget{2000};
+    double backoff = 0.9;
+    // Calls over the limit wait in arrival order; once queueCapacity are
+    // waiting, more are shed at once, and a waiter is shed once it has
+    // waited maxQueueWait or its own deadline has passed
+    size_t queueCapacity = 128;
+    std::chrono::microseconds maxQueueWait{10000};
+};
+
+struct AdmissionConfig {
+    ClassLimits reads{64, 8, 1024, std::chrono::microseconds(1000), 0.9, 256, std::chrono::microseconds(5000)};
+    ClassLimits purchases{16, 1, 256, std::chrono::microseconds(5000), 0.9, 128, std::chrono::microseconds(20000)};
+};
+
+// Counters of one request class
+struct AdmissionStats {
+    double limit = 0;
+    int64_t inFlight = 0;
+    size_t queued = 0;
+    uint64_t admitted = 0;
+    uint64_t shedOverloaded = 0;  // queue full
+    uint64_t shedDeadline = 0;    // waited too long
+    uint64_t fastFailed = 0;      // refused before queueing (sold out)
+};
+
+// Adaptive concurrency limits with bounded wait queues, one per request
+// class. Admission below the limit is a compare-and-swap; a call over it
+// waits, and a finishing call hands its slot straight to the oldest
+// waiter. The limit follows the service latency of admitted calls, so the
+// queue, not the store, absorbs a burst.
+class AdmissionController {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    // Held while an admitted call runs; releasing it feeds the call's
+    // latency to the limit
+    class [[nodiscard]] Permit {
+    public:
+        Permit() = default;
+        Permit(Permit&& other) noexcept;
+        Permit& operator=(Permit&& other) noexcept;
+        ~Permit() { release(); }
+
+        explicit operator bool() const { return controller != nullptr; }
+        // Overloaded or DeadlineExceeded for a refused permit
+        StoreFailure failure() const { return refusal; }
+        void release();
+
+    private:
+        friend class AdmissionController;
+        AdmissionController* controller = nullptr;
+        RequestClass requestClass = RequestClass::Read;
+        Clock::time_point start;
+        StoreFailure refusal = StoreFailure::Overloaded;
+    };
+
+    // Throws std::invalid_argument for limits that admit nothing or a
+    // backoff outside (0, 1)
+    explicit AdmissionController(AdmissionConfig config = AdmissionConfig());
+
+    AdmissionController(const AdmissionController&) = delete;
+    AdmissionController& operator=(const AdmissionController&) = delete;
+
+    // Admit a call, waiting in the class's queue until deadline at the
+    // latest; a refused permit says why
+    Permit admit(RequestClass requestClass, Clock::time_point deadline = Clock::time_point::max());
+
+    // Count a call refused before admission
+    void countFastFail(RequestClass requestClass);
+
+    AdmissionStats getStats(RequestClass requestClass) const;
+
+private:
+    struct Waiter {
+        std::condition_variable ready;
+        bool granted = false;
+    };
+
+    struct alignas(64) ClassState {
+        ClassLimits limits;
+        std::atomic<int64_t> inFlight{0};
+        std::atomic<uint64_t> limitFixed{0};  // limit in 1/1024ths
+        std::atomic<size_t> queued{0};
+        std::atomic<int64_t> lastDecrease{0};  // Clock ticks
+        std::atomic<uint64_t> admitted{0};
+        std::atomic<uint64_t> shedOverloaded{0};
+        std::atomic<uint64_t> shedDeadline{0};
+        std::atomic<uint64_t> fastFailed{0};
+        std::mutex mutex;  // guards waiters
+        std::deque<Waiter*> waiters;
+    };
+
+    ClassState classes[REQUEST_CLASS_COUNT];
+
+    ClassState& state(RequestClass requestClass) { return classes[static_cast<size_t>(requestClass)]; }
+    void release(RequestClass requestClass, Clock::time_point start);
+    void adapt(ClassState& state, Clock::duration latency, int64_t inFlight);
+    // Hand free slots to waiters in order; the mutex must be held
+    void grantWaiters(ClassState& state);
+};
+
+// The store's request-serving calls behind admission control: lookups and
+// search in the Read class, checkout in the Purchase class. Purchases of
+// a sold-out ISBN fail at once, without waiting for a slot. Shed calls
+// fail with StoreFailure::Overloaded or DeadlineExceeded; everything
+// else goes straight to store().
+class StoreGate {
+public:
+    using Clock = AdmissionController::Clock;
+
+    explicit StoreGate(QuantumBookstore& store, AdmissionConfig config = AdmissionConfig());
+
+    StoreResult<double> tryBuyBook(const std::string& isbn, int quantity,
+                                   const std::string& customerEmail,
+                                   const std::string& shippingAddress,
+                                   Clock::time_point deadline = Clock::time_point::max());
+    double buyBook(const std::string& isbn, int quantity,
+                   const std::string& customerEmail,
+                   const std::string& shippingAddress,
+                   Clock::time_point deadline = Clock::time_point::max());
+    std::vector<double> buyBooks(const std::vector<OrderLine>& lines,
+                                 const std::string& customerEmail,
+                                 const std::string& shippingAddress,
+                                 Clock::time_point deadline = Clock::time_point::max());
+
+    // nullptr for an unknown ISBN
+    StoreResult<Book*> tryFindBook(const std::string& isbn, Clock::time_point deadline = Clock::time_point::max());
+    Book* findBook(const std::string& isbn, Clock::time_point deadline = Clock::time_point::max());
+    void findBooks(const std::vector<std::string_view>& isbns,
+                   const std::function<void(size_t, const Book*)>& visit,
+                   Clock::time_point deadline = Clock::time_point::max());
+    std::vector<SearchHit> searchBooks(const std::string& query, size_t limit = 10,
+                                       Clock::time_point deadline = Clock::time_point::max());
+
+    QuantumBookstore& store() { return bookstore; }
+    AdmissionStats getStats(RequestClass requestClass) const { return controller.getStats(requestClass); }
+
+private:
+    QuantumBookstore& bookstore;
+    AdmissionController controller;
+
+    // Admit a call or raise why it was shed
+    AdmissionController::Permit admitOrThrow(RequestClass requestClass, Clock::time_point deadline);
+};
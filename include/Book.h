@@ -1,21 +1,86 @@
 #pragma once
+#include <cstdint>
 #include <string>
+#include <string_view>
 #include <memory>
 
+// Closed tag for the built-in book types; lets hot paths dispatch with a
+// switch instead of RTTI. Types added outside this file report Other.
+enum class BookKind : uint8_t {
+    Paper,
+    EBook,
+    Showcase,
+    Other
+};
+
+// Constant display name for a built-in kind (empty for Other)
+constexpr std::string_view bookKindName(BookKind kind) {
+    switch (kind) {
+        case BookKind::Paper: return "Paper Book";
+        case BookKind::EBook: return "EBook";
+        case BookKind::Showcase: return "Showcase/Demo Book";
+        case BookKind::Other: break;
+    }
+    return {};
+}
+
+// How a sold book reaches the customer
+enum class DeliveryChannel {
+    Shipping,   // physical delivery through ShippingService
+    Email,      // digital delivery through MailService
+    Custom      // type-specific delivery in processPurchase()
+};
+
+// Strings for a book whose text lives in storage that outlives it, such as
+// a BookArena; the book only borrows them
+struct BookText {
+    std::string_view isbn;
+    std::string_view title;
+    std::string_view author;
+};
+
 // Abstract base class for all book types
 class Book {
 protected:
-    std::string isbn;
-    std::string title;
-    int yearPublished;
+    // Text fields as pointer + length so the base fits one cache line.
+    // Heap-built books own one block holding all of them; arena books borrow.
+    const char* isbnText;
+    const char* titleText;
+    const char* authorText;
     double price;
-    std::string authorName;
+    int yearPublished;
+    uint32_t titleLength;
+    uint16_t authorLength;
+    uint8_t isbnLength;
+    BookKind kind;
+    bool ownsText = false;
+    bool arenaAllocated = false;  // set by BookArena; see BookDeleter
+
+private:
+    // A built-in kind lets the store static_cast to its type, so only those
+    // types may claim one. Heap-built books may carry trailing text (e.g.
+    // an ebook's file type) right after the author in the owned block.
+    Book(const std::string& isbn, const std::string& title, int year, double price, 
+         const std::string& author, BookKind kind, std::string_view trailing = {});
+    Book(const BookText& text, int year, double price, BookKind kind);
+    
+    friend class PaperBook;
+    friend class EBook;
+    friend class ShowcaseBook;
 
 public:
+    static constexpr size_t MAX_ISBN_LENGTH = UINT8_MAX;
+    static constexpr size_t MAX_AUTHOR_LENGTH = UINT16_MAX;
+    
+    // Types outside BookTypes.h report BookKind::Other
     Book(const std::string& isbn, const std::string& title, int year, 
          double price, const std::string& author);
+    Book(const BookText& text, int year, double price);
+    
+    virtual ~Book();
     
-    virtual ~Book() = default;
+    Book(const Book&) = delete;
+    Book& operator=(const Book&) = delete;
     
     // Pure virtual function to be implemented by derived classes
     virtual void processPurchase(const std::string& customerEmail, 
@@ -24,12 +89,32 @@ public:
     virtual bool canBeSold() const = 0;
     virtual std::string getType() const = 0;
     
+    // Lets batch checkout group deliveries; Custom falls back to processPurchase()
+    virtual DeliveryChannel getDeliveryChannel() const;
+    
     // Getters
-    const std::string& getISBN() const;
-    const std::string& getTitle() const;
+    std::string_view getISBN() const;
+    std::string_view getTitle() const;
     int getYearPublished() const;
     double getPrice() const;
-    const std::string& getAuthorName() const;
+    std::string_view getAuthorName() const;
+    BookKind getKind() const { return kind; }
+    bool isArenaAllocated() const { return arenaAllocated; }
     
     bool isOutdated(int currentYear, int yearsThreshold) const;
+    
+    friend class BookArena;
 };
+
+// Deletes heap-built books; arena books are only destroyed, their memory is
+// released with the arena. Converts from default_delete so make_unique
+// results can be passed wherever a BookPtr is expected.
+struct BookDeleter {
+    BookDeleter() = default;
+    template <typename T>
+    BookDeleter(const std::default_delete<T>&) {}
+    
+    void operator()(Book* book) const;
+};
+
+using BookPtr = std::unique_ptr<Book, BookDeleter>;
@@ -0,0 +1,100 @@
+#pragma once
+#include "BookTypes.h"
+#include "EpochReclaimer.h"
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+
+// Monotonic bump allocator: memory is carved out of large slabs and only
+// released, all at once, when the allocator is destroyed
+class MonotonicSlabs {
+public:
+    static constexpr size_t DEFAULT_SLAB_SIZE = 64 * 1024;  // below malloc's mmap threshold, so freed heap is reused
+    
+    explicit MonotonicSlabs(size_t slabSize = DEFAULT_SLAB_SIZE);
+    
+    MonotonicSlabs(const MonotonicSlabs&) = delete;
+    MonotonicSlabs& operator=(const MonotonicSlabs&) = delete;
+    
+    void* allocate(size_t size, size_t alignment);
+    // Copy text into the slabs; the view stays valid for the allocator's lifetime
+    std::string_view store(std::string_view text);
+    
+    size_t bytesReserved() const;
+    
+private:
+    size_t slabSize;
+    std::vector<std::unique_ptr<std::byte[]>> slabs;
+    std::byte* cursor = nullptr;
+    size_t remaining = 0;
+    size_t reserved = 0;
+};
+
+// Stores each distinct string once; equal strings intern to the same view
+class StringPool {
+public:
+    std::string_view intern(std::string_view text);
+    size_t size() const;
+    size_t bytesReserved() const;
+    
+private:
+    MonotonicSlabs chars{64 * 1024};
+    std::unordered_set<std::string_view> strings;
+};
+
+// Pool-backed storage for built-in book types. Each type gets its own
+// monotonic slabs, authors and file types are interned, and ISBNs and titles
+// are packed into one character heap, so loading a catalog costs a handful
+// of large allocations instead of several per book. Books made here must not
+// outlive the arena; the whole arena is freed at once on destruction.
+class BookArena {
+public:
+    BookArena() = default;
+    
+    BookArena(const BookArena&) = delete;
+    BookArena& operator=(const BookArena&) = delete;
+    
+    BookPtr makePaperBook(std::string_view isbn, std::string_view title, int year, 
+                          double price, std::string_view author, int stock);
+    BookPtr makeEBook(std::string_view isbn, std::string_view title, int year, 
+                      double price, std::string_view author, std::string_view fileType);
+    BookPtr makeShowcaseBook(std::string_view isbn, std::string_view title, int year, 
+                             double price, std::string_view author);
+    
+    // Variants for text that already lives in storage kept alive by
+    // retain(), e.g. a mapped snapshot; nothing is copied or interned
+    BookPtr makePaperBook(const BookText& text, int year, double price, int stock);
+    BookPtr makeEBook(const BookText& text, int year, double price, std::string_view fileType);
+    BookPtr makeShowcaseBook(const BookText& text, int year, double price);
+    // Keep storage alive until the arena is destroyed
+    void retain(std::shared_ptr<const void> storage);
+    
+    // Heap copy of an arena book so it can outlive the arena (heap books are
+    // returned as is). The arena copy is retired to epochs, so readers and
+    // reservations still pinned against it stay valid; its slot is not
+    // reused. The arena must outlive epochs.
+    BookPtr detach(BookPtr book, EpochReclaimer& epochs);
+    
+    size_t getBookCount() const;
+    size_t getInternedCount() const;
+    size_t bytesReserved() const;
+    
+private:
+    mutable std::mutex mutex;
+    std::vector<std::shared_ptr<const void>> retained;  // released after everything below
+    MonotonicSlabs paperSlabs;
+    MonotonicSlabs ebookSlabs;
+    MonotonicSlabs showcaseSlabs;
+    MonotonicSlabs textHeap;  // ISBNs and titles, back to back
+    StringPool authors;
+    StringPool fileTypes;
+    size_t bookCount = 0;
+    
+    BookText storeText(std::string_view isbn, std::string_view title, std::string_view author);
+    
+    template <typename T, typename... Args>
+    BookPtr construct(MonotonicSlabs& slabs, Args&&... args);
+};
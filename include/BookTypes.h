@@ -1,5 +1,7 @@
 #pragma once
 #include "Book.h"
+#include "StockCounter.h"
+#include <type_traits>
 
 // Forward declarations for services
 class ShippingService;
@@ -8,39 +10,61 @@ class MailService;
 // Paper book implementation
 class PaperBook : public Book {
 private:
-    int stock;
+    StockCounter stock;
 
 public:
+    static constexpr std::chrono::seconds DEFAULT_HOLD_TTL{900};
+    
     PaperBook(const std::string& isbn, const std::string& title, int year,
               double price, const std::string& author, int stock);
+    PaperBook(const BookText& text, int year, double price, int stock);
     
     void processPurchase(const std::string& customerEmail, 
                         const std::string& shippingAddress) const override;
     
     bool canBeSold() const override;
     std::string getType() const override;
+    DeliveryChannel getDeliveryChannel() const override;
     
     int getStock() const;
     void reduceStock(int quantity);
+    // Put units back, e.g. of a sale that could not be delivered
+    void restock(int quantity);
     bool hasEnoughStock(int quantity) const;
+    
+    // Hold stock while payment runs; commit or release the returned handle.
+    // Returns an empty handle if the stock cannot be reserved.
+    StockReservation tryReserve(int quantity, 
+                                StockCounter::Clock::duration ttl = DEFAULT_HOLD_TTL);
+    int getHeldStock() const;
+    // Available plus held, read as one value
+    int getStockOnHand() const;
+    // Return stock of reservations abandoned past their deadline
+    size_t expireHolds(StockCounter::Clock::time_point now = StockCounter::Clock::now());
 };
 
 // EBook implementation
 class EBook : public Book {
 private:
-    std::string fileType;
+    uint8_t fileTypeLength;  // declared first so it packs into Book's tail padding
+    const char* fileTypeText;
 
 public:
+    static constexpr size_t MAX_FILE_TYPE_LENGTH = UINT8_MAX;
+    
     EBook(const std::string& isbn, const std::string& title, int year,
           double price, const std::string& author, const std::string& fileType);
+    // The file type is borrowed like the rest of the text
+    EBook(const BookText& text, int year, double price, std::string_view fileType);
     
     void processPurchase(const std::string& customerEmail, 
                         const std::string& shippingAddress) const override;
     
     bool canBeSold() const override;
     std::string getType() const override;
+    DeliveryChannel getDeliveryChannel() const override;
     
-    const std::string& getFileType() const;
+    std::string_view getFileType() const;
 };
 
 // Showcase/Demo book implementation
@@ -48,6 +72,7 @@ class ShowcaseBook : public Book {
 public:
     ShowcaseBook(const std::string& isbn, const std::string& title, int year,
                  double price, const std::string& author);
+    ShowcaseBook(const BookText& text, int year, double price);
     
     void processPurchase(const std::string& customerEmail, 
                         const std::string& shippingAddress) const override;
@@ -55,3 +80,47 @@ public:
     bool canBeSold() const override;
     std::string getType() const override;
 };
+
+// Combine lambdas into one visitor for visitBook
+template <typename... Fns>
+struct BookVisitor : Fns... {
+    using Fns::operator()...;
+};
+template <typename... Fns>
+BookVisitor(Fns...) -> BookVisitor<Fns...>;
+
+// RTTI-free dispatch on the book's kind tag. The visitor is called with the
+// concrete PaperBook/EBook/ShowcaseBook, or with Book& for other types.
+template <typename BookT, typename Visitor>
+decltype(auto) visitBook(BookT& book, Visitor&& visitor) {
+    static_assert(std::is_same_v<std::remove_const_t<BookT>, Book>, "visitBook expects a Book");
+    constexpr bool isConst = std::is_const_v<BookT>;
+    using PaperT = std::conditional_t<isConst, const PaperBook, PaperBook>;
+    using EBookT = std::conditional_t<isConst, const EBook, EBook>;
+    using ShowcaseT = std::conditional_t<isConst, const ShowcaseBook, ShowcaseBook>;
+    
+    switch (book.getKind()) {
+        case BookKind::Paper: return visitor(static_cast<PaperT&>(book));
+        case BookKind::EBook: return visitor(static_cast<EBookT&>(book));
+        case BookKind::Showcase: return visitor(static_cast<ShowcaseT&>(book));
+        case BookKind::Other: break;
+    }
+    return visitor(book);
+}
+
+// Tag-checked downcasts; nullptr when the book is of another kind
+inline PaperBook* asPaperBook(Book* book) {
+    return (book && book->getKind() == BookKind::Paper) ? static_cast<PaperBook*>(book) : nullptr;
+}
+
+inline const PaperBook* asPaperBook(const Book* book) {
+    return (book && book->getKind() == BookKind::Paper) ? static_cast<const PaperBook*>(book) : nullptr;
+}
+
+inline const EBook* asEBook(const Book* book) {
+    return (book && book->getKind() == BookKind::EBook) ? static_cast<const EBook*>(book) : nullptr;
+}
+
+// Heap-built copy of a built-in book, with a paper book's available stock;
+// nullptr for other book types, which cannot be copied generically
+BookPtr copyBook(const Book& book);
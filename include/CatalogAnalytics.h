@@ -0,0 +1,149 @@
+#pragma once
+#include "Book.h"
+#include "ColumnarCatalog.h"
+#include "TaskPool.h"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Numeric value of a book that queries aggregate
+enum class BookMeasure : uint8_t {
+    Price,
+    Year,
+    Stock,           // available stock; paper books only
+    InventoryValue   // price * available stock; paper books only
+};
+
+// Grouping column of a query
+enum class GroupBy : uint8_t {
+    Kind,    // "paper", "ebook", "showcase", "other"
+    Year,    // "1994"
+    Decade,  // "1990s"
+    Author
+};
+
+enum class AggregateOp : uint8_t {
+    Count,     // books in the group; the measure is ignored
+    Sum,
+    Min,
+    Max,
+    Mean,
+    Quantile   // approximate, see QuantileSketch
+};
+
+// Mergeable quantile sketch with bounded relative error, in the style of
+// DDSketch: values are counted in logarithmic buckets of ratio
+// (1 + a) / (1 - a), so a quantile is returned within relative accuracy a
+// of the value at that rank, whatever the distribution.
+class QuantileSketch {
+public:
+    explicit QuantileSketch(double relativeAccuracy = 0.01);
+
+    void add(double value);
+    void merge(const QuantileSketch& other);
+    uint64_t count() const { return total; }
+    // Value at rank q * (count - 1) for q in [0, 1]; NaN if empty
+    double quantile(double q) const;
+
+private:
+    // Counts of buckets offset, offset + 1, ...
+    struct Buckets {
+        int32_t offset = 0;
+        std::vector<uint64_t> counts;
+
+        void add(int32_t index, uint64_t count);
+    };
+
+    double gamma;
+    double inverseLogGamma;
+    Buckets positive;
+    Buckets negative;   // by magnitude
+    uint64_t zeros = 0;
+    uint64_t total = 0;
+
+    int32_t indexOf(double magnitude) const;
+    double valueOf(int32_t index) const;
+};
+
+// Filter, grouping and aggregates of an analytics query; build one with
+// the chained setters. Books must pass every filter. Aggregates over a
+// measure only see books that have it (stock on paper books), and are NaN
+// in a group where none does.
+class CatalogQuery {
+public:
+    // Filters
+    CatalogQuery& ofKind(BookKind kind);
+    CatalogQuery& publishedBetween(int fromYear, int toYear);
+    CatalogQuery& pricedBetween(double minPrice, double maxPrice);
+    // Runs per book after the column filters, so keep it cheap and thread-safe
+    CatalogQuery& where(std::function<bool(const Book&)> predicate);
+
+    // Group by up to one column of each kind; groups are keyed by all of them.
+    // Throws std::invalid_argument if the column is already grouped on.
+    CatalogQuery& groupBy(GroupBy column);
+
+    CatalogQuery& count();
+    CatalogQuery& sum(BookMeasure measure);
+    CatalogQuery& min(BookMeasure measure);
+    CatalogQuery& max(BookMeasure measure);
+    CatalogQuery& mean(BookMeasure measure);
+    // Throws std::invalid_argument unless q is in [0, 1]
+    CatalogQuery& quantile(BookMeasure measure, double q);
+
+    // Run on at most this many threads; 0 = all of the store's pool
+    CatalogQuery& threads(size_t count);
+
+private:
+    friend class CatalogAnalytics;
+
+    struct Aggregate {
+        AggregateOp op;
+        BookMeasure measure;
+        double q;
+    };
+
+    bool filterKind = false;
+    BookKind kind = BookKind::Paper;
+    int fromYear = INT32_MIN;
+    int toYear = INT32_MAX;
+    double minPrice = -std::numeric_limits<double>::infinity();
+    double maxPrice = std::numeric_limits<double>::infinity();
+    std::vector<std::function<bool(const Book&)>> predicates;
+    std::vector<GroupBy> grouping;
+    std::vector<Aggregate> aggregates;
+    size_t maxThreads = 0;
+};
+
+// One group of a query result
+struct AnalyticsGroup {
+    std::vector<std::string> key;   // one label per groupBy column, in query order
+    uint64_t books = 0;             // books in the group
+    std::vector<double> values;     // one per aggregate, in query order
+};
+
+struct AnalyticsResult {
+    std::vector<std::string> columns;    // aggregate names, e.g. "sum(inventory_value)", "p99(price)"
+    std::vector<AnalyticsGroup> groups;  // ordered by the kind/year/decade columns, then author; one if ungrouped
+
+    // Group whose key labels are key, joined by '/' ("paper/1990s"); the
+    // ungrouped result has the empty key. nullptr if no book fell in it.
+    const AnalyticsGroup* find(std::string_view key) const;
+};
+
+// Runs CatalogQuery as a parallel reduction over columnar partitions: the
+// rows are split into fixed-size ranges claimed by the pool's workers, each
+// worker folds its ranges into its own per-group partial aggregates, and
+// the partials are merged once at the end. Rows are read straight from the
+// columns (Book records only for stock, authors and custom predicates), so
+// nothing is materialized per row.
+class CatalogAnalytics {
+public:
+    static constexpr size_t ROWS_PER_TASK = 32768;
+
+    static AnalyticsResult run(const CatalogQuery& query, const std::vector<const ColumnarCatalog*>& partitions,
+                               TaskPool& pool);
+};
@@ -0,0 +1,140 @@
+#pragma once
+#include "Book.h"
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+struct iovec;
+
+enum class ExportFormat {
+    Csv,        // header row, then the importer's columns; re-importable
+    JsonLines,  // one flat JSON object per book with the importer's keys
+    Binary      // BINARY_MAGIC, then one ExportRecordHeader and its text per book
+};
+
+// Fixed part of a binary export record, in host byte order. The ISBN,
+// title, author and (ebooks) file type follow it back to back.
+struct ExportRecordHeader {
+    uint32_t titleLength;
+    uint32_t authorLength;
+    int32_t year;
+    int32_t stock;   // paper books only
+    double price;
+    uint8_t kind;    // BookKind
+    uint8_t isbnLength;
+    uint8_t fileTypeLength;
+    uint8_t reserved[5];
+};
+
+// Destination of exported bytes. write() gets the filled buffer blocks of
+// one flush, in order; throw to abort the export.
+class ExportSink {
+public:
+    virtual ~ExportSink() = default;
+    virtual void write(const iovec* blocks, size_t count) = 0;
+};
+
+// Writes to a file descriptor with writev; the caller owns the descriptor.
+// Throws std::runtime_error on write errors.
+class FdSink : public ExportSink {
+public:
+    explicit FdSink(int fd) : fd(fd) {}
+    void write(const iovec* blocks, size_t count) override;
+
+private:
+    int fd;
+};
+
+// Collects everything in memory
+class BufferSink : public ExportSink {
+public:
+    void write(const iovec* blocks, size_t count) override;
+    const std::string& data() const { return buffer; }
+    void clear() { buffer.clear(); }
+
+private:
+    std::string buffer;
+};
+
+// Calls a function with each block
+class CallbackSink : public ExportSink {
+public:
+    using Callback = std::function<void(std::string_view)>;
+    explicit CallbackSink(Callback callback) : callback(std::move(callback)) {}
+    void write(const iovec* blocks, size_t count) override;
+
+private:
+    Callback callback;
+};
+
+// Resume point of a paginated export. Pages continue after the ISBN of the
+// last row written, so books added or removed between pages do not shift
+// the rows of later pages.
+struct ExportCursor {
+    uint64_t afterKey = 0;     // packed ISBN of the last row written
+    size_t rowsExported = 0;   // over all pages so far; 0 before the first page
+    bool finished = false;     // the last page reached the end of the catalog
+    bool headerWritten = false;  // a page has written the format's header
+};
+
+// Formats books into a few large blocks that are reused for the whole
+// export, and hands every BLOCKS_PER_FLUSH filled blocks to the sink in one
+// vectored write. Numbers are rendered with std::to_chars; prices in their
+// shortest round-trip form. Books of custom types are written with their
+// getType() name and no kind-specific fields.
+class CatalogExporter {
+public:
+    static constexpr size_t BLOCK_BYTES = 256 << 10;
+    static constexpr size_t BLOCKS_PER_FLUSH = 8;
+    static constexpr std::string_view BINARY_MAGIC{"QBEXPRT1", 8};
+
+    CatalogExporter(ExportSink& sink, ExportFormat format);
+    ~CatalogExporter();
+
+    CatalogExporter(const CatalogExporter&) = delete;
+    CatalogExporter& operator=(const CatalogExporter&) = delete;
+
+    // CSV header row or binary magic; nothing for JSON Lines
+    void writeHeader();
+    void write(const Book& book);
+    // Hand everything buffered to the sink; call before destroying the exporter
+    void flush();
+
+    size_t bytesWritten() const { return flushedBytes + pendingBytes(); }
+
+private:
+    ExportSink& sink;
+    ExportFormat format;
+    std::vector<std::unique_ptr<char[]>> blocks;
+    size_t currentBlock = 0;
+    size_t blockFill = 0;
+    size_t flushedBytes = 0;
+
+    size_t pendingBytes() const { return currentBlock * BLOCK_BYTES + blockFill; }
+    // Copies into the current block inline; spilling into the next block
+    // or flushing is out of line
+    void append(const char* data, size_t length) {
+        if (length <= BLOCK_BYTES - blockFill) {
+            std::memcpy(blocks[currentBlock].get() + blockFill, data, length);
+            blockFill += length;
+        } else {
+            appendSpilling(data, length);
+        }
+    }
+    void append(std::string_view text) { append(text.data(), text.size()); }
+    void appendChar(char c) { append(&c, 1); }
+    void appendSpilling(const char* data, size_t length);
+    template <typename T>
+    void appendNumber(T value);
+    void appendPrice(double price);
+    void appendCsvField(std::string_view text);
+    void appendJsonString(std::string_view text);
+    void writeCsv(const Book& book);
+    void writeJson(const Book& book);
+    void writeBinary(const Book& book);
+};
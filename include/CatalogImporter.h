@@ -0,0 +1,60 @@
+#pragma once
+#include "BookArena.h"
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+enum class ImportFormat {
+    Auto,       // by extension: .jsonl/.ndjson are JSON Lines, anything else CSV
+    Csv,        // header row naming the columns, then one book per line
+    JsonLines   // one flat JSON object per line
+};
+
+// Columns (CSV header names or JSON keys): type (paper, ebook or showcase),
+// isbn, title, author, year, price, stock (paper books) and file_type or
+// fileType (ebooks). Records may not span lines.
+struct ImportOptions {
+    ImportFormat format = ImportFormat::Auto;
+    size_t threads = 0;              // 0 = one per hardware thread
+    size_t chunkBytes = 4 << 20;     // parse work unit; chunks end on line boundaries
+};
+
+// A row that was not imported
+struct ImportError {
+    size_t line;          // 1-based line number in the file
+    std::string message;
+};
+
+struct ImportReport {
+    size_t rowsRead = 0;      // non-blank data rows
+    size_t booksAdded = 0;
+    std::vector<ImportError> errors;  // sorted by line
+};
+
+// Parallel catalog file loader. The file is mapped and split into chunks
+// that are parsed concurrently, each into its own BookArena. Rows are then
+// grouped by ISBN and handed to the insert callback from several threads,
+// in file order within each ISBN, so the first of several rows with the
+// same ISBN is the one kept.
+class CatalogImporter {
+public:
+    // Insert a book, returning false if its ISBN is already taken. Called
+    // concurrently, but never concurrently for the same ISBN.
+    using Insert = std::function<bool(BookPtr)>;
+
+    struct Result {
+        ImportReport report;
+        std::vector<Book*> added;
+        std::vector<std::shared_ptr<BookArena>> arenas;  // storage of the added books
+    };
+
+    // Called once with the number of parsed rows before the first insert
+    using Reserve = std::function<void(size_t)>;
+
+    // Throws std::runtime_error if the file cannot be read or a CSV header
+    // lacks a required column; bad rows are reported, not thrown.
+    static Result run(const std::string& path, const ImportOptions& options, 
+                      const Reserve& reserve, const Insert& insert);
+};
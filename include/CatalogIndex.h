@@ -0,0 +1,136 @@
+#pragma once
+#include "Book.h"
+#include "EpochReclaimer.h"
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <map>
+#include <mutex>
+#include <set>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace detail {
+
+template <typename Key>
+Book* indexedBook(const std::pair<const Key, Book*>& entry) { return entry.second; }
+template <typename Key>
+Book* indexedBook(const std::pair<Key, Book*>& entry) { return entry.second; }
+inline Book* indexedBook(Book* book) { return book; }
+
+template <typename Key>
+bool keyLess(const Key& a, const Key& b) { return a < b; }
+// NaN sorts after every number, so a NaN price keeps the order strict weak
+inline bool keyLess(double a, double b) { return a < b || (!std::isnan(a) && std::isnan(b)); }
+
+// Orders (key, book) entries by key, then book, so one book among many with
+// the same key is erased in O(log n). A bare key compares by key alone, so
+// lower_bound(key) and upper_bound(key) select whole key ranges.
+template <typename Key>
+struct KeyThenBook {
+    using is_transparent = void;
+    bool operator()(const std::pair<Key, Book*>& a, const std::pair<Key, Book*>& b) const {
+        return keyLess(a.first, b.first) || (!keyLess(b.first, a.first) && std::less<Book*>()(a.second, b.second));
+    }
+    bool operator()(const std::pair<Key, Book*>& a, const Key& b) const { return keyLess(a.first, b); }
+    bool operator()(const Key& a, const std::pair<Key, Book*>& b) const { return keyLess(a, b.first); }
+};
+
+} // namespace detail
+
+// Forward iterator over index entries that yields the indexed Book*
+template <typename BaseIterator>
+class BookIterator {
+private:
+    BaseIterator current;
+
+public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = Book*;
+    using difference_type = std::ptrdiff_t;
+    using pointer = Book* const*;
+    using reference = Book*;
+    
+    BookIterator() = default;
+    explicit BookIterator(BaseIterator current) : current(current) {}
+    
+    Book* operator*() const { return detail::indexedBook(*current); }
+    BookIterator& operator++() { ++current; return *this; }
+    BookIterator operator++(int) { BookIterator previous = *this; ++current; return previous; }
+    bool operator==(const BookIterator& other) const { return current == other.current; }
+    bool operator!=(const BookIterator& other) const { return current != other.current; }
+};
+
+// Books an index query matched, copied out under the index's read lock. It
+// pins an epoch taken before the copy, so every book stays valid while the
+// range lives even if it is removed meanwhile, and the store can be
+// modified (books bought, added, removed) while iterating.
+class BookRange {
+private:
+    EpochReclaimer::Guard guard;
+    std::vector<Book*> books;
+
+public:
+    using Iterator = std::vector<Book*>::const_iterator;
+    
+    BookRange(EpochReclaimer::Guard guard, std::vector<Book*> books)
+        : guard(std::move(guard)), books(std::move(books)) {}
+    
+    Iterator begin() const { return books.begin(); }
+    Iterator end() const { return books.end(); }
+    bool empty() const { return books.empty(); }
+    size_t size() const { return books.size(); }
+};
+
+// Secondary indexes maintained alongside the inventory: author, publication
+// year and price, plus the stock-dependent sold-out view. One reader/writer
+// lock guards all of them.
+class CatalogIndex {
+public:
+    // Every index is keyed by (key, book), so removing one book is
+    // O(log n) however many others share its key
+    using AuthorIndex = std::set<std::pair<std::string_view, Book*>,
+                                 detail::KeyThenBook<std::string_view>>;  // views of the books' authors
+    using YearIndex = std::set<std::pair<int, Book*>, detail::KeyThenBook<int>>;
+    using PriceIndex = std::set<std::pair<double, Book*>, detail::KeyThenBook<double>>;
+    using SoldOutIndex = std::unordered_set<Book*>;
+    
+    using AuthorRange = BookRange;
+    using YearRange = BookRange;
+    using PriceRange = BookRange;
+    using SoldOutRange = BookRange;
+    
+    void add(Book* book);
+    // Drop a single book from every index
+    void remove(Book* book);
+    
+    // Split off the oldest books published before the year (at most limit
+    // of them) from the ordered year index and drop those books from the
+    // other indexes. Costs O(removed log n).
+    std::vector<Book*> takePublishedBefore(int year, size_t limit = SIZE_MAX);
+    
+    // Stock-dependent view maintenance
+    void markSoldOut(Book* book);
+    void markInStock(Book* book);
+    
+    // Queries copy out the matching books; the lock is not held after they
+    // return, so a caller that needs the books kept alive pins an epoch first
+    std::vector<Book*> byAuthor(const std::string& author) const;
+    // Books published in [fromYear, toYear]
+    std::vector<Book*> publishedBetween(int fromYear, int toYear) const;
+    // Books priced in [minPrice, maxPrice]; NaN prices are in no range
+    std::vector<Book*> pricedBetween(double minPrice, double maxPrice) const;
+    std::vector<Book*> soldOut() const;
+    
+private:
+    mutable std::shared_mutex mutex;
+    AuthorIndex authors;
+    YearIndex years;
+    PriceIndex prices;
+    SoldOutIndex soldOutBooks;
+};
@@ -0,0 +1,89 @@
+#pragma once
+#include "ChangeFeed.h"
+#include "QuantumBookstore.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+struct ReplicaConfig {
+    size_t shardCount = ShardedInventory::DEFAULT_SHARD_COUNT;
+    // Longest sleep of the tailing thread while caught up; a publish wakes
+    // it sooner
+    std::chrono::microseconds idleWait{10000};
+};
+
+// How far a replica trails its primary
+struct ReplicaStats {
+    uint64_t appliedSequence = 0;    // last change applied
+    uint64_t publishedSequence = 0;  // last change the primary published
+    uint64_t changesApplied = 0;
+    uint64_t gaps = 0;               // times the feed lapped the replica
+    uint64_t resyncs = 0;            // bootstraps that ended a gap
+    bool stale = false;              // in a gap, waiting for a newer snapshot
+    std::chrono::nanoseconds lastLag{0};  // publish to apply, for the last change
+    std::chrono::nanoseconds maxLag{0};
+
+    uint64_t lagChanges() const { return publishedSequence - appliedSequence; }
+};
+
+// Read-only copy of a primary store, kept current from its change feed;
+// typically in another process. bootstrap() maps the primary's snapshot
+// (books borrow their text from the file) and seeks the feed to the
+// snapshot's position; each change is then applied to the replica's own
+// store as a write-ahead log replay would, so only changed books are ever
+// built. A replica the feed laps reports a gap, keeps serving what it has,
+// and bootstraps again once the snapshot file has caught up with the ring.
+class CatalogReplica {
+public:
+    CatalogReplica(const std::string& feedName, std::string snapshotPath, ReplicaConfig config = ReplicaConfig());
+    ~CatalogReplica();
+
+    CatalogReplica(const CatalogReplica&) = delete;
+    CatalogReplica& operator=(const CatalogReplica&) = delete;
+
+    // Load the snapshot into a fresh store and continue the feed from it.
+    // Throws std::runtime_error if the snapshot is missing or corrupt or the
+    // feed no longer holds the changes after it.
+    void bootstrap();
+
+    // Apply up to maxChanges published changes; returns the number applied.
+    // In a gap, first tries to bootstrap again.
+    size_t poll(size_t maxChanges = SIZE_MAX);
+
+    // Tail the feed on a background thread; errors are logged and retried
+    void start();
+    void stop();
+
+    // Wait until the change with this sequence has been applied; false on
+    // timeout
+    bool waitFor(uint64_t sequence, std::chrono::milliseconds timeout) const;
+
+    // Current store; a new one replaces it after a gap, while holders of
+    // the old one keep it alive
+    std::shared_ptr<const QuantumBookstore> store() const;
+
+    ReplicaStats getStats() const;
+
+private:
+    const std::string snapshotPath;
+    const ReplicaConfig config;
+    ChangeFeedReader reader;
+    ChangeRecord record;
+
+    std::mutex applyMutex;  // one poller at a time
+    uint64_t failedSnapshot = 0;  // file stamp of a snapshot the ring had already passed
+    std::shared_ptr<QuantumBookstore> current;
+    mutable std::mutex stateMutex;
+    mutable std::condition_variable applied;
+    ReplicaStats stats;
+
+    std::thread tailer;
+    std::atomic<bool> stopping{false};
+
+    void load();
+};
@@ -0,0 +1,76 @@
+#pragma once
+#include "Book.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// One book in a snapshot file. ISBN and title are stored back to back at
+// textOffset in the string area; authors and file types are stored once
+// and shared by offset.
+struct SnapshotRecord {
+    uint64_t textOffset;
+    uint64_t authorOffset;
+    uint64_t fileTypeOffset;
+    uint32_t titleLength;
+    uint16_t authorLength;
+    uint8_t isbnLength;
+    uint8_t fileTypeLength;
+    int32_t year;
+    int32_t stock;   // paper books only
+    double price;
+    uint8_t kind;    // BookKind
+    uint8_t reserved[7];
+};
+
+// Versioned, checksummed binary catalog snapshot. The file is a fixed
+// header, an array of SnapshotRecords and a string area; open() maps it
+// read-only so the loaded books can point straight into the mapped pages.
+class CatalogSnapshot {
+public:
+    static constexpr uint32_t FORMAT_VERSION = 1;
+    
+    // Write the books to path, atomically via a temporary file and rename;
+    // the file is synced before it replaces the old one. stocks, if given,
+    // holds the stock of each paper book as captured with the positions;
+    // otherwise it is read from the books. logPosition is the last
+    // write-ahead log LSN the books reflect, feedPosition the last change
+    // feed sequence. Throws std::invalid_argument for book types outside
+    // the built-in kinds and std::runtime_error on I/O errors.
+    static void write(const std::string& path, const std::vector<const Book*>& books, 
+                      uint64_t logPosition = 0, uint64_t feedPosition = 0,
+                      const std::vector<int>& stocks = {});
+    
+    // Map and validate a snapshot (magic, version, bounds, checksum);
+    // throws std::runtime_error if the file is missing or corrupt
+    static std::shared_ptr<const CatalogSnapshot> open(const std::string& path);
+    
+    ~CatalogSnapshot();
+    
+    CatalogSnapshot(const CatalogSnapshot&) = delete;
+    CatalogSnapshot& operator=(const CatalogSnapshot&) = delete;
+    
+    size_t size() const { return count; }
+    uint64_t logPosition() const { return logLsn; }
+    uint64_t feedPosition() const { return feedSequence; }
+    const SnapshotRecord& record(size_t i) const { return records[i]; }
+    
+    // Views into the mapping, valid while the snapshot is alive
+    BookText textOf(const SnapshotRecord& record) const;
+    std::string_view fileTypeOf(const SnapshotRecord& record) const;
+    
+private:
+    void* mapping;
+    size_t length;
+    const SnapshotRecord* records;
+    size_t count;
+    const char* strings;
+    size_t stringBytes;
+    uint64_t logLsn;
+    uint64_t feedSequence;
+    
+    CatalogSnapshot(void* mapping, size_t length);
+    void validate(const std::string& path);
+};
@@ -0,0 +1,61 @@
+#pragma once
+#include "Book.h"
+#include "CatalogIndex.h"
+#include "EpochReclaimer.h"
+#include "IsbnCodec.h"
+#include "ShardedInventory.h"
+#include <algorithm>
+#include <cstdint>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// Immutable list of the books in a store at one inventory version, sorted
+// by packed ISBN. Published versions are replaced, never modified.
+struct CatalogVersion {
+    using Entries = std::vector<std::pair<uint64_t, Book*>>;
+
+    uint64_t version = 0;
+    Entries books;
+    // The per-shard entries books was merged from; the next version reuses
+    // those of shards that have not changed
+    std::vector<ShardedInventory::ShardEntries> shards;
+};
+
+// Consistent, lock-free read view of the catalog. It pins an epoch, so the
+// version and every book in it stay valid while the view lives, even if
+// removeOutdated drops them meanwhile. Book fields that change in place
+// (paper book stock) are read live; the set of books is fixed.
+class CatalogView {
+public:
+    using Iterator = BookIterator<CatalogVersion::Entries::const_iterator>;
+
+    CatalogView(EpochReclaimer::Guard guard, const CatalogVersion* catalog)
+        : guard(std::move(guard)), catalog(catalog) {}
+
+    // Inventory version the view was taken at; grows with every add and removal
+    uint64_t version() const { return catalog->version; }
+    size_t size() const { return catalog->books.size(); }
+    bool empty() const { return catalog->books.empty(); }
+
+    // Binary search by ISBN (any spelling); nullptr if not in this version
+    Book* find(std::string_view isbn) const {
+        uint64_t key = IsbnCodec::pack(isbn);
+        auto it = std::lower_bound(catalog->books.begin(), catalog->books.end(), key,
+                                   [](const auto& entry, uint64_t wanted) { return entry.first < wanted; });
+        return it != catalog->books.end() && it->first == key ? it->second : nullptr;
+    }
+
+    // Books in ISBN order
+    Iterator begin() const { return Iterator(catalog->books.begin()); }
+    Iterator end() const { return Iterator(catalog->books.end()); }
+    // First book whose packed ISBN is greater than key
+    Iterator after(uint64_t key) const {
+        return Iterator(std::upper_bound(catalog->books.begin(), catalog->books.end(), key,
+                                         [](uint64_t wanted, const auto& entry) { return wanted < entry.first; }));
+    }
+
+private:
+    EpochReclaimer::Guard guard;
+    const CatalogVersion* catalog;
+};
@@ -0,0 +1,129 @@
+#pragma once
+#include "Book.h"
+#include "WriteAheadLog.h"
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Shared-memory header of a change feed, followed by the ring itself
+struct ChangeFeedHeader {
+    uint64_t magic;
+    uint32_t version;
+    uint32_t reserved;
+    uint64_t capacity;  // ring bytes, a power of two
+    alignas(64) std::atomic<uint64_t> head;           // bytes published
+    std::atomic<uint64_t> headSequence;               // sequence of the last record published
+    alignas(64) std::atomic<uint64_t> claimed;        // bytes the producer may be overwriting (>= head)
+    std::atomic<uint64_t> tail;                       // offset of the oldest record still in the ring
+    alignas(64) std::atomic<uint32_t> signal;         // futex word, bumped to wake sleeping readers
+    std::atomic<uint32_t> sleepers;
+};
+
+// Producer side of a change-data-capture stream: sequenced inventory
+// mutations (the write-ahead log's AddBook, Sale and RemoveBook records,
+// stamped with the monotonic clock) in a ring in POSIX shared memory that
+// any number of reader processes map. The producer never waits
+// for readers; one that falls a whole ring behind loses records and sees a
+// gap. Publishing is serialized, so any thread may publish.
+class ChangeFeed {
+public:
+    static constexpr size_t DEFAULT_CAPACITY = size_t{16} << 20;
+    static constexpr size_t MIN_CAPACITY = size_t{64} << 10;
+
+    // Create (or replace) the shared-memory object name, e.g. "/qb-changes",
+    // with a ring of capacity bytes, a power of two of at least
+    // MIN_CAPACITY. The first record gets sequence startAfter + 1. Throws
+    // std::invalid_argument for a bad capacity and std::runtime_error if
+    // the object cannot be created.
+    explicit ChangeFeed(const std::string& name, size_t capacity = DEFAULT_CAPACITY, uint64_t startAfter = 0);
+    // Unmaps and unlinks the object; mapped readers keep what they have
+    ~ChangeFeed();
+
+    ChangeFeed(const ChangeFeed&) = delete;
+    ChangeFeed& operator=(const ChangeFeed&) = delete;
+
+    // Publish a record and return its sequence number
+    uint64_t publishAddBook(const Book& book);
+    uint64_t publishSale(const WalSaleLine* lines, size_t count);
+    uint64_t publishRemoveBook(uint64_t isbnKey);
+
+    uint64_t lastSequence() const;
+    const std::string& getName() const { return name; }
+
+private:
+    const std::string name;
+    ChangeFeedHeader* header;
+    char* ring;
+    size_t mappedBytes;
+
+    std::mutex mutex;  // one publisher at a time
+    uint64_t nextSequence;
+    std::vector<char> staging;
+
+    // Encode a record into staging (encode(char*) writes payloadSize
+    // bytes), then copy it into the ring and publish it
+    template <typename Encode>
+    uint64_t publish(WalEntry::Type type, size_t payloadSize, Encode&& encode);
+};
+
+// A mutation read back from a change feed; the entry's lsn is its sequence
+struct ChangeRecord {
+    WalEntry entry;
+    uint64_t publishedNanos;  // CLOCK_MONOTONIC, comparable across processes
+};
+
+// Reader side of a change feed. The ring is mapped read-only (the header
+// read-write, to register as a sleeper in wait()). Records are
+// copied out and checked against the producer's claimed position before
+// they are handed over, so a record overwritten mid-read is never used.
+class ChangeFeedReader {
+public:
+    enum class Status {
+        Ok,     // a record was read
+        Empty,  // caught up
+        Gap     // records were overwritten before they were read; seek again
+    };
+
+    // Map the feed and start at its current head. Throws
+    // std::runtime_error if it does not exist or is not a change feed.
+    explicit ChangeFeedReader(const std::string& name);
+    ~ChangeFeedReader();
+
+    ChangeFeedReader(const ChangeFeedReader&) = delete;
+    ChangeFeedReader& operator=(const ChangeFeedReader&) = delete;
+
+    // Continue after the record with sequence afterSequence, e.g. the feed
+    // position of a snapshot. Returns false (and leaves the reader in a
+    // gap) if that record has already left the ring; throws
+    // std::runtime_error if it was never published.
+    bool seek(uint64_t afterSequence);
+
+    // Read the next record into record; views in it stay valid until the
+    // next call
+    Status next(ChangeRecord& record);
+
+    // Block until a record may be available or timeout passes: a short
+    // spin, then a futex wait the producer wakes
+    void wait(std::chrono::microseconds timeout);
+
+    uint64_t lastSequence() const;  // of the last record read
+    uint64_t publishedSequence() const;
+    bool inGap() const { return gap; }
+
+private:
+    ChangeFeedHeader* header;
+    const char* ring;
+    size_t headerBytes;
+    uint64_t mask;
+    uint64_t position;
+    uint64_t sequence;
+    bool gap = false;
+    std::vector<char> buffer;
+
+    void copyOut(uint64_t offset, char* out, size_t size) const;
+    bool overwritten(uint64_t offset) const;
+};
@@ -0,0 +1,64 @@
+#pragma once
+#include "Book.h"
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+// Struct-of-arrays view of a set of books. Hot scan fields (year, price,
+// stock, kind) live in contiguous columns; titles, authors and the rest stay
+// in the Book records reached through the handle column. Predicates run as
+// vectorized bitmask scans (AVX2/SSE2 with a scalar fallback).
+class ColumnarCatalog {
+public:
+    // One bit per row, 64 rows per word
+    using Bitmask = std::vector<uint64_t>;
+    
+    // Stock value stored for rows that do not track stock
+    static constexpr int32_t NO_STOCK = -1;
+    
+    // Leaves the catalog unchanged if it throws
+    void append(Book& book);
+    void clear();
+    void reserve(size_t rows);
+    size_t size() const;
+    Book* bookAt(size_t row) const;
+    
+    // Re-read the stock column from the books (stock changes outside the catalog)
+    void refreshStock();
+    
+    // Raw columns for custom scans, size() rows each; valid until the
+    // catalog changes. Kinds are BookKind values.
+    const int32_t* yearColumn() const { return years.data(); }
+    const double* priceColumn() const { return prices.data(); }
+    const uint8_t* kindColumn() const { return kinds.data(); }
+    Book* const* bookColumn() const { return books.data(); }
+    
+    Bitmask selectPublishedBefore(int year) const;
+    Bitmask selectPriceRange(double minPrice, double maxPrice) const;
+    Bitmask selectKind(BookKind kind) const;
+    // Rows that track stock and have none left (refresh the stock column first)
+    Bitmask selectOutOfStock() const;
+    // Rows matching an arbitrary predicate (scalar)
+    Bitmask selectWhere(const std::function<bool(const Book&)>& predicate) const;
+    
+    // Remove the selected rows, keeping the others in order; returns the
+    // removed book handles
+    std::vector<Book*> compact(const Bitmask& selected);
+    // Remove one row by moving the last row into it; returns the book now
+    // at that row, or nullptr if the removed row was the last
+    Book* removeRow(size_t row);
+    
+    static void intersect(Bitmask& target, const Bitmask& other);
+    static size_t countSelected(const Bitmask& mask);
+    static void forEachSelected(const Bitmask& mask, const std::function<void(size_t row)>& visitor);
+    
+    // Instruction set used by the scan kernels: "avx2", "sse2" or "scalar"
+    static const char* simdLevel();
+    
+private:
+    std::vector<int32_t> years;
+    std::vector<double> prices;
+    std::vector<int32_t> stocks;
+    std::vector<uint8_t> kinds;
+    std::vector<Book*> books;
+};
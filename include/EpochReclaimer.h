@@ -0,0 +1,89 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+// Epoch-based reclamation. Readers pin the current epoch while they hold
+// pointers into shared data; writers unlink an object first and then retire
+// it, and it is destroyed only once every reader pinned when it was retired
+// has unpinned. The global epoch advances when all pinned readers have seen
+// it, so an object retired in epoch e is safe to free from epoch e + 2 on.
+// Pinning costs one store and a fence and never waits for writers.
+class EpochReclaimer {
+private:
+    // One thread's announcement; 0 means not pinned
+    struct Slot {
+        std::atomic<uint64_t> epoch{0};
+        uint32_t depth = 0;  // nested pins, owner thread only
+        std::atomic<bool> owned{true};
+    };
+
+public:
+    // Keeps the calling thread pinned until it goes out of scope; nests
+    class Guard {
+    public:
+        Guard(Guard&& other) noexcept : slot(other.slot) { other.slot = nullptr; }
+        Guard& operator=(Guard&&) = delete;
+        ~Guard() {
+            if (slot && --slot->depth == 0) {
+                slot->epoch.store(0, std::memory_order_release);
+            }
+        }
+
+    private:
+        friend class EpochReclaimer;
+        explicit Guard(Slot* slot) : slot(slot) {}
+
+        Slot* slot;
+    };
+
+    EpochReclaimer();
+    // Destroys everything still retired; no thread may be pinned
+    ~EpochReclaimer();
+
+    EpochReclaimer(const EpochReclaimer&) = delete;
+    EpochReclaimer& operator=(const EpochReclaimer&) = delete;
+
+    Guard pin() {
+        Slot& slot = localSlot();
+        if (slot.depth++ == 0) {
+            slot.epoch.store(globalEpoch.load(std::memory_order_relaxed), std::memory_order_relaxed);
+            // The announcement must be visible before any shared pointer is read
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+        }
+        return Guard(&slot);
+    }
+
+    // Destroy the object once no pinned reader can still reach it. Call
+    // after it has been unlinked from everything readers traverse.
+    void retire(std::shared_ptr<const void> object);
+    // Advance the epoch if every pinned reader has seen it, then destroy
+    // what has become safe; returns the number of objects destroyed
+    size_t collect();
+
+    uint64_t currentEpoch() const { return globalEpoch.load(std::memory_order_acquire); }
+    size_t pendingCount() const;
+
+private:
+    static constexpr size_t COLLECT_EVERY = 64;  // retirements between automatic collections
+
+    const uint64_t id;
+    std::atomic<uint64_t> globalEpoch{1};
+    mutable std::mutex mutex;  // slot registry and retired list
+    std::vector<std::shared_ptr<Slot>> slots;  // threads keep their slot alive too
+    std::vector<std::pair<uint64_t, std::shared_ptr<const void>>> retired;  // (epoch, object)
+    size_t retiredSinceCollect = 0;
+
+    // Last slot this thread used; plain data, so reading it needs no TLS guard
+    static inline thread_local uint64_t cachedId = 0;
+    static inline thread_local Slot* cachedSlot = nullptr;
+
+    Slot& localSlot() {
+        return cachedId == id ? *cachedSlot : registerThread();
+    }
+    Slot& registerThread();
+};
@@ -0,0 +1,259 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <utility>
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+// Avalanching mix of a 64-bit key (splitmix64 finalizer). Low bits pick a
+// shard, high bits a FlatHashMap slot, so the two stay independent.
+inline uint64_t mixKey(uint64_t key) {
+    key ^= key >> 30;
+    key *= 0xbf58476d1ce4e5b9ULL;
+    key ^= key >> 27;
+    key *= 0x94d049bb133111ebULL;
+    key ^= key >> 31;
+    return key;
+}
+
+// Open-addressing hash map from 64-bit keys to values stored inline in one
+// slot array. Robin Hood probing keeps probe sequences short and lets a
+// lookup stop at the first slot closer to its home than the key would be;
+// erase shifts the following run back instead of leaving tombstones.
+// Key 0 marks an empty slot and cannot be stored.
+template <typename V>
+class FlatHashMap {
+public:
+    static constexpr uint64_t EMPTY_KEY = 0;
+    
+    FlatHashMap() = default;
+    ~FlatHashMap();
+    
+    FlatHashMap(const FlatHashMap&) = delete;
+    FlatHashMap& operator=(const FlatHashMap&) = delete;
+    
+    V* find(uint64_t key);
+    const V* find(uint64_t key) const;
+    
+    // Insert unless the key is present; returns the value slot and whether
+    // it was inserted ({nullptr, false} for EMPTY_KEY). Pointers stay valid
+    // until the next insert or erase.
+    std::pair<V*, bool> tryEmplace(uint64_t key, V value);
+    bool erase(uint64_t key);
+    
+    void reserve(size_t count);
+    size_t size() const { return count; }
+    size_t capacity() const { return slotCount; }
+    
+    // Visit every entry as fn(key, value)
+    template <typename Fn>
+    void forEach(Fn&& fn);
+    template <typename Fn>
+    void forEach(Fn&& fn) const;
+    
+private:
+    static constexpr size_t MIN_CAPACITY = 16;
+    static constexpr size_t HUGE_PAGE_SIZE = 2 << 20;
+    
+    // No stored probe length: it is recomputed from the key's home slot,
+    // which keeps a slot at 24 bytes for a pointer-sized value plus a row
+    struct Slot {
+        uint64_t key = EMPTY_KEY;
+        V value{};
+    };
+    
+    Slot* slots = nullptr;
+    size_t slotCount = 0;
+    size_t count = 0;
+    unsigned shift = 64;
+    
+    size_t home(uint64_t key) const { return static_cast<size_t>(mixKey(key) >> shift); }
+    size_t distanceAt(const Slot& slot, size_t index) const {
+        return ((index - home(slot.key)) & (slotCount - 1)) + 1;
+    }
+    size_t locate(uint64_t key) const;
+    void rehash(size_t newCapacity);
+    static Slot* allocateSlots(size_t slotCount);
+    static void freeSlots(Slot* slots, size_t slotCount);
+};
+
+template <typename V>
+FlatHashMap<V>::~FlatHashMap() {
+    freeSlots(slots, slotCount);
+}
+
+template <typename V>
+typename FlatHashMap<V>::Slot* FlatHashMap<V>::allocateSlots(size_t slotCount) {
+    size_t bytes = slotCount * sizeof(Slot);
+    // Large tables are probed at random: back them with huge pages where
+    // available so lookups miss the TLB less often
+    size_t alignment = bytes >= HUGE_PAGE_SIZE ? HUGE_PAGE_SIZE : alignof(std::max_align_t);
+    bytes = (bytes + alignment - 1) / alignment * alignment;
+    void* memory = std::aligned_alloc(alignment, bytes);
+    if (!memory) {
+        throw std::bad_alloc();
+    }
+#ifdef __linux__
+    if (alignment == HUGE_PAGE_SIZE) {
+        madvise(memory, bytes, MADV_HUGEPAGE);
+    }
+#endif
+    Slot* result = static_cast<Slot*>(memory);
+    for (size_t i = 0; i < slotCount; ++i) {
+        new (&result[i]) Slot();
+    }
+    return result;
+}
+
+template <typename V>
+void FlatHashMap<V>::freeSlots(Slot* slots, size_t slotCount) {
+    for (size_t i = 0; i < slotCount; ++i) {
+        slots[i].~Slot();
+    }
+    std::free(slots);
+}
+
+template <typename V>
+size_t FlatHashMap<V>::locate(uint64_t key) const {
+    if (count == 0 || key == EMPTY_KEY) {
+        return slotCount;
+    }
+    size_t mask = slotCount - 1;
+    size_t index = home(key);
+    for (size_t distance = 1; ; ++distance, index = (index + 1) & mask) {
+        const Slot& slot = slots[index];
+        if (slot.key == key) {
+            return index;
+        }
+        // Empty, or an entry richer than we would be: the key is absent
+        if (slot.key == EMPTY_KEY || distanceAt(slot, index) < distance) {
+            return slotCount;
+        }
+    }
+}
+
+template <typename V>
+V* FlatHashMap<V>::find(uint64_t key) {
+    size_t index = locate(key);
+    return index == slotCount ? nullptr : &slots[index].value;
+}
+
+template <typename V>
+const V* FlatHashMap<V>::find(uint64_t key) const {
+    size_t index = locate(key);
+    return index == slotCount ? nullptr : &slots[index].value;
+}
+
+template <typename V>
+std::pair<V*, bool> FlatHashMap<V>::tryEmplace(uint64_t key, V value) {
+    if (key == EMPTY_KEY) {
+        return {nullptr, false};
+    }
+    if (V* existing = find(key)) {
+        return {existing, false};
+    }
+    // Grow at 7/8 load
+    if ((count + 1) * 8 > slotCount * 7) {
+        rehash(slotCount == 0 ? MIN_CAPACITY : slotCount * 2);
+    }
+    
+    size_t mask = slotCount - 1;
+    Slot incoming{key, std::move(value)};
+    size_t distance = 1;
+    V* placed = nullptr;
+    for (size_t index = home(key); ; index = (index + 1) & mask, ++distance) {
+        Slot& slot = slots[index];
+        if (slot.key == EMPTY_KEY) {
+            slot = std::move(incoming);
+            if (!placed) {
+                placed = &slot.value;
+            }
+            break;
+        }
+        // Take from the rich: the displaced entry continues probing
+        size_t resident = distanceAt(slot, index);
+        if (resident < distance) {
+            std::swap(slot, incoming);
+            distance = resident;
+            if (!placed) {
+                placed = &slot.value;
+            }
+        }
+    }
+    ++count;
+    return {placed, true};
+}
+
+template <typename V>
+bool FlatHashMap<V>::erase(uint64_t key) {
+    size_t index = locate(key);
+    if (index == slotCount) {
+        return false;
+    }
+    size_t mask = slotCount - 1;
+    for (size_t next = (index + 1) & mask; 
+         slots[next].key != EMPTY_KEY && distanceAt(slots[next], next) > 1; 
+         next = (next + 1) & mask) {
+        slots[index] = std::move(slots[next]);
+        index = next;
+    }
+    slots[index] = Slot();
+    --count;
+    return true;
+}
+
+template <typename V>
+void FlatHashMap<V>::reserve(size_t entries) {
+    size_t capacity = slotCount == 0 ? MIN_CAPACITY : slotCount;
+    while (entries * 8 > capacity * 7) {
+        capacity *= 2;
+    }
+    if (capacity > slotCount) {
+        rehash(capacity);
+    }
+}
+
+template <typename V>
+void FlatHashMap<V>::rehash(size_t newCapacity) {
+    Slot* old = slots;
+    size_t oldCount = slotCount;
+    slots = allocateSlots(newCapacity);
+    slotCount = newCapacity;
+    shift = 64;
+    for (size_t capacity = newCapacity; capacity > 1; capacity >>= 1) {
+        --shift;
+    }
+    count = 0;
+    for (size_t i = 0; i < oldCount; ++i) {
+        if (old[i].key != EMPTY_KEY) {
+            tryEmplace(old[i].key, std::move(old[i].value));
+        }
+    }
+    if (old) {
+        freeSlots(old, oldCount);
+    }
+}
+
+template <typename V>
+template <typename Fn>
+void FlatHashMap<V>::forEach(Fn&& fn) {
+    for (size_t i = 0; i < slotCount; ++i) {
+        if (slots[i].key != EMPTY_KEY) {
+            fn(slots[i].key, slots[i].value);
+        }
+    }
+}
+
+template <typename V>
+template <typename Fn>
+void FlatHashMap<V>::forEach(Fn&& fn) const {
+    for (size_t i = 0; i < slotCount; ++i) {
+        const Slot& slot = slots[i];
+        if (slot.key != EMPTY_KEY) {
+            fn(slot.key, slot.value);
+        }
+    }
+}
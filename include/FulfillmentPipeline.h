@@ -0,0 +1,119 @@
+#pragma once
+#include "Book.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// A delivery to perform after a sale has been recorded
+struct FulfillmentJob {
+    DeliveryChannel channel;
+    std::string destination;  // shipping address or customer email
+    std::string isbn;         // empty for a multi-line order
+    int quantity;
+    // The order's lines delivered by this job, as (ISBN, quantity)
+    std::vector<std::pair<std::string, int>> lines;
+};
+
+enum class FulfillmentStatus {
+    Delivered,
+    Failed
+};
+
+// Bulk delivery calls used by the pipeline; defaults to the static services.
+// A call returns the indices of the destinations it could not deliver to,
+// and throws if it delivered to none of them.
+struct FulfillmentBackend {
+    using BatchCall = std::function<std::vector<size_t>(const std::vector<std::string>& destinations)>;
+    BatchCall shipBatch;
+    BatchCall sendEmailBatch;
+    
+    static FulfillmentBackend defaultBackend();
+};
+
+struct FulfillmentConfig {
+    size_t workerCount = 2;
+    size_t queueCapacity = 1024;     // per worker, rounded up to a power of two
+    size_t maxBatchSize = 64;
+    int maxAttempts = 3;
+    std::chrono::milliseconds initialBackoff{10};  // doubled after each failed attempt
+    // Runs on a worker before the job's future is set; an exception it
+    // throws is logged and dropped
+    std::function<void(const FulfillmentJob&, FulfillmentStatus)> onComplete;
+};
+
+// Decouples checkout from delivery I/O. Producers enqueue jobs into bounded
+// MPSC ring buffers (one per worker); each worker drains its ring in batches
+// and hands them to the bulk backend calls with retry and backoff. Only the
+// destinations a call did not deliver to are retried, and only jobs still
+// undelivered after the last attempt fail.
+class FulfillmentPipeline {
+public:
+    explicit FulfillmentPipeline(FulfillmentConfig config = FulfillmentConfig(), 
+                                 FulfillmentBackend backend = FulfillmentBackend::defaultBackend());
+    // Delivers everything already submitted, then stops the workers
+    ~FulfillmentPipeline();
+    
+    FulfillmentPipeline(const FulfillmentPipeline&) = delete;
+    FulfillmentPipeline& operator=(const FulfillmentPipeline&) = delete;
+    
+    // Enqueue a job; blocks only while the worker's ring is full
+    std::future<FulfillmentStatus> submit(FulfillmentJob job);
+    
+    // Wait until every submitted job has completed
+    void waitUntilIdle() const;
+    size_t getPendingCount() const;
+    
+private:
+    struct Entry {
+        FulfillmentJob job;
+        std::promise<FulfillmentStatus> completion;
+    };
+    
+    // Bounded multi-producer/single-consumer ring (per-cell sequence numbers)
+    class Ring {
+    public:
+        explicit Ring(size_t capacity);
+        bool tryPush(Entry& entry);
+        bool tryPop(Entry& entry);
+        
+    private:
+        struct Cell {
+            std::atomic<size_t> sequence;
+            Entry entry;
+        };
+        std::unique_ptr<Cell[]> cells;
+        size_t mask;
+        alignas(64) std::atomic<size_t> enqueuePos{0};
+        alignas(64) size_t dequeuePos{0};
+    };
+    
+    struct Worker {
+        explicit Worker(size_t capacity);
+        Ring ring;
+        std::mutex mutex;
+        std::condition_variable wakeup;
+        std::atomic<bool> sleeping{false};
+        std::thread thread;
+    };
+    
+    FulfillmentConfig config;
+    FulfillmentBackend backend;
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::atomic<bool> stopping{false};
+    std::atomic<size_t> pending{0};
+    
+    void run(Worker& worker);
+    void deliver(std::vector<Entry>& batch);
+    // Deliver the jobs at these batch positions, marking each one delivered
+    void callWithRetry(const FulfillmentBackend::BatchCall& call, const std::vector<Entry>& batch,
+                       std::vector<size_t> positions, std::vector<bool>& delivered);
+    void complete(Entry& entry, FulfillmentStatus status);
+};
@@ -0,0 +1,26 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// Packs ISBN-10 and ISBN-13 strings into 64-bit keys. Hyphens or spaces may
+// separate digit groups; "978-0134685991" and "9780134685991" pack to the
+// same key. Only the shape is checked here; check digits are verified
+// separately by hasValidChecksum.
+class IsbnCodec {
+public:
+    static constexpr uint64_t INVALID_KEY = 0;
+    
+    // Packed key, or INVALID_KEY if the text is not an ISBN-10/13
+    static uint64_t pack(std::string_view isbn);
+    // Unhyphenated ISBN for a packed key
+    static std::string unpack(uint64_t key);
+    
+    static bool isValid(std::string_view isbn);
+    static bool hasValidChecksum(std::string_view isbn);
+    
+private:
+    // Tag bits keep the two formats (and INVALID_KEY) apart
+    static constexpr uint64_t ISBN13_TAG = uint64_t{1} << 62;
+    static constexpr uint64_t ISBN10_TAG = uint64_t{1} << 63;
+};
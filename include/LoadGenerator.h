@@ -0,0 +1,130 @@
+#pragma once
+#include "StoreMetrics.h"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+class QuantumBookstore;
+
+// Item ranks 0..n-1 drawn with probability proportional to 1/(rank+1)^theta
+// (Gray et al., as used by YCSB). theta 0 is uniform; 0.99 is the usual
+// "hot set" skew. Setup is O(n), each draw O(1).
+class ZipfianGenerator {
+public:
+    ZipfianGenerator(size_t items, double theta);
+
+    template <typename Random>
+    size_t next(Random& random) {
+        double u = std::uniform_real_distribution<double>(0.0, 1.0)(random);
+        return rankFor(u);
+    }
+    // Rank for a uniform draw u in [0, 1)
+    size_t rankFor(double u) const;
+    size_t size() const { return items; }
+
+private:
+    size_t items;
+    double theta;
+    double zetaN;
+    double alpha;
+    double eta;
+};
+
+enum class LoadOpType : uint8_t {
+    BuyBook,          // one purchase of a catalog book
+    FindBook,
+    AddBook,          // a new paper book past the initial catalog
+    RemoveOutdated,   // sweep of books older than arg years
+    Count
+};
+
+constexpr size_t LOAD_OP_TYPE_COUNT = static_cast<size_t>(LoadOpType::Count);
+
+std::string_view loadOpTypeName(LoadOpType type);
+
+// One operation of a load run, as generated or read back from a trace
+struct LoadOp {
+    uint64_t intendedNanos;  // open loop: start time after the run began; closed loop: 0
+    uint32_t client;         // client thread that issues it
+    LoadOpType type;
+    uint32_t book;           // catalog index (ISBN via LoadGenerator::isbnFor)
+    int32_t arg;             // quantity, publication year or age threshold
+};
+
+// Relative weights of the operations; purchases are split by book type
+// (showcase purchases are always rejected, as in production)
+struct LoadMix {
+    double buyPaper = 0.45;
+    double buyEBook = 0.22;
+    double buyShowcase = 0.03;
+    double find = 0.25;
+    double add = 0.049;
+    double sweep = 0.001;
+};
+
+struct LoadConfig {
+    size_t catalogSize = 100000;
+    double paperShare = 0.6;     // of the catalog; ebooks next, the rest showcase books
+    double ebookShare = 0.3;
+    int initialStock = 20;       // per paper book, small enough for hot books to sell out
+    double zipfTheta = 0.99;     // ISBN popularity skew
+    LoadMix mix;
+    size_t clients = 4;
+    size_t operations = 1000000;
+    double ratePerSecond = 0;    // > 0: open loop at this total arrival rate; 0: closed loop
+    uint64_t seed = 42;
+    int currentYear = 2025;      // catalog years span the 75 years before this
+    int sweepAge = 70;           // removeOutdated threshold of a sweep
+};
+
+// A replayable run: the catalog settings and the exact operations
+struct LoadTrace {
+    LoadConfig config;
+    std::vector<LoadOp> ops;     // in issue order per client
+};
+
+struct LoadOpStats {
+    uint64_t completed = 0;
+    uint64_t rejected = 0;           // calls that threw (sold out, not for sale, ...)
+    LatencyHistogram response;       // from the intended start, so stalls are not hidden
+    LatencyHistogram service;        // from the actual start
+};
+
+struct LoadReport {
+    double elapsedSeconds = 0;
+    uint64_t lateOps = 0;            // open loop: started more than 1 ms behind schedule
+    std::array<LoadOpStats, LOAD_OP_TYPE_COUNT> byType;
+
+    const LoadOpStats& of(LoadOpType type) const { return byType[static_cast<size_t>(type)]; }
+    uint64_t totalCompleted() const;
+};
+
+// Synthetic production-like traffic for capacity planning. generate() turns
+// a config into a deterministic operation list (Zipfian ISBN popularity over
+// each book type, a paper/ebook/showcase purchase mix, inserts and sweeps),
+// which can be saved as a trace and replayed exactly. In open-loop mode
+// every operation has a scheduled start and latency is measured from it,
+// which corrects for coordinated omission: a stalled store shows up as
+// queueing delay instead of as fewer, faster samples.
+class LoadGenerator {
+public:
+    static std::string isbnFor(uint32_t book);
+    static BookKind kindOf(uint32_t book, const LoadConfig& config);
+
+    static LoadTrace generate(const LoadConfig& config);
+
+    // Add the initial catalog described by the config
+    static void buildCatalog(QuantumBookstore& store, const LoadConfig& config);
+
+    // Run the trace's operations with one thread per client. The store
+    // should hold the trace's catalog.
+    static LoadReport run(QuantumBookstore& store, const LoadTrace& trace);
+
+    // Text format: a header with the config, then one operation per line.
+    // Throws std::runtime_error on I/O or format errors.
+    static void writeTrace(const std::string& path, const LoadTrace& trace);
+    static LoadTrace readTrace(const std::string& path);
+};
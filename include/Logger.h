@@ -0,0 +1,152 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+enum class LogLevel : uint8_t {
+    Debug = 0,   // per-sale messages
+    Info = 1,    // catalog changes and inventory dumps
+    Warning = 2,
+    Error = 3,
+    Off = 4
+};
+
+// Messages below this level are removed at compile time, e.g.
+// make CXXFLAGS+=-DQB_LOG_COMPILED_LEVEL=1 drops sale messages entirely
+#ifndef QB_LOG_COMPILED_LEVEL
+#define QB_LOG_COMPILED_LEVEL 0
+#endif
+
+// Asynchronous logger. The hot path captures only the pattern pointer (the
+// format id) and raw argument bytes into a fixed-size record in a per-thread
+// lock-free SPSC ring; a background writer formats records and writes them
+// in batches. Patterns use "{}" placeholders and must be string literals.
+// A string too long for the record's payload is copied to the heap instead.
+class Logger {
+public:
+    static constexpr LogLevel COMPILED_LEVEL = static_cast<LogLevel>(QB_LOG_COMPILED_LEVEL);
+    static constexpr size_t MAX_ARGS = 8;
+    static constexpr size_t PAYLOAD_SIZE = 224;
+    static constexpr size_t RING_CAPACITY = 1024;  // records per thread
+    
+    // Process-wide logger used by the store
+    static Logger& global();
+    
+    Logger();
+    ~Logger();
+    
+    Logger(const Logger&) = delete;
+    Logger& operator=(const Logger&) = delete;
+    
+    void setLevel(LogLevel level);
+    LogLevel getLevel() const;
+    // Destination for formatted output (stdout by default); not owned
+    void setOutput(std::FILE* output);
+    // Block until everything logged before the call has been written;
+    // returns at once if the writer has already stopped
+    void flush();
+    
+    // Log "channel: pattern" with the arguments substituted for "{}"
+    template <LogLevel Level, typename... Args>
+    void log(const char* channel, const char* pattern, const Args&... args);
+    
+private:
+    enum class ArgType : uint8_t { Int, UInt, Double, String, HeapString };
+    
+    struct Record {
+        const char* channel;
+        const char* pattern;
+        uint8_t argCount;
+        ArgType argTypes[MAX_ARGS];
+        uint16_t payloadSize;
+        char payload[PAYLOAD_SIZE];
+    };
+    
+    // Single-producer (owning thread) / single-consumer (writer) ring
+    struct Ring {
+        Record records[RING_CAPACITY];
+        alignas(64) std::atomic<size_t> head{0};  // next write
+        alignas(64) std::atomic<size_t> tail{0};  // next read
+        std::atomic<bool> owned{true};
+    };
+    
+    std::atomic<LogLevel> level{LogLevel::Debug};
+    const uint64_t id;
+    std::mutex registryMutex;
+    std::vector<std::shared_ptr<Ring>> rings;  // threads keep their ring alive too
+    
+    std::mutex outputMutex;
+    std::FILE* output = stdout;
+    std::string buffer;
+    
+    std::mutex wakeMutex;
+    std::condition_variable wakeup;
+    std::condition_variable passDone;
+    std::atomic<uint64_t> completedPasses{0};
+    std::atomic<bool> stopping{false};
+    bool writerRunning = true;  // guarded by wakeMutex
+    std::thread writer;
+    
+    Ring& localRing();
+    Record& beginRecord(Ring& ring);
+    void commitRecord(Ring& ring);
+    void run();
+    bool drainOnce();
+    void format(const Record& record);
+    
+    static void encode(Record& record, long long value);
+    static void encode(Record& record, unsigned long long value);
+    static void encode(Record& record, double value);
+    static void encode(Record& record, std::string_view value);
+    
+    template <typename T>
+    static void encodeArg(Record& record, const T& value);
+};
+
+template <typename T>
+void Logger::encodeArg(Record& record, const T& value) {
+    if (record.argCount == MAX_ARGS) {
+        return;
+    }
+    if constexpr (std::is_same_v<T, bool>) {
+        encode(record, std::string_view(value ? "true" : "false"));
+    } else if constexpr (std::is_integral_v<T> && std::is_signed_v<T>) {
+        encode(record, static_cast<long long>(value));
+    } else if constexpr (std::is_integral_v<T>) {
+        encode(record, static_cast<unsigned long long>(value));
+    } else if constexpr (std::is_floating_point_v<T>) {
+        encode(record, static_cast<double>(value));
+    } else {
+        encode(record, std::string_view(value));
+    }
+}
+
+template <LogLevel Level, typename... Args>
+void Logger::log(const char* channel, const char* pattern, const Args&... args) {
+    if constexpr (Level < COMPILED_LEVEL) {
+        (void)channel;
+        (void)pattern;
+        ((void)args, ...);
+    } else {
+        if (Level < level.load(std::memory_order_relaxed)) {
+            return;
+        }
+        Ring& ring = localRing();
+        Record& record = beginRecord(ring);
+        record.channel = channel;
+        record.pattern = pattern;
+        record.argCount = 0;
+        record.payloadSize = 0;
+        (encodeArg(record, args), ...);
+        commitRecord(ring);
+    }
+}
@@ -1,38 +1,280 @@
 #pragma once
+#include "BookArena.h"
 #include "BookTypes.h"
+#include "CatalogAnalytics.h"
+#include "CatalogImporter.h"
+#include "CatalogExporter.h"
+#include "CatalogIndex.h"
+#include "CatalogSnapshot.h"
+#include "CatalogView.h"
+#include "ChangeFeed.h"
+#include "EpochReclaimer.h"
+#include "FulfillmentPipeline.h"
+#include "Logger.h"
+#include "SearchIndex.h"
+#include "ShardedInventory.h"
+#include "StoreMetrics.h"
+#include "StoreResult.h"
+#include "WriteAheadLog.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
 #include <vector>
 #include <memory>
-#include <unordered_map>
+
+// A single line of a multi-book order
+struct OrderLine {
+    std::string isbn;
+    int quantity;
+};
+
+// Receives a batch of removed books; the store is not locked meanwhile
+using RemovedBooks = std::function<void(std::vector<BookPtr>& batch)>;
+
+// Background removal of outdated books. Every interval the trimmer removes
+// batches of the oldest outdated books until none are left or the time
+// budget is spent, so a large backlist ages out in short slices instead of
+// one long pause.
+struct ExpiryConfig {
+    int yearsThreshold = 10;
+    std::function<int()> currentYear;          // default: calendar year of the system clock
+    std::chrono::milliseconds interval{1000};
+    std::chrono::microseconds budget{2000};    // per slice; at least one batch runs
+    size_t batchSize = 256;
+    RemovedBooks onRemoved;                    // default: the books are dropped
+};
 
 class QuantumBookstore {
 private:
-    std::unordered_map<std::string, std::unique_ptr<Book>> inventory;
+    BookArena arena;  // declared first so it outlives the books it backs
+    mutable EpochReclaimer epochs;  // removed books and old catalog versions
+    ShardedInventory inventory;
+    CatalogIndex index;
+    SearchIndex searchIndex;
+    // Swapped by enableAsyncFulfillment while sales may be delivering, so
+    // read and replaced only with std::atomic_load/atomic_store
+    std::shared_ptr<FulfillmentPipeline> fulfillment;
+    std::unique_ptr<WriteAheadLog> wal;
+    std::unique_ptr<ChangeFeed> changeFeed;
+    mutable StoreMetrics metrics;
+    uint64_t snapshotLogPosition = 0;  // log records up to here are in the loaded snapshot
+    uint64_t snapshotFeedPosition = 0;  // and feed records up to here
+    // Secondary indexes of a loaded snapshot are built in the background;
+    // index queries wait for the build, adds and sales do not
+    std::thread indexBuilder;
+    std::atomic<bool> indexesPending{false};
+    mutable std::mutex indexBuildMutex;
+    mutable std::condition_variable indexBuildDone;
+    // Latest catalog version handed to readers, rebuilt when the inventory changed
+    mutable std::atomic<const CatalogVersion*> publishedCatalog{nullptr};
+    mutable std::mutex catalogRebuildMutex;
+    // Workers of analytics queries, started by the first one
+    mutable std::unique_ptr<TaskPool> analyticsPool;
+    mutable std::once_flag analyticsPoolStarted;
+    // Background expiry trimmer
+    std::thread expiryThread;
+    std::mutex expiryMutex;
+    std::condition_variable expiryWake;
+    bool expiryStopping = false;
     static constexpr const char* PRINT_PREFIX = "Quantum book store";
 
 public:
     QuantumBookstore() = default;
-    ~QuantumBookstore() = default;
+    // Thread-safe inventory split into the given number of lock-striped shards
+    explicit QuantumBookstore(size_t shardCount);
+    ~QuantumBookstore();
     
     // Delete copy constructor and assignment operator to prevent copying
     QuantumBookstore(const QuantumBookstore&) = delete;
     QuantumBookstore& operator=(const QuantumBookstore&) = delete;
     
-    // Add a book to the inventory
-    void addBook(std::unique_ptr<Book> book);
+    // Add a book to the inventory. With a write-ahead log or change feed
+    // open, only the built-in book kinds can be added.
+    void addBook(BookPtr book);
+    // The same, returning a null book, an ISBN that does not parse or a
+    // duplicate ISBN as an error instead of throwing
+    StoreResult<void> tryAddBook(BookPtr book);
+    
+    // Arena-backed variants of addBook for bulk catalog loads: authors and
+    // file types are interned and the records are freed with the store
+    void addPaperBook(std::string_view isbn, std::string_view title, int year, 
+                      double price, std::string_view author, int stock);
+    void addEBook(std::string_view isbn, std::string_view title, int year, 
+                  double price, std::string_view author, std::string_view fileType);
+    void addShowcaseBook(std::string_view isbn, std::string_view title, int year, 
+                         double price, std::string_view author);
     
-    // Remove and return outdated books
-    std::vector<std::unique_ptr<Book>> removeOutdated(int currentYear, int yearsThreshold);
+    // Write the whole inventory (types, stock, file types) to a binary
+    // snapshot file; held stock is saved as available. The books, their
+    // stock and the write-ahead log and change feed positions are captured
+    // at one instant, so the store may keep changing meanwhile.
+    void saveSnapshot(const std::string& path) const;
+    // Add every book of a snapshot. The file is mapped and the books read
+    // their text straight from it, so findBook and column scans work as
+    // soon as this returns; author/year/price indexes and search are built
+    // in the background and calls that need them wait until they are ready.
+    // Must be called before openWriteAheadLog.
+    void loadSnapshot(const std::string& path);
+    
+    // Bulk-load a CSV or JSON Lines catalog file, parsing it in parallel.
+    // Bad rows and duplicate ISBNs (in the file or already in the store)
+    // are skipped and listed in the report; indexes and search are built
+    // in the background as after loadSnapshot.
+    ImportReport importCatalog(const std::string& path, const ImportOptions& options = ImportOptions());
+    
+    // Replay the write-ahead log at path on top of the loaded snapshot (or
+    // an empty store), then log every later addBook, sale and removal to
+    // it. Those calls return once their record is on disk; concurrent
+    // calls share one sync. Returns the number of records replayed.
+    size_t openWriteAheadLog(const std::string& path, WalConfig config = WalConfig());
+    // Save a snapshot and drop the log records it supersedes
+    void checkpoint(const std::string& snapshotPath);
+    
+    // Publish every later change (adds, sales, removals, and records
+    // replayed from the write-ahead log) to a change feed in shared memory
+    // under name, for CatalogReplica processes to tail. Sequences continue
+    // from the loaded snapshot's feed position, and saved snapshots record
+    // the position they reflect. Must be called after loadSnapshot and
+    // before anything else modifies the store.
+    void openChangeFeed(const std::string& name, size_t capacity = ChangeFeed::DEFAULT_CAPACITY);
+    // Sequence of the last change published; 0 without a feed
+    uint64_t getChangeFeedPosition() const;
+    
+    // Remove and return outdated books. Built-in types are returned as heap
+    // copies (paper books with their available stock); the originals are
+    // reclaimed once no CatalogView or purchase in flight can still use them.
+    std::vector<BookPtr> removeOutdated(int currentYear, int yearsThreshold);
+    // The same, streamed: books are removed oldest first in batches of at
+    // most batchSize, each handed to onBatch once its removals are logged,
+    // so memory stays bounded and the year index is locked only per batch.
+    // Returns the number of books removed.
+    size_t removeOutdated(int currentYear, int yearsThreshold, const RemovedBooks& onBatch, 
+                          size_t batchSize = 1024);
+    // Keep trimming outdated books on a background thread; replaces a
+    // running trimmer. Errors are logged and the next slice retries.
+    void startBackgroundExpiry(ExpiryConfig config = ExpiryConfig());
+    void stopBackgroundExpiry();
     
     // Buy a single book
     double buyBook(const std::string& isbn, int quantity, 
                    const std::string& customerEmail, 
                    const std::string& shippingAddress);
+    // The same without exceptions for routine refusals (bad quantity,
+    // unknown ISBN, showcase book, insufficient stock), which cost about
+    // as much as a sale; delivery and write-ahead log failures still throw
+    StoreResult<double> tryBuyBook(const std::string& isbn, int quantity, 
+                                   const std::string& customerEmail, 
+                                   const std::string& shippingAddress);
+    
+    // Buy every line of an order or none of them; returns per-line totals
+    std::vector<double> buyBooks(const std::vector<OrderLine>& lines, 
+                                 const std::string& customerEmail, 
+                                 const std::string& shippingAddress);
+    
+    // Hand shipping and email delivery to a background pipeline instead of
+    // running it inside buyBook/buyBooks. A delivery that fails for good
+    // returns its paper copies to stock and logs the reversal. Replacing a
+    // pipeline waits for the old one to drain.
+    void enableAsyncFulfillment(FulfillmentConfig config = FulfillmentConfig(), 
+                                FulfillmentBackend backend = FulfillmentBackend::defaultBackend());
+    // Wait until every queued delivery has completed
+    void waitForFulfillment() const;
+    
+    // Return stock held by reservations abandoned past their deadline
+    size_t expireReservations();
+    
+    // Secondary index queries. Each returns a copy of the matching books
+    // that keeps them valid while it lives; the store may change meanwhile.
+    CatalogIndex::AuthorRange findBooksByAuthor(const std::string& author) const;
+    CatalogIndex::YearRange findBooksPublishedBetween(int fromYear, int toYear) const;
+    CatalogIndex::PriceRange findBooksInPriceRange(double minPrice, double maxPrice) const;
+    CatalogIndex::SoldOutRange findOutOfStock() const;
+    
+    // Full-text search over titles and authors (AND of terms, "prefix*" allowed)
+    std::vector<SearchHit> searchBooks(const std::string& query, size_t limit = 10) const;
+    
+    // Catalog filter backed by a vectorized column scan
+    std::vector<Book*> findBooksByKind(BookKind kind) const;
+    
+    // Run an analytics query (filters, grouping, sums, quantiles, ...) as a
+    // parallel scan of the inventory's columns on a pool of one thread per
+    // core. The scan runs over a copy of the columns taken one shard at a
+    // time, so adds, removals and purchases go on meanwhile; books removed
+    // during the scan are still counted, and stock is read as it is when
+    // each book is scanned.
+    AnalyticsResult analyze(const CatalogQuery& query) const;
+    
+    // Consistent snapshot of the catalog for lookups and report scans. It
+    // takes no locks while in use, so scans run alongside checkout and
+    // catalog changes, and its books stay valid until it is destroyed.
+    CatalogView readView() const;
+    
+    // Write up to maxRows books in ISBN order, continuing after cursor, and
+    // return the cursor of the next page; the first page starts with the
+    // format's header. Pages are read from a CatalogView, so an export
+    // never holds up checkout.
+    ExportCursor exportPage(ExportSink& sink, ExportFormat format, size_t maxRows, 
+                            const ExportCursor& cursor = ExportCursor()) const;
+    // The whole catalog as one page; returns the number of books written
+    size_t exportCatalog(ExportSink& sink, ExportFormat format) const;
     
     // Utility methods
     void printInventory() const;
     size_t getInventorySize() const;
+    // The pointer is valid until the book is removed; hold a readView() to
+    // use books across removals
     Book* findBook(const std::string& isbn) const;
+    // Look up many books at once, locking each shard once for all of its
+    // ISBNs; visit(i, book) runs for every ISBN in order, with nullptr for
+    // unknown ones, and the books stay valid during the call
+    void findBooks(const std::vector<std::string_view>& isbns, 
+                   const std::function<void(size_t, const Book*)>& visit) const;
+    // True if isbn is a paper book with no stock left to reserve; a cheap
+    // probe for shedding doomed purchases, so it is not timed
+    bool isSoldOut(const std::string& isbn) const;
+    
+    // Call counts, latency histograms, failure and sales counters, plus the
+    // current inventory size and available paper stock (summed by a scan)
+    MetricsSnapshot getMetrics() const;
+    // The same in Prometheus text format, for a /metrics endpoint
+    std::string exportMetrics() const;
+    // Time one in every period calls of op; findBook and getInventorySize
+    // default to one in 64, everything else to every call
+    void setMetricsSamplePeriod(StoreOp op, uint32_t period);
     
 private:
-    void printMessage(const std::string& message) const;
+    BookPtr handOver(BookPtr removed);
+    std::vector<BookPtr> removeTaken(const std::vector<Book*>& outdated);
+    size_t sweepOutdated(int publishedBefore, const RemovedBooks& onBatch, size_t batchSize, 
+                         std::chrono::steady_clock::time_point deadline);
+    void deliver(const Book& book, int quantity, 
+                 const std::string& customerEmail, 
+                 const std::string& shippingAddress);
+    void deliverOrder(const std::vector<Book*>& books,
+                      const std::vector<OrderLine>& lines,
+                      const std::string& customerEmail,
+                      const std::string& shippingAddress);
+    // Undo the paper lines of an asynchronous delivery that failed
+    void compensateDelivery(const FulfillmentJob& job);
+    // Consume the holds of a sale (consume returns false, having consumed
+    // nothing, if one has lapsed) and log the sold lines in one step, under
+    // the exclusive locks of their shards, which a snapshot's capture
+    // excludes. lsn is the record to wait for, 0 if nothing was logged.
+    bool commitSale(const std::vector<WalSaleLine>& sold, const std::function<bool()>& consume,
+                    const std::function<void()>& restock, uint64_t& lsn);
+    // Put the units of a committed sale back and log the reversal the same way
+    void undoSale(const std::vector<WalSaleLine>& sold, const std::function<void()>& restock);
+    uint64_t logSale(const std::vector<WalSaleLine>& sold);
+    // saveSnapshot; returns the log position the snapshot reflects
+    uint64_t writeSnapshot(const std::string& path) const;
+    void refreshSoldOut(const std::string& isbn);
+    void indexBooks(const std::vector<Book*>& books);
+    void startIndexBuild(std::vector<Book*> books);
+    void awaitIndexes() const;
+    void applyLogEntry(const WalEntry& entry);
+    
+    friend class CatalogReplica;  // loads snapshots and applies feed records
 };
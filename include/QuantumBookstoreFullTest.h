@@ -1,5 +1,10 @@
 #pragma once
+#include "AdmissionControl.h"
+#include "CatalogReplica.h"
+#include "LoadGenerator.h"
 #include "QuantumBookstore.h"
+#include "StoreClient.h"
+#include "StoreServer.h"
 
 class QuantumBookstoreFullTest {
 public:
@@ -15,4 +20,28 @@ private:
     static void testDuplicateISBN();
     static void testBookNotFound();
     static void testInvalidQuantity();
+    static void testConcurrentAccess();
+    static void testStockReservations();
+    static void testBuyBooksBatch();
+    static void testAsyncFulfillment();
+    static void testBookKindDispatch();
+    static void testColumnarScans();
+    static void testSecondaryIndexes();
+    static void testFullTextSearch();
+    static void testAsyncLogging();
+    static void testArenaBooks();
+    static void testIsbnKeys();
+    static void testSnapshots();
+    static void testWriteAheadLog();
+    static void testCatalogImport();
+    static void testMetrics();
+    static void testLoadGenerator();
+    static void testEpochSnapshots();
+    static void testCatalogExport();
+    static void testExpiry();
+    static void testRpcServer();
+    static void testResultApi();
+    static void testAnalytics();
+    static void testChangeFeed();
+    static void testAdmission();
 };
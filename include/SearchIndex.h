@@ -0,0 +1,99 @@
+#pragma once
+#include "Book.h"
+#include <cstdint>
+#include <map>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// A ranked search result
+struct SearchHit {
+    Book* book;
+    int score;
+};
+
+// In-memory inverted index over titles and authors. Each book gets an
+// increasing ordinal; posting lists store delta-encoded ordinals as varints,
+// so appends are O(1) and lists stay compact, with a skip entry every
+// SKIP_INTERVAL postings so AND queries can probe long lists without
+// decoding them. Removed books are tombstoned and the index is rebuilt once
+// tombstones outnumber live books.
+class SearchIndex {
+public:
+    static constexpr int TITLE_WEIGHT = 2;
+    static constexpr int AUTHOR_WEIGHT = 1;
+    
+    void add(Book* book);
+    void remove(const std::string& isbn);
+    
+    // Multi-term AND query over title and author words. A term ending in '*'
+    // matches every word with that prefix. Hits are ranked by field weight,
+    // newest books first on ties.
+    std::vector<SearchHit> search(const std::string& query, size_t limit) const;
+    
+    size_t size() const;
+    
+    // Lower-cased alphanumeric words of a text, deduplicated
+    static std::vector<std::string> tokenize(std::string_view text);
+    
+private:
+    static constexpr uint32_t SKIP_INTERVAL = 64;
+    
+    class PostingList {
+    public:
+        void append(uint32_t ordinal);
+        void decodeInto(std::vector<uint32_t>& ordinals) const;
+        size_t size() const { return count; }
+        
+        // Forward-only membership test for increasing targets
+        class Probe {
+        public:
+            explicit Probe(const PostingList& list) : list(&list) {}
+            bool contains(uint32_t target);
+            
+        private:
+            const PostingList* list;
+            size_t nextSkip = 0;
+            size_t pos = 0;
+            uint32_t ordinal = 0;
+            uint32_t decoded = 0;
+        };
+        
+    private:
+        struct Skip {
+            uint32_t firstOrdinal;  // first ordinal of the block
+            uint32_t baseOrdinal;   // ordinal its first delta is relative to
+            uint32_t offset;        // byte offset of the block
+        };
+        
+        std::vector<uint8_t> bytes;
+        std::vector<Skip> skips;
+        uint32_t lastOrdinal = 0;
+        uint32_t count = 0;
+        
+        uint32_t readDelta(size_t& pos) const;
+    };
+    
+    using Postings = std::map<std::string, PostingList>;
+    
+    // Posting lists a query term resolved to, in both fields
+    struct TermLists {
+        std::vector<const PostingList*> title;
+        std::vector<const PostingList*> author;
+        size_t postings = 0;
+    };
+    
+    mutable std::shared_mutex mutex;
+    Postings titleTerms;
+    Postings authorTerms;
+    std::vector<Book*> books;  // by ordinal; nullptr once removed
+    std::unordered_map<std::string_view, uint32_t> ordinalByIsbn;  // views of the books' ISBNs
+    size_t removedCount = 0;
+    
+    void indexBook(Book* book);
+    void rebuild();
+    static void resolve(const Postings& postings, const std::string& term, bool prefix, 
+                        std::vector<const PostingList*>& lists, size_t& total);
+};
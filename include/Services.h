@@ -1,13 +1,19 @@
 #pragma once
+#include <cstddef>
 #include <string>
+#include <vector>
 
 // Service interfaces for external dependencies
 class ShippingService {
 public:
     static void ship(const std::string& address);
+    // Returns the indices of the addresses that could not be shipped to
+    static std::vector<size_t> shipBatch(const std::vector<std::string>& addresses);
 };
 
 class MailService {
 public:
     static void sendEmail(const std::string& email);
+    // Returns the indices of the emails that could not be sent
+    static std::vector<size_t> sendEmailBatch(const std::vector<std::string>& emails);
 };
@@ -0,0 +1,145 @@
+#pragma once
+#include "Book.h"
+#include "ColumnarCatalog.h"
+#include "FlatHashMap.h"
+#include "IsbnCodec.h"
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <vector>
+
+// Book inventory split into lock-striped shards keyed by packed ISBN.
+// Lookups take a shard's shared lock so they run in parallel; mutations
+// take only the exclusive lock of the shard they touch.
+class ShardedInventory {
+public:
+    static constexpr size_t DEFAULT_SHARD_COUNT = 16;
+
+    explicit ShardedInventory(size_t shardCount = DEFAULT_SHARD_COUNT);
+
+    ShardedInventory(const ShardedInventory&) = delete;
+    ShardedInventory& operator=(const ShardedInventory&) = delete;
+
+    // Insert a book; returns false if its ISBN is already present.
+    // Throws std::invalid_argument if the ISBN is not an ISBN-10/13.
+    // onInserted runs under the shard's exclusive lock, before any other
+    // thread can see the book.
+    bool insert(BookPtr book, const std::function<void(const Book&)>& onInserted = nullptr);
+
+    // Lookups accept any spelling of the ISBN (with or without hyphens);
+    // malformed ISBNs are simply not found
+    Book* find(std::string_view isbn) const;
+    // Look up many ISBNs, taking each shard's shared lock once for all of
+    // its keys; found[i] is the book of isbns[i] or nullptr
+    void findMany(const std::vector<std::string_view>& isbns, std::vector<Book*>& found) const;
+
+    // Run fn(Book&) under the owning shard's shared or exclusive lock.
+    // Returns false without calling fn if the ISBN is unknown.
+    template <typename Fn>
+    bool withShared(std::string_view isbn, Fn&& fn) const;
+    template <typename Fn>
+    bool withExclusive(std::string_view isbn, Fn&& fn);
+    // Run fn while the shards owning these IsbnCodec keys are exclusively
+    // locked together, taken in shard order so callers cannot deadlock
+    void withExclusiveKeys(const std::vector<uint64_t>& keys, const std::function<void()>& fn);
+
+    // Remove a book in O(1); returns nullptr if the ISBN is unknown.
+    // onRemoved runs under the shard's exclusive lock while the book is
+    // still present; if it throws, the book stays.
+    BookPtr remove(std::string_view isbn, const std::function<void(const Book&)>& onRemoved = nullptr);
+    
+    // Run a column scan over each shard (under its shared lock) and collect
+    // the selected books
+    using ColumnScan = std::function<ColumnarCatalog::Bitmask(const ColumnarCatalog&)>;
+    std::vector<Book*> select(const ColumnScan& scan) const;
+
+    // Copy the columns of every shard, read-locking one shard at a time, so
+    // a long scan of the copies holds up no writer. Each shard is copied as
+    // of one instant, not all of them together; the caller keeps the books
+    // alive (e.g. with an epoch pin taken first).
+    std::vector<ColumnarCatalog> copyColumns() const;
+
+    // Visit every book, holding each shard's shared lock only while visiting it
+    void forEach(const std::function<void(const Book&)>& visitor) const;
+    void forEach(const std::function<void(Book&)>& visitor);
+    // Visit every book as of one instant: all shards are read-locked
+    // together, and whileLocked runs before they are released
+    void forEachAtOnce(const std::function<void(const Book&)>& visitor,
+                       const std::function<void()>& whileLocked) const;
+
+    // Make room for count more books spread evenly over the shards
+    void reserve(size_t count);
+    
+    // Number of inserts and removals so far
+    uint64_t version() const;
+    
+    // One shard's (key, book) pairs, sorted by key, as of its change count
+    struct ShardEntries {
+        uint64_t changes = 0;
+        std::shared_ptr<const std::vector<std::pair<uint64_t, Book*>>> entries;
+    };
+    // Every (key, book) pair as of one instant, shard by shard: all shards
+    // are read-locked together, so no insert or removal lands midway, but
+    // only shards changed since taken was filled are copied; the others
+    // keep their entries. Sorting runs after the locks are released.
+    // Returns the version the entries belong to.
+    uint64_t collect(std::vector<ShardEntries>& taken) const;
+
+    size_t size() const;
+    size_t getShardCount() const;
+
+private:
+    struct Entry {
+        BookPtr book;
+        size_t row;  // the book's row in the shard's columns
+    };
+    
+    struct alignas(64) Shard {
+        mutable std::shared_mutex mutex;
+        FlatHashMap<Entry> books;  // by IsbnCodec key, entries stored inline
+        ColumnarCatalog columns;  // one row per book, for vectorized scans
+        uint64_t changes = 0;  // inserts and removals in this shard
+    };
+
+    std::unique_ptr<Shard[]> shards;
+    size_t shardMask;
+    std::atomic<size_t> bookCount{0};
+    std::atomic<uint64_t> changeCount{0};  // bumped under the changed shard's lock
+
+    Shard& shardFor(uint64_t key) const;
+};
+
+template <typename Fn>
+bool ShardedInventory::withShared(std::string_view isbn, Fn&& fn) const {
+    uint64_t key = IsbnCodec::pack(isbn);
+    if (key == IsbnCodec::INVALID_KEY) {
+        return false;
+    }
+    Shard& shard = shardFor(key);
+    std::shared_lock<std::shared_mutex> lock(shard.mutex);
+    const Entry* entry = shard.books.find(key);
+    if (!entry) {
+        return false;
+    }
+    fn(*entry->book);
+    return true;
+}
+
+template <typename Fn>
+bool ShardedInventory::withExclusive(std::string_view isbn, Fn&& fn) {
+    uint64_t key = IsbnCodec::pack(isbn);
+    if (key == IsbnCodec::INVALID_KEY) {
+        return false;
+    }
+    Shard& shard = shardFor(key);
+    std::unique_lock<std::shared_mutex> lock(shard.mutex);
+    Entry* entry = shard.books.find(key);
+    if (!entry) {
+        return false;
+    }
+    fn(*entry->book);
+    return true;
+}
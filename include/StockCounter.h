@@ -0,0 +1,123 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+
+class StockCounter;
+
+// Move-only handle for units held by StockCounter::reserve.
+// Units stay out of stock until commit() consumes them or release() returns
+// them; a handle destroyed while still active releases its hold.
+class StockReservation {
+private:
+    StockCounter* counter;
+    uint32_t slot;
+    uint64_t generation;  // or the hold's id in the overflow table
+    int quantity;
+
+    friend class StockCounter;
+    StockReservation(StockCounter* counter, uint32_t slot, uint64_t generation, int quantity);
+
+public:
+    StockReservation();
+    ~StockReservation();
+
+    StockReservation(StockReservation&& other) noexcept;
+    StockReservation& operator=(StockReservation&& other) noexcept;
+    StockReservation(const StockReservation&) = delete;
+    StockReservation& operator=(const StockReservation&) = delete;
+
+    // Consume the held units; false if the hold already expired or was released
+    bool commit();
+    // Return the held units to stock; false if the hold is no longer active
+    bool release();
+
+    bool isActive() const;
+    int getQuantity() const;
+    explicit operator bool() const;
+};
+
+// Lock-free stock counter. Starts as a single atomic; once CAS contention is
+// observed it inflates into per-core slabs that refill from the central pool
+// and steal from each other, so a bestseller's stock is not one hot cache line.
+class StockCounter {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    static constexpr size_t SLAB_COUNT = 8;
+    // Holds in the lock-free table; more spill into a locked overflow table
+    static constexpr size_t MAX_ACTIVE_HOLDS = 64;
+    static constexpr int MAX_HOLD_QUANTITY = (1 << 20) - 1;
+
+    explicit StockCounter(int initialUnits);
+    ~StockCounter();
+
+    StockCounter(const StockCounter&) = delete;
+    StockCounter& operator=(const StockCounter&) = delete;
+
+    // Units currently available (held units excluded)
+    int available() const;
+    // Units currently held by active reservations
+    int held() const;
+    // Units on the shelf: available plus held. Unlike the sum of the two,
+    // one read, and it moves only when units are sold or put back.
+    int onHand() const;
+
+    // Atomically take units for good; never drives stock below zero
+    bool tryTake(int quantity);
+    // Put units back on the shelf
+    void give(int quantity);
+
+    // Take units and record a hold that lapses after ttl (never, for
+    // Clock::duration::max()). Returns an empty handle if stock is
+    // insufficient.
+    StockReservation reserve(int quantity, Clock::duration ttl);
+
+    // Return units of holds whose deadline has passed; returns holds expired
+    size_t expireHolds(Clock::time_point now);
+
+private:
+    struct alignas(64) Slab {
+        std::atomic<int> units{0};
+    };
+
+    // Each hold is one word: [generation:32][pending:1][quantity:20], with
+    // a zero quantity marking a free slot. Its deadline sits beside it and
+    // is written while the slot is still pending, so an expiry scan never
+    // pairs a hold with the deadline of the slot's previous occupant.
+    struct HoldTable {
+        std::atomic<uint64_t> slots[MAX_ACTIVE_HOLDS];
+        std::atomic<Clock::rep> deadlines[MAX_ACTIVE_HOLDS];
+        HoldTable();
+
+        // Holds that found every slot taken, by id
+        struct Overflow {
+            int quantity;
+            Clock::rep deadline;
+        };
+        std::mutex overflowMutex;
+        std::unordered_map<uint64_t, Overflow> overflow;
+        uint64_t nextOverflowId = 1;
+    };
+
+    alignas(64) std::atomic<int> central;
+    std::atomic<int> shelved;  // onHand()
+    std::atomic<int> conflicts{0};
+    std::atomic<Slab*> slabs{nullptr};
+    std::atomic<HoldTable*> holds{nullptr};
+
+    friend class StockReservation;
+
+    // Move units out of or back into available stock; holds move units
+    // without changing onHand()
+    bool takeUnits(int quantity);
+    void giveUnits(int quantity);
+    bool takeFromSlabs(Slab* slabArray, int quantity);
+    void noteContention();
+    HoldTable* holdTable();
+    // Clear a hold matching the generation; optionally return its units to stock
+    bool finishHold(uint32_t slot, uint64_t generation, bool returnUnits);
+};
@@ -0,0 +1,75 @@
+#pragma once
+#include "CatalogExporter.h"
+#include "StoreProtocol.h"
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Outcome of one pipelined request; which value is set depends on the op
+struct RpcReply {
+    RpcOp op;
+    RpcStatus status = RpcStatus::Ok;
+    std::string error;               // message of a failed request
+    std::optional<BookRecord> book;  // FindBook
+    double amountPaid = 0;           // BuyBook
+    uint64_t removed = 0;            // RemoveOutdated
+    ExportCursor cursor;             // ExportPage
+    std::string data;                // ExportPage
+
+    bool ok() const { return status == RpcStatus::Ok; }
+};
+
+// Blocking client for StoreServer over one connection; not thread-safe, so
+// use one client per thread. Single calls send one request and wait for its
+// reply, and map failures to the exceptions the store itself throws
+// (std::invalid_argument or std::runtime_error); they throw
+// std::logic_error while requests are queued. For throughput, queue many
+// requests and send them with flush(), which writes them in one go and
+// returns the replies in order.
+class StoreClient {
+public:
+    // Throw std::runtime_error if the server cannot be reached
+    static StoreClient connectUnix(const std::string& path);
+    static StoreClient connectTcp(uint16_t port, const std::string& host = "127.0.0.1");
+
+    StoreClient(StoreClient&& other) noexcept;
+    StoreClient& operator=(StoreClient&& other) noexcept;
+    ~StoreClient();
+
+    void addBook(const BookRecord& book);
+    std::optional<BookRecord> findBook(std::string_view isbn);
+    double buyBook(std::string_view isbn, int quantity, std::string_view customerEmail,
+                   std::string_view shippingAddress);
+    uint64_t removeOutdated(int currentYear, int yearsThreshold);
+    // One page of an export; data receives the page's bytes
+    ExportCursor exportPage(ExportFormat format, size_t maxRows, const ExportCursor& cursor, std::string& data);
+
+    // Pipelining
+    void queueAddBook(const BookRecord& book);
+    void queueFindBook(std::string_view isbn);
+    void queueBuyBook(std::string_view isbn, int quantity, std::string_view customerEmail,
+                      std::string_view shippingAddress);
+    void queueRemoveOutdated(int currentYear, int yearsThreshold);
+    void queueExportPage(ExportFormat format, size_t maxRows, const ExportCursor& cursor);
+    size_t queued() const { return pendingOps.size(); }
+    // Send everything queued and wait for all replies
+    std::vector<RpcReply> flush();
+    // The same, reusing replies' storage; for hot loops
+    void flush(std::vector<RpcReply>& replies);
+
+private:
+    int fd;
+    uint32_t nextId = 1;
+    std::string request;
+    std::vector<RpcOp> pendingOps;
+    std::vector<char> response;
+
+    explicit StoreClient(int fd) : fd(fd) {}
+    WireWriter beginRequest(RpcOp op);
+    void requireIdle() const;
+    RpcReply callOne();
+    static void throwIfFailed(const RpcReply& reply);
+};
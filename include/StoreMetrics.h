@@ -0,0 +1,234 @@
+#pragma once
+#include "Book.h"
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Public QuantumBookstore operations that are counted and timed
+enum class StoreOp : uint8_t {
+    AddBook,
+    SaveSnapshot,
+    LoadSnapshot,
+    ImportCatalog,
+    OpenWriteAheadLog,
+    OpenChangeFeed,
+    Checkpoint,
+    RemoveOutdated,
+    BuyBook,
+    BuyBooks,
+    WaitForFulfillment,
+    ExpireReservations,
+    FindBooksByAuthor,
+    FindBooksPublishedBetween,
+    FindBooksInPriceRange,
+    FindOutOfStock,
+    SearchBooks,
+    FindBooksByKind,
+    PrintInventory,
+    ExportCatalog,
+    GetInventorySize,
+    FindBook,
+    FindBooks,
+    Analyze,
+    Count
+};
+
+// Why a store call was rejected
+enum class StoreFailure : uint8_t {
+    InvalidQuantity,    // zero or negative quantity
+    UnknownIsbn,        // no such book
+    NotForSale,         // showcase books
+    InsufficientStock,
+    DuplicateIsbn,      // addBook of an ISBN already present
+    NullBook,           // addBook(nullptr)
+    InvalidIsbn,        // addBook of an ISBN that does not parse
+    Overloaded,         // shed by admission control: wait queue full
+    DeadlineExceeded,   // shed by admission control: waited too long
+    Count
+};
+
+constexpr size_t STORE_OP_COUNT = static_cast<size_t>(StoreOp::Count);
+constexpr size_t STORE_FAILURE_COUNT = static_cast<size_t>(StoreFailure::Count);
+constexpr size_t BOOK_KIND_COUNT = static_cast<size_t>(BookKind::Other) + 1;
+
+// Method name of an operation, e.g. "buyBook"
+std::string_view storeOpName(StoreOp op);
+// Metric label of a failure reason, e.g. "insufficient_stock"
+std::string_view storeFailureName(StoreFailure failure);
+
+// Log-linear latency histogram in nanoseconds, in the style of HdrHistogram:
+// every power of two is split into 2^SUB_BUCKET_BITS equal buckets, so a
+// recorded value is off by at most 1/16 (6.25%). Values from 2^MAX_EXPONENT
+// ns (about 18 minutes) up land in the last bucket.
+class LatencyHistogram {
+public:
+    static constexpr int SUB_BUCKET_BITS = 4;
+    static constexpr int MAX_EXPONENT = 40;
+    static constexpr size_t SUB_BUCKETS = size_t(1) << SUB_BUCKET_BITS;
+    static constexpr size_t BUCKET_COUNT = (MAX_EXPONENT - SUB_BUCKET_BITS + 1) * SUB_BUCKETS;
+
+    static size_t bucketFor(uint64_t nanos) {
+        if (nanos < SUB_BUCKETS) {
+            return static_cast<size_t>(nanos);
+        }
+        int exponent = 63 - __builtin_clzll(nanos);
+        if (exponent >= MAX_EXPONENT) {
+            return BUCKET_COUNT - 1;
+        }
+        int shift = exponent - SUB_BUCKET_BITS;
+        return (shift + 1) * SUB_BUCKETS + static_cast<size_t>((nanos >> shift) - SUB_BUCKETS);
+    }
+    // Smallest value that falls into a bucket; its upper bound is the
+    // lower bound of the next one
+    static uint64_t bucketLowerBound(size_t bucket);
+
+    void record(uint64_t nanos);
+    void merge(const LatencyHistogram& other);
+
+    uint64_t count() const { return total; }
+    uint64_t sumNanos() const { return sum; }
+    uint64_t maxNanos() const { return max; }
+    // Upper bound of the bucket holding the given fraction of values
+    // (0.5 = median); 0 if nothing was recorded
+    uint64_t percentile(double fraction) const;
+    uint64_t bucketCount(size_t bucket) const { return buckets[bucket]; }
+
+private:
+    friend class StoreMetrics;  // fills snapshots straight from its counters
+
+    std::array<uint64_t, BUCKET_COUNT> buckets{};
+    uint64_t total = 0;
+    uint64_t sum = 0;
+    uint64_t max = 0;
+};
+
+// Point-in-time copy of a store's metrics. Snapshots of several stores (or
+// of one store over time windows taken by the caller) can be merged.
+struct MetricsSnapshot {
+    std::array<uint64_t, STORE_OP_COUNT> calls{};              // every call, exact
+    std::array<LatencyHistogram, STORE_OP_COUNT> latency;      // sampled calls
+    std::array<uint64_t, STORE_FAILURE_COUNT> failures{};
+    std::array<uint64_t, BOOK_KIND_COUNT> unitsSold{};         // by BookKind
+    uint64_t booksRemoved = 0;                                 // by removeOutdated
+    // Gauges, summed by merge
+    uint64_t inventorySize = 0;
+    int64_t totalStock = 0;                                    // available paper stock
+
+    uint64_t callCount(StoreOp op) const { return calls[static_cast<size_t>(op)]; }
+    const LatencyHistogram& latencyOf(StoreOp op) const { return latency[static_cast<size_t>(op)]; }
+    uint64_t failureCount(StoreFailure failure) const { return failures[static_cast<size_t>(failure)]; }
+    uint64_t soldOf(BookKind kind) const { return unitsSold[static_cast<size_t>(kind)]; }
+
+    void merge(const MetricsSnapshot& other);
+
+    // Prometheus text exposition format (version 0.0.4). Latency buckets
+    // are exported at power-of-two nanosecond bounds from 128 ns to 2^36 ns.
+    std::string toPrometheus() const;
+};
+
+// Per-store counters and latency histograms. Each thread writes its own
+// slot with relaxed atomic stores, so recording never contends; snapshot()
+// sums the slots. Latency costs two clock reads, so cheap lookups time only
+// every Nth call (see setSamplePeriod) while their call counts stay exact.
+class StoreMetrics {
+private:
+    // One thread's counters; only the owning thread writes them
+    struct Slot {
+        struct OpStats {
+            std::atomic<uint64_t> calls{0};
+            std::atomic<uint64_t> samples{0};
+            std::atomic<uint64_t> sumNanos{0};
+            std::atomic<uint64_t> maxNanos{0};
+            std::atomic<uint64_t> buckets[LatencyHistogram::BUCKET_COUNT] = {};
+        };
+
+        OpStats ops[STORE_OP_COUNT];
+        std::atomic<uint64_t> failures[STORE_FAILURE_COUNT] = {};
+        std::atomic<uint64_t> unitsSold[BOOK_KIND_COUNT] = {};
+        std::atomic<uint64_t> booksRemoved{0};
+        std::atomic<bool> owned{true};
+    };
+
+    // Single writer, so a relaxed load and store is enough and avoids a locked add
+    static void bump(std::atomic<uint64_t>& counter, uint64_t amount) {
+        counter.store(counter.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+    }
+
+public:
+    // Records the latency of one call when it goes out of scope
+    class Timer {
+    public:
+        Timer(Timer&& other) noexcept;
+        Timer& operator=(Timer&&) = delete;
+        ~Timer() {
+            if (slot) {
+                record();
+            }
+        }
+
+    private:
+        friend class StoreMetrics;
+        Timer(Slot* slot, StoreOp op, bool sampled) : slot(sampled ? slot : nullptr), op(op) {
+            if (sampled) {
+                start = std::chrono::steady_clock::now();
+            }
+        }
+        void record();
+
+        Slot* slot;
+        StoreOp op;
+        std::chrono::steady_clock::time_point start;
+    };
+
+    static constexpr uint32_t DEFAULT_LOOKUP_SAMPLE_PERIOD = 64;
+
+    // findBook and getInventorySize are sampled every
+    // DEFAULT_LOOKUP_SAMPLE_PERIOD calls; everything else on every call
+    StoreMetrics();
+    ~StoreMetrics();
+
+    StoreMetrics(const StoreMetrics&) = delete;
+    StoreMetrics& operator=(const StoreMetrics&) = delete;
+
+    // Count a call and, if it is sampled, time it until the timer goes away
+    Timer time(StoreOp op) {
+        Slot& slot = localSlot();
+        std::atomic<uint64_t>& calls = slot.ops[static_cast<size_t>(op)].calls;
+        uint64_t call = calls.load(std::memory_order_relaxed);
+        calls.store(call + 1, std::memory_order_relaxed);
+        uint32_t mask = sampleMasks[static_cast<size_t>(op)].load(std::memory_order_relaxed);
+        return Timer(&slot, op, (call & mask) == 0);
+    }
+    void countFailure(StoreFailure failure);
+    void countSold(BookKind kind, int quantity);
+    void countRemoved(size_t books);
+
+    // Time one in every period calls of op (rounded up to a power of two;
+    // 1 times every call)
+    void setSamplePeriod(StoreOp op, uint32_t period);
+
+    // Counters and histograms summed over all threads; gauges are left 0
+    MetricsSnapshot snapshot() const;
+
+private:
+    const uint64_t id;
+    std::array<std::atomic<uint32_t>, STORE_OP_COUNT> sampleMasks;
+    mutable std::mutex registryMutex;
+    std::vector<std::shared_ptr<Slot>> slots;  // threads keep their slot alive too
+
+    // Last slot this thread used; plain data, so reading it needs no TLS guard
+    static inline thread_local uint64_t cachedId = 0;
+    static inline thread_local Slot* cachedSlot = nullptr;
+
+    Slot& localSlot() {
+        return cachedId == id ? *cachedSlot : registerThread();
+    }
+    Slot& registerThread();
+};
@@ -0,0 +1,129 @@
+#pragma once
+#include "Book.h"
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+// Binary request/response protocol of StoreServer and StoreClient. Every
+// frame is a u32 length of the rest of the frame, a u32 request id chosen
+// by the client and echoed in the response, then a u8 op (requests) or
+// status (responses) and the payload. Integers and doubles are in host
+// byte order, since both ends run on the same machine; strings are a u32
+// length and the bytes. Clients may send many requests before reading any
+// response; responses come back in request order.
+//
+// Payloads:
+//   AddBook         book                            -> (empty)
+//   FindBook        isbn                            -> book
+//   BuyBook         i32 quantity, isbn, email, address -> f64 amount paid
+//   RemoveOutdated  i32 current year, i32 years threshold -> u64 books removed
+//   ExportPage      u8 format, u32 max rows, cursor -> cursor, string data
+//   any failure                                     -> string message
+// A book is u8 kind, i32 year, f64 price, i32 stock (paper books), isbn,
+// title, author and file type (ebooks); a cursor is u64 afterKey,
+// u64 rowsExported and u8 flags (1 finished, 2 header written).
+enum class RpcOp : uint8_t {
+    AddBook = 1,
+    FindBook,
+    BuyBook,
+    RemoveOutdated,
+    ExportPage
+};
+
+enum class RpcStatus : uint8_t {
+    Ok = 0,
+    NotFound,          // FindBook of an unknown ISBN
+    InvalidArgument,   // the store threw std::invalid_argument
+    Rejected,          // the store refused the call (unknown book, stock, ...)
+    BadRequest,        // malformed payload or unknown op
+    ServerError
+};
+
+constexpr size_t RPC_FRAME_HEADER_BYTES = 9;  // length, id, op/status
+
+// Plain copy of a book as sent over the wire
+struct BookRecord {
+    BookKind kind = BookKind::Paper;
+    std::string isbn;
+    std::string title;
+    std::string author;
+    std::string fileType;  // ebooks only
+    int year = 0;
+    double price = 0;
+    int stock = 0;         // paper books only
+};
+
+// A frame whose payload does not match its op
+class RpcFormatError : public std::runtime_error {
+public:
+    using std::runtime_error::runtime_error;
+};
+
+// Appends frames to a buffer
+class WireWriter {
+public:
+    explicit WireWriter(std::string& out) : out(out) {}
+
+    // Start a frame; end it with endFrame once its payload is written
+    void beginFrame(uint32_t id, uint8_t opOrStatus) {
+        frameStart = out.size();
+        put(uint32_t{0});
+        put(id);
+        put(opOrStatus);
+    }
+    void endFrame() {
+        uint32_t length = static_cast<uint32_t>(out.size() - frameStart - sizeof(uint32_t));
+        std::memcpy(&out[frameStart], &length, sizeof(length));
+    }
+
+    template <typename T>
+    void put(T value) {
+        out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+    }
+    void putString(std::string_view text) {
+        put(static_cast<uint32_t>(text.size()));
+        out.append(text.data(), text.size());
+    }
+    void putBook(const Book& book);
+    void putBook(const BookRecord& book);
+
+private:
+    std::string& out;
+    size_t frameStart = 0;
+};
+
+// Reads a frame's payload; throws RpcFormatError if it is too short
+class WireReader {
+public:
+    WireReader(const char* data, size_t size) : data(data), size(size) {}
+
+    template <typename T>
+    T get() {
+        T value;
+        std::memcpy(&value, take(sizeof(T)), sizeof(T));
+        return value;
+    }
+    std::string_view getString() {
+        uint32_t length = get<uint32_t>();
+        return std::string_view(take(length), length);
+    }
+    BookRecord getBook();
+    bool atEnd() const { return position == size; }
+
+private:
+    const char* data;
+    size_t size;
+    size_t position = 0;
+
+    const char* take(size_t bytes) {
+        if (bytes > size - position) {
+            throw RpcFormatError("Truncated RPC payload");
+        }
+        const char* at = data + position;
+        position += bytes;
+        return at;
+    }
+};
@@ -0,0 +1,65 @@
+#pragma once
+#include "StoreMetrics.h"
+#include <optional>
+#include <string>
+#include <utility>
+#include <variant>
+
+// Why a non-throwing store call was refused, with the details needed to
+// describe it; nothing is formatted until message() is called
+struct StoreError {
+    StoreFailure code;
+    std::string isbn;    // short enough for the small-string buffer in practice
+    int requested = 0;   // InvalidQuantity, InsufficientStock
+    int available = 0;   // InsufficientStock
+
+    // The text of the exception the throwing call raises
+    std::string message() const;
+    // Throw that exception: std::invalid_argument for bad arguments and
+    // duplicates, std::runtime_error otherwise
+    [[noreturn]] void raise() const;
+};
+
+// Value of a non-throwing store call, or why it was refused
+template <typename T>
+class [[nodiscard]] StoreResult {
+public:
+    StoreResult(T value) : outcome(std::in_place_index<0>, std::move(value)) {}
+    StoreResult(StoreError error) : outcome(std::in_place_index<1>, std::move(error)) {}
+
+    bool ok() const { return outcome.index() == 0; }
+    explicit operator bool() const { return ok(); }
+
+    // The value; raises the error if the call was refused
+    const T& value() const {
+        if (const StoreError* failure = std::get_if<1>(&outcome)) {
+            failure->raise();
+        }
+        return *std::get_if<0>(&outcome);
+    }
+    // Only valid if !ok()
+    const StoreError& error() const { return *std::get_if<1>(&outcome); }
+
+private:
+    std::variant<T, StoreError> outcome;
+};
+
+template <>
+class [[nodiscard]] StoreResult<void> {
+public:
+    StoreResult() = default;
+    StoreResult(StoreError error) : failure(std::move(error)) {}
+
+    bool ok() const { return !failure; }
+    explicit operator bool() const { return ok(); }
+
+    void value() const {
+        if (failure) {
+            failure->raise();
+        }
+    }
+    const StoreError& error() const { return *failure; }
+
+private:
+    std::optional<StoreError> failure;
+};
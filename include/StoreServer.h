@@ -0,0 +1,67 @@
+#pragma once
+#include "QuantumBookstore.h"
+#include "StoreProtocol.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct ServerConfig {
+    size_t reactors = 0;                 // event loop threads; 0 = one per hardware thread
+    size_t maxFrameBytes = 16 << 20;     // larger requests close the connection
+    size_t maxExportRows = 100000;       // per ExportPage request
+    size_t maxPendingOutput = 4 << 20;   // stop reading a connection until its replies drain
+};
+
+// Serves a QuantumBookstore over Unix domain sockets and loopback TCP with
+// the StoreProtocol frames. Each reactor thread runs its own epoll loop;
+// listening sockets are shared with EPOLLEXCLUSIVE so every accepted
+// connection stays on one reactor. All complete frames read from a
+// connection are handled as one batch: consecutive FindBook requests are
+// looked up together with findBooks (one lock per shard), and the replies
+// of the whole batch go out in one write.
+class StoreServer {
+public:
+    explicit StoreServer(QuantumBookstore& store, ServerConfig config = ServerConfig());
+    // Stops the reactors and closes every socket
+    ~StoreServer();
+
+    StoreServer(const StoreServer&) = delete;
+    StoreServer& operator=(const StoreServer&) = delete;
+
+    // Add listening sockets; call before start. Throws std::runtime_error
+    // if the socket cannot be bound. An existing socket file at path is
+    // replaced.
+    void listenUnix(const std::string& path);
+    // Binds 127.0.0.1; port 0 picks a free port. Returns the bound port.
+    uint16_t listenTcp(uint16_t port = 0);
+
+    void start();
+    // Close every connection and join the reactors; requests in flight are
+    // finished first
+    void stop();
+
+    uint64_t requestsServed() const { return served.load(std::memory_order_relaxed); }
+    size_t reactorCount() const { return reactors.size(); }
+
+private:
+    struct Connection;
+    class Reactor;
+
+    QuantumBookstore& store;
+    ServerConfig config;
+    std::vector<int> listeners;
+    std::vector<std::string> unixPaths;
+    std::vector<std::unique_ptr<Reactor>> reactors;
+    std::atomic<uint64_t> served{0};
+    bool running = false;
+
+    // Handle every complete frame in conn's input; returns false if the
+    // connection must be closed
+    bool handleInput(Connection& conn);
+    void handleRequest(uint32_t id, RpcOp op, WireReader& payload, std::string& out);
+    void handleFinds(const std::vector<std::pair<uint32_t, std::string_view>>& finds, std::string& out);
+};
@@ -0,0 +1,52 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Persistent worker threads for data-parallel loops. The calling thread
+// takes part as worker 0, so a pool of size 1 has no threads of its own.
+// Loops from different callers run one after another.
+class TaskPool {
+public:
+    using Task = std::function<void(size_t task, size_t worker)>;
+
+    // threads = total parallelism; 0 = one per hardware thread
+    explicit TaskPool(size_t threads = 0);
+    ~TaskPool();
+
+    TaskPool(const TaskPool&) = delete;
+    TaskPool& operator=(const TaskPool&) = delete;
+
+    size_t size() const { return workers.size() + 1; }
+
+    // Run fn(task, worker) for every task in [0, tasks) on up to
+    // maxWorkers threads, worker being in [0, min(size(), maxWorkers)).
+    // Tasks are claimed dynamically, so uneven ones balance out. Returns
+    // once all have run; the first exception thrown is rethrown then.
+    void parallelFor(size_t tasks, const Task& fn, size_t maxWorkers = SIZE_MAX);
+
+private:
+    std::vector<std::thread> workers;
+    std::mutex loopMutex;  // one loop at a time
+
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+    bool stopping = false;
+    uint64_t generation = 0;
+    const Task* current = nullptr;
+    size_t taskCount = 0;
+    size_t activeWorkers = 0;
+    size_t running = 0;  // workers still in the current loop
+    std::atomic<size_t> nextTask{0};
+    std::exception_ptr failure;
+
+    void workerLoop(size_t worker);
+    void runTasks(size_t worker);
+};
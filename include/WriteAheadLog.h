@@ -0,0 +1,140 @@
+#pragma once
+#include "Book.h"
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+// Group commit settings for the write-ahead log
+struct WalConfig {
+    // Latency budget: how long the first commit of a batch may wait for
+    // others to join before the sync starts. Even at zero, commits that
+    // arrive while a sync is in flight share the next one.
+    std::chrono::microseconds commitDelay{0};
+    // Start the sync before the budget runs out once this much is pending
+    size_t maxBatchBytes = 1 << 20;
+    // fdatasync every batch; turning it off only survives process crashes
+    bool syncToDisk = true;
+};
+
+// One line of a logged sale
+struct WalSaleLine {
+    uint64_t isbnKey;  // IsbnCodec key
+    int32_t quantity;
+};
+
+// A mutation read back from the log. Views point into the replay buffer
+// and are valid only during the visit.
+struct WalEntry {
+    enum class Type : uint8_t { AddBook = 1, Sale = 2, RemoveBook = 3 };
+
+    Type type;
+    uint64_t lsn;
+    // AddBook
+    BookKind kind;
+    int year;
+    double price;
+    int stock;
+    BookText text;
+    std::string_view fileType;
+    // Sale
+    std::vector<WalSaleLine> lines;
+    // RemoveBook
+    uint64_t isbnKey;
+};
+
+// Payload encoding of the log's records, native-endian. Shared with
+// ChangeFeed, so replicas apply exactly what a log replay would.
+class WalCodec {
+public:
+    static constexpr size_t REMOVE_BOOK_SIZE = 8;
+
+    // Throws std::invalid_argument for book types outside the built-in kinds
+    static size_t addBookSize(const Book& book);
+    static void encodeAddBook(const Book& book, char* out);
+    // Throws std::invalid_argument past UINT16_MAX lines
+    static size_t saleSize(size_t count);
+    static void encodeSale(const WalSaleLine* lines, size_t count, char* out);
+    static void encodeRemoveBook(uint64_t isbnKey, char* out);
+
+    // Decode a payload of entry.type into entry; false if it does not
+    // parse. Text views point into payload.
+    static bool decode(WalEntry& entry, const char* payload, size_t size);
+};
+
+// Append-only log of inventory mutations. Each record carries a log
+// sequence number (LSN) and a CRC32C. Appends only copy into a memory
+// buffer; a flusher thread writes whatever has accumulated with one
+// write and one fdatasync, so concurrent commits share the cost of a sync.
+class WriteAheadLog {
+public:
+    // Open (creating if needed) the log at path. A torn record left at the
+    // tail by a crash is cut off. New records get LSNs above both the last
+    // one in the file and startAfter. Throws std::runtime_error on I/O errors.
+    WriteAheadLog(const std::string& path, WalConfig config = WalConfig(), uint64_t startAfter = 0);
+    // Writes and syncs whatever is still pending
+    ~WriteAheadLog();
+
+    WriteAheadLog(const WriteAheadLog&) = delete;
+    WriteAheadLog& operator=(const WriteAheadLog&) = delete;
+
+    // Append a record and return its LSN; the record is durable once
+    // waitDurable(lsn) returns
+    uint64_t appendAddBook(const Book& book);
+    uint64_t appendSale(const WalSaleLine* lines, size_t count);
+    uint64_t appendRemoveBook(uint64_t isbnKey);
+
+    // Block until every record up to lsn is on disk. Throws
+    // std::runtime_error if a write or sync failed; the log stays failed.
+    void waitDurable(uint64_t lsn);
+
+    // Drop the records up to throughLsn once a snapshot has captured them;
+    // later ones, appended while the snapshot was written, are kept. LSNs
+    // keep counting up. Appends wait while the file is rewritten.
+    void truncate(uint64_t throughLsn);
+
+    uint64_t lastLsn() const;
+    uint64_t durableLsn() const;
+    uint64_t getSyncCount() const;
+
+    // Call visit for every intact record of the log at path with an LSN
+    // above afterLsn, in log order, stopping at the first torn or corrupt
+    // record. A missing file is an empty log. Returns the last LSN read.
+    static uint64_t replay(const std::string& path, uint64_t afterLsn,
+                           const std::function<void(const WalEntry&)>& visit);
+
+private:
+    const WalConfig config;
+    const std::string path;
+    int fd;
+
+    mutable std::mutex mutex;
+    std::condition_variable wakeFlusher;
+    std::condition_variable durableChanged;
+    std::vector<char> pending;   // encoded records not yet handed to the flusher
+    std::vector<char> writing;   // the batch being written, owned by the flusher
+    std::chrono::steady_clock::time_point batchStart;
+    uint64_t nextLsn;
+    uint64_t durable;
+    uint64_t syncCount = 0;
+    std::string failure;
+    bool stopping = false;
+    bool flushing = false;    // a batch is being written
+    bool truncating = false;  // truncate() owns the file; batches wait
+    std::thread flusher;
+
+    // Assign the next LSN and encode a record into the pending buffer;
+    // encode(char*) writes payloadSize bytes of payload
+    template <typename Encode>
+    uint64_t append(WalEntry::Type type, size_t payloadSize, Encode&& encode);
+    void run();
+    // Write the records after throughLsn to a new log file in place of the
+    // old one; returns its descriptor
+    int rewriteAfter(uint64_t throughLsn);
+};
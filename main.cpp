@@ -39,11 +39,13 @@ int main() {
         // Buy a paper book
         double amount1 = store.buyBook("978-0134685991", 2, 
             "test@test.com", "Cairo, Egypt");
+        Logger::global().flush();
         std::cout << "Amount paid: $" << amount1 << std::endl;
         
         // Buy an ebook
         double amount2 = store.buyBook("978-0321714114", 1, 
             "test2@test.com", "New Cairo, Egypt");
+        Logger::global().flush();
         std::cout << "Amount paid: $" << amount2 << std::endl;
         
         std::cout << "\n--- After Purchases ---" << std::endl;
@@ -51,6 +53,7 @@ int main() {
         
         std::cout << "\n--- Removing Outdated Books (>10 years from 2025) ---" << std::endl;
         auto outdatedBooks = store.removeOutdated(2025, 10);
+        Logger::global().flush();
         std::cout << "Removed " << outdatedBooks.size() << " outdated book(s)" << std::endl;
         
         std::cout << "\n--- Final Inventory ---" << std::endl;
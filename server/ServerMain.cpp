@@ -0,0 +1,112 @@
+#include "../include/LoadGenerator.h"
+#include "../include/Logger.h"
+#include "../include/QuantumBookstore.h"
+#include "../include/StoreServer.h"
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+namespace {
+
+void printUsage() {
+    std::cout << "Usage: quantum_bookstore_server [options]\n"
+                 "  --unix=PATH         listen on a Unix domain socket\n"
+                 "  --port=N            listen on 127.0.0.1:N (0 picks a free port)\n"
+                 "  --reactors=N        event loop threads (default: one per core)\n"
+                 "  --snapshot=FILE     load the catalog from a snapshot\n"
+                 "  --import=FILE       import the catalog from a CSV or JSON Lines file\n"
+                 "  --catalog=N         fill the catalog with N synthetic books\n"
+                 "At least one of --unix and --port is required. Stops on SIGINT or SIGTERM.\n";
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    std::string unixPath;
+    int port = -1;
+    ServerConfig config;
+    std::string snapshotPath;
+    std::string importPath;
+    size_t catalogSize = 0;
+    try {
+        for (int i = 1; i < argc; ++i) {
+            const char* arg = argv[i];
+            const char* value = std::strchr(arg, '=');
+            value = value ? value + 1 : "";
+            if (std::strncmp(arg, "--unix=", 7) == 0) {
+                unixPath = value;
+            } else if (std::strncmp(arg, "--port=", 7) == 0) {
+                port = std::stoi(value);
+            } else if (std::strncmp(arg, "--reactors=", 11) == 0) {
+                config.reactors = std::stoull(value);
+            } else if (std::strncmp(arg, "--snapshot=", 11) == 0) {
+                snapshotPath = value;
+            } else if (std::strncmp(arg, "--import=", 9) == 0) {
+                importPath = value;
+            } else if (std::strncmp(arg, "--catalog=", 10) == 0) {
+                catalogSize = std::stoull(value);
+            } else {
+                printUsage();
+                return std::strcmp(arg, "--help") == 0 ? 0 : 2;
+            }
+        }
+    } catch (const std::exception&) {
+        printUsage();
+        return 2;
+    }
+    if (unixPath.empty() && port < 0) {
+        printUsage();
+        return 2;
+    }
+
+    // Block the stop signals in every thread, then wait for them here
+    sigset_t stopSignals;
+    sigemptyset(&stopSignals);
+    sigaddset(&stopSignals, SIGINT);
+    sigaddset(&stopSignals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &stopSignals, nullptr);
+
+    try {
+        Logger::global().setLevel(LogLevel::Warning);
+        QuantumBookstore store;
+        if (!snapshotPath.empty()) {
+            store.loadSnapshot(snapshotPath);
+        }
+        if (!importPath.empty()) {
+            store.importCatalog(importPath);
+        }
+        if (catalogSize > 0) {
+            LoadConfig catalog;
+            catalog.catalogSize = catalogSize;
+            LoadGenerator::buildCatalog(store, catalog);
+        }
+
+        StoreServer server(store, config);
+        if (!unixPath.empty()) {
+            server.listenUnix(unixPath);
+        }
+        uint16_t boundPort = port >= 0 ? server.listenTcp(static_cast<uint16_t>(port)) : 0;
+        server.start();
+        std::cout << "Serving " << store.getInventorySize() << " book(s) on " << server.reactorCount()
+                  << " reactor(s)";
+        if (!unixPath.empty()) {
+            std::cout << ", unix:" << unixPath;
+        }
+        if (port >= 0) {
+            std::cout << ", tcp:127.0.0.1:" << boundPort;
+        }
+        std::cout << std::endl;
+
+        int signal = 0;
+        sigwait(&stopSignals, &signal);
+        server.stop();
+        std::cout << "Stopped after " << server.requestsServed() << " request(s)" << std::endl;
+    } catch (const std::exception& error) {
+        std::cerr << error.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,251 @@
+#include "../include/AdmissionControl.h"
+#include <algorithm>
+#include <stdexcept>
+
+namespace {
+
+constexpr uint64_t FIXED_ONE = 1024;
+
+void validate(const ClassLimits& limits, const char* name) {
+    if (limits.minLimit == 0 || limits.minLimit > limits.maxLimit || limits.initialLimit < limits.minLimit ||
+        limits.initialLimit > limits.maxLimit) {
+        throw std::invalid_argument(std::string("Admission limits of ") + name +
+                                    " must satisfy 0 < minLimit <= initialLimit <= maxLimit");
+    }
+    if (!(limits.backoff > 0.0 && limits.backoff < 1.0)) {
+        throw std::invalid_argument(std::string("Admission backoff of ") + name + " must be between 0 and 1");
+    }
+}
+
+int64_t wholeLimit(uint64_t limitFixed) {
+    return static_cast<int64_t>(limitFixed / FIXED_ONE);
+}
+
+} // namespace
+
+AdmissionController::Permit::Permit(Permit&& other) noexcept
+    : controller(other.controller), requestClass(other.requestClass), start(other.start), refusal(other.refusal) {
+    other.controller = nullptr;
+}
+
+AdmissionController::Permit& AdmissionController::Permit::operator=(Permit&& other) noexcept {
+    if (this != &other) {
+        release();
+        controller = other.controller;
+        requestClass = other.requestClass;
+        start = other.start;
+        refusal = other.refusal;
+        other.controller = nullptr;
+    }
+    return *this;
+}
+
+void AdmissionController::Permit::release() {
+    if (AdmissionController* owner = controller) {
+        controller = nullptr;
+        owner->release(requestClass, start);
+    }
+}
+
+AdmissionController::AdmissionController(AdmissionConfig config) {
+    validate(config.reads, "reads");
+    validate(config.purchases, "purchases");
+    state(RequestClass::Read).limits = config.reads;
+    state(RequestClass::Purchase).limits = config.purchases;
+    for (ClassState& each : classes) {
+        each.limitFixed.store(each.limits.initialLimit * FIXED_ONE, std::memory_order_relaxed);
+    }
+}
+
+AdmissionController::Permit AdmissionController::admit(RequestClass requestClass, Clock::time_point deadline) {
+    ClassState& target = state(requestClass);
+    Permit permit;
+    permit.requestClass = requestClass;
+    Clock::time_point now = Clock::now();
+
+    // Below the limit with nobody waiting: take a slot without locking
+    int64_t current = target.inFlight.load(std::memory_order_relaxed);
+    while (current < wholeLimit(target.limitFixed.load(std::memory_order_relaxed)) &&
+           target.queued.load() == 0) {
+        if (target.inFlight.compare_exchange_weak(current, current + 1)) {
+            target.admitted.fetch_add(1, std::memory_order_relaxed);
+            permit.controller = this;
+            permit.start = now;
+            return permit;
+        }
+    }
+
+    std::unique_lock<std::mutex> lock(target.mutex);
+    if (target.waiters.size() >= target.limits.queueCapacity) {
+        target.shedOverloaded.fetch_add(1, std::memory_order_relaxed);
+        permit.refusal = StoreFailure::Overloaded;
+        return permit;
+    }
+    Clock::time_point until = std::min(deadline, now + target.limits.maxQueueWait);
+    if (until <= now) {
+        target.shedDeadline.fetch_add(1, std::memory_order_relaxed);
+        permit.refusal = StoreFailure::DeadlineExceeded;
+        return permit;
+    }
+
+    Waiter waiter;
+    target.waiters.push_back(&waiter);
+    target.queued.fetch_add(1);
+    // A slot may have freed up since the fast path looked
+    grantWaiters(target);
+    if (!waiter.ready.wait_until(lock, until, [&waiter]() { return waiter.granted; })) {
+        target.waiters.erase(std::find(target.waiters.begin(), target.waiters.end(), &waiter));
+        target.queued.fetch_sub(1);
+        target.shedDeadline.fetch_add(1, std::memory_order_relaxed);
+        permit.refusal = StoreFailure::DeadlineExceeded;
+        return permit;
+    }
+    target.admitted.fetch_add(1, std::memory_order_relaxed);
+    permit.controller = this;
+    permit.start = Clock::now();
+    return permit;
+}
+
+void AdmissionController::release(RequestClass requestClass, Clock::time_point start) {
+    ClassState& target = state(requestClass);
+    Clock::duration latency = Clock::now() - start;
+    int64_t inFlight = target.inFlight.fetch_sub(1);
+    adapt(target, latency, inFlight);
+    // Pairs with the waiter's increment of queued before grantWaiters, so
+    // either this sees the waiter or the waiter sees the free slot
+    if (target.queued.load() > 0) {
+        std::lock_guard<std::mutex> lock(target.mutex);
+        grantWaiters(target);
+    }
+}
+
+void AdmissionController::adapt(ClassState& target, Clock::duration latency, int64_t inFlight) {
+    const ClassLimits& limits = target.limits;
+    uint64_t current = target.limitFixed.load(std::memory_order_relaxed);
+    uint64_t next;
+    if (latency > limits.latencyTarget) {
+        // One cut per target interval, so a burst of slow calls that were
+        // all admitted under the old limit does not collapse it
+        int64_t now = Clock::now().time_since_epoch().count();
+        int64_t last = target.lastDecrease.load(std::memory_order_relaxed);
+        Clock::duration interval = limits.latencyTarget;
+        if (now - last < interval.count() ||
+            !target.lastDecrease.compare_exchange_strong(last, now, std::memory_order_relaxed)) {
+            return;
+        }
+        next = std::max<uint64_t>(limits.minLimit * FIXED_ONE, static_cast<uint64_t>(current * limits.backoff));
+    } else if (static_cast<uint64_t>(inFlight) * 2 * FIXED_ONE >= current) {
+        // Grow only while the limit is actually in use
+        next = std::min<uint64_t>(limits.maxLimit * FIXED_ONE,
+                                  current + std::max<uint64_t>(1, FIXED_ONE * FIXED_ONE / current));
+    } else {
+        return;
+    }
+    // A lost race drops this sample; the next one adapts again
+    target.limitFixed.compare_exchange_strong(current, next, std::memory_order_relaxed);
+}
+
+void AdmissionController::grantWaiters(ClassState& target) {
+    while (!target.waiters.empty()) {
+        int64_t current = target.inFlight.load();
+        if (current >= wholeLimit(target.limitFixed.load(std::memory_order_relaxed))) {
+            return;
+        }
+        if (!target.inFlight.compare_exchange_weak(current, current + 1)) {
+            continue;
+        }
+        Waiter* waiter = target.waiters.front();
+        target.waiters.pop_front();
+        target.queued.fetch_sub(1);
+        waiter->granted = true;
+        waiter->ready.notify_one();
+    }
+}
+
+void AdmissionController::countFastFail(RequestClass requestClass) {
+    state(requestClass).fastFailed.fetch_add(1, std::memory_order_relaxed);
+}
+
+AdmissionStats AdmissionController::getStats(RequestClass requestClass) const {
+    const ClassState& source = classes[static_cast<size_t>(requestClass)];
+    AdmissionStats stats;
+    stats.limit = static_cast<double>(source.limitFixed.load(std::memory_order_relaxed)) / FIXED_ONE;
+    stats.inFlight = source.inFlight.load(std::memory_order_relaxed);
+    stats.queued = source.queued.load(std::memory_order_relaxed);
+    stats.admitted = source.admitted.load(std::memory_order_relaxed);
+    stats.shedOverloaded = source.shedOverloaded.load(std::memory_order_relaxed);
+    stats.shedDeadline = source.shedDeadline.load(std::memory_order_relaxed);
+    stats.fastFailed = source.fastFailed.load(std::memory_order_relaxed);
+    return stats;
+}
+
+StoreGate::StoreGate(QuantumBookstore& store, AdmissionConfig config) : bookstore(store), controller(config) {}
+
+AdmissionController::Permit StoreGate::admitOrThrow(RequestClass requestClass, Clock::time_point deadline) {
+    AdmissionController::Permit permit = controller.admit(requestClass, deadline);
+    if (!permit) {
+        StoreError{permit.failure(), {}}.raise();
+    }
+    return permit;
+}
+
+StoreResult<double> StoreGate::tryBuyBook(const std::string& isbn, int quantity,
+                                          const std::string& customerEmail,
+                                          const std::string& shippingAddress,
+                                          Clock::time_point deadline) {
+    // A doomed purchase should not hold a queue position a live one could use
+    if (quantity > 0 && bookstore.isSoldOut(isbn)) {
+        controller.countFastFail(RequestClass::Purchase);
+        return StoreError{StoreFailure::InsufficientStock, isbn, quantity, 0};
+    }
+    AdmissionController::Permit permit = controller.admit(RequestClass::Purchase, deadline);
+    if (!permit) {
+        return StoreError{permit.failure(), isbn};
+    }
+    return bookstore.tryBuyBook(isbn, quantity, customerEmail, shippingAddress);
+}
+
+double StoreGate::buyBook(const std::string& isbn, int quantity,
+                          const std::string& customerEmail,
+                          const std::string& shippingAddress,
+                          Clock::time_point deadline) {
+    return tryBuyBook(isbn, quantity, customerEmail, shippingAddress, deadline).value();
+}
+
+std::vector<double> StoreGate::buyBooks(const std::vector<OrderLine>& lines,
+                                        const std::string& customerEmail,
+                                        const std::string& shippingAddress,
+                                        Clock::time_point deadline) {
+    for (const OrderLine& line : lines) {
+        if (line.quantity > 0 && bookstore.isSoldOut(line.isbn)) {
+            controller.countFastFail(RequestClass::Purchase);
+            StoreError{StoreFailure::InsufficientStock, line.isbn, line.quantity, 0}.raise();
+        }
+    }
+    AdmissionController::Permit permit = admitOrThrow(RequestClass::Purchase, deadline);
+    return bookstore.buyBooks(lines, customerEmail, shippingAddress);
+}
+
+StoreResult<Book*> StoreGate::tryFindBook(const std::string& isbn, Clock::time_point deadline) {
+    AdmissionController::Permit permit = controller.admit(RequestClass::Read, deadline);
+    if (!permit) {
+        return StoreError{permit.failure(), isbn};
+    }
+    return bookstore.findBook(isbn);
+}
+
+Book* StoreGate::findBook(const std::string& isbn, Clock::time_point deadline) {
+    return tryFindBook(isbn, deadline).value();
+}
+
+void StoreGate::findBooks(const std::vector<std::string_view>& isbns,
+                          const std::function<void(size_t, const Book*)>& visit,
+                          Clock::time_point deadline) {
+    AdmissionController::Permit permit = admitOrThrow(RequestClass::Read, deadline);
+    bookstore.findBooks(isbns, visit);
+}
+
+std::vector<SearchHit> StoreGate::searchBooks(const std::string& query, size_t limit, Clock::time_point deadline) {
+    AdmissionController::Permit permit = admitOrThrow(RequestClass::Read, deadline);
+    return bookstore.searchBooks(query, limit);
+}
@@ -1,15 +1,64 @@
 #include "../include/Book.h"
+#include <algorithm>
+#include <stdexcept>
+
+namespace {
+
+void checkLengths(std::string_view isbn, std::string_view title, std::string_view author) {
+    if (isbn.size() > Book::MAX_ISBN_LENGTH || author.size() > Book::MAX_AUTHOR_LENGTH || 
+        title.size() > UINT32_MAX) {
+        throw std::invalid_argument("Book field too long for ISBN " + std::string(isbn.substr(0, 32)));
+    }
+}
+
+} // namespace
 
 Book::Book(const std::string& isbn, const std::string& title, int year, 
            double price, const std::string& author)
-    : isbn(isbn), title(title), yearPublished(year), price(price), authorName(author) {}
+    : Book(isbn, title, year, price, author, BookKind::Other) {}
 
-const std::string& Book::getISBN() const { 
-    return isbn; 
+Book::Book(const BookText& text, int year, double price)
+    : Book(text, year, price, BookKind::Other) {}
+
+Book::Book(const std::string& isbn, const std::string& title, int year, double price, 
+           const std::string& author, BookKind kind, std::string_view trailing)
+    : price(price), yearPublished(year), titleLength(static_cast<uint32_t>(title.size())), 
+      authorLength(static_cast<uint16_t>(author.size())), isbnLength(static_cast<uint8_t>(isbn.size())), 
+      kind(kind), ownsText(true) {
+    checkLengths(isbn, title, author);
+    
+    // One allocation for every string of the book
+    char* block = new char[isbn.size() + title.size() + author.size() + trailing.size()];
+    char* out = block;
+    isbnText = out;
+    out = std::copy(isbn.begin(), isbn.end(), out);
+    titleText = out;
+    out = std::copy(title.begin(), title.end(), out);
+    authorText = out;
+    out = std::copy(author.begin(), author.end(), out);
+    std::copy(trailing.begin(), trailing.end(), out);
+}
+
+Book::Book(const BookText& text, int year, double price, BookKind kind)
+    : isbnText(text.isbn.data()), titleText(text.title.data()), authorText(text.author.data()), 
+      price(price), yearPublished(year), titleLength(static_cast<uint32_t>(text.title.size())), 
+      authorLength(static_cast<uint16_t>(text.author.size())), 
+      isbnLength(static_cast<uint8_t>(text.isbn.size())), kind(kind) {
+    checkLengths(text.isbn, text.title, text.author);
 }
 
-const std::string& Book::getTitle() const { 
-    return title; 
+Book::~Book() {
+    if (ownsText) {
+        delete[] isbnText;
+    }
+}
+
+std::string_view Book::getISBN() const { 
+    return {isbnText, isbnLength}; 
+}
+
+std::string_view Book::getTitle() const { 
+    return {titleText, titleLength}; 
 }
 
 int Book::getYearPublished() const { 
@@ -20,10 +69,22 @@ double Book::getPrice() const {
     return price; 
 }
 
-const std::string& Book::getAuthorName() const { 
-    return authorName; 
+std::string_view Book::getAuthorName() const { 
+    return {authorText, authorLength}; 
+}
+
+DeliveryChannel Book::getDeliveryChannel() const {
+    return DeliveryChannel::Custom;
 }
 
 bool Book::isOutdated(int currentYear, int yearsThreshold) const {
     return (currentYear - yearPublished) > yearsThreshold;
 }
+
+void BookDeleter::operator()(Book* book) const {
+    if (book->isArenaAllocated()) {
+        book->~Book();
+    } else {
+        delete book;
+    }
+}
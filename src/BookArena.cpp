@@ -0,0 +1,140 @@
+#include "../include/BookArena.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+
+// MonotonicSlabs implementation
+MonotonicSlabs::MonotonicSlabs(size_t slabSize) : slabSize(slabSize) {}
+
+void* MonotonicSlabs::allocate(size_t size, size_t alignment) {
+    size_t padding = cursor ? (alignment - reinterpret_cast<uintptr_t>(cursor) % alignment) % alignment : 0;
+    if (!cursor || padding + size > remaining) {
+        // Oversized requests get a slab of their own
+        size_t capacity = std::max(slabSize, size + alignment);
+        slabs.emplace_back(new std::byte[capacity]);  // left uninitialized
+        reserved += capacity;
+        cursor = slabs.back().get();
+        remaining = capacity;
+        padding = (alignment - reinterpret_cast<uintptr_t>(cursor) % alignment) % alignment;
+    }
+    std::byte* result = cursor + padding;
+    cursor = result + size;
+    remaining -= padding + size;
+    return result;
+}
+
+std::string_view MonotonicSlabs::store(std::string_view text) {
+    if (text.empty()) {
+        return {};
+    }
+    char* out = static_cast<char*>(allocate(text.size(), 1));
+    std::memcpy(out, text.data(), text.size());
+    return {out, text.size()};
+}
+
+size_t MonotonicSlabs::bytesReserved() const {
+    return reserved;
+}
+
+// StringPool implementation
+std::string_view StringPool::intern(std::string_view text) {
+    auto it = strings.find(text);
+    if (it != strings.end()) {
+        return *it;
+    }
+    std::string_view stored = chars.store(text);
+    strings.insert(stored);
+    return stored;
+}
+
+size_t StringPool::size() const {
+    return strings.size();
+}
+
+size_t StringPool::bytesReserved() const {
+    return chars.bytesReserved();
+}
+
+// BookArena implementation
+BookText BookArena::storeText(std::string_view isbn, std::string_view title, std::string_view author) {
+    return BookText{textHeap.store(isbn), textHeap.store(title), authors.intern(author)};
+}
+
+template <typename T, typename... Args>
+BookPtr BookArena::construct(MonotonicSlabs& slabs, Args&&... args) {
+    void* memory = slabs.allocate(sizeof(T), alignof(T));
+    // On a constructor exception the slot is simply left unused
+    T* book = new (memory) T(std::forward<Args>(args)...);
+    book->arenaAllocated = true;
+    ++bookCount;
+    return BookPtr(book);
+}
+
+BookPtr BookArena::makePaperBook(std::string_view isbn, std::string_view title, int year, 
+                                 double price, std::string_view author, int stock) {
+    std::lock_guard<std::mutex> lock(mutex);
+    return construct<PaperBook>(paperSlabs, storeText(isbn, title, author), year, price, stock);
+}
+
+BookPtr BookArena::makeEBook(std::string_view isbn, std::string_view title, int year, 
+                             double price, std::string_view author, std::string_view fileType) {
+    std::lock_guard<std::mutex> lock(mutex);
+    return construct<EBook>(ebookSlabs, storeText(isbn, title, author), year, price, 
+                            fileTypes.intern(fileType));
+}
+
+BookPtr BookArena::makeShowcaseBook(std::string_view isbn, std::string_view title, int year, 
+                                    double price, std::string_view author) {
+    std::lock_guard<std::mutex> lock(mutex);
+    return construct<ShowcaseBook>(showcaseSlabs, storeText(isbn, title, author), year, price);
+}
+
+BookPtr BookArena::makePaperBook(const BookText& text, int year, double price, int stock) {
+    std::lock_guard<std::mutex> lock(mutex);
+    return construct<PaperBook>(paperSlabs, text, year, price, stock);
+}
+
+BookPtr BookArena::makeEBook(const BookText& text, int year, double price, std::string_view fileType) {
+    std::lock_guard<std::mutex> lock(mutex);
+    return construct<EBook>(ebookSlabs, text, year, price, fileType);
+}
+
+BookPtr BookArena::makeShowcaseBook(const BookText& text, int year, double price) {
+    std::lock_guard<std::mutex> lock(mutex);
+    return construct<ShowcaseBook>(showcaseSlabs, text, year, price);
+}
+
+void BookArena::retain(std::shared_ptr<const void> storage) {
+    std::lock_guard<std::mutex> lock(mutex);
+    retained.push_back(std::move(storage));
+}
+
+BookPtr BookArena::detach(BookPtr book, EpochReclaimer& epochs) {
+    if (!book || !book->isArenaAllocated()) {
+        return book;
+    }
+    
+    BookPtr copy = copyBook(*book);
+    if (!copy) {
+        throw std::logic_error("Only built-in book types are arena-allocated");
+    }
+    epochs.retire(std::shared_ptr<const Book>(std::move(book)));
+    return copy;
+}
+
+size_t BookArena::getBookCount() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return bookCount;
+}
+
+size_t BookArena::getInternedCount() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return authors.size() + fileTypes.size();
+}
+
+size_t BookArena::bytesReserved() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return paperSlabs.bytesReserved() + ebookSlabs.bytesReserved() + showcaseSlabs.bytesReserved() + 
+           textHeap.bytesReserved() + authors.bytesReserved() + fileTypes.bytesReserved();
+}
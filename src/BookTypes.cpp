@@ -5,7 +5,10 @@
 // PaperBook implementation
 PaperBook::PaperBook(const std::string& isbn, const std::string& title, int year,
                      double price, const std::string& author, int stock)
-    : Book(isbn, title, year, price, author), stock(stock) {}
+    : Book(isbn, title, year, price, author, BookKind::Paper), stock(stock) {}
+
+PaperBook::PaperBook(const BookText& text, int year, double price, int stock)
+    : Book(text, year, price, BookKind::Paper), stock(stock) {}
 
 void PaperBook::processPurchase(const std::string& customerEmail, 
                                const std::string& shippingAddress) const {
@@ -17,25 +20,69 @@ bool PaperBook::canBeSold() const {
 }
 
 std::string PaperBook::getType() const { 
-    return "Paper Book"; 
+    return std::string(bookKindName(BookKind::Paper)); 
+}
+
+DeliveryChannel PaperBook::getDeliveryChannel() const { 
+    return DeliveryChannel::Shipping; 
 }
 
 int PaperBook::getStock() const { 
-    return stock; 
+    return stock.available(); 
 }
 
 void PaperBook::reduceStock(int quantity) { 
-    stock -= quantity; 
+    if (!stock.tryTake(quantity)) {
+        throw std::runtime_error("Cannot reduce stock below zero");
+    }
+}
+
+void PaperBook::restock(int quantity) {
+    stock.give(quantity);
 }
 
 bool PaperBook::hasEnoughStock(int quantity) const { 
-    return stock >= quantity; 
+    return stock.available() >= quantity; 
+}
+
+StockReservation PaperBook::tryReserve(int quantity, StockCounter::Clock::duration ttl) {
+    return stock.reserve(quantity, ttl);
+}
+
+int PaperBook::getHeldStock() const {
+    return stock.held();
+}
+
+int PaperBook::getStockOnHand() const {
+    return stock.onHand();
+}
+
+size_t PaperBook::expireHolds(StockCounter::Clock::time_point now) {
+    return stock.expireHolds(now);
 }
 
 // EBook implementation
+namespace {
+
+std::string_view checkFileType(std::string_view fileType) {
+    if (fileType.size() > EBook::MAX_FILE_TYPE_LENGTH) {
+        throw std::invalid_argument("EBook file type too long");
+    }
+    return fileType;
+}
+
+} // namespace
+
 EBook::EBook(const std::string& isbn, const std::string& title, int year,
              double price, const std::string& author, const std::string& fileType)
-    : Book(isbn, title, year, price, author), fileType(fileType) {}
+    : Book(isbn, title, year, price, author, BookKind::EBook, checkFileType(fileType)),
+      fileTypeLength(static_cast<uint8_t>(fileType.size())), 
+      fileTypeText(authorText + authorLength) {}
+
+EBook::EBook(const BookText& text, int year, double price, std::string_view fileType)
+    : Book(text, year, price, BookKind::EBook), 
+      fileTypeLength(static_cast<uint8_t>(checkFileType(fileType).size())), 
+      fileTypeText(fileType.data()) {}
 
 void EBook::processPurchase(const std::string& customerEmail, 
                            const std::string& shippingAddress) const {
@@ -47,17 +94,24 @@ bool EBook::canBeSold() const {
 }
 
 std::string EBook::getType() const { 
-    return "EBook"; 
+    return std::string(bookKindName(BookKind::EBook)); 
 }
 
-const std::string& EBook::getFileType() const { 
-    return fileType; 
+DeliveryChannel EBook::getDeliveryChannel() const { 
+    return DeliveryChannel::Email; 
+}
+
+std::string_view EBook::getFileType() const { 
+    return {fileTypeText, fileTypeLength}; 
 }
 
 // ShowcaseBook implementation
 ShowcaseBook::ShowcaseBook(const std::string& isbn, const std::string& title, int year,
                            double price, const std::string& author)
-    : Book(isbn, title, year, price, author) {}
+    : Book(isbn, title, year, price, author, BookKind::Showcase) {}
+
+ShowcaseBook::ShowcaseBook(const BookText& text, int year, double price)
+    : Book(text, year, price, BookKind::Showcase) {}
 
 void ShowcaseBook::processPurchase(const std::string& customerEmail, 
                                   const std::string& shippingAddress) const {
@@ -69,5 +123,28 @@ bool ShowcaseBook::canBeSold() const {
 }
 
 std::string ShowcaseBook::getType() const { 
-    return "Showcase/Demo Book"; 
+    return std::string(bookKindName(BookKind::Showcase)); 
+}
+
+BookPtr copyBook(const Book& book) {
+    std::string isbn(book.getISBN());
+    std::string title(book.getTitle());
+    std::string author(book.getAuthorName());
+    return visitBook(book, BookVisitor{
+        [&](const PaperBook& paperBook) -> BookPtr {
+            return std::make_unique<PaperBook>(isbn, title, paperBook.getYearPublished(), 
+                                               paperBook.getPrice(), author, paperBook.getStock());
+        },
+        [&](const EBook& ebook) -> BookPtr {
+            return std::make_unique<EBook>(isbn, title, ebook.getYearPublished(), ebook.getPrice(), 
+                                           author, std::string(ebook.getFileType()));
+        },
+        [&](const ShowcaseBook& showcase) -> BookPtr {
+            return std::make_unique<ShowcaseBook>(isbn, title, showcase.getYearPublished(), 
+                                                  showcase.getPrice(), author);
+        },
+        [](const Book&) -> BookPtr {
+            return nullptr;
+        }
+    });
 }
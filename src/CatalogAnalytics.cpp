@@ -0,0 +1,624 @@
+#include "../include/CatalogAnalytics.h"
+#include "../include/BookTypes.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <memory>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace {
+
+constexpr double NaN = std::numeric_limits<double>::quiet_NaN();
+
+// Numeric group columns are packed into one key, KEY_BITS each, first
+// column most significant, so keys sort like their columns
+constexpr int KEY_BITS = 21;
+constexpr int64_t KEY_BIAS = int64_t{1} << (KEY_BITS - 1);
+constexpr int64_t KEY_MASK = (int64_t{1} << KEY_BITS) - 1;
+
+// Years far outside +-2^20 would wrap; no catalog has them
+int64_t keyPart(int64_t value) {
+    return (value + KEY_BIAS) & KEY_MASK;
+}
+
+const char* kindLabel(int64_t kind) {
+    switch (static_cast<BookKind>(kind)) {
+        case BookKind::Paper: return "paper";
+        case BookKind::EBook: return "ebook";
+        case BookKind::Showcase: return "showcase";
+        case BookKind::Other: break;
+    }
+    return "other";
+}
+
+const char* measureName(BookMeasure measure) {
+    switch (measure) {
+        case BookMeasure::Price: return "price";
+        case BookMeasure::Year: return "year";
+        case BookMeasure::Stock: return "stock";
+        case BookMeasure::InventoryValue: return "inventory_value";
+    }
+    return "unknown";
+}
+
+std::string aggregateName(AggregateOp op, BookMeasure measure, double q) {
+    const char* name = "count";
+    switch (op) {
+        case AggregateOp::Count: return name;
+        case AggregateOp::Sum: name = "sum"; break;
+        case AggregateOp::Min: name = "min"; break;
+        case AggregateOp::Max: name = "max"; break;
+        case AggregateOp::Mean: name = "mean"; break;
+        case AggregateOp::Quantile: {
+            char percentile[32];
+            std::snprintf(percentile, sizeof(percentile), "p%g", q * 100);
+            return std::string(percentile) + "(" + measureName(measure) + ")";
+        }
+    }
+    return std::string(name) + "(" + measureName(measure) + ")";
+}
+
+// Decade start, rounding down for negative years too
+int64_t decadeOf(int year) {
+    return year >= 0 ? year / 10 * 10 : -((-year + 9) / 10 * 10);
+}
+
+struct GroupKey {
+    int64_t numeric = 0;
+    std::string_view author;
+
+    bool operator==(const GroupKey& other) const {
+        return numeric == other.numeric && author == other.author;
+    }
+};
+
+struct GroupKeyHash {
+    size_t operator()(const GroupKey& key) const {
+        size_t hash = std::hash<int64_t>()(key.numeric);
+        if (!key.author.empty()) {
+            hash ^= std::hash<std::string_view>()(key.author) + 0x9e3779b97f4a7c15ULL + (hash << 6) + (hash >> 2);
+        }
+        return hash;
+    }
+};
+
+struct Accumulator {
+    uint64_t count = 0;
+    double sum = 0;
+    double min = std::numeric_limits<double>::infinity();
+    double max = -std::numeric_limits<double>::infinity();
+
+    void merge(const Accumulator& other) {
+        count += other.count;
+        sum += other.sum;
+        min = std::min(min, other.min);
+        max = std::max(max, other.max);
+    }
+};
+
+// Reused buffers of one worker, one entry per selected row of a range
+struct Scratch {
+    std::vector<uint32_t> rows;
+    std::vector<uint32_t> groups;
+    std::vector<int32_t> stocks;   // -1 for books without stock
+    std::vector<double> values;
+    std::vector<uint32_t> valueGroups;
+};
+
+// One worker's partial result, groups numbered densely in order of appearance
+struct Partial {
+    std::unordered_map<GroupKey, uint32_t, GroupKeyHash> ids;
+    std::vector<GroupKey> keys;
+    std::vector<uint64_t> books;
+    std::vector<std::vector<Accumulator>> aggregates;   // [aggregate][group]
+    std::vector<std::vector<QuantileSketch>> sketches;  // [quantile measure][group]
+    // Last group seen; ungrouped and coarse queries hit it row after row
+    GroupKey lastKey;
+    uint32_t lastId = UINT32_MAX;
+    Scratch scratch;
+
+    uint32_t idOf(const GroupKey& key) {
+        if (lastId != UINT32_MAX && lastKey == key) {
+            return lastId;
+        }
+        auto it = ids.find(key);
+        if (it == ids.end()) {
+            it = ids.emplace(key, static_cast<uint32_t>(keys.size())).first;
+            keys.push_back(key);
+            books.push_back(0);
+            for (auto& column : aggregates) {
+                column.emplace_back();
+            }
+            for (auto& column : sketches) {
+                column.emplace_back();
+            }
+        }
+        lastKey = key;
+        lastId = it->second;
+        return lastId;
+    }
+};
+
+bool needsStock(BookMeasure measure) {
+    return measure == BookMeasure::Stock || measure == BookMeasure::InventoryValue;
+}
+
+} // namespace
+
+// QuantileSketch
+
+QuantileSketch::QuantileSketch(double relativeAccuracy) {
+    if (!(relativeAccuracy > 0 && relativeAccuracy < 1)) {
+        throw std::invalid_argument("Sketch accuracy must be in (0, 1)");
+    }
+    gamma = (1 + relativeAccuracy) / (1 - relativeAccuracy);
+    inverseLogGamma = 1 / std::log(gamma);
+}
+
+void QuantileSketch::Buckets::add(int32_t index, uint64_t count) {
+    if (counts.empty()) {
+        offset = index;
+    }
+    if (index < offset) {
+        counts.insert(counts.begin(), static_cast<size_t>(offset - index), 0);
+        offset = index;
+    }
+    size_t slot = static_cast<size_t>(index - offset);
+    if (slot >= counts.size()) {
+        counts.resize(slot + 1, 0);
+    }
+    counts[slot] += count;
+}
+
+int32_t QuantileSketch::indexOf(double magnitude) const {
+    return static_cast<int32_t>(std::ceil(std::log(magnitude) * inverseLogGamma));
+}
+
+double QuantileSketch::valueOf(int32_t index) const {
+    // Midpoint (in relative terms) of (gamma^(i-1), gamma^i]
+    return 2 * std::pow(gamma, index) / (gamma + 1);
+}
+
+void QuantileSketch::add(double value) {
+    constexpr double SMALLEST = 1e-9;
+    if (value > SMALLEST) {
+        positive.add(indexOf(value), 1);
+    } else if (value < -SMALLEST) {
+        negative.add(indexOf(-value), 1);
+    } else {
+        ++zeros;
+    }
+    ++total;
+}
+
+void QuantileSketch::merge(const QuantileSketch& other) {
+    for (size_t i = 0; i < other.positive.counts.size(); ++i) {
+        if (other.positive.counts[i]) {
+            positive.add(other.positive.offset + static_cast<int32_t>(i), other.positive.counts[i]);
+        }
+    }
+    for (size_t i = 0; i < other.negative.counts.size(); ++i) {
+        if (other.negative.counts[i]) {
+            negative.add(other.negative.offset + static_cast<int32_t>(i), other.negative.counts[i]);
+        }
+    }
+    zeros += other.zeros;
+    total += other.total;
+}
+
+double QuantileSketch::quantile(double q) const {
+    if (total == 0) {
+        return NaN;
+    }
+    uint64_t rank = static_cast<uint64_t>(std::clamp(q, 0.0, 1.0) * static_cast<double>(total - 1));
+    uint64_t seen = 0;
+    // Most negative first
+    for (size_t i = negative.counts.size(); i-- > 0;) {
+        seen += negative.counts[i];
+        if (seen > rank) {
+            return -valueOf(negative.offset + static_cast<int32_t>(i));
+        }
+    }
+    seen += zeros;
+    if (seen > rank) {
+        return 0;
+    }
+    for (size_t i = 0; i < positive.counts.size(); ++i) {
+        seen += positive.counts[i];
+        if (seen > rank) {
+            return valueOf(positive.offset + static_cast<int32_t>(i));
+        }
+    }
+    return NaN;  // unreachable: the counts add up to total
+}
+
+// CatalogQuery
+
+CatalogQuery& CatalogQuery::ofKind(BookKind bookKind) {
+    filterKind = true;
+    kind = bookKind;
+    return *this;
+}
+
+CatalogQuery& CatalogQuery::publishedBetween(int from, int to) {
+    fromYear = from;
+    toYear = to;
+    return *this;
+}
+
+CatalogQuery& CatalogQuery::pricedBetween(double low, double high) {
+    minPrice = low;
+    maxPrice = high;
+    return *this;
+}
+
+CatalogQuery& CatalogQuery::where(std::function<bool(const Book&)> predicate) {
+    predicates.push_back(std::move(predicate));
+    return *this;
+}
+
+CatalogQuery& CatalogQuery::groupBy(GroupBy column) {
+    if (std::find(grouping.begin(), grouping.end(), column) != grouping.end()) {
+        throw std::invalid_argument("Query is already grouped by that column");
+    }
+    grouping.push_back(column);
+    return *this;
+}
+
+CatalogQuery& CatalogQuery::count() {
+    aggregates.push_back({AggregateOp::Count, BookMeasure::Price, 0});
+    return *this;
+}
+
+CatalogQuery& CatalogQuery::sum(BookMeasure measure) {
+    aggregates.push_back({AggregateOp::Sum, measure, 0});
+    return *this;
+}
+
+CatalogQuery& CatalogQuery::min(BookMeasure measure) {
+    aggregates.push_back({AggregateOp::Min, measure, 0});
+    return *this;
+}
+
+CatalogQuery& CatalogQuery::max(BookMeasure measure) {
+    aggregates.push_back({AggregateOp::Max, measure, 0});
+    return *this;
+}
+
+CatalogQuery& CatalogQuery::mean(BookMeasure measure) {
+    aggregates.push_back({AggregateOp::Mean, measure, 0});
+    return *this;
+}
+
+CatalogQuery& CatalogQuery::quantile(BookMeasure measure, double q) {
+    if (!(q >= 0 && q <= 1)) {
+        throw std::invalid_argument("Quantile must be in [0, 1]");
+    }
+    aggregates.push_back({AggregateOp::Quantile, measure, q});
+    return *this;
+}
+
+CatalogQuery& CatalogQuery::threads(size_t count) {
+    maxThreads = count;
+    return *this;
+}
+
+// AnalyticsResult
+
+const AnalyticsGroup* AnalyticsResult::find(std::string_view key) const {
+    for (const AnalyticsGroup& group : groups) {
+        std::string joined;
+        for (size_t i = 0; i < group.key.size(); ++i) {
+            joined += (i ? "/" : "") + group.key[i];
+        }
+        if (joined == key) {
+            return &group;
+        }
+    }
+    return nullptr;
+}
+
+// CatalogAnalytics
+
+AnalyticsResult CatalogAnalytics::run(const CatalogQuery& query, const std::vector<const ColumnarCatalog*>& partitions,
+                                      TaskPool& pool) {
+    const auto& aggregates = query.aggregates;
+    bool grouped = !query.grouping.empty();
+    bool byAuthor = std::find(query.grouping.begin(), query.grouping.end(), GroupBy::Author) != query.grouping.end();
+
+    // The measures to gather, and one sketch per measure with quantiles
+    std::vector<BookMeasure> measures;
+    std::vector<int> sketchOf;  // by measure index, -1 without quantiles
+    bool stockNeeded = false;
+    for (const auto& aggregate : aggregates) {
+        if (aggregate.op == AggregateOp::Count) {
+            continue;
+        }
+        auto it = std::find(measures.begin(), measures.end(), aggregate.measure);
+        size_t m = static_cast<size_t>(it - measures.begin());
+        if (it == measures.end()) {
+            measures.push_back(aggregate.measure);
+            sketchOf.push_back(-1);
+            stockNeeded |= needsStock(aggregate.measure);
+        }
+        if (aggregate.op == AggregateOp::Quantile && sketchOf[m] < 0) {
+            sketchOf[m] = static_cast<int>(std::count_if(sketchOf.begin(), sketchOf.end(), [](int s) { return s >= 0; }));
+        }
+    }
+    size_t sketchCount = static_cast<size_t>(std::count_if(sketchOf.begin(), sketchOf.end(), [](int s) { return s >= 0; }));
+
+    // Split every partition into row ranges
+    struct Range {
+        const ColumnarCatalog* columns;
+        size_t begin;
+        size_t end;
+    };
+    std::vector<Range> ranges;
+    for (const ColumnarCatalog* columns : partitions) {
+        for (size_t begin = 0; begin < columns->size(); begin += ROWS_PER_TASK) {
+            ranges.push_back({columns, begin, std::min(columns->size(), begin + ROWS_PER_TASK)});
+        }
+    }
+
+    size_t workers = std::min(pool.size(), query.maxThreads ? query.maxThreads : pool.size());
+    std::vector<Partial> partials(workers);
+    for (Partial& partial : partials) {
+        partial.aggregates.resize(aggregates.size());
+        partial.sketches.resize(sketchCount);
+    }
+
+    pool.parallelFor(ranges.size(), [&](size_t task, size_t worker) {
+        const Range& range = ranges[task];
+        const int32_t* years = range.columns->yearColumn();
+        const double* prices = range.columns->priceColumn();
+        const uint8_t* kinds = range.columns->kindColumn();
+        Book* const* books = range.columns->bookColumn();
+        Partial& partial = partials[worker];
+        Scratch& scratch = partial.scratch;
+
+        // Select the rows passing the column filters, then the predicates
+        scratch.rows.resize(range.end - range.begin);
+        uint32_t* rows = scratch.rows.data();
+        size_t selected = 0;
+        uint8_t kind = static_cast<uint8_t>(query.kind);
+        for (size_t row = range.begin; row < range.end; ++row) {
+            bool passes = (!query.filterKind || kinds[row] == kind) & (years[row] >= query.fromYear) &
+                          (years[row] <= query.toYear) & (prices[row] >= query.minPrice) &
+                          (prices[row] <= query.maxPrice);
+            rows[selected] = static_cast<uint32_t>(row);
+            selected += passes;
+        }
+        for (const auto& predicate : query.predicates) {
+            size_t kept = 0;
+            for (size_t i = 0; i < selected; ++i) {
+                if (predicate(*books[rows[i]])) {
+                    rows[kept++] = rows[i];
+                }
+            }
+            selected = kept;
+        }
+        if (selected == 0) {
+            return;
+        }
+
+        // Group of every selected row
+        uint32_t* groups = nullptr;
+        if (grouped) {
+            scratch.groups.resize(selected);
+            groups = scratch.groups.data();
+            for (size_t i = 0; i < selected; ++i) {
+                uint32_t row = rows[i];
+                GroupKey key;
+                for (GroupBy column : query.grouping) {
+                    switch (column) {
+                        case GroupBy::Kind:
+                            key.numeric = (key.numeric << KEY_BITS) | kinds[row];
+                            break;
+                        case GroupBy::Year:
+                            key.numeric = (key.numeric << KEY_BITS) | keyPart(years[row]);
+                            break;
+                        case GroupBy::Decade:
+                            key.numeric = (key.numeric << KEY_BITS) | keyPart(decadeOf(years[row]));
+                            break;
+                        case GroupBy::Author:
+                            key.author = books[row]->getAuthorName();
+                            break;
+                    }
+                }
+                groups[i] = partial.idOf(key);
+            }
+            for (size_t i = 0; i < selected; ++i) {
+                ++partial.books[groups[i]];
+            }
+        } else {
+            partial.books[partial.idOf(GroupKey())] += selected;
+        }
+
+        if (stockNeeded) {
+            scratch.stocks.resize(selected);
+            for (size_t i = 0; i < selected; ++i) {
+                const Book* book = books[rows[i]];
+                scratch.stocks[i] = kinds[rows[i]] == static_cast<uint8_t>(BookKind::Paper)
+                                        ? static_cast<const PaperBook*>(book)->getStock() : -1;
+            }
+        }
+
+        // Gather each measure once, dropping rows without it, then fold it
+        // into every aggregate over it
+        for (size_t m = 0; m < measures.size(); ++m) {
+            BookMeasure measure = measures[m];
+            scratch.values.resize(selected);
+            scratch.valueGroups.resize(grouped ? selected : 0);
+            double* values = scratch.values.data();
+            uint32_t* valueGroups = scratch.valueGroups.data();
+            size_t count = 0;
+            for (size_t i = 0; i < selected; ++i) {
+                uint32_t row = rows[i];
+                double value = 0;
+                switch (measure) {
+                    case BookMeasure::Price:
+                        value = prices[row];
+                        break;
+                    case BookMeasure::Year:
+                        value = years[row];
+                        break;
+                    case BookMeasure::Stock:
+                        value = scratch.stocks[i];
+                        break;
+                    case BookMeasure::InventoryValue:
+                        value = prices[row] * scratch.stocks[i];
+                        break;
+                }
+                if (needsStock(measure) && scratch.stocks[i] < 0) {
+                    continue;
+                }
+                values[count] = value;
+                if (grouped) {
+                    valueGroups[count] = groups[i];
+                }
+                ++count;
+            }
+
+            for (size_t a = 0; a < aggregates.size(); ++a) {
+                if (aggregates[a].op == AggregateOp::Count || aggregates[a].measure != measure) {
+                    continue;
+                }
+                std::vector<Accumulator>& accumulators = partial.aggregates[a];
+                if (!grouped) {
+                    Accumulator& acc = accumulators[0];
+                    acc.count += count;
+                    switch (aggregates[a].op) {
+                        case AggregateOp::Sum:
+                        case AggregateOp::Mean:
+                            for (size_t i = 0; i < count; ++i) {
+                                acc.sum += values[i];
+                            }
+                            break;
+                        case AggregateOp::Min:
+                        case AggregateOp::Quantile:
+                            for (size_t i = 0; i < count; ++i) {
+                                acc.min = std::min(acc.min, values[i]);
+                            }
+                            if (aggregates[a].op == AggregateOp::Min) {
+                                break;
+                            }
+                            [[fallthrough]];
+                        case AggregateOp::Max:
+                            for (size_t i = 0; i < count; ++i) {
+                                acc.max = std::max(acc.max, values[i]);
+                            }
+                            break;
+                        case AggregateOp::Count:
+                            break;
+                    }
+                    continue;
+                }
+                for (size_t i = 0; i < count; ++i) {
+                    Accumulator& acc = accumulators[valueGroups[i]];
+                    ++acc.count;
+                    acc.sum += values[i];
+                    acc.min = std::min(acc.min, values[i]);
+                    acc.max = std::max(acc.max, values[i]);
+                }
+            }
+            if (sketchOf[m] >= 0) {
+                std::vector<QuantileSketch>& sketches = partial.sketches[static_cast<size_t>(sketchOf[m])];
+                for (size_t i = 0; i < count; ++i) {
+                    sketches[grouped ? valueGroups[i] : 0].add(values[i]);
+                }
+            }
+        }
+    }, workers);
+
+    // Merge the partials into the first
+    Partial& merged = partials[0];
+    for (size_t w = 1; w < partials.size(); ++w) {
+        Partial& partial = partials[w];
+        for (size_t g = 0; g < partial.keys.size(); ++g) {
+            uint32_t id = merged.idOf(partial.keys[g]);
+            merged.books[id] += partial.books[g];
+            for (size_t a = 0; a < aggregates.size(); ++a) {
+                merged.aggregates[a][id].merge(partial.aggregates[a][g]);
+            }
+            for (size_t k = 0; k < sketchCount; ++k) {
+                merged.sketches[k][id].merge(partial.sketches[k][g]);
+            }
+        }
+    }
+    if (!grouped && merged.keys.empty()) {
+        merged.idOf(GroupKey());
+    }
+
+    std::vector<uint32_t> ordered(merged.keys.size());
+    for (uint32_t id = 0; id < ordered.size(); ++id) {
+        ordered[id] = id;
+    }
+    std::sort(ordered.begin(), ordered.end(), [&merged](uint32_t a, uint32_t b) {
+        const GroupKey& left = merged.keys[a];
+        const GroupKey& right = merged.keys[b];
+        return left.numeric != right.numeric ? left.numeric < right.numeric : left.author < right.author;
+    });
+
+    AnalyticsResult result;
+    for (const auto& aggregate : aggregates) {
+        result.columns.push_back(aggregateName(aggregate.op, aggregate.measure, aggregate.q));
+    }
+    int numericColumns = static_cast<int>(query.grouping.size()) - (byAuthor ? 1 : 0);
+    result.groups.reserve(ordered.size());
+    for (uint32_t id : ordered) {
+        const GroupKey& key = merged.keys[id];
+        AnalyticsGroup group;
+        // Unpack the numeric columns, last one in the lowest bits
+        int shift = KEY_BITS * (numericColumns - 1);
+        for (GroupBy column : query.grouping) {
+            if (column == GroupBy::Author) {
+                group.key.emplace_back(key.author);
+                continue;
+            }
+            int64_t value = (key.numeric >> shift) & KEY_MASK;
+            shift -= KEY_BITS;
+            if (column == GroupBy::Kind) {
+                group.key.emplace_back(kindLabel(value));
+            } else {
+                group.key.push_back(std::to_string(value - KEY_BIAS) + (column == GroupBy::Decade ? "s" : ""));
+            }
+        }
+        group.books = merged.books[id];
+        for (size_t a = 0; a < aggregates.size(); ++a) {
+            const Accumulator& acc = merged.aggregates[a][id];
+            double value = NaN;
+            switch (aggregates[a].op) {
+                case AggregateOp::Count:
+                    value = static_cast<double>(group.books);
+                    break;
+                case AggregateOp::Sum:
+                    value = acc.count ? acc.sum : NaN;
+                    break;
+                case AggregateOp::Min:
+                    value = acc.count ? acc.min : NaN;
+                    break;
+                case AggregateOp::Max:
+                    value = acc.count ? acc.max : NaN;
+                    break;
+                case AggregateOp::Mean:
+                    value = acc.count ? acc.sum / static_cast<double>(acc.count) : NaN;
+                    break;
+                case AggregateOp::Quantile: {
+                    // Exact at the ends; within the sketch's accuracy otherwise
+                    double q = aggregates[a].q;
+                    size_t m = static_cast<size_t>(std::find(measures.begin(), measures.end(), aggregates[a].measure) -
+                                                   measures.begin());
+                    const QuantileSketch& sketch = merged.sketches[static_cast<size_t>(sketchOf[m])][id];
+                    if (acc.count) {
+                        value = q == 0 ? acc.min : q == 1 ? acc.max : std::clamp(sketch.quantile(q), acc.min, acc.max);
+                    }
+                    break;
+                }
+            }
+            group.values.push_back(value);
+        }
+        result.groups.push_back(std::move(group));
+    }
+    return result;
+}
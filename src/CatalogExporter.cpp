@@ -0,0 +1,290 @@
+#include "../include/CatalogExporter.h"
+#include "../include/BookTypes.h"
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <climits>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include <sys/uio.h>
+#include <type_traits>
+#include <unistd.h>
+
+namespace {
+
+static_assert(sizeof(ExportRecordHeader) == 32, "record layout is part of the export format");
+static_assert(std::is_trivially_copyable_v<ExportRecordHeader>, "records are written as raw bytes");
+
+constexpr std::string_view CSV_HEADER = "type,isbn,title,author,year,price,stock,file_type\n";
+
+// Type names the importer accepts; custom types use scratch for getType()
+std::string_view typeName(const Book& book, std::string& scratch) {
+    switch (book.getKind()) {
+        case BookKind::Paper: return "paper";
+        case BookKind::EBook: return "ebook";
+        case BookKind::Showcase: return "showcase";
+        case BookKind::Other: break;
+    }
+    scratch = book.getType();
+    return scratch;
+}
+
+bool needsCsvQuotes(std::string_view text) {
+    if (!text.empty() && (text.front() == ' ' || text.back() == ' ')) {
+        return true;
+    }
+    // One pass with a branch-free test per byte rather than a search per character
+    bool special = false;
+    for (char c : text) {
+        special |= c == ',' || c == '"' || c == '\n' || c == '\r';
+    }
+    return special;
+}
+
+bool needsJsonEscape(unsigned char c) {
+    return c == '"' || c == '\\' || c < 0x20;
+}
+
+} // namespace
+
+void FdSink::write(const iovec* blocks, size_t count) {
+    std::vector<iovec> remaining(blocks, blocks + count);
+    size_t first = 0;
+    while (first < remaining.size()) {
+        int batch = static_cast<int>(std::min<size_t>(remaining.size() - first, IOV_MAX));
+        ssize_t wrote = ::writev(fd, remaining.data() + first, batch);
+        if (wrote < 0 && errno == EINTR) {
+            continue;
+        }
+        if (wrote < 0) {
+            throw std::runtime_error(std::string("Cannot write export: ") + std::strerror(errno));
+        }
+        // Skip what was written, including part of a block after a short write
+        size_t done = static_cast<size_t>(wrote);
+        while (first < remaining.size() && done >= remaining[first].iov_len) {
+            done -= remaining[first++].iov_len;
+        }
+        if (first < remaining.size()) {
+            remaining[first].iov_base = static_cast<char*>(remaining[first].iov_base) + done;
+            remaining[first].iov_len -= done;
+        }
+    }
+}
+
+void BufferSink::write(const iovec* blocks, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        buffer.append(static_cast<const char*>(blocks[i].iov_base), blocks[i].iov_len);
+    }
+}
+
+void CallbackSink::write(const iovec* blocks, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        callback(std::string_view(static_cast<const char*>(blocks[i].iov_base), blocks[i].iov_len));
+    }
+}
+
+CatalogExporter::CatalogExporter(ExportSink& sink, ExportFormat format) : sink(sink), format(format) {
+    blocks.push_back(std::make_unique<char[]>(BLOCK_BYTES));
+}
+
+CatalogExporter::~CatalogExporter() = default;
+
+void CatalogExporter::writeHeader() {
+    if (format == ExportFormat::Csv) {
+        append(CSV_HEADER);
+    } else if (format == ExportFormat::Binary) {
+        append(BINARY_MAGIC);
+    }
+}
+
+void CatalogExporter::write(const Book& book) {
+    switch (format) {
+        case ExportFormat::Csv: writeCsv(book); break;
+        case ExportFormat::JsonLines: writeJson(book); break;
+        case ExportFormat::Binary: writeBinary(book); break;
+    }
+}
+
+void CatalogExporter::flush() {
+    size_t filled = currentBlock + (blockFill > 0 ? 1 : 0);
+    if (filled == 0) {
+        return;
+    }
+    iovec parts[BLOCKS_PER_FLUSH];
+    for (size_t i = 0; i < filled; ++i) {
+        parts[i].iov_base = blocks[i].get();
+        parts[i].iov_len = i < currentBlock ? BLOCK_BYTES : blockFill;
+    }
+    size_t bytes = pendingBytes();
+    // Buffered bytes are dropped even if the sink throws, so a retry
+    // cannot write them twice
+    currentBlock = 0;
+    blockFill = 0;
+    sink.write(parts, filled);
+    flushedBytes += bytes;
+}
+
+void CatalogExporter::appendSpilling(const char* data, size_t length) {
+    while (length > 0) {
+        if (blockFill == BLOCK_BYTES) {
+            if (currentBlock + 1 == BLOCKS_PER_FLUSH) {
+                flush();
+            } else {
+                if (++currentBlock == blocks.size()) {
+                    blocks.push_back(std::make_unique<char[]>(BLOCK_BYTES));
+                }
+                blockFill = 0;
+            }
+        }
+        size_t chunk = std::min(length, BLOCK_BYTES - blockFill);
+        std::memcpy(blocks[currentBlock].get() + blockFill, data, chunk);
+        blockFill += chunk;
+        data += chunk;
+        length -= chunk;
+    }
+}
+
+template <typename T>
+void CatalogExporter::appendNumber(T value) {
+    char digits[32];
+    append(digits, static_cast<size_t>(std::to_chars(digits, digits + sizeof(digits), value).ptr - digits));
+}
+
+void CatalogExporter::appendPrice(double price) {
+    // Whole-cent prices print as integer cents; the text is the same as the
+    // shortest round-trip form, since no shorter decimal maps to the value
+    double cents = price * 100;
+    if (cents >= 0 && cents < 9007199254740992.0 && cents == static_cast<double>(static_cast<int64_t>(cents)) &&
+        static_cast<double>(static_cast<int64_t>(cents)) / 100 == price) {
+        int64_t whole = static_cast<int64_t>(cents);
+        appendNumber(whole / 100);
+        int64_t fraction = whole % 100;
+        if (fraction != 0) {
+            char digits[3] = {'.', static_cast<char>('0' + fraction / 10), static_cast<char>('0' + fraction % 10)};
+            append(digits, fraction % 10 == 0 ? 2 : 3);
+        }
+        return;
+    }
+    appendNumber(price);
+}
+
+void CatalogExporter::appendCsvField(std::string_view text) {
+    if (!needsCsvQuotes(text)) {
+        append(text);
+        return;
+    }
+    appendChar('"');
+    for (size_t quote; (quote = text.find('"')) != std::string_view::npos; text.remove_prefix(quote + 1)) {
+        append(text.data(), quote + 1);
+        appendChar('"');
+    }
+    append(text);
+    appendChar('"');
+}
+
+void CatalogExporter::appendJsonString(std::string_view text) {
+    appendChar('"');
+    size_t run = 0;
+    for (size_t i = 0; i < text.size(); ++i) {
+        unsigned char c = static_cast<unsigned char>(text[i]);
+        if (!needsJsonEscape(c)) {
+            continue;
+        }
+        append(text.data() + run, i - run);
+        run = i + 1;
+        switch (c) {
+            case '"': append("\\\"", 2); break;
+            case '\\': append("\\\\", 2); break;
+            case '\n': append("\\n", 2); break;
+            case '\r': append("\\r", 2); break;
+            case '\t': append("\\t", 2); break;
+            default: {
+                char escape[] = {'\\', 'u', '0', '0', "0123456789abcdef"[c >> 4], "0123456789abcdef"[c & 15]};
+                append(escape, sizeof(escape));
+            }
+        }
+    }
+    append(text.data() + run, text.size() - run);
+    appendChar('"');
+}
+
+void CatalogExporter::writeCsv(const Book& book) {
+    std::string scratch;
+    appendCsvField(typeName(book, scratch));
+    appendChar(',');
+    append(book.getISBN());
+    appendChar(',');
+    appendCsvField(book.getTitle());
+    appendChar(',');
+    appendCsvField(book.getAuthorName());
+    appendChar(',');
+    appendNumber(book.getYearPublished());
+    appendChar(',');
+    appendPrice(book.getPrice());
+    appendChar(',');
+    if (const PaperBook* paperBook = asPaperBook(&book)) {
+        appendNumber(paperBook->getStock());
+    }
+    appendChar(',');
+    if (const EBook* ebook = asEBook(&book)) {
+        appendCsvField(ebook->getFileType());
+    }
+    appendChar('\n');
+}
+
+void CatalogExporter::writeJson(const Book& book) {
+    std::string scratch;
+    append("{\"type\":", 8);
+    appendJsonString(typeName(book, scratch));
+    append(",\"isbn\":", 8);
+    appendJsonString(book.getISBN());
+    append(",\"title\":", 9);
+    appendJsonString(book.getTitle());
+    append(",\"author\":", 10);
+    appendJsonString(book.getAuthorName());
+    append(",\"year\":", 8);
+    appendNumber(book.getYearPublished());
+    append(",\"price\":", 9);
+    // JSON has no NaN or infinity
+    if (std::isfinite(book.getPrice())) {
+        appendPrice(book.getPrice());
+    } else {
+        append("null", 4);
+    }
+    if (const PaperBook* paperBook = asPaperBook(&book)) {
+        append(",\"stock\":", 9);
+        appendNumber(paperBook->getStock());
+    }
+    if (const EBook* ebook = asEBook(&book)) {
+        append(",\"file_type\":", 13);
+        appendJsonString(ebook->getFileType());
+    }
+    append("}\n", 2);
+}
+
+void CatalogExporter::writeBinary(const Book& book) {
+    const PaperBook* paperBook = asPaperBook(&book);
+    const EBook* ebook = asEBook(&book);
+    std::string_view fileType = ebook ? ebook->getFileType() : std::string_view();
+    if (book.getISBN().size() > UINT8_MAX || fileType.size() > UINT8_MAX ||
+        book.getTitle().size() > UINT32_MAX || book.getAuthorName().size() > UINT32_MAX) {
+        throw std::invalid_argument("Book " + std::string(book.getISBN()) + " has fields too long to export");
+    }
+    ExportRecordHeader header{};
+    header.titleLength = static_cast<uint32_t>(book.getTitle().size());
+    header.authorLength = static_cast<uint32_t>(book.getAuthorName().size());
+    header.year = book.getYearPublished();
+    header.stock = paperBook ? paperBook->getStock() : 0;
+    header.price = book.getPrice();
+    header.kind = static_cast<uint8_t>(book.getKind());
+    header.isbnLength = static_cast<uint8_t>(book.getISBN().size());
+    header.fileTypeLength = static_cast<uint8_t>(fileType.size());
+    append(reinterpret_cast<const char*>(&header), sizeof(header));
+    append(book.getISBN());
+    append(book.getTitle());
+    append(book.getAuthorName());
+    if (ebook) {
+        append(fileType);
+    }
+}
@@ -0,0 +1,607 @@
+#include "../include/CatalogImporter.h"
+#include "../include/FlatHashMap.h"
+#include "../include/IsbnCodec.h"
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <cmath>
+#include <cstring>
+#include <exception>
+#include <fcntl.h>
+#include <mutex>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+
+namespace {
+
+enum Field { TYPE, ISBN, TITLE, AUTHOR, YEAR, PRICE, STOCK, FILE_TYPE, FIELD_COUNT };
+
+constexpr const char* FIELD_NAMES[FIELD_COUNT] = {
+    "type", "isbn", "title", "author", "year", "price", "stock", "file_type"
+};
+
+// Field for a CSV column name or JSON key, or FIELD_COUNT if it is not one
+Field fieldNamed(std::string_view name) {
+    if (name == "fileType" || name == "filetype") {
+        return FILE_TYPE;
+    }
+    for (int field = 0; field < FIELD_COUNT; ++field) {
+        if (name == FIELD_NAMES[field]) {
+            return static_cast<Field>(field);
+        }
+    }
+    return FIELD_COUNT;
+}
+
+struct RowFields {
+    std::string_view values[FIELD_COUNT];
+    bool present[FIELD_COUNT] = {};
+
+    void set(Field field, std::string_view value) {
+        if (field != FIELD_COUNT) {
+            values[field] = value;
+            present[field] = true;
+        }
+    }
+};
+
+std::string_view trim(std::string_view text) {
+    while (!text.empty() && (text.front() == ' ' || text.front() == '\t')) {
+        text.remove_prefix(1);
+    }
+    while (!text.empty() && (text.back() == ' ' || text.back() == '\t' || text.back() == '\r')) {
+        text.remove_suffix(1);
+    }
+    return text;
+}
+
+bool equalsIgnoringCase(std::string_view text, std::string_view lowercase) {
+    if (text.size() != lowercase.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < text.size(); ++i) {
+        char c = text[i];
+        if ((c >= 'A' && c <= 'Z' ? c - 'A' + 'a' : c) != lowercase[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+template <typename T>
+T parseNumber(std::string_view text, Field field) {
+    text = trim(text);
+    T value{};
+    auto result = std::from_chars(text.data(), text.data() + text.size(), value);
+    if (result.ec != std::errc() || result.ptr != text.data() + text.size()) {
+        throw std::invalid_argument("Invalid " + std::string(FIELD_NAMES[field]) + " '" + std::string(text) + "'");
+    }
+    return value;
+}
+
+std::string_view required(const RowFields& row, Field field) {
+    if (!row.present[field] || trim(row.values[field]).empty()) {
+        throw std::invalid_argument("Missing " + std::string(FIELD_NAMES[field]));
+    }
+    return row.values[field];
+}
+
+// Validate a row and build its book in the arena
+BookPtr buildBook(BookArena& arena, const RowFields& row, uint64_t& key) {
+    std::string_view type = trim(required(row, TYPE));
+    std::string_view isbn = trim(required(row, ISBN));
+    std::string_view title = required(row, TITLE);
+    std::string_view author = required(row, AUTHOR);
+    key = IsbnCodec::pack(isbn);
+    if (key == IsbnCodec::INVALID_KEY) {
+        throw std::invalid_argument("Invalid ISBN '" + std::string(isbn) + "'");
+    }
+    int year = parseNumber<int>(required(row, YEAR), YEAR);
+    double price = parseNumber<double>(required(row, PRICE), PRICE);
+    if (!std::isfinite(price) || price < 0) {
+        throw std::invalid_argument("Invalid price '" + std::string(trim(row.values[PRICE])) + "'");
+    }
+
+    if (equalsIgnoringCase(type, "paper")) {
+        int stock = parseNumber<int>(required(row, STOCK), STOCK);
+        if (stock < 0) {
+            throw std::invalid_argument("Invalid stock '" + std::string(trim(row.values[STOCK])) + "'");
+        }
+        return arena.makePaperBook(isbn, title, year, price, author, stock);
+    }
+    if (equalsIgnoringCase(type, "ebook")) {
+        return arena.makeEBook(isbn, title, year, price, author, trim(required(row, FILE_TYPE)));
+    }
+    if (equalsIgnoringCase(type, "showcase")) {
+        return arena.makeShowcaseBook(isbn, title, year, price, author);
+    }
+    throw std::invalid_argument("Unknown book type '" + std::string(type) + "'");
+}
+
+// Split a CSV line. Quoted fields may contain commas and "" escapes; fields
+// needing unescaping are decoded into scratch, which must have capacity for
+// the whole line so earlier views stay valid.
+void splitCsv(std::string_view line, std::vector<std::string_view>& fields, std::string& scratch) {
+    fields.clear();
+    scratch.clear();
+    size_t pos = 0;
+    while (true) {
+        if (pos < line.size() && line[pos] == '"') {
+            size_t start = ++pos;
+            size_t decodedStart = scratch.size();
+            bool escaped = false;
+            while (true) {
+                size_t quote = line.find('"', pos);
+                if (quote == std::string_view::npos) {
+                    throw std::invalid_argument("Unterminated quoted field");
+                }
+                if (quote + 1 < line.size() && line[quote + 1] == '"') {
+                    scratch.append(line.substr(pos, quote + 1 - pos));
+                    escaped = true;
+                    pos = quote + 2;
+                    continue;
+                }
+                scratch.append(line.substr(pos, quote - pos));
+                fields.push_back(escaped ? std::string_view(scratch).substr(decodedStart)
+                                         : line.substr(start, quote - start));
+                pos = quote + 1;
+                break;
+            }
+            if (pos < line.size() && line[pos] != ',') {
+                throw std::invalid_argument("Unexpected text after quoted field");
+            }
+        } else {
+            size_t comma = line.find(',', pos);
+            size_t end = comma == std::string_view::npos ? line.size() : comma;
+            fields.push_back(line.substr(pos, end - pos));
+            pos = end;
+        }
+        if (pos >= line.size()) {
+            return;
+        }
+        ++pos;  // the comma
+    }
+}
+
+void appendUtf8(std::string& out, uint32_t codePoint) {
+    if (codePoint < 0x80) {
+        out += static_cast<char>(codePoint);
+    } else if (codePoint < 0x800) {
+        out += static_cast<char>(0xc0 | (codePoint >> 6));
+        out += static_cast<char>(0x80 | (codePoint & 0x3f));
+    } else if (codePoint < 0x10000) {
+        out += static_cast<char>(0xe0 | (codePoint >> 12));
+        out += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3f));
+        out += static_cast<char>(0x80 | (codePoint & 0x3f));
+    } else {
+        out += static_cast<char>(0xf0 | (codePoint >> 18));
+        out += static_cast<char>(0x80 | ((codePoint >> 12) & 0x3f));
+        out += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3f));
+        out += static_cast<char>(0x80 | (codePoint & 0x3f));
+    }
+}
+
+// Minimal reader for one flat JSON object per line: string, number, true,
+// false and null values; nested values are rejected
+class JsonRowReader {
+public:
+    JsonRowReader(std::string_view line, std::string& scratch) : line(line), scratch(scratch) {
+        scratch.clear();
+    }
+
+    void read(RowFields& row) {
+        skipSpace();
+        expect('{');
+        skipSpace();
+        if (peek() == '}') {
+            ++pos;
+        } else {
+            while (true) {
+                skipSpace();
+                std::string_view key = readString();
+                skipSpace();
+                expect(':');
+                skipSpace();
+                std::string_view value;
+                bool hasValue = readValue(value);
+                if (hasValue) {
+                    row.set(fieldNamed(key), value);
+                }
+                skipSpace();
+                if (peek() == ',') {
+                    ++pos;
+                    continue;
+                }
+                expect('}');
+                break;
+            }
+        }
+        skipSpace();
+        if (pos != line.size()) {
+            throw std::invalid_argument("Unexpected text after JSON object");
+        }
+    }
+
+private:
+    std::string_view line;
+    std::string& scratch;
+    size_t pos = 0;
+
+    char peek() const { return pos < line.size() ? line[pos] : '\0'; }
+
+    void skipSpace() {
+        while (pos < line.size() && (line[pos] == ' ' || line[pos] == '\t' || line[pos] == '\r')) {
+            ++pos;
+        }
+    }
+
+    void expect(char c) {
+        if (peek() != c) {
+            throw std::invalid_argument(std::string("Malformed JSON: expected '") + c + "'");
+        }
+        ++pos;
+    }
+
+    // False for null; booleans and numbers come back as their text
+    bool readValue(std::string_view& value) {
+        char c = peek();
+        if (c == '"') {
+            value = readString();
+            return true;
+        }
+        if (c == '{' || c == '[') {
+            throw std::invalid_argument("Nested JSON values are not supported");
+        }
+        size_t start = pos;
+        while (pos < line.size() && line[pos] != ',' && line[pos] != '}' &&
+               line[pos] != ' ' && line[pos] != '\t' && line[pos] != '\r') {
+            ++pos;
+        }
+        value = line.substr(start, pos - start);
+        if (value.empty()) {
+            throw std::invalid_argument("Malformed JSON: missing value");
+        }
+        return value != "null";
+    }
+
+    uint32_t readHex4() {
+        if (line.size() - pos < 4) {
+            throw std::invalid_argument("Malformed JSON escape");
+        }
+        uint32_t value = 0;
+        auto result = std::from_chars(line.data() + pos, line.data() + pos + 4, value, 16);
+        if (result.ptr != line.data() + pos + 4) {
+            throw std::invalid_argument("Malformed JSON escape");
+        }
+        pos += 4;
+        return value;
+    }
+
+    // Unescaped strings are views of the line; others are decoded into scratch
+    std::string_view readString() {
+        expect('"');
+        size_t start = pos;
+        while (pos < line.size() && line[pos] != '"' && line[pos] != '\\') {
+            ++pos;
+        }
+        if (peek() == '"') {
+            return line.substr(start, pos++ - start);
+        }
+        size_t decodedStart = scratch.size();
+        scratch.append(line.substr(start, pos - start));
+        while (true) {
+            char c = peek();
+            if (c == '\0' && pos >= line.size()) {
+                throw std::invalid_argument("Unterminated JSON string");
+            }
+            ++pos;
+            if (c == '"') {
+                return std::string_view(scratch).substr(decodedStart);
+            }
+            if (c != '\\') {
+                scratch += c;
+                continue;
+            }
+            char escape = peek();
+            ++pos;
+            switch (escape) {
+                case '"': case '\\': case '/': scratch += escape; break;
+                case 'b': scratch += '\b'; break;
+                case 'f': scratch += '\f'; break;
+                case 'n': scratch += '\n'; break;
+                case 'r': scratch += '\r'; break;
+                case 't': scratch += '\t'; break;
+                case 'u': {
+                    uint32_t codePoint = readHex4();
+                    if (codePoint >= 0xd800 && codePoint < 0xdc00 &&
+                        line.substr(pos, 2) == "\\u") {
+                        pos += 2;
+                        uint32_t low = readHex4();
+                        if (low < 0xdc00 || low >= 0xe000) {
+                            throw std::invalid_argument("Malformed JSON surrogate pair");
+                        }
+                        codePoint = 0x10000 + ((codePoint - 0xd800) << 10) + (low - 0xdc00);
+                    }
+                    appendUtf8(scratch, codePoint);
+                    break;
+                }
+                default:
+                    throw std::invalid_argument("Malformed JSON escape");
+            }
+        }
+    }
+};
+
+// Read-only mapping of the input file
+class MappedFile {
+public:
+    explicit MappedFile(const std::string& path) {
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            throw std::runtime_error("Cannot open catalog file " + path);
+        }
+        struct stat info;
+        if (fstat(fd, &info) != 0) {
+            ::close(fd);
+            throw std::runtime_error("Cannot stat catalog file " + path);
+        }
+        length = static_cast<size_t>(info.st_size);
+        if (length > 0) {
+            mapping = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        }
+        ::close(fd);
+        if (mapping == MAP_FAILED) {
+            throw std::runtime_error("Cannot map catalog file " + path);
+        }
+        if (mapping) {
+            madvise(mapping, length, MADV_SEQUENTIAL);
+        }
+    }
+
+    ~MappedFile() {
+        if (mapping) {
+            munmap(mapping, length);
+        }
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    std::string_view text() const {
+        return mapping ? std::string_view(static_cast<const char*>(mapping), length) : std::string_view();
+    }
+
+private:
+    void* mapping = nullptr;
+    size_t length = 0;
+};
+
+struct ParsedRow {
+    BookPtr book;
+    uint64_t key;
+    size_t line;
+};
+
+struct Chunk {
+    std::string_view text;
+    std::shared_ptr<BookArena> arena;
+    std::vector<ParsedRow> rows;
+    std::vector<ImportError> errors;
+    size_t lineCount = 0;
+    size_t rowsRead = 0;
+};
+
+// Run body(i) for i in [0, count) on up to threads threads; the first
+// exception is rethrown once all of them have stopped
+void parallelFor(size_t count, size_t threads, const std::function<void(size_t)>& body) {
+    std::atomic<size_t> next{0};
+    std::exception_ptr failure;
+    std::mutex failureMutex;
+    auto work = [&]() {
+        try {
+            for (size_t i; (i = next.fetch_add(1, std::memory_order_relaxed)) < count;) {
+                body(i);
+            }
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(failureMutex);
+            if (!failure) {
+                failure = std::current_exception();
+            }
+            next.store(count, std::memory_order_relaxed);
+        }
+    };
+    std::vector<std::thread> pool;
+    for (size_t t = 1; t < std::min(threads, count); ++t) {
+        pool.emplace_back(work);
+    }
+    work();
+    for (auto& thread : pool) {
+        thread.join();
+    }
+    if (failure) {
+        std::rethrow_exception(failure);
+    }
+}
+
+// Column of each field in a CSV header, or -1
+std::vector<int> readCsvHeader(std::string_view header, const std::string& path) {
+    if (header.substr(0, 3) == "\xEF\xBB\xBF") {
+        header.remove_prefix(3);
+    }
+    std::vector<std::string_view> names;
+    std::string scratch;
+    scratch.reserve(header.size());
+    splitCsv(header, names, scratch);
+    std::vector<int> columns(FIELD_COUNT, -1);
+    for (size_t column = 0; column < names.size(); ++column) {
+        Field field = fieldNamed(trim(names[column]));
+        if (field != FIELD_COUNT && columns[field] < 0) {
+            columns[field] = static_cast<int>(column);
+        }
+    }
+    for (Field field : {TYPE, ISBN, TITLE, AUTHOR, YEAR, PRICE}) {
+        if (columns[field] < 0) {
+            throw std::runtime_error("CSV header of " + path + " has no '" + FIELD_NAMES[field] + "' column");
+        }
+    }
+    return columns;
+}
+
+void parseChunk(Chunk& chunk, bool json, const std::vector<int>& columns) {
+    std::vector<std::string_view> fields;
+    std::string scratch;
+    std::string_view text = chunk.text;
+    size_t pos = 0;
+    while (pos < text.size()) {
+        size_t newline = text.find('\n', pos);
+        size_t end = newline == std::string_view::npos ? text.size() : newline;
+        std::string_view line = text.substr(pos, end - pos);
+        if (!line.empty() && line.back() == '\r') {
+            line.remove_suffix(1);
+        }
+        pos = end + 1;
+        ++chunk.lineCount;
+        if (trim(line).empty()) {
+            continue;
+        }
+        ++chunk.rowsRead;
+        try {
+            RowFields row;
+            if (scratch.capacity() < line.size()) {
+                scratch.reserve(line.size());
+            }
+            if (json) {
+                JsonRowReader(line, scratch).read(row);
+            } else {
+                splitCsv(line, fields, scratch);
+                for (int field = 0; field < FIELD_COUNT; ++field) {
+                    int column = columns[field];
+                    if (column >= 0 && static_cast<size_t>(column) < fields.size()) {
+                        row.set(static_cast<Field>(field), fields[column]);
+                    }
+                }
+            }
+            uint64_t key;
+            BookPtr book = buildBook(*chunk.arena, row, key);
+            chunk.rows.push_back({std::move(book), key, chunk.lineCount});
+        } catch (const std::exception& error) {
+            chunk.errors.push_back({chunk.lineCount, error.what()});
+        }
+    }
+}
+
+bool isJsonLines(const std::string& path, ImportFormat format) {
+    if (format != ImportFormat::Auto) {
+        return format == ImportFormat::JsonLines;
+    }
+    auto endsWith = [&path](std::string_view suffix) {
+        return path.size() >= suffix.size() && path.compare(path.size() - suffix.size(), suffix.size(), suffix) == 0;
+    };
+    return endsWith(".jsonl") || endsWith(".ndjson");
+}
+
+} // namespace
+
+CatalogImporter::Result CatalogImporter::run(const std::string& path, const ImportOptions& options,
+                                             const Reserve& reserve, const Insert& insert) {
+    MappedFile file(path);
+    std::string_view text = file.text();
+    bool json = isJsonLines(path, options.format);
+    size_t threads = options.threads ? options.threads : std::max(1u, std::thread::hardware_concurrency());
+    size_t chunkBytes = std::max<size_t>(options.chunkBytes, 1);
+
+    // The CSV header is line 1; data chunks start after it
+    std::vector<int> columns;
+    size_t firstLine = 1;
+    if (!json) {
+        size_t headerEnd = std::min(text.find('\n'), text.size());
+        if (trim(text.substr(0, headerEnd)).empty()) {
+            throw std::runtime_error("CSV file " + path + " has no header row");
+        }
+        columns = readCsvHeader(trim(text.substr(0, headerEnd)), path);
+        text.remove_prefix(std::min(headerEnd + 1, text.size()));
+        firstLine = 2;
+    }
+
+    std::vector<Chunk> chunks;
+    for (size_t pos = 0; pos < text.size();) {
+        size_t end = pos + chunkBytes;
+        if (end >= text.size()) {
+            end = text.size();
+        } else {
+            size_t newline = text.find('\n', end - 1);
+            end = newline == std::string_view::npos ? text.size() : newline + 1;
+        }
+        Chunk chunk;
+        chunk.text = text.substr(pos, end - pos);
+        chunk.arena = std::make_shared<BookArena>();
+        chunks.push_back(std::move(chunk));
+        pos = end;
+    }
+
+    parallelFor(chunks.size(), threads, [&](size_t i) {
+        parseChunk(chunks[i], json, columns);
+    });
+
+    // Chunk-local line numbers become file line numbers
+    Result result;
+    size_t parsed = 0;
+    size_t line = firstLine;
+    for (Chunk& chunk : chunks) {
+        for (ParsedRow& row : chunk.rows) {
+            row.line += line - 1;
+        }
+        for (ImportError& error : chunk.errors) {
+            error.line += line - 1;
+            result.report.errors.push_back(std::move(error));
+        }
+        line += chunk.lineCount;
+        parsed += chunk.rows.size();
+        result.report.rowsRead += chunk.rowsRead;
+        result.arenas.push_back(chunk.arena);
+    }
+    if (reserve) {
+        reserve(parsed);
+    }
+
+    // Every row of an ISBN lands in the same partition in file order, so
+    // partitions insert in parallel and the first duplicate wins
+    size_t partitions = std::max<size_t>(1, std::min(threads, parsed));
+    std::vector<std::vector<ParsedRow*>> partitionRows(partitions);
+    for (Chunk& chunk : chunks) {
+        for (ParsedRow& row : chunk.rows) {
+            partitionRows[mixKey(row.key) % partitions].push_back(&row);
+        }
+    }
+    std::vector<std::vector<Book*>> added(partitions);
+    std::vector<std::vector<ImportError>> rejected(partitions);
+    parallelFor(partitions, threads, [&](size_t p) {
+        added[p].reserve(partitionRows[p].size());
+        for (ParsedRow* row : partitionRows[p]) {
+            Book* book = row->book.get();
+            try {
+                if (insert(std::move(row->book))) {
+                    added[p].push_back(book);
+                } else {
+                    rejected[p].push_back({row->line, "Duplicate ISBN " + IsbnCodec::unpack(row->key)});
+                }
+            } catch (const std::exception& error) {
+                rejected[p].push_back({row->line, error.what()});
+            }
+        }
+    });
+
+    for (size_t p = 0; p < partitions; ++p) {
+        result.added.insert(result.added.end(), added[p].begin(), added[p].end());
+        for (ImportError& error : rejected[p]) {
+            result.report.errors.push_back(std::move(error));
+        }
+    }
+    std::stable_sort(result.report.errors.begin(), result.report.errors.end(),
+                     [](const ImportError& a, const ImportError& b) { return a.line < b.line; });
+    result.report.booksAdded = result.added.size();
+    return result;
+}
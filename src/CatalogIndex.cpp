@@ -0,0 +1,85 @@
+#include "../include/CatalogIndex.h"
+
+void CatalogIndex::add(Book* book) {
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    authors.emplace(book->getAuthorName(), book);
+    years.emplace(book->getYearPublished(), book);
+    prices.emplace(book->getPrice(), book);
+}
+
+void CatalogIndex::remove(Book* book) {
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    authors.erase({book->getAuthorName(), book});
+    years.erase({book->getYearPublished(), book});
+    prices.erase({book->getPrice(), book});
+    soldOutBooks.erase(book);
+}
+
+std::vector<Book*> CatalogIndex::takePublishedBefore(int year, size_t limit) {
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    auto split = years.begin();
+    
+    // Keyed erases, so the cost follows the books taken, not how many
+    // others share their author or price
+    std::vector<Book*> taken;
+    for (; split != years.end() && split->first < year && taken.size() < limit; ++split) {
+        Book* book = split->second;
+        authors.erase({book->getAuthorName(), book});
+        prices.erase({book->getPrice(), book});
+        soldOutBooks.erase(book);
+        taken.push_back(book);
+    }
+    years.erase(years.begin(), split);
+    return taken;
+}
+
+void CatalogIndex::markSoldOut(Book* book) {
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    soldOutBooks.insert(book);
+}
+
+void CatalogIndex::markInStock(Book* book) {
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    soldOutBooks.erase(book);
+}
+
+namespace {
+
+template <typename Iterator>
+std::vector<Book*> copyBooks(Iterator first, Iterator last) {
+    std::vector<Book*> books;
+    for (; first != last; ++first) {
+        books.push_back(detail::indexedBook(*first));
+    }
+    return books;
+}
+
+} // namespace
+
+std::vector<Book*> CatalogIndex::byAuthor(const std::string& author) const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    std::string_view key(author);
+    return copyBooks(authors.lower_bound(key), authors.upper_bound(key));
+}
+
+std::vector<Book*> CatalogIndex::publishedBetween(int fromYear, int toYear) const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    if (fromYear > toYear) {
+        return {};
+    }
+    return copyBooks(years.lower_bound(fromYear), years.upper_bound(toYear));
+}
+
+std::vector<Book*> CatalogIndex::pricedBetween(double minPrice, double maxPrice) const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    // Also false for a NaN bound, which would otherwise select the NaN prices
+    if (!(minPrice <= maxPrice)) {
+        return {};
+    }
+    return copyBooks(prices.lower_bound(minPrice), prices.upper_bound(maxPrice));
+}
+
+std::vector<Book*> CatalogIndex::soldOut() const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    return copyBooks(soldOutBooks.begin(), soldOutBooks.end());
+}
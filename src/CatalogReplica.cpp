@@ -0,0 +1,173 @@
+#include "../include/CatalogReplica.h"
+#include <algorithm>
+#include <stdexcept>
+#include <sys/stat.h>
+
+namespace {
+
+constexpr const char* LOG_PREFIX = "Catalog replica";
+
+std::chrono::nanoseconds sincePublished(uint64_t publishedNanos) {
+    auto now = std::chrono::steady_clock::now().time_since_epoch();
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(now) - std::chrono::nanoseconds(publishedNanos);
+}
+
+// Changes when the snapshot file is replaced or rewritten
+uint64_t fileStamp(const std::string& path) {
+    struct stat info;
+    if (stat(path.c_str(), &info) != 0) {
+        return 0;
+    }
+    return static_cast<uint64_t>(info.st_ino) * 1000003 ^ static_cast<uint64_t>(info.st_mtim.tv_sec) * 1000000000 ^
+           static_cast<uint64_t>(info.st_mtim.tv_nsec) ^ static_cast<uint64_t>(info.st_size);
+}
+
+} // namespace
+
+CatalogReplica::CatalogReplica(const std::string& feedName, std::string snapshotPath, ReplicaConfig config)
+    : snapshotPath(std::move(snapshotPath)), config(config), reader(feedName) {}
+
+CatalogReplica::~CatalogReplica() {
+    stop();
+}
+
+void CatalogReplica::bootstrap() {
+    std::lock_guard<std::mutex> lock(applyMutex);
+    load();
+}
+
+void CatalogReplica::load() {
+    // Until this succeeds, a gap waits for the file to change again
+    failedSnapshot = fileStamp(snapshotPath);
+    auto fresh = std::make_shared<QuantumBookstore>(config.shardCount);
+    fresh->loadSnapshot(snapshotPath);
+    uint64_t position = fresh->snapshotFeedPosition;
+    if (!reader.seek(position)) {
+        throw std::runtime_error("Change feed no longer holds the changes after snapshot " + snapshotPath +
+                                 " (sequence " + std::to_string(position) + ")");
+    }
+    {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        if (stats.stale) {
+            stats.stale = false;
+            ++stats.resyncs;
+        }
+        stats.appliedSequence = position;
+        stats.publishedSequence = reader.publishedSequence();
+        current = std::move(fresh);
+    }
+    applied.notify_all();
+    Logger::global().log<LogLevel::Info>(LOG_PREFIX, "Bootstrapped from snapshot {} at sequence {}",
+                                         snapshotPath, position);
+}
+
+size_t CatalogReplica::poll(size_t maxChanges) {
+    std::lock_guard<std::mutex> lock(applyMutex);
+    if (!current) {
+        load();
+    } else if (reader.inGap()) {
+        // Retry only once the snapshot has been rewritten since the last try
+        if (fileStamp(snapshotPath) == failedSnapshot) {
+            return 0;
+        }
+        try {
+            load();
+        } catch (const std::exception& error) {
+            Logger::global().log<LogLevel::Warning>(LOG_PREFIX, "Cannot catch up yet: {}", error.what());
+            return 0;
+        }
+    }
+
+    QuantumBookstore& target = *current;
+    target.awaitIndexes();
+    size_t count = 0;
+    std::chrono::nanoseconds lag{0};
+    std::chrono::nanoseconds maxLag{0};
+    bool lapped = false;
+    while (count < maxChanges) {
+        ChangeFeedReader::Status status = reader.next(record);
+        if (status == ChangeFeedReader::Status::Empty) {
+            break;
+        }
+        if (status == ChangeFeedReader::Status::Gap) {
+            lapped = true;
+            break;
+        }
+        target.applyLogEntry(record.entry);
+        ++count;
+        lag = sincePublished(record.publishedNanos);
+        maxLag = std::max(maxLag, lag);
+    }
+
+    {
+        std::lock_guard<std::mutex> stateLock(stateMutex);
+        stats.publishedSequence = reader.publishedSequence();
+        if (count > 0) {
+            stats.appliedSequence = reader.lastSequence();
+            stats.changesApplied += count;
+            stats.lastLag = lag;
+            stats.maxLag = std::max(stats.maxLag, maxLag);
+        }
+        if (lapped) {
+            ++stats.gaps;
+            stats.stale = true;
+        }
+    }
+    if (count > 0) {
+        applied.notify_all();
+    }
+    if (lapped) {
+        failedSnapshot = 0;
+        Logger::global().log<LogLevel::Warning>(LOG_PREFIX, "Change feed lapped the replica after sequence {}",
+                                                reader.lastSequence());
+    }
+    return count;
+}
+
+void CatalogReplica::start() {
+    stop();
+    stopping.store(false, std::memory_order_relaxed);
+    tailer = std::thread([this]() {
+        while (!stopping.load(std::memory_order_relaxed)) {
+            try {
+                if (poll() > 0) {
+                    continue;
+                }
+                std::lock_guard<std::mutex> lock(applyMutex);
+                if (reader.inGap()) {
+                    // Waiting for a newer snapshot, not for the feed
+                    std::this_thread::sleep_for(config.idleWait);
+                } else {
+                    reader.wait(config.idleWait);
+                }
+            } catch (const std::exception& error) {
+                Logger::global().log<LogLevel::Error>(LOG_PREFIX, "Tailing failed: {}", error.what());
+                std::this_thread::sleep_for(config.idleWait);
+            }
+        }
+    });
+}
+
+void CatalogReplica::stop() {
+    stopping.store(true, std::memory_order_relaxed);
+    if (tailer.joinable()) {
+        tailer.join();
+    }
+}
+
+bool CatalogReplica::waitFor(uint64_t sequence, std::chrono::milliseconds timeout) const {
+    std::unique_lock<std::mutex> lock(stateMutex);
+    return applied.wait_for(lock, timeout, [&]() { return current && stats.appliedSequence >= sequence; });
+}
+
+std::shared_ptr<const QuantumBookstore> CatalogReplica::store() const {
+    std::lock_guard<std::mutex> lock(stateMutex);
+    return current;
+}
+
+ReplicaStats CatalogReplica::getStats() const {
+    std::lock_guard<std::mutex> lock(stateMutex);
+    ReplicaStats snapshot = stats;
+    snapshot.publishedSequence = std::max(snapshot.publishedSequence, reader.publishedSequence());
+    return snapshot;
+}
@@ -0,0 +1,274 @@
+#include "../include/CatalogSnapshot.h"
+#include "../include/BookTypes.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <type_traits>
+#include <unistd.h>
+#include <unordered_map>
+
+namespace {
+
+constexpr char MAGIC[8] = {'Q', 'B', 'S', 'N', 'A', 'P', '\0', '\0'};
+constexpr size_t RECORDS_OFFSET = 64;
+
+struct SnapshotHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t recordSize;
+    uint64_t bookCount;
+    uint64_t stringBytes;
+    uint64_t checksum;  // over records and strings
+    uint64_t logPosition;  // last write-ahead log LSN reflected in the books
+    uint64_t feedPosition;  // last change feed sequence reflected; zero in older files
+};
+
+static_assert(sizeof(SnapshotHeader) <= RECORDS_OFFSET, "header must fit before the records");
+static_assert(sizeof(SnapshotRecord) == 56, "record layout is part of the file format");
+static_assert(std::is_trivially_copyable_v<SnapshotRecord>, "records are read straight from the file");
+
+// Whether a span lies in the string area; a corrupt offset near 2^64 must
+// not wrap the sum back into range
+bool inStrings(uint64_t offset, uint64_t length, uint64_t stringBytes) {
+    return offset <= stringBytes && length <= stringBytes - offset;
+}
+
+// Word-at-a-time hash with four independent lanes, so validating a large
+// snapshot runs at memory speed rather than a byte per cycle
+class Checksum {
+public:
+    void update(const void* data, size_t size) {
+        const unsigned char* bytes = static_cast<const unsigned char*>(data);
+        if (pendingSize > 0) {
+            size_t take = std::min(size, sizeof(pending) - pendingSize);
+            std::memcpy(pending + pendingSize, bytes, take);
+            pendingSize += take;
+            bytes += take;
+            size -= take;
+            if (pendingSize < sizeof(pending)) {
+                return;
+            }
+            mixBlock(pending);
+            pendingSize = 0;
+        }
+        for (; size >= sizeof(pending); bytes += sizeof(pending), size -= sizeof(pending)) {
+            mixBlock(bytes);
+        }
+        std::memcpy(pending, bytes, size);
+        pendingSize = size;
+    }
+    
+    uint64_t finish() {
+        std::memset(pending + pendingSize, 0, sizeof(pending) - pendingSize);
+        mixBlock(pending);
+        uint64_t result = total;
+        for (uint64_t lane : lanes) {
+            result = (result ^ lane) * PRIME;
+            result ^= result >> 29;
+        }
+        return result;
+    }
+    
+private:
+    static constexpr uint64_t PRIME = 0x9e3779b97f4a7c15ULL;
+    uint64_t lanes[4] = {1, 2, 3, 4};
+    uint64_t total = 0;
+    unsigned char pending[32];
+    size_t pendingSize = 0;
+    
+    void mixBlock(const unsigned char* block) {
+        for (size_t lane = 0; lane < 4; ++lane) {
+            uint64_t word;
+            std::memcpy(&word, block + lane * 8, sizeof(word));
+            lanes[lane] = (lanes[lane] ^ word) * PRIME;
+            lanes[lane] ^= lanes[lane] >> 32;
+        }
+        total += sizeof(pending);
+    }
+};
+
+// fsync a file or directory by name
+bool syncPath(const std::string& path) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    bool synced = fsync(fd) == 0;
+    ::close(fd);
+    return synced;
+}
+
+} // namespace
+
+void CatalogSnapshot::write(const std::string& path, const std::vector<const Book*>& books, 
+                            uint64_t logPosition, uint64_t feedPosition, const std::vector<int>& stocks) {
+    std::vector<SnapshotRecord> records;
+    records.reserve(books.size());
+    std::string strings;
+    std::unordered_map<std::string_view, uint64_t> shared;  // author/file type -> offset
+    auto sharedOffset = [&](std::string_view text) {
+        auto it = shared.find(text);
+        if (it != shared.end()) {
+            return it->second;
+        }
+        uint64_t offset = strings.size();
+        strings.append(text);
+        shared.emplace(text, offset);
+        return offset;
+    };
+    
+    for (size_t i = 0; i < books.size(); ++i) {
+        const Book* book = books[i];
+        SnapshotRecord record{};
+        record.textOffset = strings.size();
+        strings.append(book->getISBN());
+        strings.append(book->getTitle());
+        record.isbnLength = static_cast<uint8_t>(book->getISBN().size());
+        record.titleLength = static_cast<uint32_t>(book->getTitle().size());
+        record.authorOffset = sharedOffset(book->getAuthorName());
+        record.authorLength = static_cast<uint16_t>(book->getAuthorName().size());
+        record.year = book->getYearPublished();
+        record.price = book->getPrice();
+        record.kind = static_cast<uint8_t>(book->getKind());
+        visitBook(*book, BookVisitor{
+            [&](const PaperBook& paperBook) {
+                // Holds do not survive a restart; their units go back to stock
+                record.stock = stocks.empty() ? paperBook.getStockOnHand() : stocks[i];
+            },
+            [&](const EBook& ebook) {
+                record.fileTypeOffset = sharedOffset(ebook.getFileType());
+                record.fileTypeLength = static_cast<uint8_t>(ebook.getFileType().size());
+            },
+            [](const ShowcaseBook&) {},
+            [](const Book& other) {
+                throw std::invalid_argument("Cannot snapshot book type " + other.getType());
+            }
+        });
+        records.push_back(record);
+    }
+    
+    SnapshotHeader header{};
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = FORMAT_VERSION;
+    header.recordSize = sizeof(SnapshotRecord);
+    header.bookCount = records.size();
+    header.stringBytes = strings.size();
+    header.logPosition = logPosition;
+    header.feedPosition = feedPosition;
+    Checksum checksum;
+    checksum.update(records.data(), records.size() * sizeof(SnapshotRecord));
+    checksum.update(strings.data(), strings.size());
+    header.checksum = checksum.finish();
+    
+    std::string temporary = path + ".tmp";
+    {
+        std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+        char headerBlock[RECORDS_OFFSET] = {};
+        std::memcpy(headerBlock, &header, sizeof(header));
+        out.write(headerBlock, sizeof(headerBlock));
+        out.write(reinterpret_cast<const char*>(records.data()), 
+                  static_cast<std::streamsize>(records.size() * sizeof(SnapshotRecord)));
+        out.write(strings.data(), static_cast<std::streamsize>(strings.size()));
+        out.close();
+        if (!out || !syncPath(temporary)) {
+            std::remove(temporary.c_str());
+            throw std::runtime_error("Failed to write snapshot " + temporary);
+        }
+    }
+    if (std::rename(temporary.c_str(), path.c_str()) != 0) {
+        std::remove(temporary.c_str());
+        throw std::runtime_error("Failed to replace snapshot " + path);
+    }
+    // Make the rename itself durable before a checkpoint drops the log
+    std::string::size_type slash = path.rfind('/');
+    syncPath(slash == std::string::npos ? "." : (slash == 0 ? "/" : path.substr(0, slash)));
+}
+
+std::shared_ptr<const CatalogSnapshot> CatalogSnapshot::open(const std::string& path) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("Cannot open snapshot " + path);
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < RECORDS_OFFSET) {
+        ::close(fd);
+        throw std::runtime_error("Snapshot too short: " + path);
+    }
+    size_t length = static_cast<size_t>(info.st_size);
+    // Private read-only mapping: pages are shared with the page cache and
+    // never written, so nothing is copied unless the kernel has to
+    void* mapping = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        throw std::runtime_error("Cannot map snapshot " + path);
+    }
+    madvise(mapping, length, MADV_WILLNEED);
+    
+    std::shared_ptr<CatalogSnapshot> snapshot(new CatalogSnapshot(mapping, length));
+    snapshot->validate(path);
+    return snapshot;
+}
+
+CatalogSnapshot::CatalogSnapshot(void* mapping, size_t length)
+    : mapping(mapping), length(length), records(nullptr), count(0), strings(nullptr), stringBytes(0), 
+      logLsn(0) {}
+
+CatalogSnapshot::~CatalogSnapshot() {
+    munmap(mapping, length);
+}
+
+void CatalogSnapshot::validate(const std::string& path) {
+    const char* base = static_cast<const char*>(mapping);
+    SnapshotHeader header;
+    std::memcpy(&header, base, sizeof(header));
+    if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0) {
+        throw std::runtime_error("Not a catalog snapshot: " + path);
+    }
+    if (header.version != FORMAT_VERSION || header.recordSize != sizeof(SnapshotRecord)) {
+        throw std::runtime_error("Unsupported snapshot version " + std::to_string(header.version) + ": " + path);
+    }
+    size_t payload = length - RECORDS_OFFSET;
+    if (header.bookCount > payload / sizeof(SnapshotRecord) || 
+        header.stringBytes != payload - header.bookCount * sizeof(SnapshotRecord)) {
+        throw std::runtime_error("Snapshot size mismatch: " + path);
+    }
+    
+    Checksum checksum;
+    checksum.update(base + RECORDS_OFFSET, payload);
+    if (checksum.finish() != header.checksum) {
+        throw std::runtime_error("Snapshot checksum mismatch: " + path);
+    }
+    
+    records = reinterpret_cast<const SnapshotRecord*>(base + RECORDS_OFFSET);
+    count = header.bookCount;
+    strings = base + RECORDS_OFFSET + header.bookCount * sizeof(SnapshotRecord);
+    stringBytes = header.stringBytes;
+    logLsn = header.logPosition;
+    feedSequence = header.feedPosition;
+    
+    for (size_t i = 0; i < count; ++i) {
+        const SnapshotRecord& record = records[i];
+        bool inBounds = inStrings(record.textOffset, uint64_t{record.isbnLength} + record.titleLength, stringBytes) && 
+                        inStrings(record.authorOffset, record.authorLength, stringBytes) && 
+                        inStrings(record.fileTypeOffset, record.fileTypeLength, stringBytes);
+        if (!inBounds || record.kind > static_cast<uint8_t>(BookKind::Showcase)) {
+            throw std::runtime_error("Corrupt snapshot record " + std::to_string(i) + ": " + path);
+        }
+    }
+}
+
+BookText CatalogSnapshot::textOf(const SnapshotRecord& record) const {
+    const char* text = strings + record.textOffset;
+    return BookText{std::string_view(text, record.isbnLength), 
+                    std::string_view(text + record.isbnLength, record.titleLength), 
+                    std::string_view(strings + record.authorOffset, record.authorLength)};
+}
+
+std::string_view CatalogSnapshot::fileTypeOf(const SnapshotRecord& record) const {
+    return std::string_view(strings + record.fileTypeOffset, record.fileTypeLength);
+}
@@ -0,0 +1,340 @@
+#include "../include/ChangeFeed.h"
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <new>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <thread>
+#include <unistd.h>
+
+namespace {
+
+constexpr uint64_t MAGIC = 0x4445454648434251ULL;  // "QBCHFEED" in memory
+constexpr uint32_t VERSION = 1;
+// The header gets a page of its own so readers can map the ring read-only
+constexpr size_t HEADER_BYTES = 4096;
+
+// Record layout in the ring: payload size, type, padding, sequence,
+// publish time, then the payload; records start on 8-byte boundaries and
+// may wrap around the end of the ring
+constexpr size_t RECORD_HEADER_SIZE = 24;
+constexpr size_t TYPE_OFFSET = 4;
+constexpr size_t SEQUENCE_OFFSET = 8;
+constexpr size_t TIME_OFFSET = 16;
+
+// Checks of the producer's head before a reader sleeps
+constexpr int SPIN_CHECKS = 64;
+
+static_assert(sizeof(ChangeFeedHeader) <= HEADER_BYTES, "header must fit its page");
+static_assert(std::atomic<uint64_t>::is_always_lock_free && std::atomic<uint32_t>::is_always_lock_free,
+              "feed counters are shared between processes");
+
+uint64_t recordBytes(uint32_t payloadSize) {
+    return (RECORD_HEADER_SIZE + payloadSize + 7) & ~uint64_t{7};
+}
+
+uint64_t monotonicNanos() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+std::string errorText(const std::string& what, const std::string& name) {
+    return what + " " + name + ": " + std::strerror(errno);
+}
+
+uint32_t* futexWord(std::atomic<uint32_t>& word) {
+    return reinterpret_cast<uint32_t*>(&word);
+}
+
+// Head and the sequence of the record ending there, read as a pair: only
+// consistent if no publish was in flight meanwhile
+void readHead(const ChangeFeedHeader& header, uint64_t& head, uint64_t& sequence) {
+    while (true) {
+        head = header.head.load(std::memory_order_acquire);
+        sequence = header.headSequence.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (header.claimed.load(std::memory_order_relaxed) == head) {
+            return;
+        }
+        std::this_thread::yield();
+    }
+}
+
+} // namespace
+
+// ChangeFeed
+
+ChangeFeed::ChangeFeed(const std::string& name, size_t capacity, uint64_t startAfter)
+    : name(name), nextSequence(startAfter + 1) {
+    if (capacity < MIN_CAPACITY || (capacity & (capacity - 1)) != 0) {
+        throw std::invalid_argument("Change feed capacity must be a power of two of at least " +
+                                    std::to_string(MIN_CAPACITY));
+    }
+    // A fresh object each time, so a stale ring's readers are not mixed in
+    shm_unlink(name.c_str());
+    int fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        throw std::runtime_error(errorText("Cannot create change feed", name));
+    }
+    mappedBytes = HEADER_BYTES + capacity;
+    void* mapping = MAP_FAILED;
+    if (ftruncate(fd, static_cast<off_t>(mappedBytes)) == 0) {
+        mapping = mmap(nullptr, mappedBytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    if (mapping == MAP_FAILED) {
+        std::string error = errorText("Cannot map change feed", name);
+        ::close(fd);
+        shm_unlink(name.c_str());
+        throw std::runtime_error(error);
+    }
+    ::close(fd);
+
+    header = new (mapping) ChangeFeedHeader();
+    header->capacity = capacity;
+    header->headSequence.store(startAfter, std::memory_order_relaxed);
+    ring = static_cast<char*>(mapping) + HEADER_BYTES;
+    header->version = VERSION;
+    // Readers check the magic last
+    std::atomic_thread_fence(std::memory_order_release);
+    header->magic = MAGIC;
+}
+
+ChangeFeed::~ChangeFeed() {
+    munmap(header, mappedBytes);
+    shm_unlink(name.c_str());
+}
+
+template <typename Encode>
+uint64_t ChangeFeed::publish(WalEntry::Type type, size_t payloadSize, Encode&& encode) {
+    const uint64_t capacity = header->capacity;
+    if (payloadSize > capacity / 2) {
+        throw std::invalid_argument("Change record too large for feed " + name);
+    }
+    uint64_t size = recordBytes(static_cast<uint32_t>(payloadSize));
+    std::lock_guard<std::mutex> lock(mutex);
+    uint64_t sequence = nextSequence;
+    staging.assign(size, 0);
+    char* record = staging.data();
+    uint32_t payload32 = static_cast<uint32_t>(payloadSize);
+    uint64_t now = monotonicNanos();
+    std::memcpy(record, &payload32, sizeof(payload32));
+    record[TYPE_OFFSET] = static_cast<char>(type);
+    std::memcpy(record + SEQUENCE_OFFSET, &sequence, sizeof(sequence));
+    std::memcpy(record + TIME_OFFSET, &now, sizeof(now));
+    encode(record + RECORD_HEADER_SIZE);
+
+    // Drop the oldest records the new one overwrites
+    uint64_t head = header->head.load(std::memory_order_relaxed);
+    uint64_t end = head + size;
+    uint64_t tail = header->tail.load(std::memory_order_relaxed);
+    while (end - tail > capacity) {
+        uint32_t oldSize;
+        uint64_t at = tail & (capacity - 1);
+        size_t first = std::min<uint64_t>(sizeof(oldSize), capacity - at);
+        std::memcpy(&oldSize, ring + at, first);
+        std::memcpy(reinterpret_cast<char*>(&oldSize) + first, ring, sizeof(oldSize) - first);
+        tail += recordBytes(oldSize);
+    }
+    header->tail.store(tail, std::memory_order_release);
+
+    // Readers recheck claimed after copying, so they drop what this overwrites
+    header->claimed.store(end, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    uint64_t at = head & (capacity - 1);
+    size_t first = std::min<uint64_t>(size, capacity - at);
+    std::memcpy(ring + at, record, first);
+    std::memcpy(ring, record + first, size - first);
+    header->headSequence.store(sequence, std::memory_order_relaxed);
+    header->head.store(end, std::memory_order_release);
+    ++nextSequence;
+
+    // Pairs with the fence in ChangeFeedReader::wait: either the sleeper
+    // sees the new head or this sees the sleeper
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (header->sleepers.load(std::memory_order_relaxed) > 0) {
+        header->signal.fetch_add(1, std::memory_order_relaxed);
+        syscall(SYS_futex, futexWord(header->signal), FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+    }
+    return sequence;
+}
+
+uint64_t ChangeFeed::publishAddBook(const Book& book) {
+    return publish(WalEntry::Type::AddBook, WalCodec::addBookSize(book), [&](char* out) {
+        WalCodec::encodeAddBook(book, out);
+    });
+}
+
+uint64_t ChangeFeed::publishSale(const WalSaleLine* lines, size_t count) {
+    return publish(WalEntry::Type::Sale, WalCodec::saleSize(count), [&](char* out) {
+        WalCodec::encodeSale(lines, count, out);
+    });
+}
+
+uint64_t ChangeFeed::publishRemoveBook(uint64_t isbnKey) {
+    return publish(WalEntry::Type::RemoveBook, WalCodec::REMOVE_BOOK_SIZE, [&](char* out) {
+        WalCodec::encodeRemoveBook(isbnKey, out);
+    });
+}
+
+uint64_t ChangeFeed::lastSequence() const {
+    return header->headSequence.load(std::memory_order_acquire);
+}
+
+// ChangeFeedReader
+
+ChangeFeedReader::ChangeFeedReader(const std::string& name) {
+    int fd = shm_open(name.c_str(), O_RDWR | O_CLOEXEC, 0);
+    if (fd < 0) {
+        throw std::runtime_error(errorText("Cannot open change feed", name));
+    }
+    struct stat info;
+    void* headerMapping = MAP_FAILED;
+    if (fstat(fd, &info) == 0 && static_cast<size_t>(info.st_size) >= HEADER_BYTES + ChangeFeed::MIN_CAPACITY) {
+        headerMapping = mmap(nullptr, HEADER_BYTES, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    if (headerMapping == MAP_FAILED) {
+        ::close(fd);
+        throw std::runtime_error("Cannot map change feed " + name);
+    }
+    header = static_cast<ChangeFeedHeader*>(headerMapping);
+    uint64_t magic = header->magic;
+    std::atomic_thread_fence(std::memory_order_acquire);
+    uint64_t capacity = header->capacity;
+    void* ringMapping = MAP_FAILED;
+    if (magic == MAGIC && header->version == VERSION && capacity >= ChangeFeed::MIN_CAPACITY &&
+        (capacity & (capacity - 1)) == 0 && static_cast<size_t>(info.st_size) == HEADER_BYTES + capacity) {
+        ringMapping = mmap(nullptr, capacity, PROT_READ, MAP_SHARED, fd, HEADER_BYTES);
+    }
+    ::close(fd);
+    if (ringMapping == MAP_FAILED) {
+        munmap(headerMapping, HEADER_BYTES);
+        throw std::runtime_error("Not a change feed: " + name);
+    }
+    ring = static_cast<const char*>(ringMapping);
+    mask = capacity - 1;
+    readHead(*header, position, sequence);
+}
+
+ChangeFeedReader::~ChangeFeedReader() {
+    munmap(const_cast<char*>(ring), mask + 1);
+    munmap(header, HEADER_BYTES);
+}
+
+void ChangeFeedReader::copyOut(uint64_t offset, char* out, size_t size) const {
+    uint64_t at = offset & mask;
+    size_t first = std::min<uint64_t>(size, mask + 1 - at);
+    std::memcpy(out, ring + at, first);
+    std::memcpy(out + first, ring, size - first);
+}
+
+bool ChangeFeedReader::overwritten(uint64_t offset) const {
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return header->claimed.load(std::memory_order_relaxed) - offset > mask + 1;
+}
+
+bool ChangeFeedReader::seek(uint64_t afterSequence) {
+    uint64_t head;
+    uint64_t published;
+    readHead(*header, head, published);
+    if (afterSequence > published) {
+        throw std::runtime_error("Change feed has not published record " + std::to_string(afterSequence));
+    }
+    gap = false;
+    if (afterSequence == published) {
+        position = head;
+        sequence = published;
+        return true;
+    }
+    // Walk from the oldest record to the one after afterSequence
+    uint64_t offset = header->tail.load(std::memory_order_acquire);
+    while (offset != head) {
+        char fields[RECORD_HEADER_SIZE];
+        copyOut(offset, fields, sizeof(fields));
+        if (overwritten(offset)) {
+            offset = header->tail.load(std::memory_order_acquire);  // lapped while walking
+            continue;
+        }
+        uint32_t payloadSize;
+        uint64_t found;
+        std::memcpy(&payloadSize, fields, sizeof(payloadSize));
+        std::memcpy(&found, fields + SEQUENCE_OFFSET, sizeof(found));
+        if (found > afterSequence + 1) {
+            break;
+        }
+        if (found == afterSequence + 1) {
+            position = offset;
+            sequence = afterSequence;
+            return true;
+        }
+        offset += recordBytes(payloadSize);
+    }
+    gap = true;
+    return false;
+}
+
+ChangeFeedReader::Status ChangeFeedReader::next(ChangeRecord& record) {
+    if (gap) {
+        return Status::Gap;
+    }
+    if (header->head.load(std::memory_order_acquire) == position) {
+        return Status::Empty;
+    }
+    char fields[RECORD_HEADER_SIZE];
+    copyOut(position, fields, sizeof(fields));
+    uint32_t payloadSize;
+    uint64_t found;
+    std::memcpy(&payloadSize, fields, sizeof(payloadSize));
+    std::memcpy(&found, fields + SEQUENCE_OFFSET, sizeof(found));
+    if (overwritten(position) || found != sequence + 1 || payloadSize > (mask + 1) / 2) {
+        gap = true;
+        return Status::Gap;
+    }
+    buffer.resize(payloadSize);
+    copyOut(position + RECORD_HEADER_SIZE, buffer.data(), payloadSize);
+    if (overwritten(position)) {
+        gap = true;
+        return Status::Gap;
+    }
+
+    record.entry.type = static_cast<WalEntry::Type>(fields[TYPE_OFFSET]);
+    record.entry.lsn = found;
+    std::memcpy(&record.publishedNanos, fields + TIME_OFFSET, sizeof(record.publishedNanos));
+    if (!WalCodec::decode(record.entry, buffer.data(), payloadSize)) {
+        throw std::runtime_error("Corrupt change record " + std::to_string(found));
+    }
+    position += recordBytes(payloadSize);
+    sequence = found;
+    return Status::Ok;
+}
+
+void ChangeFeedReader::wait(std::chrono::microseconds timeout) {
+    for (int check = 0; check < SPIN_CHECKS; ++check) {
+        if (header->head.load(std::memory_order_acquire) != position) {
+            return;
+        }
+        std::this_thread::yield();
+    }
+    header->sleepers.fetch_add(1, std::memory_order_relaxed);
+    uint32_t observed = header->signal.load(std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (header->head.load(std::memory_order_relaxed) == position) {
+        timespec limit{static_cast<time_t>(timeout.count() / 1000000),
+                       static_cast<long>(timeout.count() % 1000000 * 1000)};
+        // Returns at once if the producer bumped the signal since it was read
+        syscall(SYS_futex, futexWord(header->signal), FUTEX_WAIT, observed, &limit, nullptr, 0);
+    }
+    header->sleepers.fetch_sub(1, std::memory_order_relaxed);
+}
+
+uint64_t ChangeFeedReader::lastSequence() const {
+    return sequence;
+}
+
+uint64_t ChangeFeedReader::publishedSequence() const {
+    return header->headSequence.load(std::memory_order_acquire);
+}
@@ -0,0 +1,400 @@
+#include "../include/ColumnarCatalog.h"
+#include "../include/BookTypes.h"
+#include <algorithm>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define QB_X86_SIMD 1
+#include <immintrin.h>
+#endif
+
+namespace {
+
+constexpr size_t ROWS_PER_WORD = 64;
+
+size_t wordCount(size_t rows) {
+    return (rows + ROWS_PER_WORD - 1) / ROWS_PER_WORD;
+}
+
+// Scalar kernels: fill mask bits for rows [begin, end)
+void lessInt32Scalar(const int32_t* data, size_t begin, size_t end, int32_t bound, uint64_t* mask) {
+    for (size_t row = begin; row < end; ++row) {
+        mask[row / ROWS_PER_WORD] |= static_cast<uint64_t>(data[row] < bound) << (row % ROWS_PER_WORD);
+    }
+}
+
+void equalInt32Scalar(const int32_t* data, size_t begin, size_t end, int32_t value, uint64_t* mask) {
+    for (size_t row = begin; row < end; ++row) {
+        mask[row / ROWS_PER_WORD] |= static_cast<uint64_t>(data[row] == value) << (row % ROWS_PER_WORD);
+    }
+}
+
+void inRangeDoubleScalar(const double* data, size_t begin, size_t end, double low, double high, uint64_t* mask) {
+    for (size_t row = begin; row < end; ++row) {
+        bool inRange = data[row] >= low && data[row] <= high;
+        mask[row / ROWS_PER_WORD] |= static_cast<uint64_t>(inRange) << (row % ROWS_PER_WORD);
+    }
+}
+
+void equalUint8Scalar(const uint8_t* data, size_t begin, size_t end, uint8_t value, uint64_t* mask) {
+    for (size_t row = begin; row < end; ++row) {
+        mask[row / ROWS_PER_WORD] |= static_cast<uint64_t>(data[row] == value) << (row % ROWS_PER_WORD);
+    }
+}
+
+#ifdef QB_X86_SIMD
+
+// SSE2 kernels (x86 baseline); each handles whole 64-row words
+void lessInt32Sse2(const int32_t* data, size_t words, int32_t bound, uint64_t* mask) {
+    const __m128i boundVec = _mm_set1_epi32(bound);
+    for (size_t w = 0; w < words; ++w) {
+        const int32_t* block = data + w * ROWS_PER_WORD;
+        uint64_t bits = 0;
+        for (size_t i = 0; i < ROWS_PER_WORD; i += 4) {
+            __m128i values = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + i));
+            int lanes = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmplt_epi32(values, boundVec)));
+            bits |= static_cast<uint64_t>(lanes) << i;
+        }
+        mask[w] = bits;
+    }
+}
+
+void equalInt32Sse2(const int32_t* data, size_t words, int32_t value, uint64_t* mask) {
+    const __m128i valueVec = _mm_set1_epi32(value);
+    for (size_t w = 0; w < words; ++w) {
+        const int32_t* block = data + w * ROWS_PER_WORD;
+        uint64_t bits = 0;
+        for (size_t i = 0; i < ROWS_PER_WORD; i += 4) {
+            __m128i values = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + i));
+            int lanes = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(values, valueVec)));
+            bits |= static_cast<uint64_t>(lanes) << i;
+        }
+        mask[w] = bits;
+    }
+}
+
+void inRangeDoubleSse2(const double* data, size_t words, double low, double high, uint64_t* mask) {
+    const __m128d lowVec = _mm_set1_pd(low);
+    const __m128d highVec = _mm_set1_pd(high);
+    for (size_t w = 0; w < words; ++w) {
+        const double* block = data + w * ROWS_PER_WORD;
+        uint64_t bits = 0;
+        for (size_t i = 0; i < ROWS_PER_WORD; i += 2) {
+            __m128d values = _mm_loadu_pd(block + i);
+            __m128d inRange = _mm_and_pd(_mm_cmpge_pd(values, lowVec), _mm_cmple_pd(values, highVec));
+            bits |= static_cast<uint64_t>(_mm_movemask_pd(inRange)) << i;
+        }
+        mask[w] = bits;
+    }
+}
+
+void equalUint8Sse2(const uint8_t* data, size_t words, uint8_t value, uint64_t* mask) {
+    const __m128i valueVec = _mm_set1_epi8(static_cast<char>(value));
+    for (size_t w = 0; w < words; ++w) {
+        const uint8_t* block = data + w * ROWS_PER_WORD;
+        uint64_t bits = 0;
+        for (size_t i = 0; i < ROWS_PER_WORD; i += 16) {
+            __m128i values = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + i));
+            unsigned lanes = static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(values, valueVec)));
+            bits |= static_cast<uint64_t>(lanes) << i;
+        }
+        mask[w] = bits;
+    }
+}
+
+// AVX2 kernels, selected at runtime when the CPU supports them
+__attribute__((target("avx2")))
+void lessInt32Avx2(const int32_t* data, size_t words, int32_t bound, uint64_t* mask) {
+    const __m256i boundVec = _mm256_set1_epi32(bound);
+    for (size_t w = 0; w < words; ++w) {
+        const int32_t* block = data + w * ROWS_PER_WORD;
+        uint64_t bits = 0;
+        for (size_t i = 0; i < ROWS_PER_WORD; i += 8) {
+            __m256i values = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block + i));
+            int lanes = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(boundVec, values)));
+            bits |= static_cast<uint64_t>(lanes) << i;
+        }
+        mask[w] = bits;
+    }
+}
+
+__attribute__((target("avx2")))
+void equalInt32Avx2(const int32_t* data, size_t words, int32_t value, uint64_t* mask) {
+    const __m256i valueVec = _mm256_set1_epi32(value);
+    for (size_t w = 0; w < words; ++w) {
+        const int32_t* block = data + w * ROWS_PER_WORD;
+        uint64_t bits = 0;
+        for (size_t i = 0; i < ROWS_PER_WORD; i += 8) {
+            __m256i values = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block + i));
+            int lanes = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(values, valueVec)));
+            bits |= static_cast<uint64_t>(lanes) << i;
+        }
+        mask[w] = bits;
+    }
+}
+
+__attribute__((target("avx2")))
+void inRangeDoubleAvx2(const double* data, size_t words, double low, double high, uint64_t* mask) {
+    const __m256d lowVec = _mm256_set1_pd(low);
+    const __m256d highVec = _mm256_set1_pd(high);
+    for (size_t w = 0; w < words; ++w) {
+        const double* block = data + w * ROWS_PER_WORD;
+        uint64_t bits = 0;
+        for (size_t i = 0; i < ROWS_PER_WORD; i += 4) {
+            __m256d values = _mm256_loadu_pd(block + i);
+            __m256d inRange = _mm256_and_pd(_mm256_cmp_pd(values, lowVec, _CMP_GE_OQ),
+                                            _mm256_cmp_pd(values, highVec, _CMP_LE_OQ));
+            bits |= static_cast<uint64_t>(_mm256_movemask_pd(inRange)) << i;
+        }
+        mask[w] = bits;
+    }
+}
+
+__attribute__((target("avx2")))
+void equalUint8Avx2(const uint8_t* data, size_t words, uint8_t value, uint64_t* mask) {
+    const __m256i valueVec = _mm256_set1_epi8(static_cast<char>(value));
+    for (size_t w = 0; w < words; ++w) {
+        const uint8_t* block = data + w * ROWS_PER_WORD;
+        uint64_t bits = 0;
+        for (size_t i = 0; i < ROWS_PER_WORD; i += 32) {
+            __m256i values = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block + i));
+            unsigned lanes = static_cast<unsigned>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(values, valueVec)));
+            bits |= static_cast<uint64_t>(lanes) << i;
+        }
+        mask[w] = bits;
+    }
+}
+
+bool cpuHasAvx2() {
+    static const bool supported = __builtin_cpu_supports("avx2");
+    return supported;
+}
+
+#endif
+
+// Vector kernels cover whole 64-row words; the scalar kernel finishes the tail
+ColumnarCatalog::Bitmask lessInt32(const std::vector<int32_t>& column, int32_t bound) {
+    ColumnarCatalog::Bitmask mask(wordCount(column.size()), 0);
+    size_t fullWords = column.size() / ROWS_PER_WORD;
+#ifdef QB_X86_SIMD
+    if (cpuHasAvx2()) {
+        lessInt32Avx2(column.data(), fullWords, bound, mask.data());
+    } else {
+        lessInt32Sse2(column.data(), fullWords, bound, mask.data());
+    }
+#else
+    fullWords = 0;
+#endif
+    lessInt32Scalar(column.data(), fullWords * ROWS_PER_WORD, column.size(), bound, mask.data());
+    return mask;
+}
+
+ColumnarCatalog::Bitmask equalInt32(const std::vector<int32_t>& column, int32_t value) {
+    ColumnarCatalog::Bitmask mask(wordCount(column.size()), 0);
+    size_t fullWords = column.size() / ROWS_PER_WORD;
+#ifdef QB_X86_SIMD
+    if (cpuHasAvx2()) {
+        equalInt32Avx2(column.data(), fullWords, value, mask.data());
+    } else {
+        equalInt32Sse2(column.data(), fullWords, value, mask.data());
+    }
+#else
+    fullWords = 0;
+#endif
+    equalInt32Scalar(column.data(), fullWords * ROWS_PER_WORD, column.size(), value, mask.data());
+    return mask;
+}
+
+ColumnarCatalog::Bitmask inRangeDouble(const std::vector<double>& column, double low, double high) {
+    ColumnarCatalog::Bitmask mask(wordCount(column.size()), 0);
+    size_t fullWords = column.size() / ROWS_PER_WORD;
+#ifdef QB_X86_SIMD
+    if (cpuHasAvx2()) {
+        inRangeDoubleAvx2(column.data(), fullWords, low, high, mask.data());
+    } else {
+        inRangeDoubleSse2(column.data(), fullWords, low, high, mask.data());
+    }
+#else
+    fullWords = 0;
+#endif
+    inRangeDoubleScalar(column.data(), fullWords * ROWS_PER_WORD, column.size(), low, high, mask.data());
+    return mask;
+}
+
+ColumnarCatalog::Bitmask equalUint8(const std::vector<uint8_t>& column, uint8_t value) {
+    ColumnarCatalog::Bitmask mask(wordCount(column.size()), 0);
+    size_t fullWords = column.size() / ROWS_PER_WORD;
+#ifdef QB_X86_SIMD
+    if (cpuHasAvx2()) {
+        equalUint8Avx2(column.data(), fullWords, value, mask.data());
+    } else {
+        equalUint8Sse2(column.data(), fullWords, value, mask.data());
+    }
+#else
+    fullWords = 0;
+#endif
+    equalUint8Scalar(column.data(), fullWords * ROWS_PER_WORD, column.size(), value, mask.data());
+    return mask;
+}
+
+int32_t stockOf(const Book& book) {
+    const PaperBook* paperBook = asPaperBook(&book);
+    return paperBook ? paperBook->getStock() : ColumnarCatalog::NO_STOCK;
+}
+
+} // namespace
+
+void ColumnarCatalog::append(Book& book) {
+    // Grow every column before writing any, so a failed allocation leaves
+    // them all as they were. books is reserved last: room in it means room
+    // in all of them.
+    if (books.size() == books.capacity()) {
+        reserve(std::max<size_t>(16, books.size() * 2));
+    }
+    years.push_back(book.getYearPublished());
+    prices.push_back(book.getPrice());
+    stocks.push_back(stockOf(book));
+    kinds.push_back(static_cast<uint8_t>(book.getKind()));
+    books.push_back(&book);
+}
+
+void ColumnarCatalog::clear() {
+    years.clear();
+    prices.clear();
+    stocks.clear();
+    kinds.clear();
+    books.clear();
+}
+
+void ColumnarCatalog::reserve(size_t rows) {
+    years.reserve(rows);
+    prices.reserve(rows);
+    stocks.reserve(rows);
+    kinds.reserve(rows);
+    books.reserve(rows);
+}
+
+size_t ColumnarCatalog::size() const {
+    return books.size();
+}
+
+Book* ColumnarCatalog::bookAt(size_t row) const {
+    return books[row];
+}
+
+void ColumnarCatalog::refreshStock() {
+    for (size_t row = 0; row < books.size(); ++row) {
+        if (kinds[row] == static_cast<uint8_t>(BookKind::Paper)) {
+            stocks[row] = stockOf(*books[row]);
+        }
+    }
+}
+
+ColumnarCatalog::Bitmask ColumnarCatalog::selectPublishedBefore(int year) const {
+    return lessInt32(years, year);
+}
+
+ColumnarCatalog::Bitmask ColumnarCatalog::selectPriceRange(double minPrice, double maxPrice) const {
+    return inRangeDouble(prices, minPrice, maxPrice);
+}
+
+ColumnarCatalog::Bitmask ColumnarCatalog::selectKind(BookKind kind) const {
+    return equalUint8(kinds, static_cast<uint8_t>(kind));
+}
+
+ColumnarCatalog::Bitmask ColumnarCatalog::selectOutOfStock() const {
+    // Rows without stock hold NO_STOCK, so only stock-tracking rows match zero
+    return equalInt32(stocks, 0);
+}
+
+ColumnarCatalog::Bitmask ColumnarCatalog::selectWhere(const std::function<bool(const Book&)>& predicate) const {
+    Bitmask mask(wordCount(books.size()), 0);
+    for (size_t row = 0; row < books.size(); ++row) {
+        if (predicate(*books[row])) {
+            mask[row / ROWS_PER_WORD] |= uint64_t{1} << (row % ROWS_PER_WORD);
+        }
+    }
+    return mask;
+}
+
+std::vector<Book*> ColumnarCatalog::compact(const Bitmask& selected) {
+    std::vector<Book*> removed;
+    size_t write = 0;
+    for (size_t w = 0; w < selected.size(); ++w) {
+        size_t begin = w * ROWS_PER_WORD;
+        size_t end = begin + ROWS_PER_WORD < books.size() ? begin + ROWS_PER_WORD : books.size();
+        // Whole words with nothing selected are moved without per-row tests
+        if (selected[w] == 0 && write == begin) {
+            write = end;
+            continue;
+        }
+        for (size_t row = begin; row < end; ++row) {
+            if (selected[w] & (uint64_t{1} << (row - begin))) {
+                removed.push_back(books[row]);
+                continue;
+            }
+            years[write] = years[row];
+            prices[write] = prices[row];
+            stocks[write] = stocks[row];
+            kinds[write] = kinds[row];
+            books[write] = books[row];
+            ++write;
+        }
+    }
+    years.resize(write);
+    prices.resize(write);
+    stocks.resize(write);
+    kinds.resize(write);
+    books.resize(write);
+    return removed;
+}
+
+Book* ColumnarCatalog::removeRow(size_t row) {
+    size_t last = books.size() - 1;
+    Book* moved = nullptr;
+    if (row != last) {
+        years[row] = years[last];
+        prices[row] = prices[last];
+        stocks[row] = stocks[last];
+        kinds[row] = kinds[last];
+        books[row] = books[last];
+        moved = books[row];
+    }
+    years.pop_back();
+    prices.pop_back();
+    stocks.pop_back();
+    kinds.pop_back();
+    books.pop_back();
+    return moved;
+}
+
+void ColumnarCatalog::intersect(Bitmask& target, const Bitmask& other) {
+    for (size_t w = 0; w < target.size(); ++w) {
+        target[w] &= (w < other.size()) ? other[w] : 0;
+    }
+}
+
+size_t ColumnarCatalog::countSelected(const Bitmask& mask) {
+    size_t count = 0;
+    for (uint64_t word : mask) {
+        count += static_cast<size_t>(__builtin_popcountll(word));
+    }
+    return count;
+}
+
+void ColumnarCatalog::forEachSelected(const Bitmask& mask, const std::function<void(size_t row)>& visitor) {
+    for (size_t w = 0; w < mask.size(); ++w) {
+        uint64_t word = mask[w];
+        while (word != 0) {
+            visitor(w * ROWS_PER_WORD + static_cast<size_t>(__builtin_ctzll(word)));
+            word &= word - 1;
+        }
+    }
+}
+
+const char* ColumnarCatalog::simdLevel() {
+#ifdef QB_X86_SIMD
+    return cpuHasAvx2() ? "avx2" : "sse2";
+#else
+    return "scalar";
+#endif
+}
@@ -0,0 +1,113 @@
+#include "../include/EpochReclaimer.h"
+#include <algorithm>
+
+namespace {
+
+std::atomic<uint64_t> nextReclaimerId{1};
+
+// Slots this thread owns, one per reclaimer; released when the thread exits
+struct ThreadSlots {
+    std::vector<std::pair<uint64_t, std::shared_ptr<void>>> entries;
+    std::vector<std::atomic<bool>*> ownedFlags;
+
+    ~ThreadSlots() {
+        for (auto* owned : ownedFlags) {
+            owned->store(false, std::memory_order_release);
+        }
+    }
+};
+
+thread_local ThreadSlots threadSlots;
+
+} // namespace
+
+EpochReclaimer::EpochReclaimer() : id(nextReclaimerId.fetch_add(1, std::memory_order_relaxed)) {}
+
+EpochReclaimer::~EpochReclaimer() = default;
+
+void EpochReclaimer::retire(std::shared_ptr<const void> object) {
+    bool collectNow;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        // Read after the unlink: a reader that still sees the object is
+        // pinned at this epoch or earlier
+        retired.emplace_back(globalEpoch.load(std::memory_order_seq_cst), std::move(object));
+        collectNow = ++retiredSinceCollect >= COLLECT_EVERY;
+    }
+    if (collectNow) {
+        collect();
+    }
+}
+
+size_t EpochReclaimer::collect() {
+    std::vector<std::shared_ptr<const void>> reclaimable;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        retiredSinceCollect = 0;
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        uint64_t epoch = globalEpoch.load(std::memory_order_relaxed);
+        bool everyoneCaughtUp = std::all_of(slots.begin(), slots.end(), [epoch](const auto& slot) {
+            uint64_t pinned = slot->epoch.load(std::memory_order_acquire);
+            return pinned == 0 || pinned == epoch;
+        });
+        if (everyoneCaughtUp) {
+            globalEpoch.store(++epoch, std::memory_order_seq_cst);
+        }
+        auto safe = std::stable_partition(retired.begin(), retired.end(), [epoch](const auto& entry) {
+            return entry.first + 2 > epoch;
+        });
+        for (auto it = safe; it != retired.end(); ++it) {
+            reclaimable.push_back(std::move(it->second));
+        }
+        retired.erase(safe, retired.end());
+    }
+    // Destructors run outside the lock
+    return reclaimable.size();
+}
+
+size_t EpochReclaimer::pendingCount() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return retired.size();
+}
+
+EpochReclaimer::Slot& EpochReclaimer::registerThread() {
+    for (auto& entry : threadSlots.entries) {
+        if (entry.first == id) {
+            cachedId = id;
+            cachedSlot = static_cast<Slot*>(entry.second.get());
+            return *cachedSlot;
+        }
+    }
+
+    // First pin from this thread: drop slots of destroyed reclaimers, then
+    // reuse the slot of an exited thread
+    auto& entries = threadSlots.entries;
+    auto& flags = threadSlots.ownedFlags;
+    for (size_t i = entries.size(); i-- > 0;) {
+        if (entries[i].second.use_count() == 1) {
+            auto* flag = &static_cast<Slot*>(entries[i].second.get())->owned;
+            flags.erase(std::remove(flags.begin(), flags.end(), flag), flags.end());
+            entries.erase(entries.begin() + static_cast<std::ptrdiff_t>(i));
+        }
+    }
+    std::shared_ptr<Slot> slot;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (auto& candidate : slots) {
+            if (!candidate->owned.load(std::memory_order_acquire)) {
+                candidate->owned.store(true, std::memory_order_relaxed);
+                slot = candidate;
+                break;
+            }
+        }
+        if (!slot) {
+            slot = std::make_shared<Slot>();
+            slots.push_back(slot);
+        }
+    }
+    entries.emplace_back(id, slot);
+    flags.push_back(&slot->owned);
+    cachedId = id;
+    cachedSlot = slot.get();
+    return *slot;
+}
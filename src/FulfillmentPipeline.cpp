@@ -0,0 +1,221 @@
+#include "../include/FulfillmentPipeline.h"
+#include "../include/Logger.h"
+#include "../include/Services.h"
+#include <algorithm>
+#include <stdexcept>
+
+namespace {
+
+size_t roundUpToPowerOfTwo(size_t value) {
+    size_t result = 1;
+    while (result < value) {
+        result <<= 1;
+    }
+    return result;
+}
+
+// Producers stick to one worker per thread so each ring keeps a single consumer
+size_t producerIndex(size_t workerCount) {
+    static std::atomic<size_t> nextProducer{0};
+    thread_local size_t index = nextProducer.fetch_add(1, std::memory_order_relaxed);
+    return index % workerCount;
+}
+
+} // namespace
+
+FulfillmentBackend FulfillmentBackend::defaultBackend() {
+    FulfillmentBackend backend;
+    backend.shipBatch = &ShippingService::shipBatch;
+    backend.sendEmailBatch = &MailService::sendEmailBatch;
+    return backend;
+}
+
+// Ring implementation
+FulfillmentPipeline::Ring::Ring(size_t capacity)
+    : cells(new Cell[roundUpToPowerOfTwo(capacity < 2 ? 2 : capacity)]),
+      mask(roundUpToPowerOfTwo(capacity < 2 ? 2 : capacity) - 1) {
+    for (size_t i = 0; i <= mask; ++i) {
+        cells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+}
+
+bool FulfillmentPipeline::Ring::tryPush(Entry& entry) {
+    size_t pos = enqueuePos.load(std::memory_order_relaxed);
+    for (;;) {
+        Cell& cell = cells[pos & mask];
+        size_t sequence = cell.sequence.load(std::memory_order_acquire);
+        intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+        if (diff == 0) {
+            if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                cell.entry = std::move(entry);
+                cell.sequence.store(pos + 1, std::memory_order_release);
+                return true;
+            }
+        } else if (diff < 0) {
+            return false;  // full
+        } else {
+            pos = enqueuePos.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+bool FulfillmentPipeline::Ring::tryPop(Entry& entry) {
+    Cell& cell = cells[dequeuePos & mask];
+    size_t sequence = cell.sequence.load(std::memory_order_acquire);
+    if (sequence != dequeuePos + 1) {
+        return false;  // empty
+    }
+    entry = std::move(cell.entry);
+    cell.sequence.store(dequeuePos + mask + 1, std::memory_order_release);
+    ++dequeuePos;
+    return true;
+}
+
+// FulfillmentPipeline implementation
+FulfillmentPipeline::Worker::Worker(size_t capacity) : ring(capacity) {}
+
+FulfillmentPipeline::FulfillmentPipeline(FulfillmentConfig config, FulfillmentBackend backend)
+    : config(std::move(config)), backend(std::move(backend)) {
+    if (this->config.workerCount == 0 || this->config.maxBatchSize == 0 || this->config.maxAttempts <= 0) {
+        throw std::invalid_argument("Fulfillment pipeline needs workers, a batch size and at least one attempt");
+    }
+    for (size_t i = 0; i < this->config.workerCount; ++i) {
+        workers.push_back(std::make_unique<Worker>(this->config.queueCapacity));
+    }
+    for (auto& worker : workers) {
+        Worker* target = worker.get();
+        worker->thread = std::thread([this, target]() { run(*target); });
+    }
+}
+
+FulfillmentPipeline::~FulfillmentPipeline() {
+    stopping.store(true, std::memory_order_release);
+    for (auto& worker : workers) {
+        {
+            std::lock_guard<std::mutex> lock(worker->mutex);
+        }
+        worker->wakeup.notify_one();
+        worker->thread.join();
+    }
+}
+
+std::future<FulfillmentStatus> FulfillmentPipeline::submit(FulfillmentJob job) {
+    Entry entry{std::move(job), std::promise<FulfillmentStatus>()};
+    std::future<FulfillmentStatus> result = entry.completion.get_future();
+    pending.fetch_add(1, std::memory_order_relaxed);
+    
+    Worker& worker = *workers[producerIndex(workers.size())];
+    while (!worker.ring.tryPush(entry)) {
+        std::this_thread::yield();  // ring is full: apply backpressure
+    }
+    if (worker.sleeping.load(std::memory_order_acquire)) {
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        worker.wakeup.notify_one();
+    }
+    return result;
+}
+
+void FulfillmentPipeline::waitUntilIdle() const {
+    while (pending.load(std::memory_order_acquire) != 0) {
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+    }
+}
+
+size_t FulfillmentPipeline::getPendingCount() const {
+    return pending.load(std::memory_order_acquire);
+}
+
+void FulfillmentPipeline::run(Worker& worker) {
+    std::vector<Entry> batch;
+    batch.reserve(config.maxBatchSize);
+    for (;;) {
+        Entry entry;
+        while (batch.size() < config.maxBatchSize && worker.ring.tryPop(entry)) {
+            batch.push_back(std::move(entry));
+        }
+        if (!batch.empty()) {
+            deliver(batch);
+            batch.clear();
+            continue;
+        }
+        if (stopping.load(std::memory_order_acquire)) {
+            return;
+        }
+        
+        // Idle: sleep until a producer notices and wakes us (or a short timeout)
+        std::unique_lock<std::mutex> lock(worker.mutex);
+        worker.sleeping.store(true, std::memory_order_release);
+        worker.wakeup.wait_for(lock, std::chrono::milliseconds(5));
+        worker.sleeping.store(false, std::memory_order_release);
+    }
+}
+
+void FulfillmentPipeline::deliver(std::vector<Entry>& batch) {
+    std::vector<size_t> shipments;
+    std::vector<size_t> emails;
+    for (size_t i = 0; i < batch.size(); ++i) {
+        (batch[i].job.channel == DeliveryChannel::Shipping ? shipments : emails).push_back(i);
+    }
+    
+    std::vector<bool> delivered(batch.size(), false);
+    callWithRetry(backend.shipBatch, batch, std::move(shipments), delivered);
+    callWithRetry(backend.sendEmailBatch, batch, std::move(emails), delivered);
+    
+    for (size_t i = 0; i < batch.size(); ++i) {
+        complete(batch[i], delivered[i] ? FulfillmentStatus::Delivered : FulfillmentStatus::Failed);
+    }
+}
+
+void FulfillmentPipeline::callWithRetry(const FulfillmentBackend::BatchCall& call, const std::vector<Entry>& batch,
+                                        std::vector<size_t> positions, std::vector<bool>& delivered) {
+    std::chrono::milliseconds backoff = config.initialBackoff;
+    std::vector<std::string> destinations;
+    for (int attempt = 1; !positions.empty(); ++attempt) {
+        destinations.clear();
+        for (size_t position : positions) {
+            destinations.push_back(batch[position].job.destination);
+        }
+        std::vector<bool> failed(destinations.size(), false);
+        try {
+            for (size_t index : call(destinations)) {
+                if (index < failed.size()) {
+                    failed[index] = true;
+                }
+            }
+        } catch (...) {
+            // A throw means nothing went through
+            std::fill(failed.begin(), failed.end(), true);
+        }
+        
+        // Retry only the destinations still undelivered
+        size_t remaining = 0;
+        for (size_t i = 0; i < positions.size(); ++i) {
+            if (failed[i]) {
+                positions[remaining++] = positions[i];
+            } else {
+                delivered[positions[i]] = true;
+            }
+        }
+        positions.resize(remaining);
+        if (positions.empty() || attempt == config.maxAttempts) {
+            return;
+        }
+        std::this_thread::sleep_for(backoff);
+        backoff *= 2;
+    }
+}
+
+void FulfillmentPipeline::complete(Entry& entry, FulfillmentStatus status) {
+    if (config.onComplete) {
+        // An escaping exception would end the worker thread, and the process
+        try {
+            config.onComplete(entry.job, status);
+        } catch (const std::exception& error) {
+            Logger::global().log<LogLevel::Error>("Fulfillment", "Completion callback failed: {}", error.what());
+        } catch (...) {
+            Logger::global().log<LogLevel::Error>("Fulfillment", "Completion callback failed");
+        }
+    }
+    entry.completion.set_value(status);
+    pending.fetch_sub(1, std::memory_order_acq_rel);
+}
@@ -0,0 +1,127 @@
+#include "../include/IsbnCodec.h"
+
+namespace {
+
+bool isSeparator(char c) {
+    return c == '-' || c == ' ';
+}
+
+// Collect the ISBN's digits ('X' as 10) into digits; returns the count, or
+// 0 if the text is not a well-formed ISBN-10/13
+size_t extractDigits(std::string_view isbn, int (&digits)[13]) {
+    size_t count = 0;
+    bool lastWasSeparator = true;  // no leading separator
+    for (size_t i = 0; i < isbn.size(); ++i) {
+        char c = isbn[i];
+        if (isSeparator(c)) {
+            if (lastWasSeparator) {
+                return 0;
+            }
+            lastWasSeparator = true;
+            continue;
+        }
+        lastWasSeparator = false;
+        if (count == 13) {
+            return 0;
+        }
+        if (c >= '0' && c <= '9') {
+            digits[count++] = c - '0';
+        } else if ((c == 'X' || c == 'x') && count == 9 && i + 1 == isbn.size()) {
+            // Check digit of an ISBN-10 only
+            digits[count++] = 10;
+        } else {
+            return 0;
+        }
+    }
+    if (lastWasSeparator || (count != 10 && count != 13)) {
+        return 0;
+    }
+    return count;
+}
+
+} // namespace
+
+uint64_t IsbnCodec::pack(std::string_view isbn) {
+    // Single pass without a digit buffer: lookups pack every query, and a
+    // short predictable loop lets the following table probe start early
+    uint64_t value = 0;
+    size_t count = 0;
+    bool lastWasSeparator = true;  // no leading separator
+    uint64_t checkX = 0;
+    for (size_t i = 0; i < isbn.size(); ++i) {
+        char c = isbn[i];
+        unsigned digit = static_cast<unsigned>(c - '0');
+        if (digit < 10) {
+            value = value * 10 + digit;
+            ++count;
+            lastWasSeparator = false;
+        } else if (isSeparator(c) && !lastWasSeparator) {
+            lastWasSeparator = true;
+        } else if ((c == 'X' || c == 'x') && count == 9 && i + 1 == isbn.size()) {
+            checkX = 10;
+            ++count;
+            lastWasSeparator = false;
+        } else {
+            return INVALID_KEY;
+        }
+    }
+    if (lastWasSeparator) {
+        return INVALID_KEY;
+    }
+    if (count == 13) {
+        return ISBN13_TAG | value;
+    }
+    if (count == 10) {
+        // value holds all ten digits, or the first nine when the check is X
+        uint64_t leading = checkX ? value : value / 10;
+        uint64_t check = checkX ? checkX : value % 10;
+        return ISBN10_TAG | (leading * 11 + check);
+    }
+    return INVALID_KEY;
+}
+
+std::string IsbnCodec::unpack(uint64_t key) {
+    if (key & ISBN13_TAG) {
+        std::string isbn(13, '0');
+        uint64_t value = key & ~ISBN13_TAG;
+        for (size_t i = 13; i-- > 0; value /= 10) {
+            isbn[i] = static_cast<char>('0' + value % 10);
+        }
+        return isbn;
+    }
+    if (key & ISBN10_TAG) {
+        std::string isbn(10, '0');
+        uint64_t value = key & ~ISBN10_TAG;
+        uint64_t check = value % 11;
+        isbn[9] = check == 10 ? 'X' : static_cast<char>('0' + check);
+        value /= 11;
+        for (size_t i = 9; i-- > 0; value /= 10) {
+            isbn[i] = static_cast<char>('0' + value % 10);
+        }
+        return isbn;
+    }
+    return {};
+}
+
+bool IsbnCodec::isValid(std::string_view isbn) {
+    return pack(isbn) != INVALID_KEY;
+}
+
+bool IsbnCodec::hasValidChecksum(std::string_view isbn) {
+    int digits[13];
+    size_t count = extractDigits(isbn, digits);
+    int sum = 0;
+    if (count == 13) {
+        for (size_t i = 0; i < 13; ++i) {
+            sum += digits[i] * (i % 2 == 0 ? 1 : 3);
+        }
+        return sum % 10 == 0;
+    }
+    if (count == 10) {
+        for (size_t i = 0; i < 10; ++i) {
+            sum += digits[i] * static_cast<int>(10 - i);
+        }
+        return sum % 11 == 0;
+    }
+    return false;
+}
@@ -0,0 +1,373 @@
+#include "../include/LoadGenerator.h"
+#include "../include/QuantumBookstore.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr const char* TRACE_MAGIC = "# quantum-bookstore load trace v1";
+constexpr int CATALOG_YEARS = 75;
+constexpr uint64_t LATE_NANOS = 1000000;
+
+// SplitMix64 finalizer: a fixed, well-mixed hash of the book index
+uint64_t mix64(uint64_t value) {
+    value += 0x9E3779B97F4A7C15ull;
+    value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ull;
+    value = (value ^ (value >> 27)) * 0x94D049BB133111EBull;
+    return value ^ (value >> 31);
+}
+
+double zeta(size_t items, double theta) {
+    double sum = 0.0;
+    for (size_t i = 1; i <= items; ++i) {
+        sum += 1.0 / std::pow(static_cast<double>(i), theta);
+    }
+    return sum;
+}
+
+LoadOpType parseType(const std::string& name) {
+    for (size_t type = 0; type < LOAD_OP_TYPE_COUNT; ++type) {
+        if (loadOpTypeName(static_cast<LoadOpType>(type)) == name) {
+            return static_cast<LoadOpType>(type);
+        }
+    }
+    throw std::runtime_error("Unknown load operation '" + name + "'");
+}
+
+// Sleep most of the way to the deadline, then yield until it passes, so
+// open-loop starts are not late by a scheduler tick
+void waitUntil(Clock::time_point deadline) {
+    auto early = deadline - std::chrono::microseconds(50);
+    if (Clock::now() < early) {
+        std::this_thread::sleep_until(early);
+    }
+    while (Clock::now() < deadline) {
+        std::this_thread::yield();
+    }
+}
+
+void execute(QuantumBookstore& store, const LoadOp& op, const LoadConfig& config) {
+    std::string isbn = LoadGenerator::isbnFor(op.book);
+    switch (op.type) {
+        case LoadOpType::BuyBook:
+            store.buyBook(isbn, op.arg, "load@example.com", "1 Load Street");
+            break;
+        case LoadOpType::FindBook: {
+            // The pointer may dangle once a sweep runs, so only test it
+            Book* volatile found = store.findBook(isbn);
+            (void)found;
+            break;
+        }
+        case LoadOpType::AddBook:
+            store.addPaperBook(isbn, "Load Title " + std::to_string(op.book), op.arg,
+                               10.0 + op.book % 40, "Load Author " + std::to_string(op.book % 5000),
+                               config.initialStock);
+            break;
+        case LoadOpType::RemoveOutdated:
+            store.removeOutdated(config.currentYear, op.arg);
+            break;
+        case LoadOpType::Count:
+            break;
+    }
+}
+
+void mergeStats(LoadOpStats& target, const LoadOpStats& source) {
+    target.completed += source.completed;
+    target.rejected += source.rejected;
+    target.response.merge(source.response);
+    target.service.merge(source.service);
+}
+
+} // namespace
+
+ZipfianGenerator::ZipfianGenerator(size_t items, double theta) : items(items), theta(theta) {
+    if (items == 0) {
+        throw std::invalid_argument("Zipfian generator needs at least one item");
+    }
+    if (!(theta >= 0.0 && theta < 1.0)) {
+        throw std::invalid_argument("Zipfian theta must be in [0, 1)");
+    }
+    zetaN = zeta(items, theta);
+    alpha = 1.0 / (1.0 - theta);
+    double zeta2 = zeta(std::min<size_t>(items, 2), theta);
+    eta = items > 2 ? (1.0 - std::pow(2.0 / static_cast<double>(items), 1.0 - theta)) / (1.0 - zeta2 / zetaN) : 0.0;
+}
+
+size_t ZipfianGenerator::rankFor(double u) const {
+    double uz = u * zetaN;
+    if (items == 1 || uz < 1.0) {
+        return 0;
+    }
+    if (items == 2 || uz < 1.0 + std::pow(0.5, theta)) {
+        return 1;
+    }
+    double rank = static_cast<double>(items) * std::pow(eta * u - eta + 1.0, alpha);
+    return std::min(items - 1, static_cast<size_t>(rank));
+}
+
+std::string_view loadOpTypeName(LoadOpType type) {
+    switch (type) {
+        case LoadOpType::BuyBook: return "buy";
+        case LoadOpType::FindBook: return "find";
+        case LoadOpType::AddBook: return "add";
+        case LoadOpType::RemoveOutdated: return "sweep";
+        case LoadOpType::Count: break;
+    }
+    return {};
+}
+
+uint64_t LoadReport::totalCompleted() const {
+    uint64_t total = 0;
+    for (const LoadOpStats& stats : byType) {
+        total += stats.completed;
+    }
+    return total;
+}
+
+std::string LoadGenerator::isbnFor(uint32_t book) {
+    return "978" + std::to_string(1000000000ull + book);
+}
+
+BookKind LoadGenerator::kindOf(uint32_t book, const LoadConfig& config) {
+    if (book >= config.catalogSize) {
+        return BookKind::Paper;
+    }
+    double fraction = static_cast<double>(mix64(book) >> 11) * 0x1.0p-53;
+    if (fraction < config.paperShare) {
+        return BookKind::Paper;
+    }
+    if (fraction < config.paperShare + config.ebookShare) {
+        return BookKind::EBook;
+    }
+    return BookKind::Showcase;
+}
+
+LoadTrace LoadGenerator::generate(const LoadConfig& config) {
+    if (config.catalogSize == 0 || config.clients == 0) {
+        throw std::invalid_argument("Load runs need a catalog and at least one client");
+    }
+    // Books of each kind; lower positions are more popular
+    std::vector<uint32_t> byKind[3];
+    for (uint32_t book = 0; book < config.catalogSize; ++book) {
+        byKind[static_cast<size_t>(kindOf(book, config))].push_back(book);
+    }
+    std::vector<ZipfianGenerator> popularity;
+    for (const auto& books : byKind) {
+        popularity.emplace_back(std::max<size_t>(books.size(), 1), config.zipfTheta);
+    }
+    ZipfianGenerator anyBook(config.catalogSize, config.zipfTheta);
+
+    const LoadMix& mix = config.mix;
+    std::discrete_distribution<int> pick({mix.buyPaper, mix.buyEBook, mix.buyShowcase,
+                                          mix.find, mix.add, mix.sweep});
+    std::mt19937_64 random(config.seed);
+
+    LoadTrace trace;
+    trace.config = config;
+    trace.ops.reserve(config.operations);
+    uint32_t nextNewBook = static_cast<uint32_t>(config.catalogSize);
+    for (size_t i = 0; i < config.operations; ++i) {
+        LoadOp op{};
+        op.client = static_cast<uint32_t>(i % config.clients);
+        if (config.ratePerSecond > 0) {
+            op.intendedNanos = static_cast<uint64_t>(static_cast<double>(i) * 1e9 / config.ratePerSecond);
+        }
+        int choice = pick(random);
+        if (choice < 3) {
+            // Purchases of a kind the catalog lacks fall back to any book
+            const auto& books = byKind[choice];
+            op.type = LoadOpType::BuyBook;
+            op.book = books.empty() ? static_cast<uint32_t>(anyBook.next(random))
+                                    : books[popularity[choice].next(random)];
+            op.arg = random() % 10 == 0 ? 2 : 1;
+        } else if (choice == 3) {
+            op.type = LoadOpType::FindBook;
+            op.book = static_cast<uint32_t>(anyBook.next(random));
+        } else if (choice == 4) {
+            op.type = LoadOpType::AddBook;
+            op.book = nextNewBook++;
+            op.arg = config.currentYear - 1 - static_cast<int>(random() % CATALOG_YEARS);
+        } else {
+            op.type = LoadOpType::RemoveOutdated;
+            op.arg = config.sweepAge;
+        }
+        trace.ops.push_back(op);
+    }
+    return trace;
+}
+
+void LoadGenerator::buildCatalog(QuantumBookstore& store, const LoadConfig& config) {
+    for (uint32_t book = 0; book < config.catalogSize; ++book) {
+        std::string isbn = isbnFor(book);
+        std::string title = "Catalog Title " + std::to_string(book);
+        std::string author = "Catalog Author " + std::to_string(book % 5000);
+        int year = config.currentYear - 1 - static_cast<int>(mix64(book ^ 0x5EED) % CATALOG_YEARS);
+        double price = 5.0 + book % 50;
+        switch (kindOf(book, config)) {
+            case BookKind::Paper:
+                store.addPaperBook(isbn, title, year, price, author, config.initialStock);
+                break;
+            case BookKind::EBook:
+                store.addEBook(isbn, title, year, price, author, book % 2 ? "EPUB" : "PDF");
+                break;
+            default:
+                store.addShowcaseBook(isbn, title, year, 0.0, author);
+                break;
+        }
+    }
+}
+
+LoadReport LoadGenerator::run(QuantumBookstore& store, const LoadTrace& trace) {
+    const LoadConfig& config = trace.config;
+    size_t clients = config.clients;
+    for (const LoadOp& op : trace.ops) {
+        clients = std::max<size_t>(clients, op.client + 1);
+    }
+    std::vector<std::vector<const LoadOp*>> perClient(clients);
+    for (const LoadOp& op : trace.ops) {
+        perClient[op.client].push_back(&op);
+    }
+
+    bool openLoop = config.ratePerSecond > 0;
+    std::vector<LoadReport> reports(clients);
+    // A common start a little ahead, so every client begins on schedule
+    Clock::time_point start = Clock::now() + std::chrono::milliseconds(10);
+    std::vector<std::thread> threads;
+    for (size_t client = 0; client < clients; ++client) {
+        threads.emplace_back([&, client]() {
+            LoadReport& report = reports[client];
+            waitUntil(start);
+            for (const LoadOp* op : perClient[client]) {
+                Clock::time_point intended = start + std::chrono::nanoseconds(op->intendedNanos);
+                if (openLoop) {
+                    waitUntil(intended);
+                }
+                Clock::time_point begin = Clock::now();
+                bool rejected = false;
+                try {
+                    execute(store, *op, config);
+                } catch (const std::exception&) {
+                    rejected = true;
+                }
+                Clock::time_point end = Clock::now();
+
+                LoadOpStats& stats = report.byType[static_cast<size_t>(op->type)];
+                ++stats.completed;
+                stats.rejected += rejected;
+                auto nanos = [](Clock::duration elapsed) {
+                    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+                };
+                stats.service.record(nanos(end - begin));
+                stats.response.record(nanos(end - (openLoop ? intended : begin)));
+                if (openLoop && begin - intended > std::chrono::nanoseconds(LATE_NANOS)) {
+                    ++report.lateOps;
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    LoadReport total;
+    total.elapsedSeconds = std::chrono::duration<double>(Clock::now() - start).count();
+    for (const LoadReport& report : reports) {
+        total.lateOps += report.lateOps;
+        for (size_t type = 0; type < LOAD_OP_TYPE_COUNT; ++type) {
+            mergeStats(total.byType[type], report.byType[type]);
+        }
+    }
+    return total;
+}
+
+void LoadGenerator::writeTrace(const std::string& path, const LoadTrace& trace) {
+    std::ofstream out(path);
+    if (!out) {
+        throw std::runtime_error("Cannot write trace " + path);
+    }
+    const LoadConfig& config = trace.config;
+    out << TRACE_MAGIC << "\n" << std::setprecision(17)
+        << "catalog=" << config.catalogSize << " paper=" << config.paperShare
+        << " ebook=" << config.ebookShare << " stock=" << config.initialStock
+        << " theta=" << config.zipfTheta << " clients=" << config.clients
+        << " operations=" << trace.ops.size() << " rate=" << config.ratePerSecond
+        << " seed=" << config.seed << " year=" << config.currentYear << "\n";
+    for (const LoadOp& op : trace.ops) {
+        out << op.intendedNanos << ' ' << op.client << ' ' << loadOpTypeName(op.type) << ' '
+            << op.book << ' ' << op.arg << '\n';
+    }
+    if (!out.flush()) {
+        throw std::runtime_error("Cannot write trace " + path);
+    }
+}
+
+LoadTrace LoadGenerator::readTrace(const std::string& path) {
+    std::ifstream in(path);
+    if (!in) {
+        throw std::runtime_error("Cannot read trace " + path);
+    }
+    std::string line;
+    if (!std::getline(in, line) || line != TRACE_MAGIC || !std::getline(in, line)) {
+        throw std::runtime_error(path + " is not a load trace");
+    }
+    std::map<std::string, std::string> settings;
+    std::istringstream header(line);
+    for (std::string item; header >> item;) {
+        size_t equals = item.find('=');
+        if (equals != std::string::npos) {
+            settings[item.substr(0, equals)] = item.substr(equals + 1);
+        }
+    }
+    auto setting = [&](const char* key) -> const std::string& {
+        auto it = settings.find(key);
+        if (it == settings.end()) {
+            throw std::runtime_error(path + ": trace header lacks " + key);
+        }
+        return it->second;
+    };
+
+    LoadTrace trace;
+    LoadConfig& config = trace.config;
+    try {
+        config.catalogSize = std::stoull(setting("catalog"));
+        config.paperShare = std::stod(setting("paper"));
+        config.ebookShare = std::stod(setting("ebook"));
+        config.initialStock = std::stoi(setting("stock"));
+        config.zipfTheta = std::stod(setting("theta"));
+        config.clients = std::stoull(setting("clients"));
+        config.operations = std::stoull(setting("operations"));
+        config.ratePerSecond = std::stod(setting("rate"));
+        config.seed = std::stoull(setting("seed"));
+        config.currentYear = std::stoi(setting("year"));
+    } catch (const std::logic_error&) {
+        throw std::runtime_error(path + ": malformed trace header");
+    }
+
+    trace.ops.reserve(config.operations);
+    size_t lineNumber = 2;
+    while (std::getline(in, line)) {
+        ++lineNumber;
+        if (line.empty()) {
+            continue;
+        }
+        std::istringstream fields(line);
+        LoadOp op{};
+        std::string type;
+        if (!(fields >> op.intendedNanos >> op.client >> type >> op.book >> op.arg)) {
+            throw std::runtime_error(path + ":" + std::to_string(lineNumber) + ": malformed operation");
+        }
+        op.type = parseType(type);
+        trace.ops.push_back(op);
+    }
+    return trace;
+}
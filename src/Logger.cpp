@@ -0,0 +1,299 @@
+#include "../include/Logger.h"
+#include <charconv>
+#include <cfloat>
+
+namespace {
+
+std::atomic<uint64_t> nextLoggerId{1};
+
+// Numbers take 8 bytes and a string at most a pointer, so no argument is dropped
+static_assert(Logger::MAX_ARGS * 8 <= Logger::PAYLOAD_SIZE && sizeof(std::string*) <= 8,
+              "record payload must hold MAX_ARGS arguments");
+
+// Rings this thread owns, one per logger; released when the thread exits
+struct ThreadRings {
+    std::vector<std::pair<uint64_t, std::shared_ptr<void>>> entries;
+    std::vector<std::atomic<bool>*> ownedFlags;
+    
+    ~ThreadRings() {
+        for (auto* owned : ownedFlags) {
+            owned->store(false, std::memory_order_release);
+        }
+    }
+};
+
+thread_local ThreadRings threadRings;
+
+} // namespace
+
+Logger& Logger::global() {
+    static Logger logger;
+    return logger;
+}
+
+Logger::Logger() : id(nextLoggerId.fetch_add(1, std::memory_order_relaxed)) {
+    writer = std::thread([this]() { run(); });
+}
+
+Logger::~Logger() {
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex);
+        stopping.store(true, std::memory_order_release);
+    }
+    wakeup.notify_one();
+    writer.join();
+}
+
+void Logger::setLevel(LogLevel newLevel) {
+    level.store(newLevel, std::memory_order_relaxed);
+}
+
+LogLevel Logger::getLevel() const {
+    return level.load(std::memory_order_relaxed);
+}
+
+void Logger::setOutput(std::FILE* newOutput) {
+    flush();
+    std::lock_guard<std::mutex> lock(outputMutex);
+    output = newOutput;
+}
+
+void Logger::flush() {
+    std::unique_lock<std::mutex> lock(wakeMutex);
+    // Two full passes guarantee one started after every record logged so far
+    uint64_t target = completedPasses.load(std::memory_order_acquire) + 2;
+    wakeup.notify_one();
+    passDone.wait(lock, [this, target]() {
+        return !writerRunning || completedPasses.load(std::memory_order_acquire) >= target;
+    });
+}
+
+Logger::Ring& Logger::localRing() {
+    for (auto& entry : threadRings.entries) {
+        if (entry.first == id) {
+            return *static_cast<Ring*>(entry.second.get());
+        }
+    }
+    
+    // First message from this thread: reuse a drained ring of an exited thread
+    std::shared_ptr<Ring> ring;
+    {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        for (auto& candidate : rings) {
+            if (!candidate->owned.load(std::memory_order_acquire) && 
+                candidate->tail.load(std::memory_order_acquire) == candidate->head.load(std::memory_order_acquire)) {
+                candidate->owned.store(true, std::memory_order_release);
+                ring = candidate;
+                break;
+            }
+        }
+        if (!ring) {
+            ring = std::make_shared<Ring>();
+            rings.push_back(ring);
+        }
+    }
+    threadRings.entries.emplace_back(id, ring);
+    threadRings.ownedFlags.push_back(&ring->owned);
+    return *ring;
+}
+
+Logger::Record& Logger::beginRecord(Ring& ring) {
+    size_t head = ring.head.load(std::memory_order_relaxed);
+    while (head - ring.tail.load(std::memory_order_acquire) == RING_CAPACITY) {
+        // Ring full: wake the writer and wait for it to catch up
+        wakeup.notify_one();
+        std::this_thread::yield();
+    }
+    return ring.records[head % RING_CAPACITY];
+}
+
+void Logger::commitRecord(Ring& ring) {
+    ring.head.store(ring.head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+void Logger::run() {
+    for (;;) {
+        bool wrote = drainOnce();
+        {
+            std::lock_guard<std::mutex> lock(wakeMutex);
+            completedPasses.fetch_add(1, std::memory_order_acq_rel);
+        }
+        passDone.notify_all();
+        
+        std::unique_lock<std::mutex> lock(wakeMutex);
+        if (stopping.load(std::memory_order_acquire)) {
+            lock.unlock();
+            drainOnce();
+            // Nothing logged from here on is written; release any flush
+            lock.lock();
+            writerRunning = false;
+            lock.unlock();
+            passDone.notify_all();
+            return;
+        }
+        if (!wrote) {
+            wakeup.wait_for(lock, std::chrono::milliseconds(2));
+        }
+    }
+}
+
+bool Logger::drainOnce() {
+    std::vector<std::shared_ptr<Ring>> snapshot;
+    {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        snapshot = rings;
+    }
+    
+    for (auto& ring : snapshot) {
+        size_t tail = ring->tail.load(std::memory_order_relaxed);
+        size_t head = ring->head.load(std::memory_order_acquire);
+        for (size_t i = tail; i != head; ++i) {
+            format(ring->records[i % RING_CAPACITY]);
+        }
+        ring->tail.store(head, std::memory_order_release);
+    }
+    
+    if (buffer.empty()) {
+        return false;
+    }
+    {
+        std::lock_guard<std::mutex> lock(outputMutex);
+        std::fwrite(buffer.data(), 1, buffer.size(), output);
+        std::fflush(output);
+    }
+    buffer.clear();
+    return true;
+}
+
+void Logger::format(const Record& record) {
+    if (record.channel) {
+        buffer.append(record.channel);
+        buffer.append(": ");
+    }
+    
+    size_t offset = 0;
+    uint8_t arg = 0;
+    for (const char* p = record.pattern; *p; ++p) {
+        if (p[0] != '{' || p[1] != '}') {
+            buffer.push_back(*p);
+            continue;
+        }
+        ++p;
+        if (arg == record.argCount) {
+            continue;
+        }
+        char digits[32];
+        switch (record.argTypes[arg++]) {
+            case ArgType::Int: {
+                long long value;
+                std::memcpy(&value, record.payload + offset, sizeof(value));
+                offset += sizeof(value);
+                buffer.append(digits, std::to_chars(digits, digits + sizeof(digits), value).ptr);
+                break;
+            }
+            case ArgType::UInt: {
+                unsigned long long value;
+                std::memcpy(&value, record.payload + offset, sizeof(value));
+                offset += sizeof(value);
+                buffer.append(digits, std::to_chars(digits, digits + sizeof(digits), value).ptr);
+                break;
+            }
+            case ArgType::Double: {
+                double value;
+                std::memcpy(&value, record.payload + offset, sizeof(value));
+                offset += sizeof(value);
+                // Fixed notation, so prices never print as 1.23457e+06;
+                // trailing zeros are dropped
+                char number[DBL_MAX_10_EXP + 16];
+                int length = std::snprintf(number, sizeof(number), "%.6f", value);
+                if (std::memchr(number, '.', static_cast<size_t>(length))) {
+                    while (number[length - 1] == '0') {
+                        --length;
+                    }
+                    if (number[length - 1] == '.') {
+                        --length;
+                    }
+                }
+                buffer.append(number, static_cast<size_t>(length));
+                break;
+            }
+            case ArgType::String: {
+                uint16_t length;
+                std::memcpy(&length, record.payload + offset, sizeof(length));
+                offset += sizeof(length);
+                buffer.append(record.payload + offset, length);
+                offset += length;
+                break;
+            }
+            case ArgType::HeapString: {
+                std::string* value;
+                std::memcpy(&value, record.payload + offset, sizeof(value));
+                offset += sizeof(value);
+                buffer.append(*value);
+                delete value;
+                break;
+            }
+        }
+    }
+    buffer.push_back('\n');
+    
+    // Free the heap strings of arguments no placeholder consumed
+    for (; arg < record.argCount; ++arg) {
+        if (record.argTypes[arg] == ArgType::String) {
+            uint16_t length;
+            std::memcpy(&length, record.payload + offset, sizeof(length));
+            offset += sizeof(length) + length;
+        } else if (record.argTypes[arg] == ArgType::HeapString) {
+            std::string* value;
+            std::memcpy(&value, record.payload + offset, sizeof(value));
+            offset += sizeof(value);
+            delete value;
+        } else {
+            offset += 8;  // every number is stored in 8 bytes
+        }
+    }
+}
+
+void Logger::encode(Record& record, long long value) {
+    if (record.payloadSize + sizeof(value) > PAYLOAD_SIZE) {
+        return;
+    }
+    std::memcpy(record.payload + record.payloadSize, &value, sizeof(value));
+    record.payloadSize += sizeof(value);
+    record.argTypes[record.argCount++] = ArgType::Int;
+}
+
+void Logger::encode(Record& record, unsigned long long value) {
+    if (record.payloadSize + sizeof(value) > PAYLOAD_SIZE) {
+        return;
+    }
+    std::memcpy(record.payload + record.payloadSize, &value, sizeof(value));
+    record.payloadSize += sizeof(value);
+    record.argTypes[record.argCount++] = ArgType::UInt;
+}
+
+void Logger::encode(Record& record, double value) {
+    if (record.payloadSize + sizeof(value) > PAYLOAD_SIZE) {
+        return;
+    }
+    std::memcpy(record.payload + record.payloadSize, &value, sizeof(value));
+    record.payloadSize += sizeof(value);
+    record.argTypes[record.argCount++] = ArgType::Double;
+}
+
+void Logger::encode(Record& record, std::string_view value) {
+    // Strings are copied inline when they fit in the space left in the
+    // record and to the heap otherwise; MAX_ARGS pointers always fit
+    if (record.payloadSize + sizeof(uint16_t) + value.size() <= PAYLOAD_SIZE) {
+        uint16_t length = static_cast<uint16_t>(value.size());
+        std::memcpy(record.payload + record.payloadSize, &length, sizeof(length));
+        std::memcpy(record.payload + record.payloadSize + sizeof(length), value.data(), length);
+        record.payloadSize += static_cast<uint16_t>(sizeof(length) + length);
+        record.argTypes[record.argCount++] = ArgType::String;
+        return;
+    }
+    std::string* copy = new std::string(value);
+    std::memcpy(record.payload + record.payloadSize, &copy, sizeof(copy));
+    record.payloadSize += sizeof(copy);
+    record.argTypes[record.argCount++] = ArgType::HeapString;
+}
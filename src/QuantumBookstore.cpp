@@ -1,117 +1,1110 @@
 #include "../include/QuantumBookstore.h"
+#include "../include/Services.h"
 #include <stdexcept>
+#include <cstdint>
+#include <ctime>
 #include <algorithm>
-#include <iostream>
 
-void QuantumBookstore::addBook(std::unique_ptr<Book> book) {
+namespace {
+
+// Merge the shards' entries, each sorted by key, into one sorted list
+void mergeShards(const std::vector<ShardedInventory::ShardEntries>& shards, CatalogVersion::Entries& merged) {
+    using Cursor = std::pair<CatalogVersion::Entries::const_iterator, CatalogVersion::Entries::const_iterator>;
+    std::vector<Cursor> heap;
+    size_t total = 0;
+    for (const auto& shard : shards) {
+        total += shard.entries->size();
+        if (!shard.entries->empty()) {
+            heap.emplace_back(shard.entries->begin(), shard.entries->end());
+        }
+    }
+    merged.reserve(total);
+    auto later = [](const Cursor& a, const Cursor& b) { return a.first->first > b.first->first; };
+    std::make_heap(heap.begin(), heap.end(), later);
+    while (!heap.empty()) {
+        std::pop_heap(heap.begin(), heap.end(), later);
+        Cursor& next = heap.back();
+        merged.push_back(*next.first);
+        if (++next.first == next.second) {
+            heap.pop_back();
+        } else {
+            std::push_heap(heap.begin(), heap.end(), later);
+        }
+    }
+}
+
+} // namespace
+
+QuantumBookstore::QuantumBookstore(size_t shardCount)
+    : inventory(shardCount) {}
+
+QuantumBookstore::~QuantumBookstore() {
+    stopBackgroundExpiry();
+    // Failed deliveries still compensate through the log, so drain them first
+    std::atomic_store(&fulfillment, std::shared_ptr<FulfillmentPipeline>());
+    if (indexBuilder.joinable()) {
+        indexBuilder.join();
+    }
+    delete publishedCatalog.load(std::memory_order_acquire);
+}
+
+void QuantumBookstore::addBook(BookPtr book) {
+    tryAddBook(std::move(book)).value();
+}
+
+StoreResult<void> QuantumBookstore::tryAddBook(BookPtr book) {
+    auto timer = metrics.time(StoreOp::AddBook);
     if (!book) {
-        throw std::invalid_argument("Cannot add null book to inventory");
+        metrics.countFailure(StoreFailure::NullBook);
+        return StoreError{StoreFailure::NullBook, {}};
     }
     
-    std::string isbn = book->getISBN();
-    if (inventory.find(isbn) != inventory.end()) {
-        throw std::invalid_argument("Book with ISBN " + isbn + " already exists in inventory");
+    // The indexes lock for themselves, so a book added while a loaded
+    // snapshot is still being indexed need not wait for the build
+    std::string isbn(book->getISBN());
+    if (IsbnCodec::pack(isbn) == IsbnCodec::INVALID_KEY) {
+        metrics.countFailure(StoreFailure::InvalidIsbn);
+        return StoreError{StoreFailure::InvalidIsbn, std::move(isbn)};
+    }
+    Book* added = book.get();
+    // Logged under the shard lock, so no sale of the book can be logged first
+    uint64_t lsn = 0;
+    bool inserted = inventory.insert(std::move(book), [this, &lsn](const Book& inserting) {
+        if (wal) {
+            lsn = wal->appendAddBook(inserting);
+        }
+        if (changeFeed) {
+            changeFeed->publishAddBook(inserting);
+        }
+    });
+    if (!inserted) {
+        metrics.countFailure(StoreFailure::DuplicateIsbn);
+        return StoreError{StoreFailure::DuplicateIsbn, std::move(isbn)};
     }
     
-    inventory[isbn] = std::move(book);
-    printMessage("Added book with ISBN: " + isbn);
+    indexBooks({added});
+    if (lsn) {
+        wal->waitDurable(lsn);
+    }
+    
+    Logger::global().log<LogLevel::Info>(PRINT_PREFIX, "Added book with ISBN: {}", isbn);
+    return {};
+}
+
+void QuantumBookstore::addPaperBook(std::string_view isbn, std::string_view title, int year, 
+                                    double price, std::string_view author, int stock) {
+    addBook(arena.makePaperBook(isbn, title, year, price, author, stock));
+}
+
+void QuantumBookstore::addEBook(std::string_view isbn, std::string_view title, int year, 
+                                double price, std::string_view author, std::string_view fileType) {
+    addBook(arena.makeEBook(isbn, title, year, price, author, fileType));
+}
+
+void QuantumBookstore::addShowcaseBook(std::string_view isbn, std::string_view title, int year, 
+                                       double price, std::string_view author) {
+    addBook(arena.makeShowcaseBook(isbn, title, year, price, author));
+}
+
+void QuantumBookstore::saveSnapshot(const std::string& path) const {
+    auto timer = metrics.time(StoreOp::SaveSnapshot);
+    writeSnapshot(path);
 }
 
-std::vector<std::unique_ptr<Book>> QuantumBookstore::removeOutdated(int currentYear, int yearsThreshold) {
-    std::vector<std::unique_ptr<Book>> outdatedBooks;
+uint64_t QuantumBookstore::writeSnapshot(const std::string& path) const {
+    // Books removed after the capture stay readable until they are written
+    auto pinned = epochs.pin();
+    uint64_t logPosition = 0;
+    uint64_t feedPosition = 0;
+    std::vector<const Book*> books;
+    std::vector<int> stocks;
+    books.reserve(inventory.size());
+    stocks.reserve(inventory.size());
+    // Every logged change is made under its shard's exclusive lock, so with
+    // all shards read-locked the books, their stock and both positions agree
+    inventory.forEachAtOnce([&](const Book& book) {
+        const PaperBook* paperBook = asPaperBook(&book);
+        books.push_back(&book);
+        stocks.push_back(paperBook ? paperBook->getStockOnHand() : 0);
+    }, [&]() {
+        logPosition = wal ? wal->lastLsn() : snapshotLogPosition;
+        feedPosition = changeFeed ? changeFeed->lastSequence() : snapshotFeedPosition;
+    });
+    CatalogSnapshot::write(path, books, logPosition, feedPosition, stocks);
+    Logger::global().log<LogLevel::Info>(PRINT_PREFIX, "Saved {} book(s) to snapshot {}", books.size(), path);
+    return logPosition;
+}
+
+void QuantumBookstore::loadSnapshot(const std::string& path) {
+    auto timer = metrics.time(StoreOp::LoadSnapshot);
+    if (wal) {
+        throw std::runtime_error("Snapshots must be loaded before the write-ahead log is opened");
+    }
+    if (changeFeed) {
+        throw std::runtime_error("Snapshots must be loaded before the change feed is opened");
+    }
+    std::shared_ptr<const CatalogSnapshot> snapshot = CatalogSnapshot::open(path);
+    awaitIndexes();
+    arena.retain(snapshot);
+    inventory.reserve(snapshot->size());
     
-    auto it = inventory.begin();
-    while (it != inventory.end()) {
-        if (it->second->isOutdated(currentYear, yearsThreshold)) {
-            printMessage("Removing outdated book: " + it->second->getTitle() + 
-                        " (ISBN: " + it->first + ")");
-            outdatedBooks.push_back(std::move(it->second));
-            it = inventory.erase(it);
-        } else {
-            ++it;
+    std::vector<Book*> loaded;
+    loaded.reserve(snapshot->size());
+    try {
+        for (size_t i = 0; i < snapshot->size(); ++i) {
+            const SnapshotRecord& record = snapshot->record(i);
+            BookText text = snapshot->textOf(record);
+            BookPtr book;
+            switch (static_cast<BookKind>(record.kind)) {
+                case BookKind::Paper:
+                    book = arena.makePaperBook(text, record.year, record.price, record.stock);
+                    break;
+                case BookKind::EBook:
+                    book = arena.makeEBook(text, record.year, record.price, snapshot->fileTypeOf(record));
+                    break;
+                default:
+                    book = arena.makeShowcaseBook(text, record.year, record.price);
+                    break;
+            }
+            Book* added = book.get();
+            if (!inventory.insert(std::move(book))) {
+                throw std::invalid_argument("Book with ISBN " + std::string(text.isbn) + 
+                                            " already exists in inventory");
+            }
+            loaded.push_back(added);
         }
+    } catch (...) {
+        // Keep the indexes in step with what made it into the inventory
+        startIndexBuild(std::move(loaded));
+        throw;
+    }
+    
+    size_t count = loaded.size();
+    snapshotLogPosition = std::max(snapshotLogPosition, snapshot->logPosition());
+    snapshotFeedPosition = std::max(snapshotFeedPosition, snapshot->feedPosition());
+    startIndexBuild(std::move(loaded));
+    Logger::global().log<LogLevel::Info>(PRINT_PREFIX, "Loaded {} book(s) from snapshot {}", count, path);
+}
+
+ImportReport QuantumBookstore::importCatalog(const std::string& path, const ImportOptions& options) {
+    auto timer = metrics.time(StoreOp::ImportCatalog);
+    awaitIndexes();
+    CatalogImporter::Result result = CatalogImporter::run(path, options, 
+        [this](size_t rows) {
+            inventory.reserve(rows);
+        }, 
+        [this](BookPtr book) {
+            return inventory.insert(std::move(book), [this](const Book& inserting) {
+                if (wal) {
+                    wal->appendAddBook(inserting);
+                }
+                if (changeFeed) {
+                    changeFeed->publishAddBook(inserting);
+                }
+            });
+        });
+    for (auto& storage : result.arenas) {
+        arena.retain(std::move(storage));
+    }
+    startIndexBuild(std::move(result.added));
+    if (wal) {
+        wal->waitDurable(wal->lastLsn());
     }
     
+    const ImportReport& report = result.report;
+    Logger::global().log<LogLevel::Info>(PRINT_PREFIX, "Imported {} of {} row(s) from {} ({} rejected)", 
+                                         report.booksAdded, report.rowsRead, path, report.errors.size());
+    return std::move(result.report);
+}
+
+size_t QuantumBookstore::openWriteAheadLog(const std::string& path, WalConfig config) {
+    auto timer = metrics.time(StoreOp::OpenWriteAheadLog);
+    if (wal) {
+        throw std::runtime_error("A write-ahead log is already open");
+    }
+    awaitIndexes();
+    size_t replayed = 0;
+    uint64_t lastLsn = WriteAheadLog::replay(path, snapshotLogPosition, [&](const WalEntry& entry) {
+        applyLogEntry(entry);
+        ++replayed;
+    });
+    wal = std::make_unique<WriteAheadLog>(path, config, lastLsn);
+    Logger::global().log<LogLevel::Info>(PRINT_PREFIX, "Replayed {} record(s) from write-ahead log {}", replayed, path);
+    return replayed;
+}
+
+void QuantumBookstore::checkpoint(const std::string& snapshotPath) {
+    auto timer = metrics.time(StoreOp::Checkpoint);
+    uint64_t position = writeSnapshot(snapshotPath);
+    if (wal) {
+        wal->truncate(position);
+    }
+}
+
+void QuantumBookstore::openChangeFeed(const std::string& name, size_t capacity) {
+    auto timer = metrics.time(StoreOp::OpenChangeFeed);
+    if (changeFeed) {
+        throw std::runtime_error("A change feed is already open");
+    }
+    changeFeed = std::make_unique<ChangeFeed>(name, capacity, snapshotFeedPosition);
+    Logger::global().log<LogLevel::Info>(PRINT_PREFIX, "Publishing changes to feed {} after sequence {}", 
+                                         name, snapshotFeedPosition);
+}
+
+uint64_t QuantumBookstore::getChangeFeedPosition() const {
+    return changeFeed ? changeFeed->lastSequence() : 0;
+}
+
+std::vector<BookPtr> QuantumBookstore::removeOutdated(int currentYear, int yearsThreshold) {
+    std::vector<BookPtr> outdatedBooks;
+    removeOutdated(currentYear, yearsThreshold, [&outdatedBooks](std::vector<BookPtr>& batch) {
+        outdatedBooks = std::move(batch);
+    }, SIZE_MAX);
+    return outdatedBooks;
+}
+
+size_t QuantumBookstore::removeOutdated(int currentYear, int yearsThreshold, const RemovedBooks& onBatch, 
+                                        size_t batchSize) {
+    auto timer = metrics.time(StoreOp::RemoveOutdated);
+    // Outdated means (currentYear - year) > threshold, i.e. year < currentYear - threshold,
+    // so the victims are a prefix of the year index and the cost tracks the number removed
+    return sweepOutdated(currentYear - yearsThreshold, onBatch, batchSize, 
+                         std::chrono::steady_clock::time_point::max());
+}
+
+void QuantumBookstore::startBackgroundExpiry(ExpiryConfig config) {
+    if (config.batchSize == 0) {
+        throw std::invalid_argument("Expiry batch size must be positive");
+    }
+    stopBackgroundExpiry();
+    if (!config.currentYear) {
+        config.currentYear = []() {
+            std::time_t now = std::time(nullptr);
+            std::tm local{};
+            localtime_r(&now, &local);
+            return local.tm_year + 1900;
+        };
+    }
+    expiryStopping = false;
+    expiryThread = std::thread([this, config = std::move(config)]() {
+        std::unique_lock<std::mutex> lock(expiryMutex);
+        while (!expiryStopping) {
+            lock.unlock();
+            try {
+                sweepOutdated(config.currentYear() - config.yearsThreshold, config.onRemoved, config.batchSize, 
+                              std::chrono::steady_clock::now() + config.budget);
+            } catch (const std::exception& error) {
+                Logger::global().log<LogLevel::Error>(PRINT_PREFIX, "Background expiry failed: {}", error.what());
+            }
+            lock.lock();
+            expiryWake.wait_for(lock, config.interval, [this]() { return expiryStopping; });
+        }
+    });
+}
+
+void QuantumBookstore::stopBackgroundExpiry() {
+    {
+        std::lock_guard<std::mutex> lock(expiryMutex);
+        expiryStopping = true;
+    }
+    expiryWake.notify_all();
+    if (expiryThread.joinable()) {
+        expiryThread.join();
+    }
+}
+
+size_t QuantumBookstore::sweepOutdated(int publishedBefore, const RemovedBooks& onBatch, size_t batchSize, 
+                                       std::chrono::steady_clock::time_point deadline) {
+    if (batchSize == 0) {
+        throw std::invalid_argument("Batch size must be positive");
+    }
+    awaitIndexes();
+    size_t removedCount = 0;
+    while (true) {
+        std::vector<Book*> outdated = index.takePublishedBefore(publishedBefore, batchSize);
+        if (outdated.empty()) {
+            break;
+        }
+        std::vector<BookPtr> batch = removeTaken(outdated);
+        removedCount += batch.size();
+        if (onBatch) {
+            onBatch(batch);
+        }
+        if (outdated.size() < batchSize || std::chrono::steady_clock::now() >= deadline) {
+            break;
+        }
+    }
+    epochs.collect();
+    return removedCount;
+}
+
+std::vector<BookPtr> QuantumBookstore::removeTaken(const std::vector<Book*>& outdated) {
+    std::vector<BookPtr> outdatedBooks;
+    outdatedBooks.reserve(outdated.size());
+    uint64_t lsn = 0;
+    for (Book* book : outdated) {
+        Logger::global().log<LogLevel::Info>(PRINT_PREFIX, "Removing outdated book: {} (ISBN: {})", 
+                                             book->getTitle(), book->getISBN());
+        std::string isbn(book->getISBN());
+        uint64_t key = IsbnCodec::pack(isbn);
+        searchIndex.remove(isbn);
+        // Logged under the shard lock, so a snapshot has the book or the
+        // record, never both. A sale of a hold taken earlier may still be
+        // logged after it; replay skips it, which matches a book that is gone.
+        BookPtr removed = inventory.remove(isbn, [&](const Book&) {
+            if (wal) {
+                lsn = wal->appendRemoveBook(key);
+            }
+            if (changeFeed) {
+                changeFeed->publishRemoveBook(key);
+            }
+        });
+        // A purchase may have marked it sold out after the index split
+        index.markInStock(book);
+        outdatedBooks.push_back(handOver(std::move(removed)));
+    }
+    if (lsn) {
+        wal->waitDurable(lsn);
+    }
+    metrics.countRemoved(outdatedBooks.size());
     return outdatedBooks;
 }
 
 double QuantumBookstore::buyBook(const std::string& isbn, int quantity, 
                                 const std::string& customerEmail, 
                                 const std::string& shippingAddress) {
+    return tryBuyBook(isbn, quantity, customerEmail, shippingAddress).value();
+}
+
+StoreResult<double> QuantumBookstore::tryBuyBook(const std::string& isbn, int quantity, 
+                                                 const std::string& customerEmail, 
+                                                 const std::string& shippingAddress) {
+    auto timer = metrics.time(StoreOp::BuyBook);
+    // The book must outlive the purchase even if removeOutdated drops it midway
+    auto pinned = epochs.pin();
     if (quantity <= 0) {
-        throw std::invalid_argument("Quantity must be positive");
+        metrics.countFailure(StoreFailure::InvalidQuantity);
+        return StoreError{StoreFailure::InvalidQuantity, isbn, quantity};
     }
     
-    auto it = inventory.find(isbn);
-    if (it == inventory.end()) {
-        throw std::runtime_error("Book with ISBN " + isbn + " not found in inventory");
-    }
+    Book* book = nullptr;
+    PaperBook* paperBook = nullptr;
+    StockReservation reservation;
+    int available = 0;
     
-    Book* book = it->second.get();
+    // Stock is reserved lock-free, so purchases only need the shard's shared lock
+    bool found = inventory.withShared(isbn, [&](Book& candidate) {
+        if (!candidate.canBeSold()) {
+            return;
+        }
+        
+        // Check if it's a paper book and hold the requested stock
+        paperBook = asPaperBook(&candidate);
+        if (paperBook) {
+            reservation = paperBook->tryReserve(quantity);
+            if (!reservation) {
+                available = paperBook->getStock();
+                return;
+            }
+        }
+        book = &candidate;
+    });
     
-    if (!book->canBeSold()) {
-        throw std::runtime_error("Book with ISBN " + isbn + " is not for sale");
+    if (!found) {
+        metrics.countFailure(StoreFailure::UnknownIsbn);
+        return StoreError{StoreFailure::UnknownIsbn, isbn};
+    }
+    if (!book) {
+        StoreFailure failure = paperBook ? StoreFailure::InsufficientStock : StoreFailure::NotForSale;
+        metrics.countFailure(failure);
+        return StoreError{failure, isbn, quantity, available};
     }
     
-    // Check if it's a paper book and verify stock
-    PaperBook* paperBook = dynamic_cast<PaperBook*>(book);
+    // The hold is consumed and the sale logged before anything ships; the
+    // units go back if the log cannot make it durable or delivery fails
+    std::vector<WalSaleLine> sold;
+    std::function<void()> restock;
     if (paperBook) {
-        if (!paperBook->hasEnoughStock(quantity)) {
-            throw std::runtime_error("Insufficient stock for book with ISBN " + isbn + 
-                                   ". Available: " + std::to_string(paperBook->getStock()) + 
-                                   ", Requested: " + std::to_string(quantity));
+        sold.push_back({IsbnCodec::pack(isbn), quantity});
+        restock = [paperBook, quantity]() { paperBook->restock(quantity); };
+        uint64_t lsn = 0;
+        if (!commitSale(sold, [&reservation]() { return reservation.commit(); }, restock, lsn)) {
+            metrics.countFailure(StoreFailure::InsufficientStock);
+            return StoreError{StoreFailure::InsufficientStock, isbn, quantity, paperBook->getStock()};
+        }
+        if (lsn) {
+            try {
+                wal->waitDurable(lsn);
+            } catch (...) {
+                undoSale(sold, restock);
+                throw;
+            }
         }
-        paperBook->reduceStock(quantity);
     }
-    
     // Process the purchase (shipping for paper books, email for ebooks)
-    book->processPurchase(customerEmail, shippingAddress);
+    try {
+        deliver(*book, quantity, customerEmail, shippingAddress);
+    } catch (...) {
+        if (paperBook) {
+            undoSale(sold, restock);
+        }
+        throw;
+    }
+    if (paperBook && paperBook->getStock() == 0) {
+        refreshSoldOut(isbn);
+    }
     
+    metrics.countSold(book->getKind(), quantity);
     double totalAmount = book->getPrice() * quantity;
     
-    printMessage("Successfully sold " + std::to_string(quantity) + 
-                " copy(ies) of '" + book->getTitle() + "' for $" + 
-                std::to_string(totalAmount));
+    Logger::global().log<LogLevel::Debug>(PRINT_PREFIX, "Successfully sold {} copy(ies) of '{}' for ${}", 
+                                          quantity, book->getTitle(), totalAmount);
     
     return totalAmount;
 }
 
-void QuantumBookstore::printInventory() const {
-    printMessage("Current Inventory:");
-    for (const auto& pair : inventory) {
-        const Book* book = pair.second.get();
-        std::cout << "  ISBN: " << book->getISBN() 
-                  << ", Title: " << book->getTitle()
-                  << ", Author: " << book->getAuthorName()
-                  << ", Year: " << book->getYearPublished()
-                  << ", Price: $" << book->getPrice()
-                  << ", Type: " << book->getType();
-        
-        // Show stock for paper books
-        const PaperBook* paperBook = dynamic_cast<const PaperBook*>(book);
-        if (paperBook) {
-            std::cout << ", Stock: " << paperBook->getStock();
+std::vector<double> QuantumBookstore::buyBooks(const std::vector<OrderLine>& lines, 
+                                               const std::string& customerEmail, 
+                                               const std::string& shippingAddress) {
+    auto timer = metrics.time(StoreOp::BuyBooks);
+    auto pinned = epochs.pin();
+    for (const auto& line : lines) {
+        if (line.quantity <= 0) {
+            metrics.countFailure(StoreFailure::InvalidQuantity);
+            throw std::invalid_argument("Quantity must be positive");
         }
+    }
+    
+    // Validate and reserve every line in one pass; if any line fails, the
+    // reservations taken so far are released as they go out of scope
+    std::vector<Book*> books(lines.size(), nullptr);
+    std::vector<StockReservation> reservations(lines.size());
+    bool hasPaperLines = false;
+    
+    for (size_t i = 0; i < lines.size(); ++i) {
+        const OrderLine& line = lines[i];
+        bool found = inventory.withShared(line.isbn, [&](Book& candidate) {
+            if (!candidate.canBeSold()) {
+                metrics.countFailure(StoreFailure::NotForSale);
+                throw std::runtime_error("Book with ISBN " + line.isbn + " is not for sale");
+            }
+            
+            // Stock comes from the kind, not the delivery channel, which
+            // subclasses may override
+            if (PaperBook* paperBook = asPaperBook(&candidate)) {
+                StockReservation reservation = paperBook->tryReserve(line.quantity);
+                if (!reservation) {
+                    metrics.countFailure(StoreFailure::InsufficientStock);
+                    throw std::runtime_error("Insufficient stock for book with ISBN " + line.isbn + 
+                                           ". Available: " + std::to_string(paperBook->getStock()) + 
+                                           ", Requested: " + std::to_string(line.quantity));
+                }
+                reservations[i] = std::move(reservation);
+                hasPaperLines = true;
+            }
+            books[i] = &candidate;
+        });
         
-        // Show file type for ebooks
-        const EBook* ebook = dynamic_cast<const EBook*>(book);
-        if (ebook) {
-            std::cout << ", File Type: " << ebook->getFileType();
+        if (!found) {
+            metrics.countFailure(StoreFailure::UnknownIsbn);
+            throw std::runtime_error("Book with ISBN " + line.isbn + " not found in inventory");
         }
-        
-        std::cout << std::endl;
     }
+    
+    // As for one book: every hold is consumed and the order logged as one
+    // record, so replay applies all lines or none, before anything ships
+    std::vector<WalSaleLine> sold;
+    sold.reserve(lines.size());
+    for (size_t i = 0; i < lines.size(); ++i) {
+        if (reservations[i]) {
+            sold.push_back({IsbnCodec::pack(lines[i].isbn), lines[i].quantity});
+        }
+    }
+    auto restockLines = [&](size_t count) {
+        for (size_t i = 0; i < count; ++i) {
+            if (PaperBook* paperBook = asPaperBook(books[i])) {
+                paperBook->restock(lines[i].quantity);
+            }
+        }
+    };
+    std::function<void()> restock = [&restockLines, &lines]() { restockLines(lines.size()); };
+    if (hasPaperLines) {
+        size_t lapsed = 0;
+        auto consume = [&]() {
+            for (size_t i = 0; i < lines.size(); ++i) {
+                if (reservations[i] && !reservations[i].commit()) {
+                    restockLines(i);
+                    lapsed = i;
+                    return false;
+                }
+            }
+            return true;
+        };
+        uint64_t lsn = 0;
+        if (!commitSale(sold, consume, restock, lsn)) {
+            metrics.countFailure(StoreFailure::InsufficientStock);
+            throw std::runtime_error("Insufficient stock for book with ISBN " + lines[lapsed].isbn +
+                                     ". Its hold expired before checkout");
+        }
+        if (lsn) {
+            try {
+                wal->waitDurable(lsn);
+            } catch (...) {
+                undoSale(sold, restock);
+                throw;
+            }
+        }
+    }
+    
+    try {
+        deliverOrder(books, lines, customerEmail, shippingAddress);
+    } catch (...) {
+        if (hasPaperLines) {
+            undoSale(sold, restock);
+        }
+        throw;
+    }
+    for (size_t i = 0; i < lines.size(); ++i) {
+        const PaperBook* paperBook = asPaperBook(books[i]);
+        if (paperBook && paperBook->getStock() == 0) {
+            refreshSoldOut(lines[i].isbn);
+        }
+    }
+    
+    std::vector<double> lineTotals;
+    lineTotals.reserve(lines.size());
+    double orderTotal = 0.0;
+    for (size_t i = 0; i < lines.size(); ++i) {
+        metrics.countSold(books[i]->getKind(), lines[i].quantity);
+        lineTotals.push_back(books[i]->getPrice() * lines[i].quantity);
+        orderTotal += lineTotals.back();
+    }
+    
+    Logger::global().log<LogLevel::Debug>(PRINT_PREFIX, "Successfully sold {} order line(s) for ${}", 
+                                          lines.size(), orderTotal);
+    
+    return lineTotals;
+}
+
+void QuantumBookstore::printInventory() const {
+    auto timer = metrics.time(StoreOp::PrintInventory);
+    Logger& logger = Logger::global();
+    logger.log<LogLevel::Info>(PRINT_PREFIX, "Current Inventory:");
+    // Formatting runs on a snapshot, so it holds up no writer
+    CatalogView view = readView();
+    for (const Book* listed : view) {
+        const Book& book = *listed;
+        // Dispatch on the kind tag: stock for paper books, file type for ebooks
+        visitBook(book, BookVisitor{
+            [&](const PaperBook& paperBook) {
+                logger.log<LogLevel::Info>(nullptr, "  ISBN: {}, Title: {}, Author: {}, Year: {}, Price: ${}, Type: {}, Stock: {}", 
+                                           book.getISBN(), book.getTitle(), book.getAuthorName(), book.getYearPublished(), 
+                                           book.getPrice(), bookKindName(BookKind::Paper), paperBook.getStock());
+            },
+            [&](const EBook& ebook) {
+                logger.log<LogLevel::Info>(nullptr, "  ISBN: {}, Title: {}, Author: {}, Year: {}, Price: ${}, Type: {}, File Type: {}", 
+                                           book.getISBN(), book.getTitle(), book.getAuthorName(), book.getYearPublished(), 
+                                           book.getPrice(), bookKindName(BookKind::EBook), ebook.getFileType());
+            },
+            [&](const Book& other) {
+                logger.log<LogLevel::Info>(nullptr, "  ISBN: {}, Title: {}, Author: {}, Year: {}, Price: ${}, Type: {}", 
+                                           book.getISBN(), book.getTitle(), book.getAuthorName(), book.getYearPublished(), 
+                                           book.getPrice(), other.getType());
+            }
+        });
+    }
+    // The dump is complete when the call returns
+    logger.flush();
+}
+
+void QuantumBookstore::enableAsyncFulfillment(FulfillmentConfig config, FulfillmentBackend backend) {
+    auto onComplete = std::move(config.onComplete);
+    config.onComplete = [this, onComplete](const FulfillmentJob& job, FulfillmentStatus status) {
+        if (status == FulfillmentStatus::Failed) {
+            compensateDelivery(job);
+        }
+        if (onComplete) {
+            onComplete(job, status);
+        }
+    };
+    auto pipeline = std::make_shared<FulfillmentPipeline>(std::move(config), std::move(backend));
+    // The old pipeline drains once the last sale still submitting to it lets go
+    std::atomic_store(&fulfillment, std::move(pipeline));
+}
+
+void QuantumBookstore::waitForFulfillment() const {
+    auto timer = metrics.time(StoreOp::WaitForFulfillment);
+    if (auto pipeline = std::atomic_load(&fulfillment)) {
+        pipeline->waitUntilIdle();
+    }
+}
+
+size_t QuantumBookstore::expireReservations() {
+    auto timer = metrics.time(StoreOp::ExpireReservations);
+    awaitIndexes();
+    size_t expired = 0;
+    auto now = StockCounter::Clock::now();
+    inventory.forEach([this, &expired, now](Book& book) {
+        PaperBook* paperBook = asPaperBook(&book);
+        size_t released = paperBook ? paperBook->expireHolds(now) : 0;
+        if (released > 0) {
+            expired += released;
+            if (paperBook->getStock() > 0) {
+                index.markInStock(&book);
+            }
+        }
+    });
+    return expired;
+}
+
+CatalogIndex::AuthorRange QuantumBookstore::findBooksByAuthor(const std::string& author) const {
+    auto timer = metrics.time(StoreOp::FindBooksByAuthor);
+    awaitIndexes();
+    // Pinned before the copy, so no book in it can be freed under the range
+    auto pinned = epochs.pin();
+    return BookRange(std::move(pinned), index.byAuthor(author));
+}
+
+CatalogIndex::YearRange QuantumBookstore::findBooksPublishedBetween(int fromYear, int toYear) const {
+    auto timer = metrics.time(StoreOp::FindBooksPublishedBetween);
+    awaitIndexes();
+    auto pinned = epochs.pin();
+    return BookRange(std::move(pinned), index.publishedBetween(fromYear, toYear));
+}
+
+CatalogIndex::PriceRange QuantumBookstore::findBooksInPriceRange(double minPrice, double maxPrice) const {
+    auto timer = metrics.time(StoreOp::FindBooksInPriceRange);
+    awaitIndexes();
+    auto pinned = epochs.pin();
+    return BookRange(std::move(pinned), index.pricedBetween(minPrice, maxPrice));
+}
+
+CatalogIndex::SoldOutRange QuantumBookstore::findOutOfStock() const {
+    auto timer = metrics.time(StoreOp::FindOutOfStock);
+    awaitIndexes();
+    auto pinned = epochs.pin();
+    return BookRange(std::move(pinned), index.soldOut());
+}
+
+std::vector<SearchHit> QuantumBookstore::searchBooks(const std::string& query, size_t limit) const {
+    auto timer = metrics.time(StoreOp::SearchBooks);
+    awaitIndexes();
+    return searchIndex.search(query, limit);
+}
+
+std::vector<Book*> QuantumBookstore::findBooksByKind(BookKind kind) const {
+    auto timer = metrics.time(StoreOp::FindBooksByKind);
+    return inventory.select([kind](const ColumnarCatalog& columns) {
+        return columns.selectKind(kind);
+    });
 }
 
 size_t QuantumBookstore::getInventorySize() const { 
+    auto timer = metrics.time(StoreOp::GetInventorySize);
     return inventory.size(); 
 }
 
 Book* QuantumBookstore::findBook(const std::string& isbn) const {
-    auto it = inventory.find(isbn);
-    return (it != inventory.end()) ? it->second.get() : nullptr;
+    auto timer = metrics.time(StoreOp::FindBook);
+    return inventory.find(isbn);
+}
+
+void QuantumBookstore::findBooks(const std::vector<std::string_view>& isbns, 
+                                 const std::function<void(size_t, const Book*)>& visit) const {
+    auto timer = metrics.time(StoreOp::FindBooks);
+    auto pinned = epochs.pin();
+    std::vector<Book*> found;
+    inventory.findMany(isbns, found);
+    for (size_t i = 0; i < found.size(); ++i) {
+        visit(i, found[i]);
+    }
+}
+
+bool QuantumBookstore::isSoldOut(const std::string& isbn) const {
+    bool soldOut = false;
+    inventory.withShared(isbn, [&](Book& book) {
+        const PaperBook* paperBook = asPaperBook(&book);
+        soldOut = paperBook && paperBook->getStock() == 0;
+    });
+    return soldOut;
+}
+
+MetricsSnapshot QuantumBookstore::getMetrics() const {
+    MetricsSnapshot snapshot = metrics.snapshot();
+    snapshot.inventorySize = inventory.size();
+    inventory.forEach([&snapshot](const Book& book) {
+        const PaperBook* paperBook = asPaperBook(&book);
+        if (paperBook) {
+            snapshot.totalStock += paperBook->getStock();
+        }
+    });
+    return snapshot;
+}
+
+std::string QuantumBookstore::exportMetrics() const {
+    return getMetrics().toPrometheus();
+}
+
+void QuantumBookstore::setMetricsSamplePeriod(StoreOp op, uint32_t period) {
+    metrics.setSamplePeriod(op, period);
+}
+
+AnalyticsResult QuantumBookstore::analyze(const CatalogQuery& query) const {
+    auto timer = metrics.time(StoreOp::Analyze);
+    std::call_once(analyticsPoolStarted, [this]() { analyticsPool = std::make_unique<TaskPool>(); });
+    // Scan copies of the columns, so catalog changes need not wait for the
+    // scan; the pin keeps books removed meanwhile alive until it is done
+    auto pinned = epochs.pin();
+    std::vector<ColumnarCatalog> columns = inventory.copyColumns();
+    std::vector<const ColumnarCatalog*> partitions;
+    partitions.reserve(columns.size());
+    for (const ColumnarCatalog& shard : columns) {
+        partitions.push_back(&shard);
+    }
+    return CatalogAnalytics::run(query, partitions, *analyticsPool);
+}
+
+CatalogView QuantumBookstore::readView() const {
+    auto pinned = epochs.pin();
+    const CatalogVersion* current = publishedCatalog.load(std::memory_order_acquire);
+    if (current && current->version == inventory.version()) {
+        return CatalogView(std::move(pinned), current);
+    }
+    
+    // One reader rebuilds a stale version; the others wait for it
+    std::lock_guard<std::mutex> lock(catalogRebuildMutex);
+    current = publishedCatalog.load(std::memory_order_acquire);
+    if (!current || current->version != inventory.version()) {
+        // Writers wait only while the shards changed since the current
+        // version are copied; sorting them and merging run unlocked
+        auto rebuilt = std::make_unique<CatalogVersion>();
+        if (current) {
+            rebuilt->shards = current->shards;
+        }
+        rebuilt->version = inventory.collect(rebuilt->shards);
+        mergeShards(rebuilt->shards, rebuilt->books);
+        const CatalogVersion* previous = publishedCatalog.exchange(rebuilt.get(), std::memory_order_acq_rel);
+        current = rebuilt.release();
+        if (previous) {
+            epochs.retire(std::shared_ptr<const CatalogVersion>(previous));
+            // A version is as large as the catalog; free those no view pins
+            // any more now instead of every few dozen retirements
+            epochs.collect();
+        }
+    }
+    return CatalogView(std::move(pinned), current);
+}
+
+ExportCursor QuantumBookstore::exportPage(ExportSink& sink, ExportFormat format, size_t maxRows, 
+                                          const ExportCursor& cursor) const {
+    auto timer = metrics.time(StoreOp::ExportCatalog);
+    ExportCursor next = cursor;
+    if (cursor.finished) {
+        return next;
+    }
+    CatalogView view = readView();
+    CatalogExporter exporter(sink, format);
+    // Rows alone do not say whether the header went out: a first page may
+    // be empty
+    if (!cursor.headerWritten) {
+        exporter.writeHeader();
+        next.headerWritten = true;
+    }
+    auto it = cursor.rowsExported == 0 ? view.begin() : view.after(cursor.afterKey);
+    size_t rows = 0;
+    const Book* last = nullptr;
+    for (; rows < maxRows && it != view.end(); ++rows, ++it) {
+        last = *it;
+        exporter.write(*last);
+    }
+    exporter.flush();
+    if (last) {
+        next.afterKey = IsbnCodec::pack(last->getISBN());
+        next.rowsExported += rows;
+    }
+    next.finished = it == view.end();
+    return next;
+}
+
+size_t QuantumBookstore::exportCatalog(ExportSink& sink, ExportFormat format) const {
+    return exportPage(sink, format, SIZE_MAX).rowsExported;
+}
+
+BookPtr QuantumBookstore::handOver(BookPtr removed) {
+    BookPtr copy = copyBook(*removed);
+    if (!copy) {
+        // Custom types cannot be copied and are handed over as is
+        return removed;
+    }
+    epochs.retire(std::shared_ptr<const Book>(std::move(removed)));
+    return copy;
+}
+
+void QuantumBookstore::deliver(const Book& book, int quantity, 
+                               const std::string& customerEmail, 
+                               const std::string& shippingAddress) {
+    DeliveryChannel channel = book.getDeliveryChannel();
+    std::shared_ptr<FulfillmentPipeline> pipeline;
+    if (channel != DeliveryChannel::Custom) {
+        pipeline = std::atomic_load(&fulfillment);
+    }
+    if (!pipeline) {
+        book.processPurchase(customerEmail, shippingAddress);
+        return;
+    }
+    const std::string& destination = (channel == DeliveryChannel::Shipping) ? shippingAddress : customerEmail;
+    pipeline->submit({channel, destination, std::string(book.getISBN()), quantity, {}});
+}
+
+void QuantumBookstore::compensateDelivery(const FulfillmentJob& job) {
+    auto pinned = epochs.pin();
+    std::vector<std::pair<std::string, int>> lines = job.lines;
+    if (!job.isbn.empty()) {
+        lines.emplace_back(job.isbn, job.quantity);
+    }
+    // Only paper copies were taken from stock; a book removed since has
+    // nothing to return to
+    std::vector<WalSaleLine> sold;
+    std::vector<PaperBook*> paperBooks;
+    for (const auto& [isbn, quantity] : lines) {
+        inventory.withShared(isbn, [&, quantity = quantity](Book& book) {
+            if (PaperBook* paperBook = asPaperBook(&book)) {
+                sold.push_back({IsbnCodec::pack(isbn), quantity});
+                paperBooks.push_back(paperBook);
+            }
+        });
+    }
+    Logger::global().log<LogLevel::Warning>(PRINT_PREFIX, "Delivery to {} failed; returning {} line(s) to stock",
+                                            job.destination, sold.size());
+    if (sold.empty()) {
+        return;
+    }
+    undoSale(sold, [&]() {
+        for (size_t i = 0; i < sold.size(); ++i) {
+            paperBooks[i]->restock(sold[i].quantity);
+        }
+    });
+    for (const auto& [isbn, quantity] : lines) {
+        refreshSoldOut(isbn);
+    }
+}
+
+bool QuantumBookstore::commitSale(const std::vector<WalSaleLine>& sold, const std::function<bool()>& consume,
+                                  const std::function<void()>& restock, uint64_t& lsn) {
+    if (!wal && !changeFeed) {
+        return consume();
+    }
+    std::vector<uint64_t> keys;
+    keys.reserve(sold.size());
+    for (const WalSaleLine& line : sold) {
+        keys.push_back(line.isbnKey);
+    }
+    bool consumed = false;
+    inventory.withExclusiveKeys(keys, [&]() {
+        consumed = consume();
+        if (!consumed) {
+            return;
+        }
+        try {
+            lsn = logSale(sold);
+        } catch (...) {
+            restock();
+            throw;
+        }
+    });
+    return consumed;
+}
+
+void QuantumBookstore::undoSale(const std::vector<WalSaleLine>& sold, const std::function<void()>& restock) {
+    if (!wal && !changeFeed) {
+        restock();
+        return;
+    }
+    std::vector<WalSaleLine> reversed(sold);
+    std::vector<uint64_t> keys;
+    keys.reserve(sold.size());
+    for (WalSaleLine& line : reversed) {
+        line.quantity = -line.quantity;
+        keys.push_back(line.isbnKey);
+    }
+    // Not waited for: if it is lost, replay leaves the units sold, which
+    // undersells but never oversells
+    inventory.withExclusiveKeys(keys, [&]() {
+        restock();
+        logSale(reversed);
+    });
+}
+
+uint64_t QuantumBookstore::logSale(const std::vector<WalSaleLine>& sold) {
+    uint64_t lsn = wal ? wal->appendSale(sold.data(), sold.size()) : 0;
+    if (changeFeed) {
+        changeFeed->publishSale(sold.data(), sold.size());
+    }
+    return lsn;
 }
 
-void QuantumBookstore::printMessage(const std::string& message) const {
-    std::cout << PRINT_PREFIX << ": " << message << std::endl;
+void QuantumBookstore::deliverOrder(const std::vector<Book*>& books,
+                                    const std::vector<OrderLine>& lines,
+                                    const std::string& customerEmail,
+                                    const std::string& shippingAddress) {
+    // One shipment for all paper lines and one email for all ebook lines
+    FulfillmentJob shipment{DeliveryChannel::Shipping, shippingAddress, "", 0, {}};
+    FulfillmentJob email{DeliveryChannel::Email, customerEmail, "", 0, {}};
+    bool needsShipping = false;
+    bool needsEmail = false;
+    for (size_t i = 0; i < books.size(); ++i) {
+        switch (books[i]->getDeliveryChannel()) {
+            case DeliveryChannel::Shipping:
+                needsShipping = true;
+                shipment.lines.emplace_back(lines[i].isbn, lines[i].quantity);
+                break;
+            case DeliveryChannel::Email:
+                needsEmail = true;
+                email.lines.emplace_back(lines[i].isbn, lines[i].quantity);
+                break;
+            case DeliveryChannel::Custom:
+                books[i]->processPurchase(customerEmail, shippingAddress);
+                break;
+        }
+    }
+    if (auto pipeline = std::atomic_load(&fulfillment)) {
+        if (needsShipping) {
+            pipeline->submit(std::move(shipment));
+        }
+        if (needsEmail) {
+            pipeline->submit(std::move(email));
+        }
+    } else {
+        if (needsShipping) {
+            ShippingService::ship(shippingAddress);
+        }
+        if (needsEmail) {
+            MailService::sendEmail(customerEmail);
+        }
+    }
+}
+
+void QuantumBookstore::indexBooks(const std::vector<Book*>& books) {
+    for (Book* book : books) {
+        index.add(book);
+        searchIndex.add(book);
+        const PaperBook* paperBook = asPaperBook(book);
+        if (paperBook && paperBook->getStock() == 0) {
+            index.markSoldOut(book);
+        }
+    }
+}
+
+void QuantumBookstore::applyLogEntry(const WalEntry& entry) {
+    switch (entry.type) {
+        case WalEntry::Type::AddBook: {
+            const BookText& text = entry.text;
+            BookPtr book;
+            switch (entry.kind) {
+                case BookKind::Paper:
+                    book = arena.makePaperBook(text.isbn, text.title, entry.year, entry.price, text.author, entry.stock);
+                    break;
+                case BookKind::EBook:
+                    book = arena.makeEBook(text.isbn, text.title, entry.year, entry.price, text.author, entry.fileType);
+                    break;
+                default:
+                    book = arena.makeShowcaseBook(text.isbn, text.title, entry.year, entry.price, text.author);
+                    break;
+            }
+            Book* added = book.get();
+            if (!inventory.insert(std::move(book))) {
+                throw std::runtime_error("Write-ahead log record " + std::to_string(entry.lsn) + 
+                                         " adds ISBN " + std::string(text.isbn) + " twice");
+            }
+            indexBooks({added});
+            if (changeFeed) {
+                changeFeed->publishAddBook(*added);
+            }
+            break;
+        }
+        case WalEntry::Type::Sale:
+            for (const WalSaleLine& line : entry.lines) {
+                // Books removed after the sale are already gone
+                std::string isbn = IsbnCodec::unpack(line.isbnKey);
+                bool soldOut = false;
+                inventory.withShared(isbn, [&](Book& book) {
+                    PaperBook* paperBook = asPaperBook(&book);
+                    if (!paperBook) {
+                        return;
+                    }
+                    // A negative line undoes a sale that could not complete
+                    if (line.quantity < 0) {
+                        paperBook->restock(-line.quantity);
+                    } else {
+                        paperBook->reduceStock(line.quantity);
+                    }
+                    soldOut = paperBook->getStock() == 0;
+                });
+                if (soldOut) {
+                    refreshSoldOut(isbn);
+                }
+            }
+            if (changeFeed) {
+                changeFeed->publishSale(entry.lines.data(), entry.lines.size());
+            }
+            break;
+        case WalEntry::Type::RemoveBook: {
+            std::string isbn = IsbnCodec::unpack(entry.isbnKey);
+            Book* book = inventory.find(isbn);
+            if (book) {
+                // The search index keys books by their ISBN as written,
+                // hyphens and all, not by the unpacked key
+                searchIndex.remove(std::string(book->getISBN()));
+                index.remove(book);
+                epochs.retire(std::shared_ptr<const Book>(inventory.remove(isbn, [&](const Book&) {
+                    if (changeFeed) {
+                        changeFeed->publishRemoveBook(entry.isbnKey);
+                    }
+                })));
+            }
+            break;
+        }
+    }
+}
+
+void QuantumBookstore::startIndexBuild(std::vector<Book*> books) {
+    // Callers have already waited out any previous build
+    if (indexBuilder.joinable()) {
+        indexBuilder.join();
+    }
+    indexesPending.store(true, std::memory_order_release);
+    indexBuilder = std::thread([this, books = std::move(books)]() {
+        indexBooks(books);
+        {
+            std::lock_guard<std::mutex> lock(indexBuildMutex);
+            indexesPending.store(false, std::memory_order_release);
+        }
+        indexBuildDone.notify_all();
+    });
+}
+
+void QuantumBookstore::awaitIndexes() const {
+    if (!indexesPending.load(std::memory_order_acquire)) {
+        return;
+    }
+    std::unique_lock<std::mutex> lock(indexBuildMutex);
+    indexBuildDone.wait(lock, [this]() {
+        return !indexesPending.load(std::memory_order_acquire);
+    });
+}
+
+void QuantumBookstore::refreshSoldOut(const std::string& isbn) {
+    // No wait for a pending index build: marking a book the build has not
+    // reached yet is kept when it gets there. Re-check under the shard lock so a book removed meanwhile is never indexed
+    inventory.withShared(isbn, [this](Book& book) {
+        const PaperBook* paperBook = asPaperBook(&book);
+        if (!paperBook) {
+            return;
+        }
+        if (paperBook->getStock() == 0) {
+            index.markSoldOut(&book);
+        } else {
+            index.markInStock(&book);
+        }
+    });
 }
@@ -1,6 +1,22 @@
 #include "../include/QuantumBookstoreFullTest.h"
+#include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <cstdio>
+#include <fcntl.h>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <future>
 #include <iostream>
+#include <mutex>
+#include <random>
+#include <unordered_map>
+#include <thread>
+#include <unistd.h>
 #include <vector>
 
 void QuantumBookstoreFullTest::runAllTests() {
@@ -15,6 +31,30 @@ void QuantumBookstoreFullTest::runAllTests() {
     testDuplicateISBN();
     testBookNotFound();
     testInvalidQuantity();
+    testConcurrentAccess();
+    testStockReservations();
+    testBuyBooksBatch();
+    testAsyncFulfillment();
+    testBookKindDispatch();
+    testColumnarScans();
+    testSecondaryIndexes();
+    testFullTextSearch();
+    testAsyncLogging();
+    testArenaBooks();
+    testIsbnKeys();
+    testSnapshots();
+    testWriteAheadLog();
+    testCatalogImport();
+    testMetrics();
+    testLoadGenerator();
+    testEpochSnapshots();
+    testCatalogExport();
+    testExpiry();
+    testRpcServer();
+    testResultApi();
+    testAnalytics();
+    testChangeFeed();
+    testAdmission();
     
     std::cout << "=== All tests passed! ===" << std::endl;
 }
@@ -196,3 +236,2321 @@ void QuantumBookstoreFullTest::testInvalidQuantity() {
     
     std::cout << "✓ invalidQuantity test passed" << std::endl;
 }
+
+void QuantumBookstoreFullTest::testConcurrentAccess() {
+    std::cout << "Testing concurrent lookups and purchases..." << std::endl;
+    QuantumBookstore store(8);
+    
+    const int bookCount = 4;
+    const int initialStock = 20;
+    for (int i = 0; i < bookCount; ++i) {
+        store.addBook(std::make_unique<PaperBook>("978-000000000" + std::to_string(i), 
+            "Concurrent Book " + std::to_string(i), 2020, 10.0, "Author", initialStock));
+    }
+    
+    // Mixed 90% lookup / 10% purchase workload; every purchase tries to take one copy
+    const int threadCount = 4;
+    const int opsPerThread = 100;
+    std::vector<int> sold(threadCount, 0);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < threadCount; ++t) {
+        threads.emplace_back([&store, &sold, t]() {
+            for (int op = 0; op < opsPerThread; ++op) {
+                std::string isbn = "978-000000000" + std::to_string((t + op) % bookCount);
+                if (op % 10 != 0) {
+                    assert(store.findBook(isbn) != nullptr);
+                    continue;
+                }
+                try {
+                    store.buyBook(isbn, 1, "test@test.com", "Cairo, Egypt");
+                    ++sold[t];
+                } catch (const std::runtime_error& e) {
+                    // Sold out is acceptable under contention
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    
+    // No copy is ever sold twice or lost
+    int totalSold = 0;
+    for (int count : sold) {
+        totalSold += count;
+    }
+    int remaining = 0;
+    for (int i = 0; i < bookCount; ++i) {
+        remaining += dynamic_cast<PaperBook*>(store.findBook("978-000000000" + std::to_string(i)))->getStock();
+    }
+    assert(totalSold + remaining == bookCount * initialStock);
+    assert(store.getInventorySize() == static_cast<size_t>(bookCount));
+    
+    std::cout << "✓ concurrentAccess test passed" << std::endl;
+}
+
+void QuantumBookstoreFullTest::testStockReservations() {
+    std::cout << "Testing stock reservations..." << std::endl;
+    PaperBook book("978-0134685991", "Effective Modern C++", 2014, 45.99, "Scott Meyers", 10);
+    
+    // Held units leave stock until released or committed
+    StockReservation hold = book.tryReserve(4);
+    assert(hold && hold.isActive());
+    assert(book.getStock() == 6 && book.getHeldStock() == 4);
+    assert(hold.release());
+    assert(book.getStock() == 10 && book.getHeldStock() == 0);
+    
+    StockReservation sale = book.tryReserve(3);
+    assert(sale.commit());
+    assert(!sale.release());
+    assert(book.getStock() == 7);
+    
+    // Cannot reserve more than is available
+    assert(!book.tryReserve(8));
+    
+    // Abandoned holds are returned once their deadline passes
+    StockReservation abandoned = book.tryReserve(2, std::chrono::milliseconds(0));
+    assert(book.getStock() == 5);
+    assert(book.expireHolds(StockCounter::Clock::now() + std::chrono::seconds(1)) == 1);
+    assert(book.getStock() == 7);
+    assert(!abandoned.commit());
+    
+    // Deadlines do not saturate, however long the TTL
+    StockReservation longHold = book.tryReserve(1, std::chrono::hours(24 * 60));
+    assert(book.expireHolds(StockCounter::Clock::now() + std::chrono::hours(24 * 59)) == 0);
+    assert(book.expireHolds(StockCounter::Clock::now() + std::chrono::hours(24 * 61)) == 1);
+    assert(book.getStock() == 7 && !longHold.isActive());
+    
+    // A burst of holds beyond the slot table still succeeds, and its
+    // overflow holds commit, release and expire like any other
+    const int burstSize = static_cast<int>(StockCounter::MAX_ACTIVE_HOLDS) + 4;
+    PaperBook popular("978-2222222222", "Popular", 2024, 5.0, "Popular Author", 100);
+    std::vector<StockReservation> burst;
+    for (int i = 0; i < burstSize; ++i) {
+        burst.push_back(popular.tryReserve(1));
+        assert(burst.back());
+    }
+    assert(popular.getHeldStock() == burstSize && popular.getStock() == 100 - burstSize);
+    assert(burst.back().isActive() && burst.back().commit());
+    assert(burst[burstSize - 2].release());
+    StockReservation lapsed = popular.tryReserve(1, std::chrono::milliseconds(0));
+    assert(popular.expireHolds(StockCounter::Clock::now() + std::chrono::seconds(1)) == 1);
+    assert(!lapsed.isActive());
+    burst.clear();
+    assert(popular.getStock() == 99 && popular.getHeldStock() == 0);
+    
+    // Concurrent reservations never oversell, even after the counter spreads into slabs
+    PaperBook bestseller("978-1111111111", "Bestseller", 2024, 9.99, "Popular Author", 5000);
+    const int threadCount = 8;
+    std::vector<int> reserved(threadCount, 0);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < threadCount; ++t) {
+        threads.emplace_back([&bestseller, &reserved, t]() {
+            for (int i = 0; i < 1000; ++i) {
+                StockReservation reservation = bestseller.tryReserve(1 + i % 3);
+                if (reservation) {
+                    reserved[t] += reservation.getQuantity();
+                    reservation.commit();
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    int totalReserved = 0;
+    for (int units : reserved) {
+        totalReserved += units;
+    }
+    assert(totalReserved + bestseller.getStock() == 5000);
+    assert(bestseller.getHeldStock() == 0);
+    
+    std::cout << "✓ stockReservations test passed" << std::endl;
+}
+
+namespace {
+
+// Custom type that ships without being a paper book
+class BoxedSet : public Book {
+public:
+    BoxedSet() : Book("978-6666666666", "Boxed Set", 2024, 99.0, "Various") {}
+    void processPurchase(const std::string&, const std::string&) const override {}
+    bool canBeSold() const override { return true; }
+    std::string getType() const override { return "Boxed Set"; }
+    DeliveryChannel getDeliveryChannel() const override { return DeliveryChannel::Shipping; }
+};
+
+} // namespace
+
+void QuantumBookstoreFullTest::testBuyBooksBatch() {
+    std::cout << "Testing batch checkout..." << std::endl;
+    QuantumBookstore store;
+    
+    store.addBook(std::make_unique<PaperBook>("978-0134685991", 
+        "Effective Modern C++", 2014, 45.99, "Scott Meyers", 10));
+    store.addBook(std::make_unique<PaperBook>("978-0321714114", 
+        "C++ Primer", 2012, 59.99, "Stanley Lippman", 1));
+    store.addBook(std::make_unique<EBook>("978-1035024957", 
+        "Think Faster, Talk Smarter", 2023, 14.99, "Matt Abrahams", "PDF"));
+    store.addBook(std::make_unique<ShowcaseBook>("978-9999999999", 
+        "Demo Book", 2023, 0.0, "Demo Author"));
+    
+    std::vector<double> totals = store.buyBooks({{"978-0134685991", 2}, {"978-1035024957", 1}}, 
+        "test@test.com", "Cairo, Egypt");
+    assert(totals.size() == 2);
+    assert(std::abs(totals[0] - 91.98) < 0.01);
+    assert(std::abs(totals[1] - 14.99) < 0.01);
+    
+    PaperBook* modernCpp = dynamic_cast<PaperBook*>(store.findBook("978-0134685991"));
+    PaperBook* primer = dynamic_cast<PaperBook*>(store.findBook("978-0321714114"));
+    assert(modernCpp->getStock() == 8);
+    
+    // A failing line rolls back the stock reserved by earlier lines
+    const std::vector<std::vector<OrderLine>> failingOrders = {
+        {{"978-0134685991", 3}, {"978-0321714114", 2}},
+        {{"978-0134685991", 3}, {"978-0000000000", 1}},
+        {{"978-0134685991", 3}, {"978-9999999999", 1}},
+    };
+    for (const auto& order : failingOrders) {
+        try {
+            store.buyBooks(order, "test@test.com", "Cairo, Egypt");
+            assert(false); // Should not reach here
+        } catch (const std::runtime_error& e) {
+            // Expected exception
+        }
+        assert(modernCpp->getStock() == 8);
+        assert(primer->getStock() == 1);
+    }
+    
+    // Stock is only reserved for paper books, whatever the channel
+    store.addBook(std::make_unique<BoxedSet>());
+    totals = store.buyBooks({{"978-6666666666", 2}, {"978-0134685991", 1}}, "test@test.com", "Cairo, Egypt");
+    assert(totals.size() == 2 && std::abs(totals[0] - 198.0) < 0.01);
+    assert(modernCpp->getStock() == 7);
+    
+    std::cout << "✓ buyBooksBatch test passed" << std::endl;
+}
+
+void QuantumBookstoreFullTest::testAsyncFulfillment() {
+    std::cout << "Testing asynchronous fulfillment..." << std::endl;
+    
+    // Stand-in carrier that takes 20ms per bulk call
+    std::atomic<int> shipped{0};
+    FulfillmentBackend slowBackend;
+    slowBackend.shipBatch = [&shipped](const std::vector<std::string>& addresses) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        shipped += static_cast<int>(addresses.size());
+        return std::vector<size_t>();
+    };
+    slowBackend.sendEmailBatch = [](const std::vector<std::string>&) { return std::vector<size_t>(); };
+    
+    QuantumBookstore store;
+    store.enableAsyncFulfillment(FulfillmentConfig(), slowBackend);
+    store.addBook(std::make_unique<PaperBook>("978-0134685991", 
+        "Effective Modern C++", 2014, 45.99, "Scott Meyers", 100));
+    
+    // Checkouts return without waiting for the carrier
+    const int purchases = 50;
+    for (int i = 0; i < purchases; ++i) {
+        store.buyBook("978-0134685991", 1, "test@test.com", "Cairo, Egypt");
+    }
+    store.waitForFulfillment();
+    assert(shipped == purchases);
+    
+    // A delivery that fails for good puts its copies back, for every line
+    // of an order; a pipeline can be swapped while the store is in use
+    FulfillmentBackend downBackend;
+    downBackend.shipBatch = [](const std::vector<std::string>&) -> std::vector<size_t> {
+        throw std::runtime_error("carrier unavailable");
+    };
+    downBackend.sendEmailBatch = [](const std::vector<std::string>&) { return std::vector<size_t>(); };
+    FulfillmentConfig downConfig;
+    downConfig.maxAttempts = 1;
+    std::atomic<int> failures{0};
+    downConfig.onComplete = [&failures](const FulfillmentJob&, FulfillmentStatus status) {
+        failures += status == FulfillmentStatus::Failed;
+    };
+    store.enableAsyncFulfillment(downConfig, downBackend);
+    store.addBook(std::make_unique<PaperBook>("978-0201633610", "Design Patterns", 1994, 54.99, "Gang of Four", 2));
+    store.buyBook("978-0201633610", 2, "test@test.com", "Cairo, Egypt");
+    store.waitForFulfillment();
+    assert(failures == 1);
+    assert(static_cast<PaperBook*>(store.findBook("978-0201633610"))->getStock() == 2);
+    store.buyBooks({{"978-0134685991", 3}, {"978-0201633610", 1}}, "test@test.com", "Cairo, Egypt");
+    store.waitForFulfillment();
+    assert(failures == 2);
+    assert(static_cast<PaperBook*>(store.findBook("978-0134685991"))->getStock() == 50);
+    assert(static_cast<PaperBook*>(store.findBook("978-0201633610"))->getStock() == 2);
+    assert(!store.isSoldOut("978-0201633610"));
+    
+    // Failed bulk calls are retried with backoff before a job is reported failed
+    std::atomic<int> attempts{0};
+    FulfillmentBackend flakyBackend;
+    flakyBackend.shipBatch = [&attempts](const std::vector<std::string>&) {
+        if (++attempts < 3) {
+            throw std::runtime_error("carrier unavailable");
+        }
+        return std::vector<size_t>();
+    };
+    flakyBackend.sendEmailBatch = [](const std::vector<std::string>&) -> std::vector<size_t> {
+        throw std::runtime_error("relay down");
+    };
+    FulfillmentConfig config;
+    config.initialBackoff = std::chrono::milliseconds(1);
+    std::atomic<int> callbacks{0};
+    config.onComplete = [&callbacks](const FulfillmentJob&, FulfillmentStatus) { ++callbacks; };
+    
+    FulfillmentPipeline pipeline(config, flakyBackend);
+    auto shipment = pipeline.submit({DeliveryChannel::Shipping, "Cairo, Egypt", "978-0134685991", 1, {}});
+    assert(shipment.get() == FulfillmentStatus::Delivered);
+    auto email = pipeline.submit({DeliveryChannel::Email, "test@test.com", "978-1035024957", 1, {}});
+    assert(email.get() == FulfillmentStatus::Failed);
+    pipeline.waitUntilIdle();
+    assert(attempts == 3);
+    assert(callbacks == 2);
+    
+    // A carrier that rejects one address of a batch fails that job alone,
+    // and retries send only the rejected address
+    std::promise<void> opened;
+    std::shared_future<void> gate = opened.get_future().share();
+    std::mutex callsMutex;
+    std::vector<std::vector<std::string>> calls;
+    FulfillmentBackend pickyBackend;
+    pickyBackend.shipBatch = [&](const std::vector<std::string>& addresses) {
+        gate.wait();
+        std::lock_guard<std::mutex> lock(callsMutex);
+        calls.push_back(addresses);
+        std::vector<size_t> rejected;
+        for (size_t i = 0; i < addresses.size(); ++i) {
+            if (addresses[i] == "Nowhere") {
+                rejected.push_back(i);
+            }
+        }
+        return rejected;
+    };
+    pickyBackend.sendEmailBatch = [](const std::vector<std::string>&) { return std::vector<size_t>(); };
+    FulfillmentConfig pickyConfig;
+    pickyConfig.workerCount = 1;
+    pickyConfig.maxAttempts = 2;
+    pickyConfig.initialBackoff = std::chrono::milliseconds(1);
+    std::atomic<int> compensated{0};
+    pickyConfig.onComplete = [&compensated](const FulfillmentJob&, FulfillmentStatus status) {
+        compensated += status == FulfillmentStatus::Failed;
+    };
+    store.enableAsyncFulfillment(pickyConfig, pickyBackend);
+    store.buyBook("978-0134685991", 1, "test@test.com", "Cairo, Egypt");  // holds the worker at the gate
+    store.buyBook("978-0134685991", 2, "test@test.com", "Alexandria, Egypt");
+    store.buyBook("978-0134685991", 4, "test@test.com", "Nowhere");
+    store.buyBook("978-0134685991", 8, "test@test.com", "Giza, Egypt");
+    opened.set_value();
+    store.waitForFulfillment();
+    assert(compensated == 1);
+    assert(static_cast<PaperBook*>(store.findBook("978-0134685991"))->getStock() == 50 - 1 - 2 - 8);
+    std::unordered_map<std::string, int> sends;
+    for (const auto& call : calls) {
+        for (const std::string& address : call) {
+            ++sends[address];
+        }
+    }
+    assert(sends["Cairo, Egypt"] == 1 && sends["Alexandria, Egypt"] == 1 && sends["Giza, Egypt"] == 1);
+    assert(sends["Nowhere"] == 2 && calls.back() == std::vector<std::string>({"Nowhere"}));
+    
+    // A throwing completion callback is contained; the worker keeps going
+    FulfillmentConfig throwingConfig;
+    throwingConfig.workerCount = 1;
+    throwingConfig.onComplete = [](const FulfillmentJob&, FulfillmentStatus) {
+        throw std::runtime_error("callback bug");
+    };
+    FulfillmentBackend quietBackend;
+    quietBackend.shipBatch = [](const std::vector<std::string>&) { return std::vector<size_t>(); };
+    quietBackend.sendEmailBatch = [](const std::vector<std::string>&) { return std::vector<size_t>(); };
+    FulfillmentPipeline throwing(throwingConfig, quietBackend);
+    assert(throwing.submit({DeliveryChannel::Shipping, "Cairo, Egypt", "", 0, {}}).get() == FulfillmentStatus::Delivered);
+    assert(throwing.submit({DeliveryChannel::Shipping, "Cairo, Egypt", "", 0, {}}).get() == FulfillmentStatus::Delivered);
+    
+    std::cout << "✓ asyncFulfillment test passed" << std::endl;
+}
+
+namespace {
+
+// Book type defined outside the closed set of built-in kinds
+class AudioBook : public Book {
+public:
+    AudioBook() : Book("978-5555555555", "Audio Book", 2024, 19.99, "Narrator") {}
+    void processPurchase(const std::string&, const std::string&) const override {}
+    bool canBeSold() const override { return true; }
+    std::string getType() const override { return "Audio Book"; }
+};
+
+} // namespace
+
+void QuantumBookstoreFullTest::testBookKindDispatch() {
+    std::cout << "Testing tag-based book dispatch..." << std::endl;
+    PaperBook paperBook("978-0134685991", "Effective Modern C++", 2014, 45.99, "Scott Meyers", 10);
+    EBook ebook("978-1035024957", "Think Faster, Talk Smarter", 2023, 14.99, "Matt Abrahams", "PDF");
+    ShowcaseBook showcaseBook("978-9999999999", "Demo Book", 2023, 0.0, "Demo Author");
+    AudioBook audioBook;
+    
+    assert(paperBook.getKind() == BookKind::Paper);
+    assert(ebook.getKind() == BookKind::EBook);
+    assert(showcaseBook.getKind() == BookKind::Showcase);
+    assert(audioBook.getKind() == BookKind::Other);
+    
+    // The virtual getType() stays consistent with the constant kind names
+    assert(paperBook.getType() == bookKindName(BookKind::Paper));
+    assert(ebook.getType() == bookKindName(BookKind::EBook));
+    assert(showcaseBook.getType() == bookKindName(BookKind::Showcase));
+    
+    assert(asPaperBook(static_cast<Book*>(&paperBook)) == &paperBook);
+    assert(asPaperBook(static_cast<Book*>(&ebook)) == nullptr);
+    assert(asEBook(static_cast<const Book*>(&ebook)) == &ebook);
+    
+    auto describe = [](const Book& book) {
+        return visitBook(book, BookVisitor{
+            [](const PaperBook& paper) { return "stock " + std::to_string(paper.getStock()); },
+            [](const EBook& digital) { return "file " + std::string(digital.getFileType()); },
+            [](const ShowcaseBook&) { return std::string("showcase"); },
+            [](const Book& other) { return other.getType(); }
+        });
+    };
+    assert(describe(paperBook) == "stock 10");
+    assert(describe(ebook) == "file PDF");
+    assert(describe(showcaseBook) == "showcase");
+    assert(describe(audioBook) == "Audio Book");
+    
+    std::cout << "✓ bookKindDispatch test passed" << std::endl;
+}
+
+void QuantumBookstoreFullTest::testColumnarScans() {
+    std::cout << "Testing columnar catalog scans..." << std::endl;
+    
+    // 150 rows: two full 64-row words plus a scalar tail
+    std::vector<std::unique_ptr<Book>> books;
+    ColumnarCatalog columns;
+    for (int i = 0; i < 150; ++i) {
+        std::string isbn = "978-" + std::to_string(1000000000 + i);
+        if (i % 3 == 0) {
+            books.push_back(std::make_unique<PaperBook>(isbn, "Paper", 1990 + i % 35, 5.0 + i % 40, "Author", i % 4));
+        } else if (i % 3 == 1) {
+            books.push_back(std::make_unique<EBook>(isbn, "Digital", 1990 + i % 35, 5.0 + i % 40, "Author", "EPUB"));
+        } else {
+            books.push_back(std::make_unique<ShowcaseBook>(isbn, "Showcase", 1990 + i % 35, 5.0 + i % 40, "Author"));
+        }
+        columns.append(*books.back());
+    }
+    
+    // Every vectorized scan agrees with the equivalent per-book predicate
+    auto expectMatches = [&columns](const ColumnarCatalog::Bitmask& mask, 
+                                    const std::function<bool(const Book&)>& predicate) {
+        assert(mask == columns.selectWhere(predicate));
+    };
+    expectMatches(columns.selectPublishedBefore(2005), 
+        [](const Book& book) { return book.getYearPublished() < 2005; });
+    expectMatches(columns.selectPriceRange(10.0, 20.0), 
+        [](const Book& book) { return book.getPrice() >= 10.0 && book.getPrice() <= 20.0; });
+    expectMatches(columns.selectKind(BookKind::EBook), 
+        [](const Book& book) { return book.getKind() == BookKind::EBook; });
+    expectMatches(columns.selectOutOfStock(), 
+        [](const Book& book) { return asPaperBook(&book) && asPaperBook(&book)->getStock() == 0; });
+    
+    ColumnarCatalog::Bitmask cheapEbooks = columns.selectKind(BookKind::EBook);
+    ColumnarCatalog::intersect(cheapEbooks, columns.selectPriceRange(0.0, 10.0));
+    size_t expectedCheapEbooks = ColumnarCatalog::countSelected(cheapEbooks);
+    
+    // Compaction removes the selected rows and keeps the rest in order
+    ColumnarCatalog::Bitmask old = columns.selectPublishedBefore(2000);
+    size_t oldCount = ColumnarCatalog::countSelected(old);
+    std::vector<Book*> removed = columns.compact(old);
+    assert(removed.size() == oldCount);
+    assert(columns.size() == 150 - oldCount);
+    assert(ColumnarCatalog::countSelected(columns.selectPublishedBefore(2000)) == 0);
+    for (size_t row = 1; row < columns.size(); ++row) {
+        assert(columns.bookAt(row - 1)->getISBN() < columns.bookAt(row)->getISBN());
+    }
+    assert(expectedCheapEbooks > 0);
+    
+    // Store-level filters and removeOutdated run on the per-shard columns
+    QuantumBookstore store(4);
+    store.addBook(std::make_unique<PaperBook>("978-1111111111", "Old Book", 2000, 25.99, "Old Author", 1));
+    store.addBook(std::make_unique<PaperBook>("978-2222222222", "New Book", 2020, 55.99, "New Author", 10));
+    store.addBook(std::make_unique<EBook>("978-3333333333", "New EBook", 2021, 9.99, "New Author", "PDF"));
+    assert(store.findBooksInPriceRange(20.0, 60.0).size() == 2);
+    assert(store.findBooksByKind(BookKind::EBook).size() == 1);
+    assert(store.findOutOfStock().empty());
+    store.buyBook("978-1111111111", 1, "test@test.com", "Cairo, Egypt");
+    assert(store.findOutOfStock().size() == 1);
+    
+    auto outdated = store.removeOutdated(2025, 20);
+    assert(outdated.size() == 1 && outdated[0]->getTitle() == "Old Book");
+    assert(store.findBook("978-1111111111") == nullptr);
+    assert(store.findOutOfStock().empty());
+    assert(store.getInventorySize() == 2);
+    
+    std::cout << "✓ columnarScans test passed (" << ColumnarCatalog::simdLevel() << ")" << std::endl;
+}
+
+void QuantumBookstoreFullTest::testSecondaryIndexes() {
+    std::cout << "Testing secondary indexes..." << std::endl;
+    QuantumBookstore store;
+    
+    store.addBook(std::make_unique<PaperBook>("978-0134685991", 
+        "Effective Modern C++", 2014, 45.99, "Scott Meyers", 1));
+    store.addBook(std::make_unique<PaperBook>("978-0321334879", 
+        "Effective C++", 2005, 39.99, "Scott Meyers", 3));
+    store.addBook(std::make_unique<PaperBook>("978-0321714114", 
+        "C++ Primer", 2012, 59.99, "Stanley Lippman", 0));
+    store.addBook(std::make_unique<EBook>("978-1035024957", 
+        "Think Faster, Talk Smarter", 2023, 14.99, "Matt Abrahams", "PDF"));
+    
+    std::vector<std::string> titles;
+    for (Book* book : store.findBooksByAuthor("Scott Meyers")) {
+        titles.emplace_back(book->getTitle());
+    }
+    std::sort(titles.begin(), titles.end());
+    assert((titles == std::vector<std::string>{"Effective C++", "Effective Modern C++"}));
+    assert(store.findBooksByAuthor("Unknown Author").empty());
+    
+    // Ordered ranges come back sorted by their key
+    std::vector<int> years;
+    for (Book* book : store.findBooksPublishedBetween(2005, 2014)) {
+        years.push_back(book->getYearPublished());
+    }
+    assert((years == std::vector<int>{2005, 2012, 2014}));
+    assert(store.findBooksPublishedBetween(2014, 2005).empty());
+    
+    std::vector<double> prices;
+    for (Book* book : store.findBooksInPriceRange(14.99, 45.99)) {
+        prices.push_back(book->getPrice());
+    }
+    assert((prices == std::vector<double>{14.99, 39.99, 45.99}));
+    
+    // The sold-out view follows purchases
+    assert(store.findOutOfStock().size() == 1);
+    store.buyBook("978-0134685991", 1, "test@test.com", "Cairo, Egypt");
+    assert(store.findOutOfStock().size() == 2);
+    store.buyBooks({{"978-0321334879", 3}}, "test@test.com", "Cairo, Egypt");
+    assert(store.findOutOfStock().size() == 3);
+    
+    // removeOutdated splits the year index and keeps every index consistent
+    auto outdated = store.removeOutdated(2025, 15);
+    assert(outdated.size() == 1 && outdated[0]->getTitle() == "Effective C++");
+    assert(store.findBooksByAuthor("Scott Meyers").size() == 1);
+    assert(store.findBooksPublishedBetween(0, 3000).size() == 3);
+    assert(store.findBooksInPriceRange(0.0, 100.0).size() == 3);
+    assert(store.findOutOfStock().size() == 2);
+    
+    // A range holds no index lock, so the store can change while iterating
+    size_t visited = 0;
+    for (Book* book : store.findBooksInPriceRange(0.0, 100.0)) {
+        if (book->getKind() == BookKind::Paper && asPaperBook(book)->getStock() > 0) {
+            store.buyBook(std::string(book->getISBN()), 1, "test@test.com", "Cairo, Egypt");
+        }
+        store.removeOutdated(2025, 0);
+        ++visited;
+    }
+    assert(visited == 3 && store.getInventorySize() == 0);
+    
+    // NaN prices sort last, so they can be removed and fall in no range
+    QuantumBookstore oddPrices;
+    oddPrices.addEBook("978-0000000001", "Unpriced", 2020, std::nan(""), "Author", "PDF");
+    oddPrices.addEBook("978-0000000002", "Priced", 2020, 5.0, "Author", "PDF");
+    oddPrices.addEBook("978-0000000003", "Also Unpriced", 2020, std::nan(""), "Author", "PDF");
+    assert(oddPrices.findBooksInPriceRange(0.0, INFINITY).size() == 1);
+    assert(oddPrices.findBooksInPriceRange(std::nan(""), std::nan("")).empty());
+    assert(oddPrices.removeOutdated(2025, 0).size() == 3);
+    assert(oddPrices.findBooksByAuthor("Author").empty() && oddPrices.findBooksInPriceRange(-INFINITY, INFINITY).empty());
+    
+    // One book among many sharing its keys is removed on its own
+    CatalogIndex index;
+    std::vector<std::unique_ptr<PaperBook>> volumes;
+    for (int i = 0; i < 1000; ++i) {
+        volumes.push_back(std::make_unique<PaperBook>("978-3" + std::to_string(100000000 + i), 
+            "Volume", 2000, 10.0, "Prolific Author", 1));
+        index.add(volumes.back().get());
+    }
+    index.remove(volumes[500].get());
+    assert(index.byAuthor("Prolific Author").size() == 999);
+    assert(index.publishedBetween(2000, 2000).size() == 999 && index.pricedBetween(10.0, 10.0).size() == 999);
+    for (Book* book : index.byAuthor("Prolific Author")) {
+        assert(book != volumes[500].get());
+    }
+    PaperBook firstEdition("978-3999999999", "First Edition", 1990, 10.0, "Prolific Author", 1);
+    index.add(&firstEdition);
+    std::vector<Book*> taken = index.takePublishedBefore(2001, 10);
+    assert(taken.size() == 10 && taken[0] == &firstEdition);
+    assert(index.byAuthor("Prolific Author").size() == 990 && index.pricedBetween(10.0, 10.0).size() == 990);
+    
+    std::cout << "✓ secondaryIndexes test passed" << std::endl;
+}
+
+void QuantumBookstoreFullTest::testFullTextSearch() {
+    std::cout << "Testing full-text search..." << std::endl;
+    QuantumBookstore store;
+    
+    store.addBook(std::make_unique<PaperBook>("978-0134685991", 
+        "Effective Modern C++", 2014, 45.99, "Scott Meyers", 10));
+    store.addBook(std::make_unique<PaperBook>("978-0321334879", 
+        "Effective C++", 2005, 39.99, "Scott Meyers", 3));
+    store.addBook(std::make_unique<EBook>("978-0132350884", 
+        "Clean Code", 2008, 29.99, "Robert C. Martin", "EPUB"));
+    store.addBook(std::make_unique<EBook>("978-1000000000", 
+        "Modern Scott Family Recipes", 2024, 9.99, "Jane Doe", "PDF"));
+    
+    assert(SearchIndex::tokenize("Effective, MODERN c++!") == 
+           (std::vector<std::string>{"c", "effective", "modern"}));
+    
+    // Terms are ANDed and matching is case-insensitive
+    auto hits = store.searchBooks("effective MODERN");
+    assert(hits.size() == 1 && hits[0].book->getISBN() == "978-0134685991");
+    assert(store.searchBooks("effective clean").empty());
+    assert(store.searchBooks("").empty());
+    
+    // Prefix terms expand to every matching word
+    assert(store.searchBooks("eff*").size() == 2);
+    assert(store.searchBooks("mar* code").size() == 1);
+    
+    // Title matches outrank author matches
+    hits = store.searchBooks("scott");
+    assert(hits.size() == 3);
+    assert(hits[0].book->getTitle() == "Modern Scott Family Recipes");
+    assert(hits[0].score > hits[1].score);
+    assert(store.searchBooks("scott", 2).size() == 2);
+    
+    // Removed books drop out of results
+    store.removeOutdated(2025, 15);
+    hits = store.searchBooks("effective");
+    assert(hits.size() == 1 && hits[0].book->getISBN() == "978-0134685991");
+    assert(store.searchBooks("clean").empty());
+    
+    std::cout << "✓ fullTextSearch test passed" << std::endl;
+}
+
+namespace {
+
+std::string readAll(std::FILE* file) {
+    std::string contents;
+    std::rewind(file);
+    char chunk[4096];
+    size_t read;
+    while ((read = std::fread(chunk, 1, sizeof(chunk), file)) > 0) {
+        contents.append(chunk, read);
+    }
+    return contents;
+}
+
+} // namespace
+
+void QuantumBookstoreFullTest::testAsyncLogging() {
+    std::cout << "Testing asynchronous logging..." << std::endl;
+    std::FILE* capture = std::tmpfile();
+    assert(capture != nullptr);
+    
+    {
+        Logger logger;
+        logger.setOutput(capture);
+        
+        // Placeholders are filled in order; extra placeholders print nothing
+        logger.log<LogLevel::Info>("Store", "Sold {} of '{}' for ${} ({})", 3, std::string("Clean Code"), 89.97, true);
+        logger.log<LogLevel::Info>(nullptr, "bare {}{}", 7u);
+        
+        // Large prices print in fixed notation; long strings are not cut
+        std::string longTitle(300, 'x');
+        logger.log<LogLevel::Info>(nullptr, "price {} {} {}", 1234567.5, 2.0, -0.25);
+        logger.log<LogLevel::Info>(nullptr, "title {} {}", longTitle, 1, longTitle);
+        
+        // Runtime level filtering
+        logger.setLevel(LogLevel::Warning);
+        logger.log<LogLevel::Info>("Store", "filtered");
+        logger.log<LogLevel::Error>("Store", "kept");
+        logger.setLevel(LogLevel::Debug);
+        
+        // Every thread gets its own ring; nothing is lost or torn
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 4; ++t) {
+            threads.emplace_back([&logger, t]() {
+                for (int i = 0; i < 2000; ++i) {
+                    logger.log<LogLevel::Debug>("T", "{} {}", t, i);
+                }
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        logger.flush();
+        
+        std::string output = readAll(capture);
+        assert(output.find("Store: Sold 3 of 'Clean Code' for $89.97 (true)\n") != std::string::npos);
+        assert(output.find("bare 7\n") != std::string::npos);
+        assert(output.find("price 1234567.5 2 -0.25\n") != std::string::npos);
+        assert(output.find("title " + longTitle + " 1\n") != std::string::npos);
+        assert(output.find("filtered") == std::string::npos);
+        assert(output.find("Store: kept\n") != std::string::npos);
+        assert(std::count(output.begin(), output.end(), '\n') == 5 + 4 * 2000);
+        assert(output.find("T: 3 1999\n") != std::string::npos);
+    }
+    std::fclose(capture);
+    
+    // The store's inventory dump goes through the global logger and is
+    // complete when printInventory returns
+    capture = std::tmpfile();
+    Logger& global = Logger::global();
+    global.setOutput(capture);
+    {
+        QuantumBookstore store;
+        store.addBook(std::make_unique<PaperBook>("978-0134685991", 
+            "Effective Modern C++", 2014, 45.99, "Scott Meyers", 10));
+        store.addBook(std::make_unique<EBook>("978-0132350884", 
+            "Clean Code", 2008, 29.99, "Robert C. Martin", "EPUB"));
+        
+        global.setLevel(LogLevel::Info);
+        store.buyBook("978-0132350884", 1, "reader@example.com", "");
+        global.setLevel(LogLevel::Debug);
+        store.printInventory();
+    }
+    std::string output = readAll(capture);
+    global.setOutput(stdout);
+    std::fclose(capture);
+    
+    assert(output.find("Quantum book store: Added book with ISBN: 978-0132350884\n") != std::string::npos);
+    assert(output.find("Successfully sold") == std::string::npos);  // sales are Debug
+    assert(output.find("Quantum book store: Current Inventory:\n") != std::string::npos);
+    assert(output.find("  ISBN: 978-0134685991, Title: Effective Modern C++, Author: Scott Meyers, "
+                       "Year: 2014, Price: $45.99, Type: Paper Book, Stock: 10\n") != std::string::npos);
+    assert(output.find("Type: EBook, File Type: EPUB\n") != std::string::npos);
+    
+    std::cout << "✓ asyncLogging test passed" << std::endl;
+}
+
+void QuantumBookstoreFullTest::testArenaBooks() {
+    std::cout << "Testing arena-backed books..." << std::endl;
+    
+    // Authors and file types are interned; ISBNs and titles are copied in
+    BookArena arena;
+    std::string author = "Scott Meyers";
+    BookPtr first = arena.makeEBook("978-0000000001", "Effective C++", 2005, 39.99, author, "PDF");
+    BookPtr second = arena.makeEBook("978-0000000002", "Effective STL", 2001, 35.99, author, "PDF");
+    author = "Someone Else";
+    assert(first->isArenaAllocated());
+    assert(first->getAuthorName() == "Scott Meyers");
+    assert(first->getAuthorName().data() == second->getAuthorName().data());
+    assert(asEBook(first.get())->getFileType().data() == asEBook(second.get())->getFileType().data());
+    assert(arena.getBookCount() == 2);
+    assert(arena.getInternedCount() == 2);
+    
+    // Heap-built books own their text and are left alone by detach
+    BookPtr heapBook = std::make_unique<EBook>("978-0000000003", "Heap Book", 2020, 5.0, "A. Writer", "EPUB");
+    assert(!heapBook->isArenaAllocated());
+    assert(asEBook(heapBook.get())->getFileType() == "EPUB");
+    Book* heapAddress = heapBook.get();
+    EpochReclaimer epochs;  // destroyed before the arena
+    assert(arena.detach(std::move(heapBook), epochs).get() == heapAddress);
+    
+    // An arena book's copy is independent; the original is retired, not kept
+    BookPtr copy = arena.detach(std::move(second), epochs);
+    assert(!copy->isArenaAllocated() && copy->getTitle() == "Effective STL");
+    assert(epochs.pendingCount() == 1);
+    while (epochs.collect() == 0) {}
+    assert(epochs.pendingCount() == 0);
+    
+    std::vector<BookPtr> outdated;
+    {
+        QuantumBookstore store;
+        store.addPaperBook("978-0134685991", "Effective Modern C++", 2014, 45.99, "Scott Meyers", 10);
+        store.addEBook("978-0132350884", "Clean Code", 2008, 29.99, "Robert C. Martin", "EPUB");
+        store.addShowcaseBook("978-9999999999", "Demo Book", 2023, 0.0, "Demo Author");
+        assert(store.getInventorySize() == 3);
+        
+        // Arena books behave like heap-built ones
+        assert(std::abs(store.buyBook("978-0134685991", 3, "reader@example.com", "Cairo") - 137.97) < 0.01);
+        assert(asPaperBook(store.findBook("978-0134685991"))->getStock() == 7);
+        assert(store.searchBooks("clean code").size() == 1);
+        assert(store.findBooksByAuthor("Scott Meyers").size() == 1);
+        
+        // Duplicates are still rejected
+        bool threw = false;
+        try {
+            store.addEBook("978-0132350884", "Clean Code", 2008, 29.99, "Robert C. Martin", "EPUB");
+        } catch (const std::invalid_argument&) {
+            threw = true;
+        }
+        assert(threw);
+        
+        outdated = store.removeOutdated(2025, 12);
+        assert(store.getInventorySize() == 2);
+    }
+    
+    // Removed books are heap copies that outlive the store and its arena
+    assert(outdated.size() == 1);
+    assert(!outdated[0]->isArenaAllocated());
+    assert(outdated[0]->getTitle() == "Clean Code");
+    assert(outdated[0]->getAuthorName() == "Robert C. Martin");
+    assert(asEBook(outdated[0].get())->getFileType() == "EPUB");
+    
+    std::cout << "✓ arenaBooks test passed" << std::endl;
+}
+
+void QuantumBookstoreFullTest::testIsbnKeys() {
+    std::cout << "Testing packed ISBN keys..." << std::endl;
+    
+    // Any hyphenation packs to the same key; the formats stay distinct
+    uint64_t key = IsbnCodec::pack("978-0-13-468599-1");
+    assert(key != IsbnCodec::INVALID_KEY);
+    assert(IsbnCodec::pack("9780134685991") == key);
+    assert(IsbnCodec::pack("978 0134685991") == key);
+    assert(IsbnCodec::unpack(key) == "9780134685991");
+    assert(IsbnCodec::pack("0-8044-2957-X") == IsbnCodec::pack("080442957x"));
+    assert(IsbnCodec::unpack(IsbnCodec::pack("0-8044-2957-X")) == "080442957X");
+    assert(IsbnCodec::pack("0134685997") != IsbnCodec::pack("9780134685997"));
+    
+    for (const char* bad : {"", "978", "978--0134685991", "-9780134685991", "9780134685991-", 
+                            "97801346859912", "978013468599X", "X134685997", "97801346a5991"}) {
+        assert(!IsbnCodec::isValid(bad));
+    }
+    assert(IsbnCodec::hasValidChecksum("978-0134685991"));
+    assert(IsbnCodec::hasValidChecksum("0-8044-2957-X"));
+    assert(!IsbnCodec::hasValidChecksum("978-0134685992"));
+    
+    // Flat map against a reference map under random insert/erase churn
+    FlatHashMap<int> flat;
+    std::unordered_map<uint64_t, int> reference;
+    std::mt19937_64 rng(7);
+    for (int op = 0; op < 20000; ++op) {
+        uint64_t k = rng() % 3000 + 1;
+        if (rng() % 3 == 0) {
+            assert(flat.erase(k) == (reference.erase(k) == 1));
+        } else {
+            auto result = flat.tryEmplace(k, op);
+            auto expected = reference.try_emplace(k, op);
+            assert(result.second == expected.second);
+            assert(*result.first == expected.first->second);
+        }
+    }
+    assert(flat.size() == reference.size());
+    for (const auto& pair : reference) {
+        assert(flat.find(pair.first) && *flat.find(pair.first) == pair.second);
+    }
+    
+    // A failed insert leaves no entry or column row behind
+    ShardedInventory inventory(4);
+    bool refused = false;
+    try {
+        inventory.insert(std::make_unique<PaperBook>("978-0134685991", "Refused", 2014, 1.0, "Someone", 1),
+                         [](const Book&) { throw std::runtime_error("log unavailable"); });
+    } catch (const std::runtime_error&) {
+        refused = true;
+    }
+    assert(refused && inventory.find("978-0134685991") == nullptr && inventory.size() == 0);
+    assert(inventory.insert(std::make_unique<PaperBook>("978-0134685991", "Kept", 2014, 1.0, "Someone", 1)));
+    std::vector<Book*> all = inventory.select([](const ColumnarCatalog& columns) {
+        return columns.selectPublishedBefore(3000);
+    });
+    assert(all.size() == 1 && all[0]->getTitle() == "Kept");
+    
+    // The store finds books by any spelling and rejects malformed ISBNs
+    QuantumBookstore store;
+    store.addBook(std::make_unique<PaperBook>("978-0134685991", 
+        "Effective Modern C++", 2014, 45.99, "Scott Meyers", 10));
+    assert(store.findBook("9780134685991") == store.findBook("978-0134685991"));
+    assert(store.findBook("not an isbn") == nullptr);
+    bool threw = false;
+    try {
+        store.addBook(std::make_unique<PaperBook>("9780134685991", "Duplicate", 2014, 1.0, "Someone", 1));
+    } catch (const std::invalid_argument&) {
+        threw = true;
+    }
+    assert(threw);
+    threw = false;
+    try {
+        store.addBook(std::make_unique<EBook>("12-34", "Bad ISBN", 2020, 1.0, "Someone", "PDF"));
+    } catch (const std::invalid_argument&) {
+        threw = true;
+    }
+    assert(threw);
+    assert(store.getInventorySize() == 1);
+    
+    std::cout << "✓ isbnKeys test passed" << std::endl;
+}
+
+void QuantumBookstoreFullTest::testSnapshots() {
+    std::cout << "Testing catalog snapshots..." << std::endl;
+    std::string path = (std::filesystem::temp_directory_path() / "quantum_bookstore_test.snapshot").string();
+    
+    {
+        QuantumBookstore store;
+        store.addBook(std::make_unique<PaperBook>("978-0134685991", 
+            "Effective Modern C++", 2014, 45.99, "Scott Meyers", 10));
+        store.addPaperBook("978-0321334879", "Effective C++", 2005, 39.99, "Scott Meyers", 1);
+        store.addEBook("978-0132350884", "Clean Code", 2008, 29.99, "Robert C. Martin", "EPUB");
+        store.addShowcaseBook("978-9999999999", "Demo Book", 2023, 0.0, "Demo Author");
+        store.buyBook("978-0134685991", 3, "reader@example.com", "Cairo");
+        store.buyBook("978-0321334879", 1, "reader@example.com", "Cairo");
+        // A pending hold is saved as available stock
+        StockReservation hold = asPaperBook(store.findBook("978-0134685991"))->tryReserve(2);
+        assert(hold);
+        store.saveSnapshot(path);
+        hold.release();
+        
+        // Custom book types have no snapshot encoding
+        store.addBook(std::make_unique<AudioBook>());
+        bool threw = false;
+        try {
+            store.saveSnapshot(path + ".custom");
+        } catch (const std::invalid_argument&) {
+            threw = true;
+        }
+        assert(threw);
+    }
+    
+    std::vector<BookPtr> outdated;
+    {
+        QuantumBookstore store;
+        store.loadSnapshot(path);
+        assert(store.getInventorySize() == 4);
+        
+        // Lookups and column scans are served from the mapped file
+        const PaperBook* paperBook = asPaperBook(store.findBook("978-0134685991"));
+        assert(paperBook && paperBook->isArenaAllocated());
+        assert(paperBook->getTitle() == "Effective Modern C++");
+        assert(paperBook->getAuthorName() == "Scott Meyers");
+        assert(paperBook->getStock() == 7);
+        assert(std::abs(paperBook->getPrice() - 45.99) < 1e-9);
+        const EBook* ebook = asEBook(store.findBook("978-0132350884"));
+        assert(ebook && ebook->getFileType() == "EPUB" && ebook->getYearPublished() == 2008);
+        assert(store.findBook("978-9999999999")->getKind() == BookKind::Showcase);
+        assert(store.findBooksByKind(BookKind::Paper).size() == 2);
+        
+        // Adds and sales do not wait for the background index build
+        store.addBook(std::make_unique<PaperBook>("978-1111111111", "Fresh Arrival", 2024, 9.99, "Scott Meyers", 1));
+        store.buyBook("978-1111111111", 1, "reader@example.com", "Cairo");
+        
+        // Secondary indexes come up in the background; queries wait for them
+        assert(store.findBooksByAuthor("Scott Meyers").size() == 3);
+        assert(store.searchBooks("clean").size() == 1);
+        {
+            auto soldOut = store.findOutOfStock();
+            assert(soldOut.size() == 2);
+            for (const Book* book : soldOut) {
+                assert(book->getISBN() == "978-0321334879" || book->getISBN() == "978-1111111111");
+            }
+        }
+        
+        // Stock changes stay in memory; the file is untouched
+        store.buyBook("978-0134685991", 7, "reader@example.com", "Cairo");
+        assert(paperBook->getStock() == 0);
+        
+        // Loading the same books again is rejected like a duplicate addBook
+        bool threw = false;
+        try {
+            store.loadSnapshot(path);
+        } catch (const std::invalid_argument&) {
+            threw = true;
+        }
+        assert(threw);
+        
+        outdated = store.removeOutdated(2025, 15);
+        assert(outdated.size() == 2);
+    }
+    // Removed books were copied out of the mapping before it went away
+    for (const auto& book : outdated) {
+        assert(!book->isArenaAllocated());
+        assert(book->getTitle() == "Effective C++" || book->getTitle() == "Clean Code");
+    }
+    
+    // Corrupt and missing files are rejected
+    {
+        std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+        file.seekp(100);
+        file.put('\x7f');
+    }
+    for (const std::string& bad : {path, path + ".missing"}) {
+        QuantumBookstore store;
+        bool threw = false;
+        try {
+            store.loadSnapshot(bad);
+        } catch (const std::runtime_error&) {
+            threw = true;
+        }
+        assert(threw);
+        assert(store.getInventorySize() == 0);
+    }
+    std::filesystem::remove(path);
+    
+    std::cout << "✓ snapshots test passed" << std::endl;
+}
+
+namespace {
+
+// Paper book whose courier never comes
+class UndeliverableBook : public PaperBook {
+public:
+    UndeliverableBook() : PaperBook("978-7777777777", "Lost Parcel", 2024, 8.0, "Courier", 5) {}
+    void processPurchase(const std::string&, const std::string&) const override {
+        throw std::runtime_error("Courier unavailable");
+    }
+};
+
+} // namespace
+
+void QuantumBookstoreFullTest::testWriteAheadLog() {
+    std::cout << "Testing write-ahead log..." << std::endl;
+    std::filesystem::path directory = std::filesystem::temp_directory_path();
+    std::string logPath = (directory / "quantum_bookstore_test.wal").string();
+    std::string snapshotPath = (directory / "quantum_bookstore_test_wal.snapshot").string();
+    std::filesystem::remove(logPath);
+    std::filesystem::remove(snapshotPath);
+    
+    {
+        QuantumBookstore store;
+        assert(store.openWriteAheadLog(logPath) == 0);
+        store.addBook(std::make_unique<PaperBook>("978-0134685991", 
+            "Effective Modern C++", 2014, 45.99, "Scott Meyers", 10));
+        store.addEBook("978-0132350884", "Clean Code", 2008, 29.99, "Robert C. Martin", "EPUB");
+        store.addPaperBook("978-0201633610", "Design Patterns", 1994, 54.99, "Erich Gamma", 5);
+        store.addPaperBook("978-1111111111", "Busy Book", 2020, 5.0, "Busy Author", 400);
+        store.buyBook("978-0134685991", 3, "reader@example.com", "Cairo");
+        store.buyBooks({{"978-0134685991", 2}, {"978-0132350884", 1}, {"978-0201633610", 5}}, 
+                       "reader@example.com", "Cairo");
+        
+        // Concurrent buyers share syncs
+        std::vector<std::thread> buyers;
+        for (int t = 0; t < 4; ++t) {
+            buyers.emplace_back([&store]() {
+                for (int i = 0; i < 25; ++i) {
+                    store.buyBook("978-1111111111", 1, "reader@example.com", "Cairo");
+                }
+            });
+        }
+        for (auto& buyer : buyers) {
+            buyer.join();
+        }
+        
+        // Custom types have no log encoding and are not added
+        bool threw = false;
+        try {
+            store.addBook(std::make_unique<AudioBook>());
+        } catch (const std::invalid_argument&) {
+            threw = true;
+        }
+        assert(threw && store.findBook("978-5555555555") == nullptr);
+        
+        // Snapshots go underneath the log, not on top of it
+        threw = false;
+        try {
+            store.loadSnapshot(snapshotPath);
+        } catch (const std::runtime_error&) {
+            threw = true;
+        }
+        assert(threw);
+    }
+    
+    // Restart: everything acknowledged comes back from the log alone
+    {
+        QuantumBookstore store;
+        assert(store.openWriteAheadLog(logPath) == 4 + 2 + 100);
+        assert(store.getInventorySize() == 4);
+        assert(asPaperBook(store.findBook("978-0134685991"))->getStock() == 5);
+        assert(asPaperBook(store.findBook("978-1111111111"))->getStock() == 300);
+        assert(asEBook(store.findBook("978-0132350884"))->getFileType() == "EPUB");
+        assert(store.findOutOfStock().size() == 1);
+        
+        // A checkpoint folds the log into a snapshot and empties it
+        auto outdated = store.removeOutdated(2025, 20);
+        assert(outdated.size() == 1 && outdated[0]->getTitle() == "Design Patterns");
+        store.checkpoint(snapshotPath);
+        assert(std::filesystem::file_size(logPath) == 0);
+        store.buyBook("978-0134685991", 1, "reader@example.com", "Cairo");
+    }
+    
+    // A torn record at the tail is ignored and overwritten
+    {
+        std::ofstream log(logPath, std::ios::binary | std::ios::app);
+        log.write("\x40\x00\x00\x00torn", 8);
+    }
+    for (int restart = 0; restart < 2; ++restart) {
+        QuantumBookstore store;
+        store.loadSnapshot(snapshotPath);
+        assert(store.openWriteAheadLog(logPath) == static_cast<size_t>(1 + restart));
+        assert(store.getInventorySize() == 3);
+        assert(store.findBook("978-0201633610") == nullptr);
+        assert(asPaperBook(store.findBook("978-0134685991"))->getStock() == 4 - restart);
+        assert(store.findBooksByAuthor("Scott Meyers").size() == 1);
+        store.buyBook("978-0134685991", 1, "reader@example.com", "Cairo");
+    }
+    
+    // Checkpoints under live sales: each sale is in the snapshot or in the
+    // log after it, never both or neither. A sale whose delivery fails
+    // after it was logged is logged back.
+    std::filesystem::remove(logPath);
+    std::filesystem::remove(snapshotPath);
+    {
+        QuantumBookstore store;
+        store.openWriteAheadLog(logPath);
+        store.addPaperBook("978-2222222222", "Checkpointed", 2024, 5.0, "Busy Author", 1000);
+        store.addBook(std::make_unique<UndeliverableBook>());
+        std::vector<std::thread> buyers;
+        for (int t = 0; t < 2; ++t) {
+            buyers.emplace_back([&store]() {
+                for (int i = 0; i < 100; ++i) {
+                    store.buyBook("978-2222222222", 1, "reader@example.com", "Cairo");
+                }
+            });
+        }
+        for (int i = 0; i < 5; ++i) {
+            store.checkpoint(snapshotPath);
+        }
+        for (auto& buyer : buyers) {
+            buyer.join();
+        }
+        bool threw = false;
+        try {
+            store.buyBook("978-7777777777", 2, "reader@example.com", "Cairo");
+        } catch (const std::runtime_error&) {
+            threw = true;
+        }
+        assert(threw && asPaperBook(store.findBook("978-7777777777"))->getStock() == 5);
+    }
+    {
+        QuantumBookstore store;
+        store.loadSnapshot(snapshotPath);
+        store.openWriteAheadLog(logPath);
+        assert(asPaperBook(store.findBook("978-2222222222"))->getStock() == 800);
+        assert(asPaperBook(store.findBook("978-7777777777"))->getStock() == 5);
+    }
+    
+    // A replayed removal of a hyphenated ISBN leaves it out of search too
+    std::filesystem::remove(logPath);
+    {
+        QuantumBookstore store;
+        store.openWriteAheadLog(logPath);
+        store.addPaperBook("978-0-306-40615-7", "Zebra Stripes", 1950, 9.99, "Zoe Zebra", 2);
+        assert(store.removeOutdated(2025, 50).size() == 1);
+    }
+    {
+        QuantumBookstore store;
+        assert(store.openWriteAheadLog(logPath) == 2);
+        assert(store.getInventorySize() == 0 && store.searchBooks("zebra").empty());
+    }
+    
+    std::filesystem::remove(logPath);
+    std::filesystem::remove(snapshotPath);
+    
+    std::cout << "✓ writeAheadLog test passed" << std::endl;
+}
+
+void QuantumBookstoreFullTest::testCatalogImport() {
+    std::cout << "Testing catalog import..." << std::endl;
+    std::filesystem::path directory = std::filesystem::temp_directory_path();
+    std::string csvPath = (directory / "quantum_bookstore_test_import.csv").string();
+    std::string jsonPath = (directory / "quantum_bookstore_test_import.jsonl").string();
+    {
+        std::ofstream csv(csvPath, std::ios::binary);
+        csv << "type,isbn,title,author,year,price,stock,file_type\n"                          // line 1
+            << "paper,978-0134685991,Effective Modern C++,Scott Meyers,2014,45.99,10,\n"       // 2
+            << "ebook,978-0132350884,\"Clean Code, \"\"Agile\"\" Edition\",Robert C. Martin,2008,29.99,,EPUB\n"
+            << "showcase,978-9999999999,Demo Book,Demo Author,2023,0,,\n"                      // 4
+            << "\n"                                                                             // 5
+            << "paper,978-0321334879,Effective C++,Scott Meyers,20x5,39.99,5,\n"               // 6
+            << "audio,978-0201633610,Design Patterns,Erich Gamma,1994,54.99,5,\n"              // 7
+            << "paper,9780134685991,Duplicate Title,Someone,2020,1.0,1,\r\n"                  // 8
+            << "paper,not-an-isbn,Bad Isbn,Someone,2020,1.0,1,\n"                              // 9
+            << "paper,978-1111111111,Existing Book,Someone,2020,1.0,1,\n"                      // 10
+            << "paper,978-0201633610,\"Design Patterns\",Erich Gamma,1994,54.99,0,\r\n";      // 11
+    }
+    
+    QuantumBookstore store;
+    store.addPaperBook("978-1111111111", "Already Here", 2020, 1.0, "Someone", 1);
+    
+    // Tiny chunks so the file is split and parsed by several threads
+    ImportOptions options;
+    options.threads = 3;
+    options.chunkBytes = 64;
+    ImportReport report = store.importCatalog(csvPath, options);
+    assert(report.rowsRead == 9);
+    assert(report.booksAdded == 4);
+    assert(store.getInventorySize() == 5);
+    std::vector<size_t> errorLines;
+    for (const auto& error : report.errors) {
+        errorLines.push_back(error.line);
+    }
+    assert((errorLines == std::vector<size_t>{6, 7, 8, 9, 10}));
+    assert(report.errors[0].message == "Invalid year '20x5'");
+    assert(report.errors[1].message == "Unknown book type 'audio'");
+    assert(report.errors[2].message == "Duplicate ISBN 9780134685991");
+    assert(report.errors[3].message == "Invalid ISBN 'not-an-isbn'");
+    
+    // The first row of a duplicated ISBN is kept
+    assert(store.findBook("978-0134685991")->getTitle() == "Effective Modern C++");
+    assert(store.findBook("978-1111111111")->getTitle() == "Already Here");
+    const EBook* ebook = asEBook(store.findBook("978-0132350884"));
+    assert(ebook && ebook->getTitle() == "Clean Code, \"Agile\" Edition" && ebook->getFileType() == "EPUB");
+    assert(store.findBook("978-9999999999")->getKind() == BookKind::Showcase);
+    assert(store.findBooksByAuthor("Scott Meyers").size() == 1);
+    assert(store.searchBooks("agile").size() == 1);
+    assert(store.findOutOfStock().size() == 1);
+    
+    {
+        std::ofstream json(jsonPath, std::ios::binary);
+        json << "{\"type\": \"paper\", \"isbn\": \"978-0596007126\", \"title\": \"Head First Design Patterns\", "
+                "\"author\": \"Eric Freeman\", \"year\": 2004, \"price\": 44.95, \"stock\": 3}\n"
+             << "{\"type\":\"ebook\",\"isbn\":\"978-1491950357\",\"title\":\"Caf\\u00e9 \\\"Scripts\\\"\","
+                "\"author\":\"Ana\",\"year\":2016,\"price\":9.5,\"stock\":null,\"fileType\":\"PDF\",\"extra\":true}\n"
+             << "{\"type\":\"paper\",\"isbn\":\"978-0262033848\"\n"
+             << "{\"type\":\"paper\",\"isbn\":\"978-0262033848\",\"title\":\"CLRS\",\"author\":\"Cormen\","
+                "\"year\":2009,\"price\":80,\"stock\":-1}\n";
+    }
+    report = store.importCatalog(jsonPath);
+    assert(report.rowsRead == 4 && report.booksAdded == 2);
+    assert(report.errors.size() == 2 && report.errors[0].line == 3 && report.errors[1].line == 4);
+    assert(report.errors[1].message == "Invalid stock '-1'");
+    assert(asPaperBook(store.findBook("978-0596007126"))->getStock() == 3);
+    assert(store.findBook("978-1491950357")->getTitle() == "Caf\xc3\xa9 \"Scripts\"");
+    
+    // File-level problems throw
+    bool threw = false;
+    try {
+        store.importCatalog(csvPath + ".missing");
+    } catch (const std::runtime_error&) {
+        threw = true;
+    }
+    assert(threw);
+    
+    std::filesystem::remove(csvPath);
+    std::filesystem::remove(jsonPath);
+    
+    std::cout << "✓ catalogImport test passed" << std::endl;
+}
+
+void QuantumBookstoreFullTest::testMetrics() {
+    std::cout << "Testing metrics..." << std::endl;
+    
+    // Histogram buckets: exact below 16 ns, then within 1/16 of the value
+    assert(LatencyHistogram::bucketFor(5) == 5);
+    for (uint64_t value : {16ull, 17ull, 100ull, 1000ull, 123456789ull}) {
+        size_t bucket = LatencyHistogram::bucketFor(value);
+        assert(LatencyHistogram::bucketLowerBound(bucket) <= value);
+        assert(value < LatencyHistogram::bucketLowerBound(bucket + 1));
+        assert(value - LatencyHistogram::bucketLowerBound(bucket) <= value / 16);
+    }
+    LatencyHistogram histogram;
+    for (uint64_t value = 1; value <= 1000; ++value) {
+        histogram.record(value * 1000);
+    }
+    assert(histogram.count() == 1000 && histogram.maxNanos() == 1000000);
+    assert(histogram.percentile(0.5) >= 500000 && histogram.percentile(0.5) <= 500000 + 500000 / 16);
+    assert(histogram.percentile(1.0) == 1000000);
+    
+    QuantumBookstore store;
+    store.setMetricsSamplePeriod(StoreOp::FindBook, 1);
+    store.addPaperBook("978-0134685991", "Effective Modern C++", 2014, 45.99, "Scott Meyers", 10);
+    store.addEBook("978-0132350884", "Clean Code", 2008, 29.99, "Robert C. Martin", "EPUB");
+    store.addShowcaseBook("978-9999999999", "Demo Book", 1990, 0.0, "Demo Author");
+    
+    // Sales on two threads land in separate per-thread slots
+    std::thread buyer([&store]() {
+        store.buyBook("978-0134685991", 2, "reader@example.com", "Cairo");
+    });
+    buyer.join();
+    store.buyBook("978-0134685991", 1, "reader@example.com", "Cairo");
+    store.buyBooks({{"978-0132350884", 3}}, "reader@example.com", "Cairo");
+    auto expectFailure = [&store](const std::string& isbn, int quantity) {
+        bool threw = false;
+        try {
+            store.buyBook(isbn, quantity, "reader@example.com", "Cairo");
+        } catch (const std::exception&) {
+            threw = true;
+        }
+        assert(threw);
+    };
+    expectFailure("978-0134685991", 0);
+    expectFailure("978-0134685991", 100);
+    expectFailure("978-9999999999", 1);
+    expectFailure("978-0000000002", 1);
+    for (int i = 0; i < 5; ++i) {
+        assert(store.findBook("978-0132350884") != nullptr);
+    }
+    assert(store.removeOutdated(2025, 30).size() == 1);
+    
+    MetricsSnapshot metrics = store.getMetrics();
+    assert(metrics.callCount(StoreOp::AddBook) == 3);
+    assert(metrics.callCount(StoreOp::BuyBook) == 6 && metrics.latencyOf(StoreOp::BuyBook).count() == 6);
+    assert(metrics.callCount(StoreOp::FindBook) == 5 && metrics.latencyOf(StoreOp::FindBook).count() == 5);
+    assert(metrics.failureCount(StoreFailure::InvalidQuantity) == 1);
+    assert(metrics.failureCount(StoreFailure::InsufficientStock) == 1);
+    assert(metrics.failureCount(StoreFailure::NotForSale) == 1);
+    assert(metrics.failureCount(StoreFailure::UnknownIsbn) == 1);
+    assert(metrics.soldOf(BookKind::Paper) == 3 && metrics.soldOf(BookKind::EBook) == 3);
+    assert(metrics.booksRemoved == 1);
+    assert(metrics.inventorySize == 2 && metrics.totalStock == 7);
+    
+    // Lookups are sampled by default, but every call is counted
+    QuantumBookstore sampled;
+    for (int i = 0; i < 256; ++i) {
+        sampled.findBook("978-0134685991");
+    }
+    MetricsSnapshot lookups = sampled.getMetrics();
+    assert(lookups.callCount(StoreOp::FindBook) == 256);
+    assert(lookups.latencyOf(StoreOp::FindBook).count() == 256 / StoreMetrics::DEFAULT_LOOKUP_SAMPLE_PERIOD);
+    
+    // Snapshots of several stores merge
+    lookups.merge(metrics);
+    assert(lookups.callCount(StoreOp::FindBook) == 261 && lookups.inventorySize == 2);
+    
+    std::string text = store.exportMetrics();
+    assert(text.find("# TYPE quantum_bookstore_latency_seconds histogram") != std::string::npos);
+    assert(text.find("quantum_bookstore_calls_total{op=\"buyBook\"} 6") != std::string::npos);
+    assert(text.find("quantum_bookstore_latency_seconds_count{op=\"buyBook\"} 6") != std::string::npos);
+    assert(text.find("quantum_bookstore_latency_seconds_bucket{op=\"buyBook\",le=\"+Inf\"} 6") != std::string::npos);
+    assert(text.find("quantum_bookstore_failures_total{reason=\"not_for_sale\"} 1") != std::string::npos);
+    assert(text.find("quantum_bookstore_units_sold_total{kind=\"paper\"} 3") != std::string::npos);
+    assert(text.find("quantum_bookstore_inventory_stock 7") != std::string::npos);
+    
+    std::cout << "✓ Metrics test passed" << std::endl;
+}
+
+void QuantumBookstoreFullTest::testLoadGenerator() {
+    std::cout << "Testing load generator..." << std::endl;
+    
+    // Zipfian ranks stay in range and favour the head
+    ZipfianGenerator zipf(1000, 0.99);
+    std::mt19937_64 random(7);
+    std::vector<size_t> hits(1000, 0);
+    for (int i = 0; i < 100000; ++i) {
+        size_t rank = zipf.next(random);
+        assert(rank < 1000);
+        ++hits[rank];
+    }
+    assert(hits[0] > hits[1] && hits[1] > hits[10] && hits[10] > hits[500]);
+    assert(hits[0] > 100000 / 10);
+    bool threw = false;
+    try {
+        ZipfianGenerator(10, 1.0);
+    } catch (const std::invalid_argument&) {
+        threw = true;
+    }
+    assert(threw);
+    
+    // Generation is deterministic and open-loop starts follow the rate
+    LoadConfig config;
+    config.catalogSize = 2000;
+    config.operations = 20000;
+    config.clients = 1;
+    config.initialStock = 3;
+    LoadTrace trace = LoadGenerator::generate(config);
+    LoadTrace again = LoadGenerator::generate(config);
+    assert(trace.ops.size() == 20000);
+    size_t counts[LOAD_OP_TYPE_COUNT] = {};
+    for (size_t i = 0; i < trace.ops.size(); ++i) {
+        const LoadOp& op = trace.ops[i];
+        const LoadOp& other = again.ops[i];
+        assert(op.type == other.type && op.book == other.book && op.arg == other.arg);
+        ++counts[static_cast<size_t>(op.type)];
+        if (op.type == LoadOpType::BuyBook || op.type == LoadOpType::FindBook) {
+            assert(op.book < config.catalogSize);
+        } else if (op.type == LoadOpType::AddBook) {
+            assert(op.book >= config.catalogSize && LoadGenerator::kindOf(op.book, config) == BookKind::Paper);
+        }
+    }
+    assert(counts[static_cast<size_t>(LoadOpType::BuyBook)] > counts[static_cast<size_t>(LoadOpType::FindBook)]);
+    assert(counts[static_cast<size_t>(LoadOpType::AddBook)] > 0);
+    LoadConfig paced = config;
+    paced.ratePerSecond = 1000;
+    paced.operations = 3;
+    LoadTrace pacedTrace = LoadGenerator::generate(paced);
+    assert(pacedTrace.ops[1].intendedNanos == 1000000 && pacedTrace.ops[2].intendedNanos == 2000000);
+    
+    // Traces round-trip through a file
+    std::string tracePath = (std::filesystem::temp_directory_path() / "quantum_bookstore_test.trace").string();
+    LoadGenerator::writeTrace(tracePath, trace);
+    LoadTrace loaded = LoadGenerator::readTrace(tracePath);
+    assert(loaded.ops.size() == trace.ops.size());
+    assert(loaded.config.catalogSize == 2000 && loaded.config.initialStock == 3 && loaded.config.seed == 42);
+    for (size_t i = 0; i < trace.ops.size(); ++i) {
+        assert(loaded.ops[i].type == trace.ops[i].type && loaded.ops[i].book == trace.ops[i].book &&
+               loaded.ops[i].arg == trace.ops[i].arg && loaded.ops[i].client == trace.ops[i].client);
+    }
+    
+    // With one client a replay reproduces the run exactly, sell-outs included
+    auto runOn = [](const LoadTrace& load, MetricsSnapshot& metrics) {
+        QuantumBookstore store;
+        LoadGenerator::buildCatalog(store, load.config);
+        LoadReport report = LoadGenerator::run(store, load);
+        metrics = store.getMetrics();
+        return report;
+    };
+    MetricsSnapshot firstMetrics;
+    MetricsSnapshot replayMetrics;
+    LoadReport first = runOn(trace, firstMetrics);
+    LoadReport replay = runOn(loaded, replayMetrics);
+    assert(first.totalCompleted() == 20000);
+    for (size_t type = 0; type < LOAD_OP_TYPE_COUNT; ++type) {
+        assert(first.byType[type].completed == replay.byType[type].completed);
+        assert(first.byType[type].rejected == replay.byType[type].rejected);
+        assert(first.byType[type].response.count() == first.byType[type].completed);
+    }
+    assert(first.of(LoadOpType::BuyBook).rejected > 0);
+    assert(firstMetrics.failureCount(StoreFailure::InsufficientStock) > 0);
+    assert(firstMetrics.failureCount(StoreFailure::NotForSale) > 0);
+    assert(firstMetrics.soldOf(BookKind::Paper) == replayMetrics.soldOf(BookKind::Paper));
+    assert(firstMetrics.totalStock == replayMetrics.totalStock);
+    std::filesystem::remove(tracePath);
+    
+    std::cout << "✓ Load generator test passed" << std::endl;
+}
+
+void QuantumBookstoreFullTest::testEpochSnapshots() {
+    std::cout << "Testing epoch-protected catalog views..." << std::endl;
+    
+    // A retired object survives while a reader pinned before the retirement
+    // is still pinned, and is destroyed two epochs after it unpins
+    EpochReclaimer reclaimer;
+    auto destroyed = std::make_shared<std::atomic<bool>>(false);
+    struct Tracked {
+        explicit Tracked(std::shared_ptr<std::atomic<bool>> flag) : flag(std::move(flag)) {}
+        ~Tracked() { flag->store(true); }
+        std::shared_ptr<std::atomic<bool>> flag;
+    };
+    {
+        auto guard = reclaimer.pin();
+        reclaimer.retire(std::make_shared<const Tracked>(destroyed));
+        for (int i = 0; i < 4; ++i) {
+            reclaimer.collect();
+        }
+        assert(!destroyed->load() && reclaimer.pendingCount() == 1);
+    }
+    size_t freed = 0;
+    for (int i = 0; i < 3; ++i) {
+        freed += reclaimer.collect();
+    }
+    assert(freed == 1 && destroyed->load() && reclaimer.pendingCount() == 0);
+    
+    QuantumBookstore store;
+    store.addPaperBook("978-0134685991", "Effective Modern C++", 2014, 45.99, "Scott Meyers", 10);
+    store.addEBook("978-0132350884", "Clean Code", 2008, 29.99, "Robert C. Martin", "EPUB");
+    store.addPaperBook("978-0201633610", "Design Patterns", 1994, 54.99, "Gang of Four", 3);
+    
+    // Views are shared until the inventory changes
+    uint64_t firstVersion;
+    {
+        CatalogView view = store.readView();
+        CatalogView same = store.readView();
+        assert(view.size() == 3 && same.version() == view.version());
+        firstVersion = view.version();
+        std::vector<std::string> isbns;
+        for (const Book* book : view) {
+            isbns.emplace_back(book->getISBN());
+        }
+        assert(std::is_sorted(isbns.begin(), isbns.end()));
+        assert(view.find("9780132350884") == store.findBook("978-0132350884"));
+        assert(view.find("978-0000000000") == nullptr);
+    }
+    
+    // An open view keeps removed books readable; the caller gets copies
+    {
+        CatalogView before = store.readView();
+        Book* old = before.find("978-0201633610");
+        auto removed = store.removeOutdated(2025, 20);
+        assert(removed.size() == 1 && removed[0].get() != old);
+        assert(removed[0]->getTitle() == "Design Patterns" && static_cast<PaperBook&>(*removed[0]).getStock() == 3);
+        assert(store.findBook("978-0201633610") == nullptr);
+        assert(old->getTitle() == "Design Patterns" && before.size() == 3);
+        CatalogView after = store.readView();
+        assert(after.version() > before.version() && after.version() > firstVersion);
+        assert(after.size() == 2 && after.find("978-0201633610") == nullptr);
+    }
+    
+    // Scans run against purchases and catalog churn without blocking them
+    std::atomic<bool> done{false};
+    std::thread scanner([&store, &done]() {
+        while (!done.load()) {
+            CatalogView view = store.readView();
+            size_t count = 0;
+            for (const Book* book : view) {
+                assert(!book->getTitle().empty());
+                ++count;
+            }
+            assert(count == view.size());
+        }
+    });
+    store.addPaperBook("978-0596007126", "Head First Design Patterns", 2020, 39.99, "Eric Freeman", 1000);
+    for (int i = 0; i < 200; ++i) {
+        std::string isbn = "978-1" + std::to_string(100000000 + i);
+        store.addPaperBook(isbn, "Churn", 1990, 1.0, "Author", 5);
+        store.buyBook("978-0596007126", 1, "reader@example.com", "Cairo");
+        if (i % 50 == 49) {
+            store.removeOutdated(2025, 20);
+        }
+    }
+    done.store(true);
+    scanner.join();
+    assert(store.readView().size() == store.getInventorySize());
+    
+    // A rebuild copies only the shards that changed
+    ShardedInventory shards(4);
+    for (int i = 0; i < 100; ++i) {
+        shards.insert(std::make_unique<PaperBook>("978-2" + std::to_string(100000000 + i), "Shard", 2020, 1.0, "A", 1));
+    }
+    std::vector<ShardedInventory::ShardEntries> taken;
+    shards.collect(taken);
+    std::vector<ShardedInventory::ShardEntries> before = taken;
+    shards.remove("978-2100000007");
+    assert(shards.collect(taken) == shards.version());
+    size_t recopied = 0;
+    size_t total = 0;
+    for (size_t i = 0; i < taken.size(); ++i) {
+        recopied += taken[i].entries != before[i].entries;
+        total += taken[i].entries->size();
+        assert(std::is_sorted(taken[i].entries->begin(), taken[i].entries->end()));
+    }
+    assert(recopied == 1 && total == 99);
+    
+    std::cout << "✓ Epoch-protected catalog view test passed" << std::endl;
+}
+
+void QuantumBookstoreFullTest::testCatalogExport() {
+    std::cout << "Testing catalog export..." << std::endl;
+    
+    QuantumBookstore store;
+    store.addPaperBook("978-0134685991", "Effective Modern C++", 2014, 45.99, "Scott Meyers", 10);
+    store.addEBook("978-0132350884", "Clean Code, \"2nd\" printing", 2008, 29.99, "Robert C. Martin", "EPUB");
+    store.addShowcaseBook("978-9999999999", "Demo Book", 1990, 0.0, "Demo Author");
+    store.addPaperBook("978-0201633610", "Design Patterns", 1994, 54.99, "Gang of Four", 3);
+    store.addEBook("978-0596007126", "Head First\tPatterns", 2004, 0.1, "Eric Freeman", "PDF");
+    
+    // CSV quotes fields with commas and quotes, in ISBN order
+    BufferSink csv;
+    assert(store.exportCatalog(csv, ExportFormat::Csv) == 5);
+    std::string expectedCsv = 
+        "type,isbn,title,author,year,price,stock,file_type\n"
+        "ebook,978-0132350884,\"Clean Code, \"\"2nd\"\" printing\",Robert C. Martin,2008,29.99,,EPUB\n"
+        "paper,978-0134685991,Effective Modern C++,Scott Meyers,2014,45.99,10,\n"
+        "paper,978-0201633610,Design Patterns,Gang of Four,1994,54.99,3,\n"
+        "ebook,978-0596007126,Head First\tPatterns,Eric Freeman,2004,0.1,,PDF\n"
+        "showcase,978-9999999999,Demo Book,Demo Author,1990,0,,\n";
+    assert(csv.data() == expectedCsv);
+    
+    // JSON Lines escapes control characters
+    std::vector<std::string> lines;
+    CallbackSink jsonSink([&lines](std::string_view block) {
+        lines.emplace_back(block);
+    });
+    store.exportCatalog(jsonSink, ExportFormat::JsonLines);
+    std::string json;
+    for (const std::string& line : lines) {
+        json += line;
+    }
+    assert(json.find("{\"type\":\"ebook\",\"isbn\":\"978-0596007126\",\"title\":\"Head First\\tPatterns\","
+                     "\"author\":\"Eric Freeman\",\"year\":2004,\"price\":0.1,\"file_type\":\"PDF\"}\n") != std::string::npos);
+    assert(json.find("\"Clean Code, \\\"2nd\\\" printing\"") != std::string::npos);
+    assert(std::count(json.begin(), json.end(), '\n') == 5);
+    
+    // Both text formats re-import into an equal catalog
+    for (ExportFormat format : {ExportFormat::Csv, ExportFormat::JsonLines}) {
+        std::string path = (std::filesystem::temp_directory_path() / 
+                            (format == ExportFormat::Csv ? "quantum_bookstore_export.csv" 
+                                                         : "quantum_bookstore_export.jsonl")).string();
+        int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        assert(fd >= 0);
+        FdSink fileSink(fd);
+        store.exportCatalog(fileSink, format);
+        ::close(fd);
+        QuantumBookstore copy;
+        ImportReport report = copy.importCatalog(path);
+        assert(report.booksAdded == 5 && report.errors.empty());
+        BufferSink again;
+        copy.exportCatalog(again, ExportFormat::Csv);
+        assert(again.data() == expectedCsv);
+        std::filesystem::remove(path);
+    }
+    
+    // Binary records carry the fixed header and the text back to back
+    BufferSink binary;
+    store.exportCatalog(binary, ExportFormat::Binary);
+    const std::string& bytes = binary.data();
+    assert(bytes.compare(0, CatalogExporter::BINARY_MAGIC.size(), CatalogExporter::BINARY_MAGIC) == 0);
+    size_t offset = CatalogExporter::BINARY_MAGIC.size();
+    size_t records = 0;
+    int stock = 0;
+    while (offset < bytes.size()) {
+        ExportRecordHeader header;
+        std::memcpy(&header, bytes.data() + offset, sizeof(header));
+        offset += sizeof(header);
+        std::string isbn = bytes.substr(offset, header.isbnLength);
+        if (isbn == "978-0201633610") {
+            assert(header.kind == static_cast<uint8_t>(BookKind::Paper) && header.year == 1994 && header.price == 54.99);
+            assert(bytes.substr(offset + header.isbnLength, header.titleLength) == "Design Patterns");
+            stock = header.stock;
+        }
+        offset += header.isbnLength + header.titleLength + header.authorLength + header.fileTypeLength;
+        ++records;
+    }
+    assert(offset == bytes.size() && records == 5 && stock == 3);
+    
+    // Pages resume after the last ISBN, so changes between pages do not
+    // repeat or skip the remaining rows
+    BufferSink paged;
+    ExportCursor cursor = store.exportPage(paged, ExportFormat::Csv, 2);
+    assert(cursor.rowsExported == 2 && !cursor.finished);
+    store.addPaperBook("978-0000000002", "Earlier", 2020, 1.0, "Author", 1);
+    store.addPaperBook("978-0300000000", "Later", 2020, 1.0, "Author", 1);
+    store.removeOutdated(2025, 32);
+    cursor = store.exportPage(paged, ExportFormat::Csv, 2, cursor);
+    assert(cursor.rowsExported == 4 && !cursor.finished);
+    cursor = store.exportPage(paged, ExportFormat::Csv, 2, cursor);
+    assert(cursor.rowsExported == 5 && cursor.finished);
+    assert(paged.data().find("Earlier") == std::string::npos && paged.data().find("Demo Book") == std::string::npos);
+    assert(paged.data().find("Later") != std::string::npos);
+    assert(std::count(paged.data().begin(), paged.data().end(), '\n') == 6);
+    ExportCursor done = store.exportPage(paged, ExportFormat::Csv, 2, cursor);
+    assert(done.finished && done.rowsExported == 5);
+    
+    // An empty first page still writes the header, and only once
+    BufferSink emptyFirst;
+    cursor = store.exportPage(emptyFirst, ExportFormat::Csv, 0);
+    assert(cursor.rowsExported == 0 && cursor.headerWritten && emptyFirst.data() == "type,isbn,title,author,year,price,stock,file_type\n");
+    cursor = store.exportPage(emptyFirst, ExportFormat::Csv, 2, cursor);
+    assert(cursor.rowsExported == 2);
+    assert(emptyFirst.data().find("type,isbn") == 0 && emptyFirst.data().find("type,isbn", 1) == std::string::npos);
+    
+    // JSON has no NaN, so a non-finite price is written as null
+    QuantumBookstore oddPrices;
+    oddPrices.addEBook("978-0000000001", "Unpriced", 2020, std::nan(""), "Author", "PDF");
+    BufferSink oddJson;
+    oddPrices.exportCatalog(oddJson, ExportFormat::JsonLines);
+    assert(oddJson.data().find("\"price\":null") != std::string::npos);
+    
+    // Output larger than the buffer blocks arrives in order and complete
+    QuantumBookstore large;
+    std::string longTitle(1000, 'x');
+    for (int i = 0; i < 5000; ++i) {
+        large.addEBook("978-" + std::to_string(1000000000 + i), longTitle, 2020, 1.5, "Author", "EPUB");
+    }
+    BufferSink whole;
+    size_t blocks = 0;
+    size_t streamed = 0;
+    CallbackSink counter([&](std::string_view block) {
+        ++blocks;
+        streamed += block.size();
+    });
+    large.exportCatalog(whole, ExportFormat::JsonLines);
+    large.exportCatalog(counter, ExportFormat::JsonLines);
+    assert(streamed == whole.data().size() && blocks > CatalogExporter::BLOCKS_PER_FLUSH);
+    assert(whole.data().rfind("{\"type\":\"ebook\",\"isbn\":\"978-1000004999\"", std::string::npos) != std::string::npos);
+    
+    std::cout << "✓ Catalog export test passed" << std::endl;
+}
+
+void QuantumBookstoreFullTest::testExpiry() {
+    std::cout << "Testing batched and background expiry..." << std::endl;
+    
+    QuantumBookstore store;
+    for (int i = 0; i < 10; ++i) {
+        store.addPaperBook("978-2" + std::to_string(100000000 + i), "Backlist", 1999 - i, 5.0, "Old Author", 2);
+    }
+    store.addEBook("978-0132350884", "Clean Code", 2008, 29.99, "Robert C. Martin", "EPUB");
+    store.addPaperBook("978-0134685991", "Effective Modern C++", 2014, 45.99, "Scott Meyers", 10);
+    
+    // Batches are bounded and come oldest first
+    std::vector<size_t> batchSizes;
+    int lastYear = 0;
+    size_t removed = store.removeOutdated(2025, 20, [&](std::vector<BookPtr>& batch) {
+        batchSizes.push_back(batch.size());
+        for (const BookPtr& book : batch) {
+            assert(book->getYearPublished() >= lastYear && book->getTitle() == "Backlist");
+            lastYear = book->getYearPublished();
+        }
+    }, 3);
+    assert(removed == 10 && (batchSizes == std::vector<size_t>{3, 3, 3, 1}));
+    assert(store.getInventorySize() == 2 && store.findBooksByAuthor("Old Author").empty());
+    assert(store.findBooksPublishedBetween(0, 3000).size() == 2);
+    assert(store.removeOutdated(2025, 20, [](std::vector<BookPtr>&) { assert(false); }, 3) == 0);
+    bool threw = false;
+    try {
+        store.removeOutdated(2025, 20, nullptr, 0);
+    } catch (const std::invalid_argument&) {
+        threw = true;
+    }
+    assert(threw);
+    
+    // The background trimmer follows the clock it is given, in small batches
+    std::atomic<int> year{2025};
+    std::atomic<size_t> trimmed{0};
+    std::atomic<size_t> largestBatch{0};
+    ExpiryConfig config;
+    config.yearsThreshold = 20;
+    config.currentYear = [&year]() { return year.load(); };
+    config.interval = std::chrono::milliseconds(2);
+    config.budget = std::chrono::microseconds(1);
+    config.batchSize = 2;
+    config.onRemoved = [&](std::vector<BookPtr>& batch) {
+        largestBatch = std::max(largestBatch.load(), batch.size());
+        trimmed += batch.size();
+    };
+    for (int i = 0; i < 7; ++i) {
+        store.addPaperBook("978-3" + std::to_string(100000000 + i), "Backlist", 1990, 5.0, "Old Author", 2);
+    }
+    store.startBackgroundExpiry(config);
+    auto waitFor = [&trimmed](size_t count) {
+        auto giveUp = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+        while (trimmed.load() < count && std::chrono::steady_clock::now() < giveUp) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return trimmed.load() == count;
+    };
+    assert(waitFor(7));
+    year = 2029;  // Clean Code (2008) ages out
+    assert(waitFor(8));
+    store.stopBackgroundExpiry();
+    assert(largestBatch.load() == 2);
+    assert(store.getInventorySize() == 1 && store.findBook("978-0134685991") != nullptr);
+    assert(store.getMetrics().booksRemoved == 18);
+    
+    std::cout << "✓ Batched and background expiry test passed" << std::endl;
+}
+
+void QuantumBookstoreFullTest::testRpcServer() {
+    std::cout << "Testing RPC server..." << std::endl;
+    
+    QuantumBookstore store;
+    store.addPaperBook("978-0134685991", "Effective Modern C++", 2014, 45.99, "Scott Meyers", 10);
+    store.addShowcaseBook("978-9999999999", "Demo Book", 1990, 0.0, "Demo Author");
+    ServerConfig config;
+    config.reactors = 2;
+    StoreServer server(store, config);
+    std::string socketPath = (std::filesystem::temp_directory_path() / "quantum_bookstore_test.sock").string();
+    server.listenUnix(socketPath);
+    uint16_t port = server.listenTcp();
+    assert(port != 0);
+    server.start();
+    assert(server.reactorCount() == 2);
+    
+    // Single calls behave like the in-process API
+    StoreClient client = StoreClient::connectUnix(socketPath);
+    BookRecord ebook;
+    ebook.kind = BookKind::EBook;
+    ebook.isbn = "978-0132350884";
+    ebook.title = "Clean Code";
+    ebook.author = "Robert C. Martin";
+    ebook.fileType = "EPUB";
+    ebook.year = 2008;
+    ebook.price = 29.99;
+    client.addBook(ebook);
+    std::optional<BookRecord> found = client.findBook("978-0132350884");
+    assert(found && found->kind == BookKind::EBook && found->title == "Clean Code" && found->fileType == "EPUB");
+    assert(store.findBook("978-0132350884") != nullptr);
+    assert(!client.findBook("978-0000000000"));
+    assert(std::abs(client.buyBook("978-0134685991", 2, "a@example.com", "1 Main St") - 91.98) < 0.01);
+    assert(client.findBook("978-0134685991")->stock == 8);
+    bool threw = false;
+    try {
+        client.buyBook("978-0134685991", 0, "a@example.com", "1 Main St");
+    } catch (const std::invalid_argument&) {
+        threw = true;
+    }
+    assert(threw);
+    threw = false;
+    try {
+        client.buyBook("978-9999999999", 1, "a@example.com", "1 Main St");
+    } catch (const std::invalid_argument&) {
+    } catch (const std::runtime_error&) {
+        threw = true;
+    }
+    assert(threw);
+    threw = false;
+    try {
+        client.addBook(ebook);
+    } catch (const std::invalid_argument&) {
+        threw = true;
+    }
+    assert(threw);
+    
+    // Export pages concatenate to the local export
+    std::string exported;
+    ExportCursor cursor;
+    uint64_t pages = 0;
+    while (!cursor.finished) {
+        ++pages;
+        std::string page;
+        cursor = client.exportPage(ExportFormat::Csv, 2, cursor, page);
+        exported += page;
+    }
+    BufferSink local;
+    store.exportCatalog(local, ExportFormat::Csv);
+    assert(exported == local.data() && cursor.rowsExported == 3);
+    
+    // Pipelined requests, lookups batched around a purchase, come back in order
+    for (int i = 0; i < 1000; ++i) {
+        if (i == 500) {
+            client.queueBuyBook("978-0134685991", 1, "b@example.com", "2 Main St");
+        }
+        client.queueFindBook(i % 2 ? "978-0134685991" : "978-1" + std::to_string(100000000 + i));
+    }
+    threw = false;
+    try {
+        client.findBook("978-0134685991");
+    } catch (const std::logic_error&) {
+        threw = true;
+    }
+    assert(threw && client.queued() == 1001);
+    std::vector<RpcReply> replies = client.flush();
+    assert(replies.size() == 1001 && client.queued() == 0);
+    for (size_t i = 0; i < replies.size(); ++i) {
+        const RpcReply& reply = replies[i];
+        if (i == 500) {
+            assert(reply.op == RpcOp::BuyBook && reply.ok() && std::abs(reply.amountPaid - 45.99) < 0.01);
+            continue;
+        }
+        size_t request = i < 500 ? i : i - 1;
+        assert(reply.op == RpcOp::FindBook);
+        if (request % 2) {
+            assert(reply.ok() && reply.book->stock == (request < 500 ? 8 : 7));
+        } else {
+            assert(reply.status == RpcStatus::NotFound && !reply.book && !reply.error.empty());
+        }
+    }
+    
+    // A batch whose replies outgrow the server's output limit still
+    // completes: the client reads replies while it sends
+    const size_t hugeBatch = 200000;
+    for (size_t i = 0; i < hugeBatch; ++i) {
+        client.queueFindBook("978-0000000000");
+    }
+    client.flush(replies);
+    assert(replies.size() == hugeBatch && replies.back().status == RpcStatus::NotFound);
+    
+    // Clients on other connections and over TCP are served concurrently
+    std::atomic<int> tcpFound{0};
+    std::thread other([port, &tcpFound]() {
+        StoreClient tcp = StoreClient::connectTcp(port);
+        for (int round = 0; round < 10; ++round) {
+            for (int i = 0; i < 100; ++i) {
+                tcp.queueFindBook("978-0132350884");
+            }
+            for (const RpcReply& reply : tcp.flush()) {
+                tcpFound += reply.ok() && reply.book->author == "Robert C. Martin";
+            }
+        }
+    });
+    for (int i = 0; i < 200; ++i) {
+        assert(client.findBook("978-9999999999")->kind == BookKind::Showcase);
+    }
+    other.join();
+    assert(tcpFound == 1000);
+    
+    assert(client.removeOutdated(2025, 20) == 1);
+    assert(store.getInventorySize() == 2);
+    assert(server.requestsServed() == 8 + pages + 1001 + hugeBatch + 1000 + 200 + 1);
+    
+    server.stop();
+    assert(!std::filesystem::exists(socketPath));
+    threw = false;
+    try {
+        StoreClient::connectUnix(socketPath);
+    } catch (const std::runtime_error&) {
+        threw = true;
+    }
+    assert(threw);
+    
+    std::cout << "✓ RPC server test passed" << std::endl;
+}
+
+void QuantumBookstoreFullTest::testResultApi() {
+    std::cout << "Testing non-throwing result API..." << std::endl;
+    
+    QuantumBookstore store;
+    store.addPaperBook("978-0134685991", "Effective Modern C++", 2014, 45.99, "Scott Meyers", 3);
+    store.addEBook("978-0132350884", "Clean Code", 2008, 29.99, "Robert C. Martin", "EPUB");
+    store.addShowcaseBook("978-9999999999", "Demo Book", 1990, 0.0, "Demo Author");
+    
+    StoreResult<double> paid = store.tryBuyBook("978-0134685991", 2, "a@example.com", "1 Main St");
+    assert(paid.ok() && std::abs(paid.value() - 91.98) < 0.01);
+    assert(store.tryBuyBook("978-0132350884", 1, "a@example.com", "").ok());
+    
+    // Refusals carry their details; the message matches the exception
+    auto expectRefusal = [&store](const std::string& isbn, int quantity, StoreFailure code) {
+        StoreResult<double> result = store.tryBuyBook(isbn, quantity, "a@example.com", "1 Main St");
+        assert(!result && result.error().code == code);
+        std::string thrown;
+        try {
+            store.buyBook(isbn, quantity, "a@example.com", "1 Main St");
+        } catch (const std::exception& error) {
+            thrown = error.what();
+        }
+        assert(thrown == result.error().message());
+        return result.error();
+    };
+    StoreError stock = expectRefusal("978-0134685991", 5, StoreFailure::InsufficientStock);
+    assert(stock.available == 1 && stock.requested == 5 && stock.isbn == "978-0134685991");
+    assert(stock.message() == "Insufficient stock for book with ISBN 978-0134685991. Available: 1, Requested: 5");
+    assert(expectRefusal("978-0134685991", 0, StoreFailure::InvalidQuantity).requested == 0);
+    assert(expectRefusal("978-9999999999", 1, StoreFailure::NotForSale).isbn == "978-9999999999");
+    expectRefusal("978-0000000000", 1, StoreFailure::UnknownIsbn);
+    assert(store.findBook("978-0134685991") != nullptr);
+    assert(asPaperBook(store.findBook("978-0134685991"))->getStock() == 1);
+    
+    // value() raises the throwing call's exception type
+    bool threw = false;
+    try {
+        (void)store.tryBuyBook("978-0134685991", -1, "a@example.com", "1 Main St").value();
+    } catch (const std::invalid_argument&) {
+        threw = true;
+    }
+    assert(threw);
+    
+    // Adds
+    assert(store.tryAddBook(std::make_unique<PaperBook>("978-0201633610", "Design Patterns", 1994, 54.99,
+                                                        "Gang of Four", 2)).ok());
+    StoreResult<void> duplicate = store.tryAddBook(std::make_unique<EBook>("978-0201633610", "Copy", 1994, 1.0,
+                                                                           "Someone", "PDF"));
+    assert(!duplicate && duplicate.error().code == StoreFailure::DuplicateIsbn);
+    assert(duplicate.error().message() == "Book with ISBN 978-0201633610 already exists in inventory");
+    StoreResult<void> null = store.tryAddBook(nullptr);
+    assert(!null && null.error().code == StoreFailure::NullBook);
+    threw = false;
+    try {
+        null.value();
+    } catch (const std::invalid_argument& error) {
+        threw = std::string(error.what()) == "Cannot add null book to inventory";
+    }
+    assert(threw);
+    StoreResult<void> unparsable = store.tryAddBook(std::make_unique<EBook>("BOOK-1", "No ISBN", 2020, 1.0,
+                                                                            "Someone", "PDF"));
+    assert(!unparsable && unparsable.error().code == StoreFailure::InvalidIsbn);
+    threw = false;
+    try {
+        store.addEBook("BOOK-1", "No ISBN", 2020, 1.0, "Someone", "PDF");
+    } catch (const std::invalid_argument& error) {
+        threw = std::string(error.what()) == "Invalid ISBN: BOOK-1";
+    }
+    assert(threw);
+    assert(store.getInventorySize() == 4);
+    
+    // Refusals are counted the same on both paths
+    MetricsSnapshot metrics = store.getMetrics();
+    assert(metrics.failureCount(StoreFailure::InsufficientStock) == 2);
+    assert(metrics.failureCount(StoreFailure::InvalidQuantity) == 3);
+    assert(metrics.failureCount(StoreFailure::UnknownIsbn) == 2);
+    assert(metrics.failureCount(StoreFailure::DuplicateIsbn) == 1);
+    assert(metrics.failureCount(StoreFailure::InvalidIsbn) == 2);
+    
+    std::cout << "✓ Non-throwing result API test passed" << std::endl;
+}
+
+void QuantumBookstoreFullTest::testAnalytics() {
+    std::cout << "Testing parallel analytics..." << std::endl;
+    
+    // Two shards, so each is split into several row ranges
+    QuantumBookstore store(2);
+    LogLevel previousLevel = Logger::global().getLevel();
+    Logger::global().setLevel(LogLevel::Warning);
+    const int bookCount = 100000;
+    for (int i = 0; i < bookCount; ++i) {
+        std::string isbn = "978-" + std::to_string(1000000000 + i);
+        std::string author = "Author " + std::to_string(i % 97);
+        int year = 1950 + i % 73;
+        double price = 5.0 + (i * 37 % 1000) / 10.0;
+        if (i % 10 < 6) {
+            store.addPaperBook(isbn, "Title", year, price, author, i % 50);
+        } else if (i % 10 < 9) {
+            store.addEBook(isbn, "Title", year, price, author, "EPUB");
+        } else {
+            store.addShowcaseBook(isbn, "Title", year, 0.0, author);
+        }
+    }
+    Logger::global().setLevel(previousLevel);
+    store.buyBook("978-1000000001", 1, "a@example.com", "1 Main St");  // stock 1 -> 0
+    
+    // Reference figures from a plain scan
+    double inventoryValue = 0;
+    std::unordered_map<std::string, double> stockByAuthor;
+    std::unordered_map<std::string, uint64_t> paperByDecade;
+    std::vector<double> ebookPrices;
+    for (const Book* book : store.readView()) {
+        if (const PaperBook* paper = asPaperBook(book)) {
+            inventoryValue += paper->getPrice() * paper->getStock();
+            stockByAuthor[std::string(book->getAuthorName())] += paper->getStock();
+            ++paperByDecade[std::to_string(book->getYearPublished() / 10 * 10) + "s"];
+        } else if (book->getKind() == BookKind::EBook) {
+            ebookPrices.push_back(book->getPrice());
+        }
+    }
+    std::sort(ebookPrices.begin(), ebookPrices.end());
+    auto near = [](double actual, double expected, double relative) {
+        return std::abs(actual - expected) <= relative * std::abs(expected) + 1e-9;
+    };
+    
+    // Inventory value, ungrouped
+    AnalyticsResult value = store.analyze(CatalogQuery().ofKind(BookKind::Paper).sum(BookMeasure::InventoryValue).count());
+    assert(value.columns.size() == 2 && value.columns[0] == "sum(inventory_value)" && value.columns[1] == "count");
+    assert(value.groups.size() == 1 && value.groups[0].key.empty() && value.find("") == &value.groups[0]);
+    assert(near(value.groups[0].values[0], inventoryValue, 1e-12) && value.groups[0].books == 60000);
+    
+    // Stock by author; stock is a paper-only measure
+    AnalyticsResult byAuthor = store.analyze(CatalogQuery().groupBy(GroupBy::Author).sum(BookMeasure::Stock));
+    assert(byAuthor.groups.size() == 97 && byAuthor.groups[0].key[0] == "Author 0");
+    for (const AnalyticsGroup& group : byAuthor.groups) {
+        assert(group.values[0] == stockByAuthor[group.key[0]]);
+    }
+    
+    // Counts by type and decade
+    AnalyticsResult counts = store.analyze(CatalogQuery().groupBy(GroupBy::Kind).groupBy(GroupBy::Decade).count());
+    assert(counts.groups.front().key[0] == "paper" && counts.groups.front().key[1] == "1950s");
+    assert(counts.groups.back().key[0] == "showcase" && counts.groups.back().key[1] == "2020s");
+    uint64_t total = 0;
+    for (const AnalyticsGroup& group : counts.groups) {
+        total += group.books;
+        if (group.key[0] == "paper") {
+            assert(group.books == paperByDecade[group.key[1]]);
+        }
+    }
+    assert(total == static_cast<uint64_t>(bookCount));
+    assert(counts.find("ebook/1980s") != nullptr && counts.find("ebook/1940s") == nullptr);
+    
+    // Price percentiles within the sketch's 1%, exact at the ends
+    AnalyticsResult prices = store.analyze(CatalogQuery().ofKind(BookKind::EBook).quantile(BookMeasure::Price, 0.5)
+                                               .quantile(BookMeasure::Price, 0.99).quantile(BookMeasure::Price, 1)
+                                               .min(BookMeasure::Price).max(BookMeasure::Price).mean(BookMeasure::Price));
+    assert(prices.columns[0] == "p50(price)" && prices.columns[1] == "p99(price)" && prices.columns[2] == "p100(price)");
+    auto rankOf = [&ebookPrices](double q) { return ebookPrices[static_cast<size_t>(q * (ebookPrices.size() - 1))]; };
+    const std::vector<double>& quantiles = prices.groups[0].values;
+    assert(near(quantiles[0], rankOf(0.5), 0.01) && near(quantiles[1], rankOf(0.99), 0.01));
+    assert(quantiles[2] == ebookPrices.back() && quantiles[3] == ebookPrices.front() && quantiles[4] == ebookPrices.back());
+    double mean = 0;
+    for (double price : ebookPrices) {
+        mean += price;
+    }
+    assert(near(quantiles[5], mean / ebookPrices.size(), 1e-12));
+    
+    // Filters combine; the result does not depend on the thread count
+    CatalogQuery filtered = CatalogQuery().publishedBetween(1990, 1999).pricedBetween(20, 40)
+                                .where([](const Book& book) { return book.getAuthorName() != "Author 3"; })
+                                .groupBy(GroupBy::Year).count().sum(BookMeasure::Stock);
+    AnalyticsResult parallel = store.analyze(filtered);
+    AnalyticsResult serial = store.analyze(CatalogQuery(filtered).threads(1));
+    assert(parallel.groups.size() == 10 && parallel.groups[0].key[0] == "1990");
+    size_t expected = 0;
+    for (const Book* book : store.readView()) {
+        expected += book->getYearPublished() >= 1990 && book->getYearPublished() <= 1999 && book->getPrice() >= 20 &&
+                    book->getPrice() <= 40 && book->getAuthorName() != "Author 3";
+    }
+    uint64_t filteredBooks = 0;
+    for (size_t i = 0; i < parallel.groups.size(); ++i) {
+        filteredBooks += parallel.groups[i].books;
+        assert(parallel.groups[i].books == serial.groups[i].books);
+        assert(parallel.groups[i].values[1] == serial.groups[i].values[1]);
+    }
+    assert(filteredBooks == expected);
+    
+    // Empty input, bad queries and throwing predicates
+    QuantumBookstore empty;
+    AnalyticsResult none = empty.analyze(CatalogQuery().sum(BookMeasure::Price).count());
+    assert(none.groups.size() == 1 && none.groups[0].books == 0 && std::isnan(none.groups[0].values[0]));
+    assert(none.groups[0].values[1] == 0);
+    assert(empty.analyze(CatalogQuery().groupBy(GroupBy::Kind).count()).groups.empty());
+    AnalyticsResult showcaseStock = store.analyze(CatalogQuery().ofKind(BookKind::Showcase).sum(BookMeasure::Stock));
+    assert(showcaseStock.groups[0].books == 10000 && std::isnan(showcaseStock.groups[0].values[0]));
+    bool threw = false;
+    try {
+        CatalogQuery().groupBy(GroupBy::Kind).groupBy(GroupBy::Kind);
+    } catch (const std::invalid_argument&) {
+        threw = true;
+    }
+    assert(threw);
+    threw = false;
+    try {
+        CatalogQuery().quantile(BookMeasure::Price, 1.5);
+    } catch (const std::invalid_argument&) {
+        threw = true;
+    }
+    assert(threw);
+    threw = false;
+    try {
+        store.analyze(CatalogQuery().where([](const Book&) -> bool { throw std::runtime_error("bad row"); }).count());
+    } catch (const std::runtime_error& error) {
+        threw = std::string(error.what()) == "bad row";
+    }
+    assert(threw);
+    
+    // The scan holds no shard lock, so the catalog can change under it; a
+    // book removed meanwhile is still counted and stays readable
+    std::atomic<bool> changed{false};
+    size_t removedMidScan = 0;
+    AnalyticsResult during = store.analyze(CatalogQuery().where([&](const Book& book) {
+        if (!changed.exchange(true)) {
+            removedMidScan = store.removeOutdated(2025, 2025 - 1960).size();
+            store.addPaperBook("978-0999999999", "Added Mid-Scan", 2024, 1.0, "Author 0", 1);
+        }
+        return !book.getTitle().empty();
+    }).count());
+    assert(removedMidScan > 0 && during.groups[0].books == static_cast<uint64_t>(bookCount));
+    assert(store.getInventorySize() == bookCount - removedMidScan + 1);
+    assert(store.getMetrics().callCount(StoreOp::Analyze) == 9);
+    
+    std::cout << "✓ Parallel analytics test passed" << std::endl;
+}
+
+void QuantumBookstoreFullTest::testChangeFeed() {
+    std::cout << "Testing change feed and read replica..." << std::endl;
+    
+    std::string feedName = "/quantum_bookstore_test_feed_" + std::to_string(getpid());
+    std::string snapshotPath = (std::filesystem::temp_directory_path() / "quantum_bookstore_test_feed.snapshot").string();
+    QuantumBookstore primary;
+    primary.addPaperBook("978-0134685991", "Effective Modern C++", 2014, 45.99, "Scott Meyers", 10);
+    bool threw = false;
+    try {
+        primary.openChangeFeed(feedName, 1000);  // not a power of two
+    } catch (const std::invalid_argument&) {
+        threw = true;
+    }
+    assert(threw && primary.getChangeFeedPosition() == 0);
+    primary.openChangeFeed(feedName, ChangeFeed::MIN_CAPACITY);
+    primary.addEBook("978-0132350884", "Clean Code", 2008, 29.99, "Robert C. Martin", "EPUB");
+    primary.addPaperBook("978-0201633610", "Design Patterns", 1994, 54.99, "Erich Gamma", 5);
+    assert(primary.getChangeFeedPosition() == 2);
+    primary.saveSnapshot(snapshotPath);
+    
+    // Changes after the snapshot reach a replica bootstrapped from it
+    primary.buyBook("978-0134685991", 3, "a@example.com", "1 Main St");
+    primary.buyBooks({{"978-0201633610", 1}, {"978-0132350884", 1}}, "a@example.com", "1 Main St");
+    primary.addShowcaseBook("978-9999999999", "Demo Book", 1990, 0.0, "Demo Author");
+    assert(primary.removeOutdated(2025, 33).size() == 1);  // the demo book
+    assert(primary.getChangeFeedPosition() == 6);
+    
+    CatalogReplica replica(feedName, snapshotPath);
+    replica.bootstrap();
+    assert(replica.getStats().appliedSequence == 2 && replica.getStats().lagChanges() == 4);
+    assert(replica.store()->getInventorySize() == 3);
+    assert(replica.poll(2) == 2 && replica.poll() == 2 && replica.poll() == 0);
+    std::shared_ptr<const QuantumBookstore> copy = replica.store();
+    assert(copy->getInventorySize() == 3 && copy->findBook("978-9999999999") == nullptr);
+    // The applied removal also took the hyphenated ISBN out of search
+    assert(copy->searchBooks("demo").empty() && copy->searchBooks("clean code").size() == 1);
+    assert(asPaperBook(copy->findBook("978-0134685991"))->getStock() == 7);
+    assert(asPaperBook(copy->findBook("978-0201633610"))->getStock() == 4);
+    assert(copy->findBooksByAuthor("Erich Gamma").size() == 1);
+    ReplicaStats stats = replica.getStats();
+    assert(stats.appliedSequence == 6 && stats.lagChanges() == 0 && stats.changesApplied == 4);
+    assert(stats.gaps == 0 && !stats.stale && stats.maxLag >= stats.lastLag && stats.lastLag.count() > 0);
+    
+    // A tailing replica follows within a wakeup
+    replica.start();
+    primary.buyBook("978-0134685991", 2, "a@example.com", "1 Main St");
+    assert(replica.waitFor(primary.getChangeFeedPosition(), std::chrono::seconds(10)));
+    assert(asPaperBook(replica.store()->findBook("978-0134685991"))->getStock() == 5);
+    replica.stop();
+    
+    // Lapped by a full ring: the replica reports the gap, keeps its data,
+    // and catches up from the next snapshot
+    LogLevel previousLevel = Logger::global().getLevel();
+    Logger::global().setLevel(LogLevel::Error);
+    for (int i = 0; i < 2000; ++i) {
+        primary.addPaperBook("978-1" + std::to_string(100000000 + i), "Filler", 2020, 10.0, "Filler Author", 1);
+    }
+    assert(replica.poll() == 0);
+    stats = replica.getStats();
+    assert(stats.gaps == 1 && stats.stale && stats.lagChanges() == 2000);
+    assert(replica.store()->getInventorySize() == 3);
+    assert(replica.poll() == 0 && replica.getStats().gaps == 1);  // same old snapshot: no retry
+    std::filesystem::remove(snapshotPath);
+    primary.saveSnapshot(snapshotPath);
+    primary.buyBook("978-1100000007", 1, "a@example.com", "1 Main St");
+    assert(replica.poll() == 1);
+    stats = replica.getStats();
+    assert(!stats.stale && stats.resyncs == 1 && stats.appliedSequence == primary.getChangeFeedPosition());
+    assert(copy->getInventorySize() == 3);  // the old store lives on while held
+    assert(replica.store()->getInventorySize() == 2003);
+    assert(asPaperBook(replica.store()->findBook("978-1100000007"))->getStock() == 0);
+    Logger::global().setLevel(previousLevel);
+    
+    // Snapshots with a feed position must come first, and the feed cannot
+    // start ahead of what it has published
+    threw = false;
+    try {
+        primary.loadSnapshot(snapshotPath);
+    } catch (const std::runtime_error&) {
+        threw = true;
+    }
+    assert(threw);
+    QuantumBookstore restarted;
+    restarted.loadSnapshot(snapshotPath);
+    restarted.openChangeFeed(feedName + "_restarted", ChangeFeed::MIN_CAPACITY);
+    assert(restarted.getChangeFeedPosition() == 2007);
+    threw = false;
+    try {
+        ChangeFeedReader reader(feedName + "_restarted");
+        reader.seek(2008);
+    } catch (const std::runtime_error&) {
+        threw = true;
+    }
+    assert(threw);
+    assert(primary.getMetrics().callCount(StoreOp::OpenChangeFeed) == 2);
+    std::filesystem::remove(snapshotPath);
+    
+    // A snapshot taken under live adds and sales matches its feed position:
+    // a replica bootstrapped from it neither repeats nor misses a change
+    std::thread seller([&primary]() {
+        for (int i = 0; i < 200; ++i) {
+            std::string isbn = "978-2" + std::to_string(100000000 + i);
+            primary.addPaperBook(isbn, "Live", 2024, 10.0, "Live Author", 5);
+            primary.buyBook(isbn, 2, "a@example.com", "1 Main St");
+        }
+    });
+    primary.saveSnapshot(snapshotPath);
+    seller.join();
+    CatalogReplica live(feedName, snapshotPath);
+    live.bootstrap();
+    live.poll();
+    assert(live.getStats().appliedSequence == primary.getChangeFeedPosition());
+    assert(live.store()->getInventorySize() == primary.getInventorySize());
+    for (int i = 0; i < 200; ++i) {
+        assert(asPaperBook(live.store()->findBook("978-2" + std::to_string(100000000 + i)))->getStock() == 3);
+    }
+    std::filesystem::remove(snapshotPath);
+    
+    std::cout << "✓ Change feed and read replica test passed" << std::endl;
+}
+
+namespace {
+
+// Custom book whose delivery blocks until the test opens the gate
+class GatedBook : public Book {
+public:
+    GatedBook(const std::string& isbn, const std::atomic<bool>& open)
+        : Book(isbn, "Gated Book", 2024, 5.0, "Gatekeeper"), open(open) {}
+    void processPurchase(const std::string&, const std::string&) const override {
+        while (!open.load()) {
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+        }
+    }
+    bool canBeSold() const override { return true; }
+    std::string getType() const override { return "Gated Book"; }
+
+private:
+    const std::atomic<bool>& open;
+};
+
+} // namespace
+
+void QuantumBookstoreFullTest::testAdmission() {
+    std::cout << "Testing admission control..." << std::endl;
+    using Clock = AdmissionController::Clock;
+    
+    // Limits that admit nothing are rejected
+    AdmissionConfig invalid;
+    invalid.purchases.minLimit = 0;
+    bool threw = false;
+    try {
+        AdmissionController controller(invalid);
+    } catch (const std::invalid_argument&) {
+        threw = true;
+    }
+    assert(threw);
+    
+    // Over the limit a call waits, is handed the next free slot, and is
+    // shed once the queue is full or it has waited too long
+    AdmissionConfig config;
+    config.purchases = ClassLimits{2, 1, 4, std::chrono::microseconds(60000000), 0.5, 1, std::chrono::microseconds(5000)};
+    AdmissionController controller(config);
+    auto first = controller.admit(RequestClass::Purchase);
+    auto second = controller.admit(RequestClass::Purchase);
+    assert(first && second);
+    auto late = controller.admit(RequestClass::Purchase);
+    assert(!late && late.failure() == StoreFailure::DeadlineExceeded);
+    auto expired = controller.admit(RequestClass::Purchase, Clock::now());
+    assert(!expired && expired.failure() == StoreFailure::DeadlineExceeded);
+    
+    std::atomic<bool> queuedAdmitted{false};
+    std::thread waiter([&]() {
+        auto permit = controller.admit(RequestClass::Purchase, Clock::now() + std::chrono::seconds(10));
+        queuedAdmitted = static_cast<bool>(permit);
+    });
+    while (controller.getStats(RequestClass::Purchase).queued == 0) {
+        std::this_thread::yield();
+    }
+    auto overflow = controller.admit(RequestClass::Purchase, Clock::now() + std::chrono::seconds(10));
+    assert(!overflow && overflow.failure() == StoreFailure::Overloaded);
+    // Reads have their own limit
+    auto read = controller.admit(RequestClass::Read);
+    assert(read);
+    read.release();
+    first.release();
+    waiter.join();
+    assert(queuedAdmitted);
+    
+    AdmissionStats stats = controller.getStats(RequestClass::Purchase);
+    assert(stats.admitted == 3);
+    assert(stats.shedOverloaded == 1);
+    assert(stats.shedDeadline == 2);
+    assert(stats.queued == 0);
+    assert(stats.inFlight == 1);
+    // Fast calls at the limit grow it by 1/limit each
+    assert(stats.limit > 2.0);
+    second.release();
+    assert(controller.getStats(RequestClass::Purchase).inFlight == 0);
+    assert(controller.getStats(RequestClass::Read).admitted == 1);
+    
+    // Calls slower than the target cut the limit, down to minLimit
+    AdmissionConfig slow;
+    slow.purchases = ClassLimits{4, 1, 4, std::chrono::microseconds(1), 0.5, 1, std::chrono::microseconds(1000)};
+    AdmissionController backingOff(slow);
+    for (int i = 0; i < 3; ++i) {
+        auto permit = backingOff.admit(RequestClass::Purchase);
+        assert(permit);
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+    }
+    assert(backingOff.getStats(RequestClass::Purchase).limit == 1.0);
+    
+    // The store behind a gate: sold-out ISBNs fail before queueing, and
+    // reads keep flowing while checkout is saturated
+    QuantumBookstore store;
+    store.addPaperBook("978-1200000001", "Last Copy", 2022, 30.0, "Author", 1);
+    std::atomic<bool> open{false};
+    store.addBook(std::make_unique<GatedBook>("978-1200000002", open));
+    AdmissionConfig gated;
+    gated.purchases = ClassLimits{1, 1, 1, std::chrono::microseconds(60000000), 0.5, 0, std::chrono::microseconds(0)};
+    StoreGate gate(store, gated);
+    assert(gate.buyBook("978-1200000001", 1, "a@example.com", "Cairo") == 30.0);
+    StoreResult<double> soldOut = gate.tryBuyBook("978-1200000001", 1, "a@example.com", "Cairo");
+    assert(!soldOut && soldOut.error().code == StoreFailure::InsufficientStock);
+    assert(soldOut.error().available == 0);
+    assert(gate.getStats(RequestClass::Purchase).fastFailed == 1);
+    threw = false;
+    try {
+        gate.buyBooks({{"978-1200000002", 1}, {"978-1200000001", 1}}, "a@example.com", "Cairo");
+    } catch (const std::runtime_error&) {
+        threw = true;
+    }
+    assert(threw);
+    assert(gate.getStats(RequestClass::Purchase).fastFailed == 2);
+    
+    std::thread buyer([&]() {
+        assert(gate.buyBook("978-1200000002", 1, "a@example.com", "Cairo") == 5.0);
+    });
+    while (gate.getStats(RequestClass::Purchase).inFlight == 0) {
+        std::this_thread::yield();
+    }
+    StoreResult<double> shed = gate.tryBuyBook("978-1200000002", 1, "a@example.com", "Cairo");
+    assert(!shed && shed.error().code == StoreFailure::Overloaded);
+    assert(shed.error().message() == "Store is overloaded; try again later");
+    threw = false;
+    try {
+        gate.buyBook("978-1200000002", 1, "a@example.com", "Cairo");
+    } catch (const std::runtime_error&) {
+        threw = true;
+    }
+    assert(threw);
+    Book* found = gate.findBook("978-1200000001");
+    assert(found && found->getTitle() == "Last Copy");
+    assert(gate.findBook("978-0000000000") == nullptr);
+    assert(gate.searchBooks("last").size() == 1);
+    open = true;
+    buyer.join();
+    
+    stats = gate.getStats(RequestClass::Purchase);
+    assert(stats.admitted == 2);
+    assert(stats.shedOverloaded == 2);
+    assert(stats.inFlight == 0);
+    assert(gate.getStats(RequestClass::Read).admitted == 3);
+    assert(storeFailureName(StoreFailure::DeadlineExceeded) == "deadline_exceeded");
+    
+    std::cout << "✓ Admission control test passed" << std::endl;
+}
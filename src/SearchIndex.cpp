@@ -0,0 +1,289 @@
+#include "../include/SearchIndex.h"
+#include <algorithm>
+#include <cctype>
+#include <mutex>
+
+namespace {
+
+// Merge a sorted run into a sorted, unique accumulator
+void mergeUnique(std::vector<uint32_t>& accumulator, const std::vector<uint32_t>& run) {
+    std::vector<uint32_t> merged;
+    merged.reserve(accumulator.size() + run.size());
+    std::set_union(accumulator.begin(), accumulator.end(), run.begin(), run.end(), 
+                   std::back_inserter(merged));
+    accumulator.swap(merged);
+}
+
+} // namespace
+
+// PostingList implementation
+void SearchIndex::PostingList::append(uint32_t ordinal) {
+    if (count % SKIP_INTERVAL == 0) {
+        skips.push_back({ordinal, lastOrdinal, static_cast<uint32_t>(bytes.size())});
+    }
+    uint32_t delta = ordinal - lastOrdinal;
+    while (delta >= 0x80) {
+        bytes.push_back(static_cast<uint8_t>(delta | 0x80));
+        delta >>= 7;
+    }
+    bytes.push_back(static_cast<uint8_t>(delta));
+    lastOrdinal = ordinal;
+    ++count;
+}
+
+uint32_t SearchIndex::PostingList::readDelta(size_t& pos) const {
+    uint32_t delta = 0;
+    int shift = 0;
+    uint8_t byte;
+    do {
+        byte = bytes[pos++];
+        delta |= static_cast<uint32_t>(byte & 0x7F) << shift;
+        shift += 7;
+    } while (byte & 0x80);
+    return delta;
+}
+
+void SearchIndex::PostingList::decodeInto(std::vector<uint32_t>& ordinals) const {
+    uint32_t ordinal = 0;
+    size_t pos = 0;
+    for (uint32_t i = 0; i < count; ++i) {
+        ordinal += readDelta(pos);
+        ordinals.push_back(ordinal);
+    }
+}
+
+bool SearchIndex::PostingList::Probe::contains(uint32_t target) {
+    if (decoded > 0 && ordinal >= target) {
+        return ordinal == target;
+    }
+    
+    // Jump to the last block starting at or before the target, if it is ahead
+    auto skipEnd = list->skips.end();
+    auto block = std::upper_bound(list->skips.begin() + nextSkip, skipEnd, target,
+        [](uint32_t value, const Skip& skip) { return value < skip.firstOrdinal; });
+    if (block != list->skips.begin() + nextSkip) {
+        --block;
+        uint32_t blockStart = static_cast<uint32_t>(block - list->skips.begin()) * SKIP_INTERVAL;
+        if (blockStart >= decoded) {
+            pos = block->offset;
+            ordinal = block->baseOrdinal;
+            decoded = blockStart;
+        }
+        nextSkip = static_cast<size_t>(block - list->skips.begin()) + 1;
+    }
+    
+    while (decoded < list->count) {
+        ordinal += list->readDelta(pos);
+        ++decoded;
+        if (ordinal >= target) {
+            return ordinal == target;
+        }
+    }
+    return false;
+}
+
+// SearchIndex implementation
+std::vector<std::string> SearchIndex::tokenize(std::string_view text) {
+    std::vector<std::string> tokens;
+    std::string current;
+    for (char c : text) {
+        unsigned char uc = static_cast<unsigned char>(c);
+        if (std::isalnum(uc)) {
+            current.push_back(static_cast<char>(std::tolower(uc)));
+        } else if (!current.empty()) {
+            tokens.push_back(std::move(current));
+            current.clear();
+        }
+    }
+    if (!current.empty()) {
+        tokens.push_back(std::move(current));
+    }
+    std::sort(tokens.begin(), tokens.end());
+    tokens.erase(std::unique(tokens.begin(), tokens.end()), tokens.end());
+    return tokens;
+}
+
+void SearchIndex::add(Book* book) {
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    indexBook(book);
+}
+
+void SearchIndex::remove(const std::string& isbn) {
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    auto it = ordinalByIsbn.find(isbn);
+    if (it == ordinalByIsbn.end()) {
+        return;
+    }
+    books[it->second] = nullptr;
+    ordinalByIsbn.erase(it);
+    ++removedCount;
+    if (removedCount > ordinalByIsbn.size()) {
+        rebuild();
+    }
+}
+
+size_t SearchIndex::size() const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    return ordinalByIsbn.size();
+}
+
+void SearchIndex::indexBook(Book* book) {
+    uint32_t ordinal = static_cast<uint32_t>(books.size());
+    books.push_back(book);
+    ordinalByIsbn[book->getISBN()] = ordinal;
+    for (const auto& token : tokenize(book->getTitle())) {
+        titleTerms[token].append(ordinal);
+    }
+    for (const auto& token : tokenize(book->getAuthorName())) {
+        authorTerms[token].append(ordinal);
+    }
+}
+
+void SearchIndex::rebuild() {
+    std::vector<Book*> live;
+    live.reserve(ordinalByIsbn.size());
+    for (Book* book : books) {
+        if (book) {
+            live.push_back(book);
+        }
+    }
+    titleTerms.clear();
+    authorTerms.clear();
+    books.clear();
+    ordinalByIsbn.clear();
+    removedCount = 0;
+    for (Book* book : live) {
+        indexBook(book);
+    }
+}
+
+void SearchIndex::resolve(const Postings& postings, const std::string& term, bool prefix, 
+                          std::vector<const PostingList*>& lists, size_t& total) {
+    if (!prefix) {
+        auto it = postings.find(term);
+        if (it != postings.end()) {
+            lists.push_back(&it->second);
+            total += it->second.size();
+        }
+        return;
+    }
+    for (auto it = postings.lower_bound(term); 
+         it != postings.end() && it->first.compare(0, term.size(), term) == 0; ++it) {
+        lists.push_back(&it->second);
+        total += it->second.size();
+    }
+}
+
+std::vector<SearchHit> SearchIndex::search(const std::string& query, size_t limit) const {
+    // Split the raw query first so a trailing '*' survives tokenization
+    std::vector<std::pair<std::string, bool>> terms;
+    size_t start = 0;
+    while (start < query.size()) {
+        size_t end = query.find(' ', start);
+        if (end == std::string::npos) {
+            end = query.size();
+        }
+        std::string word = query.substr(start, end - start);
+        bool prefix = !word.empty() && word.back() == '*';
+        for (auto& token : tokenize(word)) {
+            terms.emplace_back(std::move(token), prefix);
+        }
+        start = end + 1;
+    }
+    if (terms.empty() || limit == 0) {
+        return {};
+    }
+    
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    
+    std::vector<TermLists> resolved(terms.size());
+    for (size_t t = 0; t < terms.size(); ++t) {
+        resolve(titleTerms, terms[t].first, terms[t].second, resolved[t].title, resolved[t].postings);
+        resolve(authorTerms, terms[t].first, terms[t].second, resolved[t].author, resolved[t].postings);
+        if (resolved[t].postings == 0) {
+            return {};
+        }
+    }
+    // Rarest term first keeps the candidate set small
+    std::sort(resolved.begin(), resolved.end(), 
+        [](const TermLists& a, const TermLists& b) { return a.postings < b.postings; });
+    
+    // Seed the candidates (ordinal, score) from the rarest term
+    std::vector<std::pair<uint32_t, int>> candidates;
+    {
+        std::vector<uint32_t> titleHits;
+        std::vector<uint32_t> authorHits;
+        std::vector<uint32_t> run;
+        for (const PostingList* list : resolved[0].title) {
+            run.clear();
+            list->decodeInto(run);
+            mergeUnique(titleHits, run);
+        }
+        for (const PostingList* list : resolved[0].author) {
+            run.clear();
+            list->decodeInto(run);
+            mergeUnique(authorHits, run);
+        }
+        size_t i = 0;
+        size_t j = 0;
+        while (i < titleHits.size() || j < authorHits.size()) {
+            if (j == authorHits.size() || (i < titleHits.size() && titleHits[i] < authorHits[j])) {
+                candidates.emplace_back(titleHits[i++], TITLE_WEIGHT);
+            } else if (i == titleHits.size() || authorHits[j] < titleHits[i]) {
+                candidates.emplace_back(authorHits[j++], AUTHOR_WEIGHT);
+            } else {
+                candidates.emplace_back(titleHits[i++], TITLE_WEIGHT + AUTHOR_WEIGHT);
+                ++j;
+            }
+        }
+    }
+    
+    // Every other term filters the candidates by probing its lists (AND)
+    for (size_t t = 1; t < resolved.size() && !candidates.empty(); ++t) {
+        std::vector<PostingList::Probe> titleProbes;
+        std::vector<PostingList::Probe> authorProbes;
+        for (const PostingList* list : resolved[t].title) {
+            titleProbes.emplace_back(*list);
+        }
+        for (const PostingList* list : resolved[t].author) {
+            authorProbes.emplace_back(*list);
+        }
+        
+        size_t kept = 0;
+        for (auto& candidate : candidates) {
+            int score = 0;
+            for (auto& probe : titleProbes) {
+                if (probe.contains(candidate.first)) {
+                    score = TITLE_WEIGHT;
+                }
+            }
+            for (auto& probe : authorProbes) {
+                if (probe.contains(candidate.first)) {
+                    score += AUTHOR_WEIGHT;
+                    break;
+                }
+            }
+            if (score > 0) {
+                candidates[kept++] = {candidate.first, candidate.second + score};
+            }
+        }
+        candidates.resize(kept);
+    }
+    
+    // Drop tombstoned books, then keep the top k by score (newest first on ties)
+    candidates.erase(std::remove_if(candidates.begin(), candidates.end(), 
+        [this](const std::pair<uint32_t, int>& candidate) { return books[candidate.first] == nullptr; }),
+        candidates.end());
+    auto better = [](const std::pair<uint32_t, int>& a, const std::pair<uint32_t, int>& b) {
+        return a.second != b.second ? a.second > b.second : a.first > b.first;
+    };
+    size_t keep = std::min(limit, candidates.size());
+    std::partial_sort(candidates.begin(), candidates.begin() + keep, candidates.end(), better);
+    
+    std::vector<SearchHit> hits;
+    hits.reserve(keep);
+    for (size_t i = 0; i < keep; ++i) {
+        hits.push_back({books[candidates[i].first], candidates[i].second});
+    }
+    return hits;
+}
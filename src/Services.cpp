@@ -1,4 +1,5 @@
 #include "../include/Services.h"
+#include <exception>
 
 void ShippingService::ship(const std::string& address) {
     // Implementation would go here
@@ -9,3 +10,30 @@ void MailService::sendEmail(const std::string& email) {
     // Implementation would go here
     // For now, just a placeholder
 }
+
+std::vector<size_t> ShippingService::shipBatch(const std::vector<std::string>& addresses) {
+    // A real carrier integration would submit one bulk request and report
+    // the rejected addresses
+    std::vector<size_t> failed;
+    for (size_t i = 0; i < addresses.size(); ++i) {
+        try {
+            ship(addresses[i]);
+        } catch (const std::exception&) {
+            failed.push_back(i);
+        }
+    }
+    return failed;
+}
+
+std::vector<size_t> MailService::sendEmailBatch(const std::vector<std::string>& emails) {
+    // A real SMTP relay would reuse one connection for the whole batch
+    std::vector<size_t> failed;
+    for (size_t i = 0; i < emails.size(); ++i) {
+        try {
+            sendEmail(emails[i]);
+        } catch (const std::exception&) {
+            failed.push_back(i);
+        }
+    }
+    return failed;
+}
@@ -0,0 +1,266 @@
+#include "../include/ShardedInventory.h"
+#include <algorithm>
+#include <stdexcept>
+
+namespace {
+
+// Round up to the next power of two so a shard is picked with a mask
+size_t roundUpToPowerOfTwo(size_t value) {
+    size_t result = 1;
+    while (result < value) {
+        result <<= 1;
+    }
+    return result;
+}
+
+} // namespace
+
+ShardedInventory::ShardedInventory(size_t shardCount)
+    : shards(new Shard[roundUpToPowerOfTwo(shardCount == 0 ? 1 : shardCount)]),
+      shardMask(roundUpToPowerOfTwo(shardCount == 0 ? 1 : shardCount) - 1) {}
+
+bool ShardedInventory::insert(BookPtr book, const std::function<void(const Book&)>& onInserted) {
+    uint64_t key = IsbnCodec::pack(book->getISBN());
+    if (key == IsbnCodec::INVALID_KEY) {
+        throw std::invalid_argument("Invalid ISBN: " + std::string(book->getISBN()));
+    }
+    Shard& shard = shardFor(key);
+    std::unique_lock<std::shared_mutex> lock(shard.mutex);
+    if (shard.books.find(key)) {
+        return false;
+    }
+    // Each step undoes the ones before it if it throws, so a failed insert
+    // leaves neither a row nor an entry without a book behind
+    size_t row = shard.columns.size();
+    shard.columns.append(*book);
+    Entry* entry;
+    try {
+        entry = shard.books.tryEmplace(key, Entry{std::move(book), row}).first;
+    } catch (...) {
+        shard.columns.removeRow(row);
+        throw;
+    }
+    if (onInserted) {
+        try {
+            onInserted(*entry->book);
+        } catch (...) {
+            shard.books.erase(key);
+            shard.columns.removeRow(row);
+            throw;
+        }
+    }
+    ++shard.changes;
+    bookCount.fetch_add(1, std::memory_order_relaxed);
+    changeCount.fetch_add(1, std::memory_order_release);
+    return true;
+}
+
+Book* ShardedInventory::find(std::string_view isbn) const {
+    uint64_t key = IsbnCodec::pack(isbn);
+    if (key == IsbnCodec::INVALID_KEY) {
+        return nullptr;
+    }
+    Shard& shard = shardFor(key);
+    std::shared_lock<std::shared_mutex> lock(shard.mutex);
+    const Entry* entry = shard.books.find(key);
+    return entry ? entry->book.get() : nullptr;
+}
+
+void ShardedInventory::findMany(const std::vector<std::string_view>& isbns, std::vector<Book*>& found) const {
+    found.assign(isbns.size(), nullptr);
+    // Counting sort of the positions by shard
+    std::vector<uint64_t> keys(isbns.size());
+    std::vector<uint32_t> shardStart(shardMask + 2, 0);
+    for (size_t i = 0; i < isbns.size(); ++i) {
+        keys[i] = IsbnCodec::pack(isbns[i]);
+        if (keys[i] != IsbnCodec::INVALID_KEY) {
+            ++shardStart[(mixKey(keys[i]) & shardMask) + 1];
+        }
+    }
+    for (size_t s = 1; s < shardStart.size(); ++s) {
+        shardStart[s] += shardStart[s - 1];
+    }
+    std::vector<uint32_t> order(shardStart.back());
+    std::vector<uint32_t> fill(shardStart.begin(), shardStart.end() - 1);
+    for (size_t i = 0; i < isbns.size(); ++i) {
+        if (keys[i] != IsbnCodec::INVALID_KEY) {
+            order[fill[mixKey(keys[i]) & shardMask]++] = static_cast<uint32_t>(i);
+        }
+    }
+    for (size_t s = 0; s <= shardMask; ++s) {
+        if (shardStart[s] == shardStart[s + 1]) {
+            continue;
+        }
+        std::shared_lock<std::shared_mutex> lock(shards[s].mutex);
+        for (uint32_t k = shardStart[s]; k < shardStart[s + 1]; ++k) {
+            const Entry* entry = shards[s].books.find(keys[order[k]]);
+            found[order[k]] = entry ? entry->book.get() : nullptr;
+        }
+    }
+}
+
+BookPtr ShardedInventory::remove(std::string_view isbn, const std::function<void(const Book&)>& onRemoved) {
+    uint64_t key = IsbnCodec::pack(isbn);
+    if (key == IsbnCodec::INVALID_KEY) {
+        return nullptr;
+    }
+    Shard& shard = shardFor(key);
+    std::unique_lock<std::shared_mutex> lock(shard.mutex);
+    Entry* entry = shard.books.find(key);
+    if (!entry) {
+        return nullptr;
+    }
+    if (onRemoved) {
+        onRemoved(*entry->book);
+    }
+    
+    // The last row moves into the freed slot; repoint its map entry
+    size_t row = entry->row;
+    BookPtr removed = std::move(entry->book);
+    shard.books.erase(key);
+    Book* moved = shard.columns.removeRow(row);
+    if (moved) {
+        shard.books.find(IsbnCodec::pack(moved->getISBN()))->row = row;
+    }
+    ++shard.changes;
+    bookCount.fetch_sub(1, std::memory_order_relaxed);
+    changeCount.fetch_add(1, std::memory_order_release);
+    return removed;
+}
+
+void ShardedInventory::withExclusiveKeys(const std::vector<uint64_t>& keys, const std::function<void()>& fn) {
+    std::vector<size_t> owners;
+    owners.reserve(keys.size());
+    for (uint64_t key : keys) {
+        owners.push_back(mixKey(key) & shardMask);
+    }
+    std::sort(owners.begin(), owners.end());
+    owners.erase(std::unique(owners.begin(), owners.end()), owners.end());
+    std::vector<std::unique_lock<std::shared_mutex>> locks;
+    locks.reserve(owners.size());
+    for (size_t owner : owners) {
+        locks.emplace_back(shards[owner].mutex);
+    }
+    fn();
+}
+
+std::vector<Book*> ShardedInventory::select(const ColumnScan& scan) const {
+    std::vector<Book*> selected;
+    for (size_t i = 0; i <= shardMask; ++i) {
+        const Shard& shard = shards[i];
+        std::shared_lock<std::shared_mutex> lock(shard.mutex);
+        ColumnarCatalog::forEachSelected(scan(shard.columns), [&](size_t row) {
+            selected.push_back(shard.columns.bookAt(row));
+        });
+    }
+    return selected;
+}
+
+void ShardedInventory::forEach(const std::function<void(const Book&)>& visitor) const {
+    for (size_t i = 0; i <= shardMask; ++i) {
+        const Shard& shard = shards[i];
+        std::shared_lock<std::shared_mutex> lock(shard.mutex);
+        shard.books.forEach([&visitor](uint64_t, const Entry& entry) {
+            visitor(*entry.book);
+        });
+    }
+}
+
+void ShardedInventory::forEach(const std::function<void(Book&)>& visitor) {
+    for (size_t i = 0; i <= shardMask; ++i) {
+        Shard& shard = shards[i];
+        std::shared_lock<std::shared_mutex> lock(shard.mutex);
+        shard.books.forEach([&visitor](uint64_t, Entry& entry) {
+            visitor(*entry.book);
+        });
+    }
+}
+
+void ShardedInventory::forEachAtOnce(const std::function<void(const Book&)>& visitor,
+                                     const std::function<void()>& whileLocked) const {
+    // Shard order, as in collect
+    std::vector<std::shared_lock<std::shared_mutex>> locks;
+    locks.reserve(shardMask + 1);
+    for (size_t i = 0; i <= shardMask; ++i) {
+        locks.emplace_back(shards[i].mutex);
+    }
+    for (size_t i = 0; i <= shardMask; ++i) {
+        shards[i].books.forEach([&visitor](uint64_t, const Entry& entry) {
+            visitor(*entry.book);
+        });
+    }
+    whileLocked();
+}
+
+void ShardedInventory::reserve(size_t count) {
+    // Hashing spreads books evenly; leave slack for the unlucky shards
+    size_t perShard = count / (shardMask + 1) + count / (shardMask + 1) / 8 + 1;
+    for (size_t i = 0; i <= shardMask; ++i) {
+        Shard& shard = shards[i];
+        std::unique_lock<std::shared_mutex> lock(shard.mutex);
+        shard.books.reserve(shard.books.size() + perShard);
+        shard.columns.reserve(shard.columns.size() + perShard);
+    }
+}
+
+uint64_t ShardedInventory::version() const {
+    return changeCount.load(std::memory_order_acquire);
+}
+
+std::vector<ColumnarCatalog> ShardedInventory::copyColumns() const {
+    std::vector<ColumnarCatalog> columns;
+    columns.reserve(shardMask + 1);
+    for (size_t i = 0; i <= shardMask; ++i) {
+        std::shared_lock<std::shared_mutex> lock(shards[i].mutex);
+        columns.push_back(shards[i].columns);
+    }
+    return columns;
+}
+
+uint64_t ShardedInventory::collect(std::vector<ShardEntries>& taken) const {
+    taken.resize(shardMask + 1);
+    std::vector<std::shared_ptr<std::vector<std::pair<uint64_t, Book*>>>> copied(shardMask + 1);
+    uint64_t collected;
+    {
+        // Always in shard order, so two collectors cannot deadlock
+        std::vector<std::shared_lock<std::shared_mutex>> locks;
+        locks.reserve(shardMask + 1);
+        for (size_t i = 0; i <= shardMask; ++i) {
+            locks.emplace_back(shards[i].mutex);
+        }
+        for (size_t i = 0; i <= shardMask; ++i) {
+            const Shard& shard = shards[i];
+            if (taken[i].entries && taken[i].changes == shard.changes) {
+                continue;
+            }
+            auto entries = std::make_shared<std::vector<std::pair<uint64_t, Book*>>>();
+            entries->reserve(shard.books.size());
+            shard.books.forEach([&entries](uint64_t key, const Entry& entry) {
+                entries->emplace_back(key, entry.book.get());
+            });
+            taken[i].changes = shard.changes;
+            copied[i] = std::move(entries);
+        }
+        collected = changeCount.load(std::memory_order_acquire);
+    }
+    for (size_t i = 0; i <= shardMask; ++i) {
+        if (copied[i]) {
+            std::sort(copied[i]->begin(), copied[i]->end());
+            taken[i].entries = std::move(copied[i]);
+        }
+    }
+    return collected;
+}
+
+size_t ShardedInventory::size() const {
+    return bookCount.load(std::memory_order_relaxed);
+}
+
+size_t ShardedInventory::getShardCount() const {
+    return shardMask + 1;
+}
+
+ShardedInventory::Shard& ShardedInventory::shardFor(uint64_t key) const {
+    return shards[mixKey(key) & shardMask];
+}
+
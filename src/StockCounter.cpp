@@ -0,0 +1,381 @@
+#include "../include/StockCounter.h"
+#include <limits>
+#include <stdexcept>
+
+namespace {
+
+constexpr int INFLATE_AFTER_CONFLICTS = 64;
+constexpr uint64_t QUANTITY_MASK = (1ULL << 20) - 1;
+constexpr uint64_t PENDING_BIT = 1ULL << 20;
+// Slot number of a handle whose hold lives in the overflow table
+constexpr uint32_t OVERFLOW_SLOT = UINT32_MAX;
+
+uint64_t packHold(uint32_t generation, int quantity, uint64_t flags = 0) {
+    return (static_cast<uint64_t>(generation) << 32) | flags |
+           (static_cast<uint64_t>(quantity) & QUANTITY_MASK);
+}
+
+uint32_t holdGeneration(uint64_t word) { return static_cast<uint32_t>(word >> 32); }
+int holdQuantity(uint64_t word) { return static_cast<int>(word & QUANTITY_MASK); }
+bool holdPending(uint64_t word) { return (word & PENDING_BIT) != 0; }
+
+// now + ttl in clock ticks, saturating so that duration::max() never lapses
+StockCounter::Clock::rep deadlineAfter(StockCounter::Clock::duration ttl) {
+    StockCounter::Clock::rep now = StockCounter::Clock::now().time_since_epoch().count();
+    StockCounter::Clock::rep limit = std::numeric_limits<StockCounter::Clock::rep>::max();
+    return ttl.count() > limit - now ? limit : now + ttl.count();
+}
+
+// Each thread sticks to one home slab, assigned round-robin
+size_t homeSlab() {
+    static std::atomic<size_t> nextSlab{0};
+    thread_local size_t slab = nextSlab.fetch_add(1, std::memory_order_relaxed) % StockCounter::SLAB_COUNT;
+    return slab;
+}
+
+// Take up to `wanted` units from an atomic without going below zero
+int takeUpTo(std::atomic<int>& units, int wanted) {
+    int current = units.load(std::memory_order_relaxed);
+    while (current > 0) {
+        int taken = current < wanted ? current : wanted;
+        if (units.compare_exchange_weak(current, current - taken,
+                                        std::memory_order_acq_rel, std::memory_order_relaxed)) {
+            return taken;
+        }
+    }
+    return 0;
+}
+
+} // namespace
+
+// StockReservation implementation
+StockReservation::StockReservation()
+    : counter(nullptr), slot(0), generation(0), quantity(0) {}
+
+StockReservation::StockReservation(StockCounter* counter, uint32_t slot, uint64_t generation, int quantity)
+    : counter(counter), slot(slot), generation(generation), quantity(quantity) {}
+
+StockReservation::~StockReservation() {
+    release();
+}
+
+StockReservation::StockReservation(StockReservation&& other) noexcept
+    : counter(other.counter), slot(other.slot), generation(other.generation), quantity(other.quantity) {
+    other.counter = nullptr;
+}
+
+StockReservation& StockReservation::operator=(StockReservation&& other) noexcept {
+    if (this != &other) {
+        release();
+        counter = other.counter;
+        slot = other.slot;
+        generation = other.generation;
+        quantity = other.quantity;
+        other.counter = nullptr;
+    }
+    return *this;
+}
+
+bool StockReservation::commit() {
+    if (!counter) {
+        return false;
+    }
+    bool committed = counter->finishHold(slot, generation, false);
+    counter = nullptr;
+    return committed;
+}
+
+bool StockReservation::release() {
+    if (!counter) {
+        return false;
+    }
+    bool released = counter->finishHold(slot, generation, true);
+    counter = nullptr;
+    return released;
+}
+
+bool StockReservation::isActive() const {
+    if (!counter) {
+        return false;
+    }
+    StockCounter::HoldTable* table = counter->holds.load(std::memory_order_acquire);
+    if (slot == OVERFLOW_SLOT) {
+        std::lock_guard<std::mutex> lock(table->overflowMutex);
+        return table->overflow.count(generation) != 0;
+    }
+    uint64_t word = table->slots[slot].load(std::memory_order_acquire);
+    return holdQuantity(word) != 0 && holdGeneration(word) == generation;
+}
+
+int StockReservation::getQuantity() const {
+    return quantity;
+}
+
+StockReservation::operator bool() const {
+    return counter != nullptr;
+}
+
+// StockCounter implementation
+StockCounter::HoldTable::HoldTable() {
+    for (size_t i = 0; i < MAX_ACTIVE_HOLDS; ++i) {
+        slots[i].store(0, std::memory_order_relaxed);
+        deadlines[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+StockCounter::StockCounter(int initialUnits) : central(initialUnits), shelved(initialUnits) {
+    if (initialUnits < 0) {
+        throw std::invalid_argument("Stock cannot be negative");
+    }
+}
+
+StockCounter::~StockCounter() {
+    delete[] slabs.load(std::memory_order_relaxed);
+    delete holds.load(std::memory_order_relaxed);
+}
+
+int StockCounter::available() const {
+    int total = central.load(std::memory_order_acquire);
+    Slab* slabArray = slabs.load(std::memory_order_acquire);
+    if (slabArray) {
+        for (size_t i = 0; i < SLAB_COUNT; ++i) {
+            total += slabArray[i].units.load(std::memory_order_acquire);
+        }
+    }
+    return total;
+}
+
+int StockCounter::held() const {
+    HoldTable* table = holds.load(std::memory_order_acquire);
+    if (!table) {
+        return 0;
+    }
+    int total = 0;
+    for (const auto& slot : table->slots) {
+        total += holdQuantity(slot.load(std::memory_order_acquire));
+    }
+    std::lock_guard<std::mutex> lock(table->overflowMutex);
+    for (const auto& entry : table->overflow) {
+        total += entry.second.quantity;
+    }
+    return total;
+}
+
+int StockCounter::onHand() const {
+    return shelved.load(std::memory_order_acquire);
+}
+
+bool StockCounter::tryTake(int quantity) {
+    if (!takeUnits(quantity)) {
+        return false;
+    }
+    shelved.fetch_sub(quantity, std::memory_order_acq_rel);
+    return true;
+}
+
+void StockCounter::give(int quantity) {
+    if (quantity <= 0) {
+        return;
+    }
+    giveUnits(quantity);
+    shelved.fetch_add(quantity, std::memory_order_acq_rel);
+}
+
+bool StockCounter::takeUnits(int quantity) {
+    if (quantity <= 0) {
+        return quantity == 0;
+    }
+    
+    Slab* slabArray = slabs.load(std::memory_order_acquire);
+    if (!slabArray) {
+        int current = central.load(std::memory_order_relaxed);
+        int failures = 0;
+        while (current >= quantity) {
+            if (central.compare_exchange_weak(current, current - quantity,
+                                              std::memory_order_acq_rel, std::memory_order_relaxed)) {
+                return true;
+            }
+            if (++failures == 2) {
+                noteContention();
+            }
+        }
+        // Stock may have moved into slabs that were inflated meanwhile
+        slabArray = slabs.load(std::memory_order_acquire);
+        if (!slabArray) {
+            return false;
+        }
+    }
+    return takeFromSlabs(slabArray, quantity);
+}
+
+void StockCounter::giveUnits(int quantity) {
+    if (quantity <= 0) {
+        return;
+    }
+    Slab* slabArray = slabs.load(std::memory_order_acquire);
+    if (slabArray) {
+        slabArray[homeSlab()].units.fetch_add(quantity, std::memory_order_acq_rel);
+    } else {
+        central.fetch_add(quantity, std::memory_order_acq_rel);
+    }
+}
+
+bool StockCounter::takeFromSlabs(Slab* slabArray, int quantity) {
+    size_t home = homeSlab();
+    std::atomic<int>& local = slabArray[home].units;
+    
+    // Fast path: the home slab covers the request on its own
+    int current = local.load(std::memory_order_relaxed);
+    while (current >= quantity) {
+        if (local.compare_exchange_weak(current, current - quantity,
+                                        std::memory_order_acq_rel, std::memory_order_relaxed)) {
+            return true;
+        }
+    }
+    
+    // Rebalance: drain what the home slab has, refill a share from the central
+    // pool, then steal from the other slabs
+    int gathered = takeUpTo(local, quantity);
+    int share = central.load(std::memory_order_relaxed) / static_cast<int>(SLAB_COUNT);
+    gathered += takeUpTo(central, (quantity - gathered) + share);
+    for (size_t i = 1; i < SLAB_COUNT && gathered < quantity; ++i) {
+        gathered += takeUpTo(slabArray[(home + i) % SLAB_COUNT].units, quantity - gathered);
+    }
+    
+    if (gathered >= quantity) {
+        if (gathered > quantity) {
+            local.fetch_add(gathered - quantity, std::memory_order_acq_rel);
+        }
+        return true;
+    }
+    central.fetch_add(gathered, std::memory_order_acq_rel);
+    return false;
+}
+
+void StockCounter::noteContention() {
+    if (conflicts.fetch_add(1, std::memory_order_relaxed) + 1 != INFLATE_AFTER_CONFLICTS) {
+        return;
+    }
+    Slab* fresh = new Slab[SLAB_COUNT];
+    Slab* expected = nullptr;
+    if (!slabs.compare_exchange_strong(expected, fresh, std::memory_order_acq_rel)) {
+        delete[] fresh;
+    }
+}
+
+StockCounter::HoldTable* StockCounter::holdTable() {
+    HoldTable* table = holds.load(std::memory_order_acquire);
+    if (table) {
+        return table;
+    }
+    HoldTable* fresh = new HoldTable();
+    if (holds.compare_exchange_strong(table, fresh, std::memory_order_acq_rel)) {
+        return fresh;
+    }
+    delete fresh;
+    return table;
+}
+
+StockReservation StockCounter::reserve(int quantity, Clock::duration ttl) {
+    if (quantity <= 0 || quantity > MAX_HOLD_QUANTITY) {
+        throw std::invalid_argument("Reservation quantity out of range");
+    }
+    if (!takeUnits(quantity)) {
+        return StockReservation();
+    }
+    
+    HoldTable* table = holdTable();
+    Clock::rep deadline = deadlineAfter(ttl);
+    size_t start = homeSlab() * (MAX_ACTIVE_HOLDS / SLAB_COUNT);
+    for (size_t i = 0; i < MAX_ACTIVE_HOLDS; ++i) {
+        uint32_t slot = static_cast<uint32_t>((start + i) % MAX_ACTIVE_HOLDS);
+        uint64_t word = table->slots[slot].load(std::memory_order_relaxed);
+        if (holdQuantity(word) != 0) {
+            continue;
+        }
+        uint32_t generation = holdGeneration(word);
+        if (table->slots[slot].compare_exchange_strong(word, packHold(generation, quantity, PENDING_BIT),
+                                                       std::memory_order_acq_rel)) {
+            table->deadlines[slot].store(deadline, std::memory_order_relaxed);
+            table->slots[slot].store(packHold(generation, quantity), std::memory_order_release);
+            return StockReservation(this, slot, generation, quantity);
+        }
+    }
+    
+    // Every slot is in use: a burst of buyers still gets its holds, just
+    // under a lock
+    std::lock_guard<std::mutex> lock(table->overflowMutex);
+    uint64_t id = table->nextOverflowId++;
+    table->overflow.emplace(id, HoldTable::Overflow{quantity, deadline});
+    return StockReservation(this, OVERFLOW_SLOT, id, quantity);
+}
+
+size_t StockCounter::expireHolds(Clock::time_point now) {
+    HoldTable* table = holds.load(std::memory_order_acquire);
+    if (!table) {
+        return 0;
+    }
+    Clock::rep nowTicks = now.time_since_epoch().count();
+    size_t expired = 0;
+    for (uint32_t slot = 0; slot < MAX_ACTIVE_HOLDS; ++slot) {
+        // A pending slot's deadline is not written yet; it is a fresh hold
+        uint64_t word = table->slots[slot].load(std::memory_order_acquire);
+        if (holdQuantity(word) != 0 && !holdPending(word) &&
+            table->deadlines[slot].load(std::memory_order_relaxed) < nowTicks &&
+            finishHold(slot, holdGeneration(word), true)) {
+            ++expired;
+        }
+    }
+    int overflowUnits = 0;
+    {
+        std::lock_guard<std::mutex> lock(table->overflowMutex);
+        for (auto it = table->overflow.begin(); it != table->overflow.end();) {
+            if (it->second.deadline < nowTicks) {
+                overflowUnits += it->second.quantity;
+                it = table->overflow.erase(it);
+                ++expired;
+            } else {
+                ++it;
+            }
+        }
+    }
+    giveUnits(overflowUnits);
+    return expired;
+}
+
+bool StockCounter::finishHold(uint32_t slot, uint64_t generation, bool returnUnits) {
+    HoldTable* table = holds.load(std::memory_order_acquire);
+    if (slot == OVERFLOW_SLOT) {
+        int quantity = 0;
+        {
+            std::lock_guard<std::mutex> lock(table->overflowMutex);
+            auto it = table->overflow.find(generation);
+            if (it == table->overflow.end()) {
+                return false;
+            }
+            quantity = it->second.quantity;
+            table->overflow.erase(it);
+        }
+        if (returnUnits) {
+            giveUnits(quantity);
+        } else {
+            shelved.fetch_sub(quantity, std::memory_order_acq_rel);
+        }
+        return true;
+    }
+    std::atomic<uint64_t>& entry = table->slots[slot];
+    uint64_t word = entry.load(std::memory_order_acquire);
+    while (holdQuantity(word) != 0 && !holdPending(word) && holdGeneration(word) == generation) {
+        // Bumping the generation frees the slot and invalidates stale handles
+        if (entry.compare_exchange_weak(word, packHold(static_cast<uint32_t>(generation) + 1, 0),
+                                        std::memory_order_acq_rel)) {
+            if (returnUnits) {
+                giveUnits(holdQuantity(word));
+            } else {
+                shelved.fetch_sub(holdQuantity(word), std::memory_order_acq_rel);
+            }
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,310 @@
+#include "../include/StoreClient.h"
+#include <algorithm>
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstring>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <stdexcept>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+
+std::string errorText(const std::string& what) {
+    return what + ": " + std::strerror(errno);
+}
+
+void decodeReply(RpcReply& reply, WireReader& payload) {
+    if (!reply.ok()) {
+        reply.error = payload.getString();
+        return;
+    }
+    switch (reply.op) {
+        case RpcOp::AddBook:
+            break;
+        case RpcOp::FindBook:
+            reply.book = payload.getBook();
+            break;
+        case RpcOp::BuyBook:
+            reply.amountPaid = payload.get<double>();
+            break;
+        case RpcOp::RemoveOutdated:
+            reply.removed = payload.get<uint64_t>();
+            break;
+        case RpcOp::ExportPage: {
+            reply.cursor.afterKey = payload.get<uint64_t>();
+            reply.cursor.rowsExported = static_cast<size_t>(payload.get<uint64_t>());
+            uint8_t flags = payload.get<uint8_t>();
+            reply.cursor.finished = (flags & 1) != 0;
+            reply.cursor.headerWritten = (flags & 2) != 0;
+            reply.data = payload.getString();
+            break;
+        }
+    }
+}
+
+} // namespace
+
+StoreClient StoreClient::connectUnix(const std::string& path) {
+    sockaddr_un address{};
+    if (path.size() >= sizeof(address.sun_path)) {
+        throw std::runtime_error("Socket path too long: " + path);
+    }
+    address.sun_family = AF_UNIX;
+    std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+    int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0 || ::connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+        std::string error = errorText("Cannot connect to " + path);
+        if (fd >= 0) {
+            ::close(fd);
+        }
+        throw std::runtime_error(error);
+    }
+    return StoreClient(fd);
+}
+
+StoreClient StoreClient::connectTcp(uint16_t port, const std::string& host) {
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(port);
+    if (inet_pton(AF_INET, host.c_str(), &address.sin_addr) != 1) {
+        throw std::runtime_error("Invalid IPv4 address: " + host);
+    }
+    int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0 || ::connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+        std::string error = errorText("Cannot connect to " + host + ":" + std::to_string(port));
+        if (fd >= 0) {
+            ::close(fd);
+        }
+        throw std::runtime_error(error);
+    }
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    return StoreClient(fd);
+}
+
+StoreClient::StoreClient(StoreClient&& other) noexcept
+    : fd(other.fd), nextId(other.nextId), request(std::move(other.request)),
+      pendingOps(std::move(other.pendingOps)), response(std::move(other.response)) {
+    other.fd = -1;
+}
+
+StoreClient& StoreClient::operator=(StoreClient&& other) noexcept {
+    if (this != &other) {
+        if (fd >= 0) {
+            ::close(fd);
+        }
+        fd = other.fd;
+        nextId = other.nextId;
+        request = std::move(other.request);
+        pendingOps = std::move(other.pendingOps);
+        response = std::move(other.response);
+        other.fd = -1;
+    }
+    return *this;
+}
+
+StoreClient::~StoreClient() {
+    if (fd >= 0) {
+        ::close(fd);
+    }
+}
+
+void StoreClient::addBook(const BookRecord& book) {
+    requireIdle();
+    queueAddBook(book);
+    throwIfFailed(callOne());
+}
+
+std::optional<BookRecord> StoreClient::findBook(std::string_view isbn) {
+    requireIdle();
+    queueFindBook(isbn);
+    RpcReply reply = callOne();
+    if (reply.status == RpcStatus::NotFound) {
+        return std::nullopt;
+    }
+    throwIfFailed(reply);
+    return std::move(reply.book);
+}
+
+double StoreClient::buyBook(std::string_view isbn, int quantity, std::string_view customerEmail,
+                            std::string_view shippingAddress) {
+    requireIdle();
+    queueBuyBook(isbn, quantity, customerEmail, shippingAddress);
+    RpcReply reply = callOne();
+    throwIfFailed(reply);
+    return reply.amountPaid;
+}
+
+uint64_t StoreClient::removeOutdated(int currentYear, int yearsThreshold) {
+    requireIdle();
+    queueRemoveOutdated(currentYear, yearsThreshold);
+    RpcReply reply = callOne();
+    throwIfFailed(reply);
+    return reply.removed;
+}
+
+ExportCursor StoreClient::exportPage(ExportFormat format, size_t maxRows, const ExportCursor& cursor,
+                                     std::string& data) {
+    requireIdle();
+    queueExportPage(format, maxRows, cursor);
+    RpcReply reply = callOne();
+    throwIfFailed(reply);
+    data = std::move(reply.data);
+    return reply.cursor;
+}
+
+void StoreClient::queueAddBook(const BookRecord& book) {
+    WireWriter writer = beginRequest(RpcOp::AddBook);
+    writer.putBook(book);
+    writer.endFrame();
+}
+
+void StoreClient::queueFindBook(std::string_view isbn) {
+    WireWriter writer = beginRequest(RpcOp::FindBook);
+    writer.putString(isbn);
+    writer.endFrame();
+}
+
+void StoreClient::queueBuyBook(std::string_view isbn, int quantity, std::string_view customerEmail,
+                               std::string_view shippingAddress) {
+    WireWriter writer = beginRequest(RpcOp::BuyBook);
+    writer.put(static_cast<int32_t>(quantity));
+    writer.putString(isbn);
+    writer.putString(customerEmail);
+    writer.putString(shippingAddress);
+    writer.endFrame();
+}
+
+void StoreClient::queueRemoveOutdated(int currentYear, int yearsThreshold) {
+    WireWriter writer = beginRequest(RpcOp::RemoveOutdated);
+    writer.put(static_cast<int32_t>(currentYear));
+    writer.put(static_cast<int32_t>(yearsThreshold));
+    writer.endFrame();
+}
+
+void StoreClient::queueExportPage(ExportFormat format, size_t maxRows, const ExportCursor& cursor) {
+    WireWriter writer = beginRequest(RpcOp::ExportPage);
+    writer.put(static_cast<uint8_t>(format));
+    writer.put(static_cast<uint32_t>(std::min<size_t>(maxRows, UINT32_MAX)));
+    writer.put(cursor.afterKey);
+    writer.put(static_cast<uint64_t>(cursor.rowsExported));
+    writer.put(static_cast<uint8_t>((cursor.finished ? 1 : 0) | (cursor.headerWritten ? 2 : 0)));
+    writer.endFrame();
+}
+
+std::vector<RpcReply> StoreClient::flush() {
+    std::vector<RpcReply> replies;
+    flush(replies);
+    return replies;
+}
+
+void StoreClient::flush(std::vector<RpcReply>& replies) {
+    auto fail = [this](const std::string& message) {
+        request.clear();
+        pendingOps.clear();
+        throw std::runtime_error(message);
+    };
+    // Send and read together: the server stops reading a connection whose
+    // replies go unread, so writing a large batch before reading would
+    // leave both sides waiting on each other
+    replies.resize(pendingOps.size());
+    size_t sent = 0;
+    size_t received = 0;
+    size_t used = 0;
+    size_t parsed = 0;
+    if (response.size() < 64 << 10) {
+        response.resize(64 << 10);
+    }
+    while (received < pendingOps.size()) {
+        while (used - parsed >= sizeof(uint32_t)) {
+            uint32_t length;
+            std::memcpy(&length, response.data() + parsed, sizeof(length));
+            if (length < RPC_FRAME_HEADER_BYTES - sizeof(uint32_t)) {
+                fail("Malformed reply from server");
+            }
+            if (used - parsed - sizeof(uint32_t) < length) {
+                break;
+            }
+            const char* frame = response.data() + parsed + sizeof(uint32_t);
+            RpcReply& reply = replies[received];
+            reply = RpcReply();
+            reply.op = pendingOps[received];
+            reply.status = static_cast<RpcStatus>(frame[sizeof(uint32_t)]);
+            WireReader payload(frame + sizeof(uint32_t) + 1, length - sizeof(uint32_t) - 1);
+            decodeReply(reply, payload);
+            parsed += sizeof(uint32_t) + length;
+            ++received;
+        }
+        if (received == pendingOps.size()) {
+            break;
+        }
+        // Make room: drop parsed replies, grow for a large one
+        std::memmove(response.data(), response.data() + parsed, used - parsed);
+        used -= parsed;
+        parsed = 0;
+        if (used == response.size()) {
+            response.resize(response.size() * 2);
+        }
+        
+        pollfd ready{fd, static_cast<short>(POLLIN | (sent < request.size() ? POLLOUT : 0)), 0};
+        if (::poll(&ready, 1, -1) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            fail(errorText("Cannot wait for the server"));
+        }
+        if (ready.revents & POLLOUT) {
+            ssize_t wrote = ::send(fd, request.data() + sent, request.size() - sent, MSG_NOSIGNAL | MSG_DONTWAIT);
+            if (wrote >= 0) {
+                sent += static_cast<size_t>(wrote);
+            } else if (errno != EINTR && errno != EAGAIN && errno != EWOULDBLOCK) {
+                fail(errorText("Cannot send request"));
+            }
+        }
+        if (ready.revents & (POLLIN | POLLHUP | POLLERR)) {
+            ssize_t got = ::recv(fd, response.data() + used, response.size() - used, MSG_DONTWAIT);
+            if (got > 0) {
+                used += static_cast<size_t>(got);
+            } else if (got == 0) {
+                fail("Server closed the connection");
+            } else if (errno != EINTR && errno != EAGAIN && errno != EWOULDBLOCK) {
+                fail(errorText("Cannot read reply"));
+            }
+        }
+    }
+    request.clear();
+    pendingOps.clear();
+}
+
+WireWriter StoreClient::beginRequest(RpcOp op) {
+    WireWriter writer(request);
+    writer.beginFrame(nextId++, static_cast<uint8_t>(op));
+    pendingOps.push_back(op);
+    return writer;
+}
+
+void StoreClient::requireIdle() const {
+    if (!pendingOps.empty()) {
+        throw std::logic_error("Flush queued requests before a single call");
+    }
+}
+
+RpcReply StoreClient::callOne() {
+    std::vector<RpcReply> replies = flush();
+    return std::move(replies.back());
+}
+
+void StoreClient::throwIfFailed(const RpcReply& reply) {
+    switch (reply.status) {
+        case RpcStatus::Ok:
+            return;
+        case RpcStatus::InvalidArgument:
+            throw std::invalid_argument(reply.error);
+        default:
+            throw std::runtime_error(reply.error);
+    }
+}
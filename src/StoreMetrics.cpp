@@ -0,0 +1,334 @@
+#include "../include/StoreMetrics.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdarg>
+#include <cstdio>
+
+namespace {
+
+std::atomic<uint64_t> nextMetricsId{1};
+
+// Slots this thread owns, one per StoreMetrics; released when the thread exits
+struct ThreadSlots {
+    std::vector<std::pair<uint64_t, std::shared_ptr<void>>> entries;
+    std::vector<std::atomic<bool>*> ownedFlags;
+
+    ~ThreadSlots() {
+        for (auto* owned : ownedFlags) {
+            owned->store(false, std::memory_order_release);
+        }
+    }
+};
+
+thread_local ThreadSlots threadSlots;
+
+uint32_t maskFor(uint32_t period) {
+    uint32_t rounded = 1;
+    while (rounded < period && rounded < (1u << 31)) {
+        rounded <<= 1;
+    }
+    return rounded - 1;
+}
+
+void appendLine(std::string& out, const char* format, ...) __attribute__((format(printf, 2, 3)));
+
+void appendLine(std::string& out, const char* format, ...) {
+    char line[256];
+    va_list args;
+    va_start(args, format);
+    int length = std::vsnprintf(line, sizeof(line), format, args);
+    va_end(args);
+    out.append(line, static_cast<size_t>(std::min<int>(length, sizeof(line) - 1)));
+    out += '\n';
+}
+
+const char* kindLabel(size_t kind) {
+    switch (static_cast<BookKind>(kind)) {
+        case BookKind::Paper: return "paper";
+        case BookKind::EBook: return "ebook";
+        case BookKind::Showcase: return "showcase";
+        case BookKind::Other: break;
+    }
+    return "other";
+}
+
+} // namespace
+
+std::string_view storeOpName(StoreOp op) {
+    switch (op) {
+        case StoreOp::AddBook: return "addBook";
+        case StoreOp::SaveSnapshot: return "saveSnapshot";
+        case StoreOp::LoadSnapshot: return "loadSnapshot";
+        case StoreOp::ImportCatalog: return "importCatalog";
+        case StoreOp::OpenWriteAheadLog: return "openWriteAheadLog";
+        case StoreOp::OpenChangeFeed: return "openChangeFeed";
+        case StoreOp::Checkpoint: return "checkpoint";
+        case StoreOp::RemoveOutdated: return "removeOutdated";
+        case StoreOp::BuyBook: return "buyBook";
+        case StoreOp::BuyBooks: return "buyBooks";
+        case StoreOp::WaitForFulfillment: return "waitForFulfillment";
+        case StoreOp::ExpireReservations: return "expireReservations";
+        case StoreOp::FindBooksByAuthor: return "findBooksByAuthor";
+        case StoreOp::FindBooksPublishedBetween: return "findBooksPublishedBetween";
+        case StoreOp::FindBooksInPriceRange: return "findBooksInPriceRange";
+        case StoreOp::FindOutOfStock: return "findOutOfStock";
+        case StoreOp::SearchBooks: return "searchBooks";
+        case StoreOp::FindBooksByKind: return "findBooksByKind";
+        case StoreOp::PrintInventory: return "printInventory";
+        case StoreOp::ExportCatalog: return "exportCatalog";
+        case StoreOp::GetInventorySize: return "getInventorySize";
+        case StoreOp::FindBook: return "findBook";
+        case StoreOp::FindBooks: return "findBooks";
+        case StoreOp::Analyze: return "analyze";
+        case StoreOp::Count: break;
+    }
+    return {};
+}
+
+std::string_view storeFailureName(StoreFailure failure) {
+    switch (failure) {
+        case StoreFailure::InvalidQuantity: return "invalid_quantity";
+        case StoreFailure::UnknownIsbn: return "unknown_isbn";
+        case StoreFailure::NotForSale: return "not_for_sale";
+        case StoreFailure::InsufficientStock: return "insufficient_stock";
+        case StoreFailure::DuplicateIsbn: return "duplicate_isbn";
+        case StoreFailure::NullBook: return "null_book";
+        case StoreFailure::InvalidIsbn: return "invalid_isbn";
+        case StoreFailure::Overloaded: return "overloaded";
+        case StoreFailure::DeadlineExceeded: return "deadline_exceeded";
+        case StoreFailure::Count: break;
+    }
+    return {};
+}
+
+uint64_t LatencyHistogram::bucketLowerBound(size_t bucket) {
+    if (bucket < SUB_BUCKETS) {
+        return bucket;
+    }
+    size_t shift = bucket / SUB_BUCKETS - 1;
+    return (SUB_BUCKETS + bucket % SUB_BUCKETS) << shift;
+}
+
+void LatencyHistogram::record(uint64_t nanos) {
+    ++buckets[bucketFor(nanos)];
+    ++total;
+    sum += nanos;
+    max = std::max(max, nanos);
+}
+
+void LatencyHistogram::merge(const LatencyHistogram& other) {
+    for (size_t i = 0; i < BUCKET_COUNT; ++i) {
+        buckets[i] += other.buckets[i];
+    }
+    total += other.total;
+    sum += other.sum;
+    max = std::max(max, other.max);
+}
+
+uint64_t LatencyHistogram::percentile(double fraction) const {
+    if (total == 0) {
+        return 0;
+    }
+    double wanted = std::ceil(std::clamp(fraction, 0.0, 1.0) * static_cast<double>(total));
+    uint64_t rank = std::max<uint64_t>(static_cast<uint64_t>(wanted), 1);
+    uint64_t seen = 0;
+    for (size_t i = 0; i + 1 < BUCKET_COUNT; ++i) {
+        seen += buckets[i];
+        if (seen >= rank) {
+            return std::min(bucketLowerBound(i + 1) - 1, max);
+        }
+    }
+    return max;
+}
+
+void MetricsSnapshot::merge(const MetricsSnapshot& other) {
+    for (size_t op = 0; op < STORE_OP_COUNT; ++op) {
+        calls[op] += other.calls[op];
+        latency[op].merge(other.latency[op]);
+    }
+    for (size_t failure = 0; failure < STORE_FAILURE_COUNT; ++failure) {
+        failures[failure] += other.failures[failure];
+    }
+    for (size_t kind = 0; kind < BOOK_KIND_COUNT; ++kind) {
+        unitsSold[kind] += other.unitsSold[kind];
+    }
+    booksRemoved += other.booksRemoved;
+    inventorySize += other.inventorySize;
+    totalStock += other.totalStock;
+}
+
+std::string MetricsSnapshot::toPrometheus() const {
+    constexpr int FIRST_BOUND_EXPONENT = 7;
+    constexpr int LAST_BOUND_EXPONENT = 36;
+    std::string out;
+
+    out += "# HELP quantum_bookstore_calls_total Calls of each public store operation.\n"
+           "# TYPE quantum_bookstore_calls_total counter\n";
+    for (size_t op = 0; op < STORE_OP_COUNT; ++op) {
+        appendLine(out, "quantum_bookstore_calls_total{op=\"%s\"} %llu",
+                   storeOpName(static_cast<StoreOp>(op)).data(), static_cast<unsigned long long>(calls[op]));
+    }
+
+    out += "# HELP quantum_bookstore_latency_seconds Latency of sampled store calls.\n"
+           "# TYPE quantum_bookstore_latency_seconds histogram\n";
+    for (size_t op = 0; op < STORE_OP_COUNT; ++op) {
+        const LatencyHistogram& histogram = latency[op];
+        if (histogram.count() == 0) {
+            continue;
+        }
+        const char* name = storeOpName(static_cast<StoreOp>(op)).data();
+        uint64_t cumulative = 0;
+        size_t bucket = 0;
+        for (int exponent = FIRST_BOUND_EXPONENT; exponent <= LAST_BOUND_EXPONENT; ++exponent) {
+            uint64_t bound = uint64_t(1) << exponent;
+            for (size_t end = LatencyHistogram::bucketFor(bound); bucket < end; ++bucket) {
+                cumulative += histogram.bucketCount(bucket);
+            }
+            appendLine(out, "quantum_bookstore_latency_seconds_bucket{op=\"%s\",le=\"%.9g\"} %llu",
+                       name, static_cast<double>(bound) * 1e-9, static_cast<unsigned long long>(cumulative));
+        }
+        appendLine(out, "quantum_bookstore_latency_seconds_bucket{op=\"%s\",le=\"+Inf\"} %llu",
+                   name, static_cast<unsigned long long>(histogram.count()));
+        appendLine(out, "quantum_bookstore_latency_seconds_sum{op=\"%s\"} %.9g",
+                   name, static_cast<double>(histogram.sumNanos()) * 1e-9);
+        appendLine(out, "quantum_bookstore_latency_seconds_count{op=\"%s\"} %llu",
+                   name, static_cast<unsigned long long>(histogram.count()));
+    }
+
+    out += "# HELP quantum_bookstore_failures_total Store calls rejected, by reason.\n"
+           "# TYPE quantum_bookstore_failures_total counter\n";
+    for (size_t failure = 0; failure < STORE_FAILURE_COUNT; ++failure) {
+        appendLine(out, "quantum_bookstore_failures_total{reason=\"%s\"} %llu",
+                   storeFailureName(static_cast<StoreFailure>(failure)).data(),
+                   static_cast<unsigned long long>(failures[failure]));
+    }
+
+    out += "# HELP quantum_bookstore_units_sold_total Copies sold, by book type.\n"
+           "# TYPE quantum_bookstore_units_sold_total counter\n";
+    for (size_t kind = 0; kind < BOOK_KIND_COUNT; ++kind) {
+        appendLine(out, "quantum_bookstore_units_sold_total{kind=\"%s\"} %llu",
+                   kindLabel(kind), static_cast<unsigned long long>(unitsSold[kind]));
+    }
+
+    out += "# HELP quantum_bookstore_books_removed_total Books evicted by removeOutdated.\n"
+           "# TYPE quantum_bookstore_books_removed_total counter\n";
+    appendLine(out, "quantum_bookstore_books_removed_total %llu", static_cast<unsigned long long>(booksRemoved));
+    out += "# HELP quantum_bookstore_inventory_books Books in the inventory.\n"
+           "# TYPE quantum_bookstore_inventory_books gauge\n";
+    appendLine(out, "quantum_bookstore_inventory_books %llu", static_cast<unsigned long long>(inventorySize));
+    out += "# HELP quantum_bookstore_inventory_stock Available copies of paper books.\n"
+           "# TYPE quantum_bookstore_inventory_stock gauge\n";
+    appendLine(out, "quantum_bookstore_inventory_stock %lld", static_cast<long long>(totalStock));
+    return out;
+}
+
+StoreMetrics::Timer::Timer(Timer&& other) noexcept
+    : slot(other.slot), op(other.op), start(other.start) {
+    other.slot = nullptr;
+}
+
+void StoreMetrics::Timer::record() {
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    uint64_t nanos = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+    Slot::OpStats& stats = slot->ops[static_cast<size_t>(op)];
+    StoreMetrics::bump(stats.buckets[LatencyHistogram::bucketFor(nanos)], 1);
+    StoreMetrics::bump(stats.samples, 1);
+    StoreMetrics::bump(stats.sumNanos, nanos);
+    if (nanos > stats.maxNanos.load(std::memory_order_relaxed)) {
+        stats.maxNanos.store(nanos, std::memory_order_relaxed);
+    }
+}
+
+StoreMetrics::StoreMetrics() : id(nextMetricsId.fetch_add(1, std::memory_order_relaxed)) {
+    for (auto& mask : sampleMasks) {
+        mask.store(0, std::memory_order_relaxed);
+    }
+    setSamplePeriod(StoreOp::FindBook, DEFAULT_LOOKUP_SAMPLE_PERIOD);
+    setSamplePeriod(StoreOp::GetInventorySize, DEFAULT_LOOKUP_SAMPLE_PERIOD);
+}
+
+StoreMetrics::~StoreMetrics() = default;
+
+void StoreMetrics::countFailure(StoreFailure failure) {
+    StoreMetrics::bump(localSlot().failures[static_cast<size_t>(failure)], 1);
+}
+
+void StoreMetrics::countSold(BookKind kind, int quantity) {
+    StoreMetrics::bump(localSlot().unitsSold[static_cast<size_t>(kind)], static_cast<uint64_t>(quantity));
+}
+
+void StoreMetrics::countRemoved(size_t books) {
+    StoreMetrics::bump(localSlot().booksRemoved, books);
+}
+
+void StoreMetrics::setSamplePeriod(StoreOp op, uint32_t period) {
+    sampleMasks[static_cast<size_t>(op)].store(maskFor(period), std::memory_order_relaxed);
+}
+
+MetricsSnapshot StoreMetrics::snapshot() const {
+    MetricsSnapshot result;
+    std::lock_guard<std::mutex> lock(registryMutex);
+    for (const auto& slot : slots) {
+        for (size_t op = 0; op < STORE_OP_COUNT; ++op) {
+            const Slot::OpStats& stats = slot->ops[op];
+            result.calls[op] += stats.calls.load(std::memory_order_relaxed);
+            LatencyHistogram& histogram = result.latency[op];
+            for (size_t bucket = 0; bucket < LatencyHistogram::BUCKET_COUNT; ++bucket) {
+                histogram.buckets[bucket] += stats.buckets[bucket].load(std::memory_order_relaxed);
+            }
+            histogram.total += stats.samples.load(std::memory_order_relaxed);
+            histogram.sum += stats.sumNanos.load(std::memory_order_relaxed);
+            histogram.max = std::max(histogram.max, stats.maxNanos.load(std::memory_order_relaxed));
+        }
+        for (size_t failure = 0; failure < STORE_FAILURE_COUNT; ++failure) {
+            result.failures[failure] += slot->failures[failure].load(std::memory_order_relaxed);
+        }
+        for (size_t kind = 0; kind < BOOK_KIND_COUNT; ++kind) {
+            result.unitsSold[kind] += slot->unitsSold[kind].load(std::memory_order_relaxed);
+        }
+        result.booksRemoved += slot->booksRemoved.load(std::memory_order_relaxed);
+    }
+    return result;
+}
+
+StoreMetrics::Slot& StoreMetrics::registerThread() {
+    for (auto& entry : threadSlots.entries) {
+        if (entry.first == id) {
+            cachedId = id;
+            cachedSlot = static_cast<Slot*>(entry.second.get());
+            return *cachedSlot;
+        }
+    }
+
+    // First call from this thread: drop slots of destroyed metrics, then
+    // reuse the slot of an exited thread (its counts carry over)
+    auto& entries = threadSlots.entries;
+    auto& flags = threadSlots.ownedFlags;
+    for (size_t i = entries.size(); i-- > 0;) {
+        if (entries[i].second.use_count() == 1) {
+            auto* flag = &static_cast<Slot*>(entries[i].second.get())->owned;
+            flags.erase(std::remove(flags.begin(), flags.end(), flag), flags.end());
+            entries.erase(entries.begin() + static_cast<std::ptrdiff_t>(i));
+        }
+    }
+    std::shared_ptr<Slot> slot;
+    {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        for (auto& candidate : slots) {
+            if (!candidate->owned.load(std::memory_order_acquire)) {
+                candidate->owned.store(true, std::memory_order_relaxed);
+                slot = candidate;
+                break;
+            }
+        }
+        if (!slot) {
+            slot = std::make_shared<Slot>();
+            slots.push_back(slot);
+        }
+    }
+    entries.emplace_back(id, slot);
+    flags.push_back(&slot->owned);
+    cachedId = id;
+    cachedSlot = slot.get();
+    return *slot;
+}
@@ -0,0 +1,43 @@
+#include "../include/StoreProtocol.h"
+#include "../include/BookTypes.h"
+
+void WireWriter::putBook(const Book& book) {
+    const PaperBook* paperBook = asPaperBook(&book);
+    const EBook* ebook = asEBook(&book);
+    put(static_cast<uint8_t>(book.getKind()));
+    put(static_cast<int32_t>(book.getYearPublished()));
+    put(book.getPrice());
+    put(static_cast<int32_t>(paperBook ? paperBook->getStock() : 0));
+    putString(book.getISBN());
+    putString(book.getTitle());
+    putString(book.getAuthorName());
+    putString(ebook ? ebook->getFileType() : std::string_view());
+}
+
+void WireWriter::putBook(const BookRecord& book) {
+    put(static_cast<uint8_t>(book.kind));
+    put(static_cast<int32_t>(book.year));
+    put(book.price);
+    put(static_cast<int32_t>(book.stock));
+    putString(book.isbn);
+    putString(book.title);
+    putString(book.author);
+    putString(book.fileType);
+}
+
+BookRecord WireReader::getBook() {
+    BookRecord book;
+    uint8_t kind = get<uint8_t>();
+    if (kind > static_cast<uint8_t>(BookKind::Other)) {
+        throw RpcFormatError("Unknown book kind in RPC payload");
+    }
+    book.kind = static_cast<BookKind>(kind);
+    book.year = get<int32_t>();
+    book.price = get<double>();
+    book.stock = get<int32_t>();
+    book.isbn = getString();
+    book.title = getString();
+    book.author = getString();
+    book.fileType = getString();
+    return book;
+}
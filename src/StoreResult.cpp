@@ -0,0 +1,41 @@
+#include "../include/StoreResult.h"
+#include <stdexcept>
+
+std::string StoreError::message() const {
+    switch (code) {
+        case StoreFailure::InvalidQuantity:
+            return "Quantity must be positive";
+        case StoreFailure::UnknownIsbn:
+            return "Book with ISBN " + isbn + " not found in inventory";
+        case StoreFailure::NotForSale:
+            return "Book with ISBN " + isbn + " is not for sale";
+        case StoreFailure::InsufficientStock:
+            return "Insufficient stock for book with ISBN " + isbn + ". Available: " + std::to_string(available) +
+                   ", Requested: " + std::to_string(requested);
+        case StoreFailure::DuplicateIsbn:
+            return "Book with ISBN " + isbn + " already exists in inventory";
+        case StoreFailure::NullBook:
+            return "Cannot add null book to inventory";
+        case StoreFailure::InvalidIsbn:
+            return "Invalid ISBN: " + isbn;
+        case StoreFailure::Overloaded:
+            return "Store is overloaded; try again later";
+        case StoreFailure::DeadlineExceeded:
+            return "Store is busy; request deadline passed while waiting";
+        case StoreFailure::Count:
+            break;
+    }
+    return "Unknown store failure";
+}
+
+void StoreError::raise() const {
+    switch (code) {
+        case StoreFailure::InvalidQuantity:
+        case StoreFailure::DuplicateIsbn:
+        case StoreFailure::NullBook:
+        case StoreFailure::InvalidIsbn:
+            throw std::invalid_argument(message());
+        default:
+            throw std::runtime_error(message());
+    }
+}
@@ -0,0 +1,476 @@
+#include "../include/StoreServer.h"
+#include <algorithm>
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstring>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <stdexcept>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace {
+
+constexpr size_t READ_CHUNK = 64 << 10;
+constexpr int MAX_EVENTS = 64;
+
+std::string errorText(const std::string& what) {
+    return what + ": " + std::strerror(errno);
+}
+
+} // namespace
+
+struct StoreServer::Connection {
+    int fd;
+    std::vector<char> in = std::vector<char>(READ_CHUNK);
+    size_t inUsed = 0;
+    std::string out;
+    size_t outSent = 0;
+    uint32_t events = EPOLLIN;  // current epoll interest
+
+    size_t pendingOutput() const { return out.size() - outSent; }
+};
+
+// One event loop thread with its own epoll set and connections
+class StoreServer::Reactor {
+public:
+    explicit Reactor(StoreServer& server) : server(server) {
+        epollFd = epoll_create1(EPOLL_CLOEXEC);
+        wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (epollFd < 0 || wakeFd < 0) {
+            throw std::runtime_error(errorText("Cannot create reactor"));
+        }
+        watch(wakeFd, EPOLLIN);
+    }
+
+    ~Reactor() {
+        stop();
+        for (auto& entry : connections) {
+            ::close(entry.first);
+        }
+        ::close(wakeFd);
+        ::close(epollFd);
+    }
+
+    void addListener(int fd) {
+        listenerFds.insert(fd);
+        // Only one reactor is woken per incoming connection
+        watch(fd, EPOLLIN | EPOLLEXCLUSIVE);
+    }
+
+    void start() {
+        thread = std::thread([this]() { run(); });
+    }
+
+    void stop() {
+        if (thread.joinable()) {
+            uint64_t one = 1;
+            ssize_t wrote = ::write(wakeFd, &one, sizeof(one));
+            (void)wrote;
+            thread.join();
+        }
+    }
+
+private:
+    StoreServer& server;
+    int epollFd;
+    int wakeFd;
+    std::thread thread;
+    std::unordered_set<int> listenerFds;
+    std::unordered_map<int, std::unique_ptr<Connection>> connections;
+
+    void watch(int fd, uint32_t events) {
+        epoll_event event{};
+        event.events = events;
+        event.data.fd = fd;
+        if (epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event) != 0) {
+            throw std::runtime_error(errorText("Cannot watch socket"));
+        }
+    }
+
+    void run() {
+        epoll_event events[MAX_EVENTS];
+        while (true) {
+            int ready = epoll_wait(epollFd, events, MAX_EVENTS, -1);
+            if (ready < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                return;
+            }
+            for (int i = 0; i < ready; ++i) {
+                int fd = events[i].data.fd;
+                if (fd == wakeFd) {
+                    return;
+                }
+                if (listenerFds.count(fd)) {
+                    acceptAll(fd);
+                    continue;
+                }
+                auto it = connections.find(fd);
+                if (it == connections.end()) {
+                    continue;
+                }
+                Connection& conn = *it->second;
+                bool open = true;
+                if (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) {
+                    open = readAvailable(conn);
+                }
+                if (open && conn.pendingOutput() > 0) {
+                    open = writePending(conn);
+                }
+                if (open) {
+                    updateInterest(conn);
+                } else {
+                    close(fd);
+                }
+            }
+        }
+    }
+
+    void acceptAll(int listener) {
+        while (true) {
+            int fd = ::accept4(listener, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+            if (fd < 0) {
+                return;  // EAGAIN, or another reactor took it
+            }
+            int one = 1;
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));  // fails harmlessly on Unix sockets
+            auto conn = std::make_unique<Connection>();
+            conn->fd = fd;
+            try {
+                watch(fd, EPOLLIN);
+            } catch (const std::exception&) {
+                ::close(fd);
+                continue;
+            }
+            connections.emplace(fd, std::move(conn));
+        }
+    }
+
+    // Read what the socket has, then answer every complete request in it;
+    // returns false once the connection should be closed
+    bool readAvailable(Connection& conn) {
+        bool peerClosed = false;
+        while (conn.pendingOutput() < server.config.maxPendingOutput) {
+            if (conn.inUsed == conn.in.size()) {
+                // Grow only for a frame too large for the buffer; otherwise
+                // answer what is there first and read the rest on the next
+                // wakeup
+                uint32_t length;
+                std::memcpy(&length, conn.in.data(), sizeof(length));
+                if (length > server.config.maxFrameBytes || sizeof(length) + length <= conn.in.size()) {
+                    break;
+                }
+                conn.in.resize(sizeof(length) + length);
+            }
+            ssize_t got = ::read(conn.fd, conn.in.data() + conn.inUsed, conn.in.size() - conn.inUsed);
+            if (got > 0) {
+                conn.inUsed += static_cast<size_t>(got);
+                if (conn.inUsed < conn.in.size()) {
+                    break;  // drained; a short read means nothing more is queued
+                }
+                continue;
+            }
+            if (got == 0) {
+                peerClosed = true;
+            } else if (errno == EINTR) {
+                continue;
+            } else if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                return false;
+            }
+            break;
+        }
+        if (!server.handleInput(conn)) {
+            return false;
+        }
+        if (peerClosed) {
+            writePending(conn);
+            return false;
+        }
+        return true;
+    }
+
+    bool writePending(Connection& conn) {
+        while (conn.pendingOutput() > 0) {
+            ssize_t sent = ::send(conn.fd, conn.out.data() + conn.outSent, conn.pendingOutput(), MSG_NOSIGNAL);
+            if (sent < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                return errno == EAGAIN || errno == EWOULDBLOCK;
+            }
+            conn.outSent += static_cast<size_t>(sent);
+        }
+        conn.out.clear();
+        conn.outSent = 0;
+        return true;
+    }
+
+    // Watch for writability while replies are queued, and stop reading
+    // while too many are
+    void updateInterest(Connection& conn) {
+        uint32_t wanted = 0;
+        if (conn.pendingOutput() < server.config.maxPendingOutput) {
+            wanted |= EPOLLIN;
+        }
+        if (conn.pendingOutput() > 0) {
+            wanted |= EPOLLOUT;
+        }
+        if (wanted != conn.events) {
+            epoll_event event{};
+            event.events = wanted;
+            event.data.fd = conn.fd;
+            epoll_ctl(epollFd, EPOLL_CTL_MOD, conn.fd, &event);
+            conn.events = wanted;
+        }
+    }
+
+    void close(int fd) {
+        epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, nullptr);
+        ::close(fd);
+        connections.erase(fd);
+    }
+};
+
+StoreServer::StoreServer(QuantumBookstore& store, ServerConfig config) : store(store), config(config) {}
+
+StoreServer::~StoreServer() {
+    stop();
+}
+
+void StoreServer::listenUnix(const std::string& path) {
+    sockaddr_un address{};
+    if (path.size() >= sizeof(address.sun_path)) {
+        throw std::runtime_error("Socket path too long: " + path);
+    }
+    address.sun_family = AF_UNIX;
+    std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+    int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    ::unlink(path.c_str());
+    if (fd < 0 || ::bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+        ::listen(fd, SOMAXCONN) != 0) {
+        std::string error = errorText("Cannot listen on " + path);
+        if (fd >= 0) {
+            ::close(fd);
+        }
+        throw std::runtime_error(error);
+    }
+    listeners.push_back(fd);
+    unixPaths.push_back(path);
+}
+
+uint16_t StoreServer::listenTcp(uint16_t port) {
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = htons(port);
+    int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    int one = 1;
+    socklen_t length = sizeof(address);
+    if (fd < 0 || setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one)) != 0 ||
+        ::bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+        ::listen(fd, SOMAXCONN) != 0 ||
+        getsockname(fd, reinterpret_cast<sockaddr*>(&address), &length) != 0) {
+        std::string error = errorText("Cannot listen on port " + std::to_string(port));
+        if (fd >= 0) {
+            ::close(fd);
+        }
+        throw std::runtime_error(error);
+    }
+    listeners.push_back(fd);
+    return ntohs(address.sin_port);
+}
+
+void StoreServer::start() {
+    if (running) {
+        return;
+    }
+    size_t count = config.reactors ? config.reactors : std::max(1u, std::thread::hardware_concurrency());
+    for (size_t i = 0; i < count; ++i) {
+        auto reactor = std::make_unique<Reactor>(*this);
+        for (int listener : listeners) {
+            reactor->addListener(listener);
+        }
+        reactors.push_back(std::move(reactor));
+    }
+    for (auto& reactor : reactors) {
+        reactor->start();
+    }
+    running = true;
+}
+
+void StoreServer::stop() {
+    for (auto& reactor : reactors) {
+        reactor->stop();
+    }
+    reactors.clear();
+    for (int fd : listeners) {
+        ::close(fd);
+    }
+    listeners.clear();
+    for (const std::string& path : unixPaths) {
+        ::unlink(path.c_str());
+    }
+    unixPaths.clear();
+    running = false;
+}
+
+bool StoreServer::handleInput(Connection& conn) {
+    std::vector<std::pair<uint32_t, std::string_view>> finds;
+    const char* data = conn.in.data();
+    size_t position = 0;
+    while (conn.inUsed - position >= sizeof(uint32_t)) {
+        uint32_t length;
+        std::memcpy(&length, data + position, sizeof(length));
+        if (length < RPC_FRAME_HEADER_BYTES - sizeof(uint32_t) || length > config.maxFrameBytes) {
+            return false;  // framing is lost
+        }
+        if (conn.inUsed - position - sizeof(uint32_t) < length) {
+            break;
+        }
+        const char* frame = data + position + sizeof(uint32_t);
+        uint32_t id;
+        std::memcpy(&id, frame, sizeof(id));
+        auto op = static_cast<RpcOp>(frame[sizeof(id)]);
+        WireReader payload(frame + sizeof(id) + 1, length - sizeof(id) - 1);
+        position += sizeof(uint32_t) + length;
+
+        if (op == RpcOp::FindBook) {
+            try {
+                finds.emplace_back(id, payload.getString());
+                continue;
+            } catch (const RpcFormatError&) {
+            }
+        }
+        // Anything else ends the run of lookups, which are answered first
+        handleFinds(finds, conn.out);
+        finds.clear();
+        handleRequest(id, op, payload, conn.out);
+    }
+    handleFinds(finds, conn.out);
+
+    // Keep a partial frame at the front for the next read
+    std::memmove(conn.in.data(), data + position, conn.inUsed - position);
+    conn.inUsed -= position;
+    return true;
+}
+
+void StoreServer::handleFinds(const std::vector<std::pair<uint32_t, std::string_view>>& finds, std::string& out) {
+    if (finds.empty()) {
+        return;
+    }
+    std::vector<std::string_view> isbns;
+    isbns.reserve(finds.size());
+    for (const auto& find : finds) {
+        isbns.push_back(find.second);
+    }
+    WireWriter writer(out);
+    store.findBooks(isbns, [&](size_t i, const Book* book) {
+        writer.beginFrame(finds[i].first, static_cast<uint8_t>(book ? RpcStatus::Ok : RpcStatus::NotFound));
+        if (book) {
+            writer.putBook(*book);
+        } else {
+            writer.putString("Book with ISBN " + std::string(finds[i].second) + " not found in inventory");
+        }
+        writer.endFrame();
+    });
+    served.fetch_add(finds.size(), std::memory_order_relaxed);
+}
+
+void StoreServer::handleRequest(uint32_t id, RpcOp op, WireReader& payload, std::string& out) {
+    WireWriter writer(out);
+    auto fail = [&](RpcStatus status, const std::string& message) {
+        writer.beginFrame(id, static_cast<uint8_t>(status));
+        writer.putString(message);
+        writer.endFrame();
+    };
+    served.fetch_add(1, std::memory_order_relaxed);
+    try {
+        switch (op) {
+            case RpcOp::AddBook: {
+                BookRecord book = payload.getBook();
+                switch (book.kind) {
+                    case BookKind::Paper:
+                        store.addPaperBook(book.isbn, book.title, book.year, book.price, book.author, book.stock);
+                        break;
+                    case BookKind::EBook:
+                        store.addEBook(book.isbn, book.title, book.year, book.price, book.author, book.fileType);
+                        break;
+                    case BookKind::Showcase:
+                        store.addShowcaseBook(book.isbn, book.title, book.year, book.price, book.author);
+                        break;
+                    case BookKind::Other:
+                        throw std::invalid_argument("Only built-in book kinds can be added remotely");
+                }
+                writer.beginFrame(id, static_cast<uint8_t>(RpcStatus::Ok));
+                writer.endFrame();
+                return;
+            }
+            case RpcOp::BuyBook: {
+                int quantity = payload.get<int32_t>();
+                std::string isbn(payload.getString());
+                std::string email(payload.getString());
+                std::string address(payload.getString());
+                // Sold-out books are refused often; keep that off the exception path
+                StoreResult<double> paid = store.tryBuyBook(isbn, quantity, email, address);
+                if (!paid) {
+                    bool invalid = paid.error().code == StoreFailure::InvalidQuantity;
+                    fail(invalid ? RpcStatus::InvalidArgument : RpcStatus::Rejected, paid.error().message());
+                    return;
+                }
+                writer.beginFrame(id, static_cast<uint8_t>(RpcStatus::Ok));
+                writer.put(paid.value());
+                writer.endFrame();
+                return;
+            }
+            case RpcOp::RemoveOutdated: {
+                int currentYear = payload.get<int32_t>();
+                int yearsThreshold = payload.get<int32_t>();
+                uint64_t removed = store.removeOutdated(currentYear, yearsThreshold, nullptr);
+                writer.beginFrame(id, static_cast<uint8_t>(RpcStatus::Ok));
+                writer.put(removed);
+                writer.endFrame();
+                return;
+            }
+            case RpcOp::ExportPage: {
+                uint8_t format = payload.get<uint8_t>();
+                if (format > static_cast<uint8_t>(ExportFormat::Binary)) {
+                    throw RpcFormatError("Unknown export format");
+                }
+                size_t maxRows = std::min<size_t>(payload.get<uint32_t>(), config.maxExportRows);
+                ExportCursor cursor;
+                cursor.afterKey = payload.get<uint64_t>();
+                cursor.rowsExported = payload.get<uint64_t>();
+                uint8_t flags = payload.get<uint8_t>();
+                cursor.finished = (flags & 1) != 0;
+                cursor.headerWritten = (flags & 2) != 0;
+                BufferSink sink;
+                ExportCursor next = store.exportPage(sink, static_cast<ExportFormat>(format), maxRows, cursor);
+                writer.beginFrame(id, static_cast<uint8_t>(RpcStatus::Ok));
+                writer.put(next.afterKey);
+                writer.put(static_cast<uint64_t>(next.rowsExported));
+                writer.put(static_cast<uint8_t>((next.finished ? 1 : 0) | (next.headerWritten ? 2 : 0)));
+                writer.putString(sink.data());
+                writer.endFrame();
+                return;
+            }
+            case RpcOp::FindBook:
+                break;  // only reached with a malformed payload
+        }
+        fail(RpcStatus::BadRequest, "Malformed or unknown request");
+    } catch (const RpcFormatError& error) {
+        fail(RpcStatus::BadRequest, error.what());
+    } catch (const std::invalid_argument& error) {
+        fail(RpcStatus::InvalidArgument, error.what());
+    } catch (const std::runtime_error& error) {
+        fail(RpcStatus::Rejected, error.what());
+    } catch (const std::exception& error) {
+        fail(RpcStatus::ServerError, error.what());
+    }
+}
@@ -0,0 +1,91 @@
+#include "../include/TaskPool.h"
+#include <algorithm>
+
+TaskPool::TaskPool(size_t threads) {
+    size_t total = threads ? threads : std::max(1u, std::thread::hardware_concurrency());
+    workers.reserve(total - 1);
+    for (size_t worker = 1; worker < total; ++worker) {
+        workers.emplace_back([this, worker]() { workerLoop(worker); });
+    }
+}
+
+TaskPool::~TaskPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+}
+
+void TaskPool::parallelFor(size_t tasks, const Task& fn, size_t maxWorkers) {
+    if (tasks == 0) {
+        return;
+    }
+    std::lock_guard<std::mutex> loop(loopMutex);
+    size_t helpers = std::min({workers.size(), std::max<size_t>(maxWorkers, 1) - 1, tasks - 1});
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        current = &fn;
+        taskCount = tasks;
+        activeWorkers = helpers + 1;
+        running = helpers;
+        nextTask.store(0, std::memory_order_relaxed);
+        failure = nullptr;
+        ++generation;
+    }
+    if (helpers > 0) {
+        wake.notify_all();
+    }
+    runTasks(0);
+
+    std::unique_lock<std::mutex> lock(mutex);
+    done.wait(lock, [this]() { return running == 0; });
+    current = nullptr;
+    if (failure) {
+        std::rethrow_exception(failure);
+    }
+}
+
+void TaskPool::workerLoop(size_t worker) {
+    uint64_t seen = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [&]() { return stopping || generation != seen; });
+            if (stopping) {
+                return;
+            }
+            seen = generation;
+            if (worker >= activeWorkers) {
+                continue;  // not needed for this loop
+            }
+        }
+        runTasks(worker);
+        std::lock_guard<std::mutex> lock(mutex);
+        if (--running == 0) {
+            done.notify_one();
+        }
+    }
+}
+
+void TaskPool::runTasks(size_t worker) {
+    while (true) {
+        size_t task = nextTask.fetch_add(1, std::memory_order_relaxed);
+        if (task >= taskCount) {
+            return;
+        }
+        try {
+            (*current)(task, worker);
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!failure) {
+                failure = std::current_exception();
+            }
+            // Skip the remaining tasks
+            nextTask.store(taskCount, std::memory_order_relaxed);
+        }
+    }
+}
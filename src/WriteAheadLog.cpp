@@ -0,0 +1,502 @@
+#include "../include/WriteAheadLog.h"
+#include "../include/BookTypes.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <stdexcept>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+// Record layout: payload size, CRC32C of everything after the CRC, LSN,
+// type, then the payload. All fields are native-endian.
+constexpr size_t RECORD_HEADER_SIZE = 4 + 4 + 8 + 1;
+constexpr size_t CRC_OFFSET = 4;
+constexpr size_t LSN_OFFSET = 8;
+constexpr size_t TYPE_OFFSET = 16;
+
+// AddBook payload: kind, year, price, stock, then the four string lengths
+// and the strings themselves
+constexpr size_t ADD_BOOK_FIXED_SIZE = 1 + 4 + 8 + 4 + 1 + 4 + 2 + 1;
+constexpr size_t SALE_LINE_SIZE = 8 + 4;
+
+template <typename T>
+void put(char*& out, T value) {
+    std::memcpy(out, &value, sizeof(value));
+    out += sizeof(value);
+}
+
+void putText(char*& out, std::string_view text) {
+    if (text.empty()) {
+        return;
+    }
+    std::memcpy(out, text.data(), text.size());
+    out += text.size();
+}
+
+template <typename T>
+T get(const char*& in) {
+    T value;
+    std::memcpy(&value, in, sizeof(value));
+    in += sizeof(value);
+    return value;
+}
+
+// CRC32C (Castagnoli), using the SSE4.2 instruction when the CPU has it
+class Crc32c {
+public:
+    static uint32_t compute(const char* data, size_t size) {
+        static const bool hardware = __builtin_cpu_supports("sse4.2");
+        return ~(hardware ? updateHardware(~0u, data, size) : updateTable(~0u, data, size));
+    }
+
+private:
+    struct Table {
+        uint32_t entries[256];
+        Table() {
+            for (uint32_t i = 0; i < 256; ++i) {
+                uint32_t crc = i;
+                for (int bit = 0; bit < 8; ++bit) {
+                    crc = (crc >> 1) ^ ((crc & 1) ? 0x82f63b78u : 0);
+                }
+                entries[i] = crc;
+            }
+        }
+    };
+
+    static uint32_t updateTable(uint32_t crc, const char* data, size_t size) {
+        static const Table table;
+        for (size_t i = 0; i < size; ++i) {
+            crc = table.entries[(crc ^ static_cast<unsigned char>(data[i])) & 0xff] ^ (crc >> 8);
+        }
+        return crc;
+    }
+
+    __attribute__((target("sse4.2")))
+    static uint32_t updateHardware(uint32_t crc, const char* data, size_t size) {
+        uint64_t wide = crc;
+        for (; size >= 8; data += 8, size -= 8) {
+            uint64_t word;
+            std::memcpy(&word, data, sizeof(word));
+            wide = __builtin_ia32_crc32di(wide, word);
+        }
+        crc = static_cast<uint32_t>(wide);
+        for (; size > 0; ++data, --size) {
+            crc = __builtin_ia32_crc32qi(crc, static_cast<unsigned char>(*data));
+        }
+        return crc;
+    }
+};
+
+std::string errorText(const std::string& what, const std::string& path) {
+    return what + " " + path + ": " + std::strerror(errno);
+}
+
+std::vector<char> readWholeFile(int fd, const std::string& path) {
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        throw std::runtime_error(errorText("Cannot stat write-ahead log", path));
+    }
+    std::vector<char> data(static_cast<size_t>(info.st_size));
+    size_t done = 0;
+    while (done < data.size()) {
+        ssize_t got = pread(fd, data.data() + done, data.size() - done, static_cast<off_t>(done));
+        if (got < 0 && errno == EINTR) {
+            continue;
+        }
+        if (got <= 0) {
+            throw std::runtime_error(errorText("Cannot read write-ahead log", path));
+        }
+        done += static_cast<size_t>(got);
+    }
+    return data;
+}
+
+bool writeAll(int fd, const char* data, size_t size) {
+    size_t done = 0;
+    while (done < size) {
+        ssize_t wrote = ::write(fd, data + done, size - done);
+        if (wrote < 0 && errno == EINTR) {
+            continue;
+        }
+        if (wrote < 0) {
+            return false;
+        }
+        done += static_cast<size_t>(wrote);
+    }
+    return true;
+}
+
+// Walk the intact prefix of a log image, visiting records above afterLsn.
+// Returns the byte length of the prefix; lastLsn is its highest LSN.
+size_t scanRecords(const std::vector<char>& data, uint64_t afterLsn, uint64_t& lastLsn,
+                   const std::function<void(const WalEntry&)>& visit) {
+    WalEntry entry{};
+    size_t offset = 0;
+    while (data.size() - offset >= RECORD_HEADER_SIZE) {
+        const char* record = data.data() + offset;
+        uint32_t payloadSize;
+        uint32_t crc;
+        std::memcpy(&payloadSize, record, sizeof(payloadSize));
+        std::memcpy(&crc, record + CRC_OFFSET, sizeof(crc));
+        if (payloadSize > data.size() - offset - RECORD_HEADER_SIZE ||
+            Crc32c::compute(record + LSN_OFFSET, RECORD_HEADER_SIZE - LSN_OFFSET + payloadSize) != crc) {
+            break;
+        }
+        std::memcpy(&entry.lsn, record + LSN_OFFSET, sizeof(entry.lsn));
+        entry.type = static_cast<WalEntry::Type>(record[TYPE_OFFSET]);
+        if (entry.lsn <= lastLsn || !WalCodec::decode(entry, record + RECORD_HEADER_SIZE, payloadSize)) {
+            break;
+        }
+        lastLsn = entry.lsn;
+        if (entry.lsn > afterLsn && visit) {
+            visit(entry);
+        }
+        offset += RECORD_HEADER_SIZE + payloadSize;
+    }
+    return offset;
+}
+
+// Stock and file type of a loggable book
+void loggedFields(const Book& book, int& stock, std::string_view& fileType) {
+    visitBook(book, BookVisitor{
+        [&](const PaperBook& paperBook) { stock = paperBook.getStockOnHand(); },
+        [&](const EBook& ebook) { fileType = ebook.getFileType(); },
+        [](const ShowcaseBook&) {},
+        [](const Book& other) {
+            throw std::invalid_argument("Cannot log book type " + other.getType());
+        }
+    });
+}
+
+} // namespace
+
+size_t WalCodec::addBookSize(const Book& book) {
+    int stock = 0;
+    std::string_view fileType;
+    loggedFields(book, stock, fileType);
+    return ADD_BOOK_FIXED_SIZE + book.getISBN().size() + book.getTitle().size() +
+           book.getAuthorName().size() + fileType.size();
+}
+
+void WalCodec::encodeAddBook(const Book& book, char* out) {
+    int stock = 0;
+    std::string_view fileType;
+    loggedFields(book, stock, fileType);
+    put(out, static_cast<uint8_t>(book.getKind()));
+    put(out, static_cast<int32_t>(book.getYearPublished()));
+    put(out, book.getPrice());
+    put(out, static_cast<int32_t>(stock));
+    put(out, static_cast<uint8_t>(book.getISBN().size()));
+    put(out, static_cast<uint32_t>(book.getTitle().size()));
+    put(out, static_cast<uint16_t>(book.getAuthorName().size()));
+    put(out, static_cast<uint8_t>(fileType.size()));
+    putText(out, book.getISBN());
+    putText(out, book.getTitle());
+    putText(out, book.getAuthorName());
+    putText(out, fileType);
+}
+
+size_t WalCodec::saleSize(size_t count) {
+    if (count > UINT16_MAX) {
+        throw std::invalid_argument("Too many lines in one logged sale");
+    }
+    return 2 + count * SALE_LINE_SIZE;
+}
+
+void WalCodec::encodeSale(const WalSaleLine* lines, size_t count, char* out) {
+    put(out, static_cast<uint16_t>(count));
+    for (size_t i = 0; i < count; ++i) {
+        put(out, lines[i].isbnKey);
+        put(out, lines[i].quantity);
+    }
+}
+
+void WalCodec::encodeRemoveBook(uint64_t isbnKey, char* out) {
+    put(out, isbnKey);
+}
+
+bool WalCodec::decode(WalEntry& entry, const char* payload, size_t size) {
+    const char* in = payload;
+    switch (entry.type) {
+        case WalEntry::Type::AddBook: {
+            if (size < ADD_BOOK_FIXED_SIZE) {
+                return false;
+            }
+            uint8_t kind = get<uint8_t>(in);
+            entry.year = get<int32_t>(in);
+            entry.price = get<double>(in);
+            entry.stock = get<int32_t>(in);
+            size_t isbnLength = get<uint8_t>(in);
+            size_t titleLength = get<uint32_t>(in);
+            size_t authorLength = get<uint16_t>(in);
+            size_t fileTypeLength = get<uint8_t>(in);
+            if (kind > static_cast<uint8_t>(BookKind::Showcase) ||
+                ADD_BOOK_FIXED_SIZE + isbnLength + titleLength + authorLength + fileTypeLength != size) {
+                return false;
+            }
+            entry.kind = static_cast<BookKind>(kind);
+            entry.text.isbn = std::string_view(in, isbnLength);
+            entry.text.title = std::string_view(in += isbnLength, titleLength);
+            entry.text.author = std::string_view(in += titleLength, authorLength);
+            entry.fileType = std::string_view(in += authorLength, fileTypeLength);
+            return true;
+        }
+        case WalEntry::Type::Sale: {
+            if (size < 2) {
+                return false;
+            }
+            size_t count = get<uint16_t>(in);
+            if (2 + count * SALE_LINE_SIZE != size) {
+                return false;
+            }
+            entry.lines.clear();
+            for (size_t i = 0; i < count; ++i) {
+                WalSaleLine line;
+                line.isbnKey = get<uint64_t>(in);
+                line.quantity = get<int32_t>(in);
+                entry.lines.push_back(line);
+            }
+            return true;
+        }
+        case WalEntry::Type::RemoveBook:
+            if (size != 8) {
+                return false;
+            }
+            entry.isbnKey = get<uint64_t>(in);
+            return true;
+    }
+    return false;
+}
+
+WriteAheadLog::WriteAheadLog(const std::string& path, WalConfig config, uint64_t startAfter)
+    : config(config), path(path), fd(::open(path.c_str(), O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC, 0644)) {
+    if (fd < 0) {
+        throw std::runtime_error(errorText("Cannot open write-ahead log", path));
+    }
+    try {
+        std::vector<char> data = readWholeFile(fd, path);
+        uint64_t lastInFile = 0;
+        size_t intact = scanRecords(data, UINT64_MAX, lastInFile, nullptr);
+        // Appends must follow the last good record, not a torn one
+        if (intact < data.size() &&
+            (ftruncate(fd, static_cast<off_t>(intact)) != 0 || fdatasync(fd) != 0)) {
+            throw std::runtime_error(errorText("Cannot trim write-ahead log", path));
+        }
+        durable = std::max(lastInFile, startAfter);
+        nextLsn = durable + 1;
+    } catch (...) {
+        ::close(fd);
+        throw;
+    }
+    flusher = std::thread([this]() { run(); });
+}
+
+WriteAheadLog::~WriteAheadLog() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wakeFlusher.notify_one();
+    flusher.join();
+    ::close(fd);
+}
+
+template <typename Encode>
+uint64_t WriteAheadLog::append(WalEntry::Type type, size_t payloadSize, Encode&& encode) {
+    std::unique_lock<std::mutex> lock(mutex);
+    bool wasEmpty = pending.empty();
+    size_t offset = pending.size();
+    pending.resize(offset + RECORD_HEADER_SIZE + payloadSize);
+    char* record = pending.data() + offset;
+    uint64_t lsn = nextLsn++;
+
+    char* out = record;
+    put(out, static_cast<uint32_t>(payloadSize));
+    out += sizeof(uint32_t);  // CRC goes here once the rest is in place
+    put(out, lsn);
+    put(out, static_cast<uint8_t>(type));
+    encode(out);
+    uint32_t crc = Crc32c::compute(record + LSN_OFFSET, RECORD_HEADER_SIZE - LSN_OFFSET + payloadSize);
+    std::memcpy(record + CRC_OFFSET, &crc, sizeof(crc));
+
+    // The flusher only needs a nudge when a batch opens or fills up
+    bool filled = pending.size() >= config.maxBatchBytes &&
+                  offset < config.maxBatchBytes;
+    if (wasEmpty) {
+        batchStart = std::chrono::steady_clock::now();
+    }
+    lock.unlock();
+    if (wasEmpty || filled) {
+        wakeFlusher.notify_one();
+    }
+    return lsn;
+}
+
+uint64_t WriteAheadLog::appendAddBook(const Book& book) {
+    return append(WalEntry::Type::AddBook, WalCodec::addBookSize(book), [&](char* out) {
+        WalCodec::encodeAddBook(book, out);
+    });
+}
+
+uint64_t WriteAheadLog::appendSale(const WalSaleLine* lines, size_t count) {
+    return append(WalEntry::Type::Sale, WalCodec::saleSize(count), [&](char* out) {
+        WalCodec::encodeSale(lines, count, out);
+    });
+}
+
+uint64_t WriteAheadLog::appendRemoveBook(uint64_t isbnKey) {
+    return append(WalEntry::Type::RemoveBook, WalCodec::REMOVE_BOOK_SIZE, [&](char* out) {
+        WalCodec::encodeRemoveBook(isbnKey, out);
+    });
+}
+
+void WriteAheadLog::waitDurable(uint64_t lsn) {
+    std::unique_lock<std::mutex> lock(mutex);
+    durableChanged.wait(lock, [&]() { return durable >= lsn || !failure.empty(); });
+    if (durable < lsn) {
+        throw std::runtime_error(failure);
+    }
+}
+
+void WriteAheadLog::truncate(uint64_t throughLsn) {
+    std::unique_lock<std::mutex> lock(mutex);
+    durableChanged.wait(lock, [&]() { return durable >= throughLsn || !failure.empty(); });
+    if (!failure.empty()) {
+        throw std::runtime_error(failure);
+    }
+    // Keep the flusher off the file; records appended meanwhile stay pending
+    truncating = true;
+    durableChanged.wait(lock, [&]() { return !flushing; });
+    try {
+        if (durable == throughLsn) {
+            if (ftruncate(fd, 0) != 0 || fdatasync(fd) != 0) {
+                throw std::runtime_error(errorText("Cannot truncate write-ahead log", path));
+            }
+        } else {
+            fd = rewriteAfter(throughLsn);
+        }
+    } catch (...) {
+        truncating = false;
+        wakeFlusher.notify_one();
+        throw;
+    }
+    truncating = false;
+    lock.unlock();
+    wakeFlusher.notify_one();
+}
+
+int WriteAheadLog::rewriteAfter(uint64_t throughLsn) {
+    std::vector<char> data = readWholeFile(fd, path);
+    size_t keepFrom = 0;
+    while (data.size() - keepFrom >= RECORD_HEADER_SIZE) {
+        uint32_t payloadSize;
+        uint64_t lsn;
+        std::memcpy(&payloadSize, data.data() + keepFrom, sizeof(payloadSize));
+        std::memcpy(&lsn, data.data() + keepFrom + LSN_OFFSET, sizeof(lsn));
+        if (lsn > throughLsn) {
+            break;
+        }
+        keepFrom += RECORD_HEADER_SIZE + payloadSize;
+    }
+    
+    // The kept records go to a new file that replaces the log. Should the
+    // rename not survive a crash, the old log only repeats records the
+    // snapshot already has, which replay skips.
+    std::string temporary = path + ".tmp";
+    int fresh = ::open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fresh < 0) {
+        throw std::runtime_error(errorText("Cannot create write-ahead log", temporary));
+    }
+    bool written = writeAll(fresh, data.data() + keepFrom, data.size() - keepFrom) && fdatasync(fresh) == 0;
+    ::close(fresh);
+    if (!written || std::rename(temporary.c_str(), path.c_str()) != 0) {
+        std::remove(temporary.c_str());
+        throw std::runtime_error(errorText("Cannot rewrite write-ahead log", path));
+    }
+    int reopened = ::open(path.c_str(), O_RDWR | O_APPEND | O_CLOEXEC);
+    if (reopened < 0) {
+        throw std::runtime_error(errorText("Cannot reopen write-ahead log", path));
+    }
+    ::close(fd);
+    return reopened;
+}
+
+uint64_t WriteAheadLog::lastLsn() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return nextLsn - 1;
+}
+
+uint64_t WriteAheadLog::durableLsn() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return durable;
+}
+
+uint64_t WriteAheadLog::getSyncCount() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return syncCount;
+}
+
+void WriteAheadLog::run() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        wakeFlusher.wait(lock, [&]() { return !truncating && (stopping || !pending.empty()); });
+        if (pending.empty()) {
+            return;
+        }
+        flushing = true;
+        // Hold the batch open for the latency budget so more commits join
+        if (config.commitDelay.count() > 0 && !stopping) {
+            wakeFlusher.wait_until(lock, batchStart + config.commitDelay, [&]() {
+                return stopping || pending.size() >= config.maxBatchBytes;
+            });
+        }
+        writing.swap(pending);
+        uint64_t batchLsn = nextLsn - 1;
+        lock.unlock();
+
+        std::string error;
+        if (!writeAll(fd, writing.data(), writing.size())) {
+            error = errorText("Cannot write write-ahead log", path);
+        }
+        if (error.empty() && config.syncToDisk && fdatasync(fd) != 0) {
+            error = errorText("Cannot sync write-ahead log", path);
+        }
+        writing.clear();
+
+        lock.lock();
+        flushing = false;
+        if (!error.empty()) {
+            failure = error;
+        } else if (failure.empty()) {
+            durable = batchLsn;
+            ++syncCount;
+        }
+        durableChanged.notify_all();
+    }
+}
+
+uint64_t WriteAheadLog::replay(const std::string& path, uint64_t afterLsn,
+                               const std::function<void(const WalEntry&)>& visit) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        if (errno == ENOENT) {
+            return afterLsn;
+        }
+        throw std::runtime_error(errorText("Cannot open write-ahead log", path));
+    }
+    std::vector<char> data;
+    try {
+        data = readWholeFile(fd, path);
+    } catch (...) {
+        ::close(fd);
+        throw;
+    }
+    ::close(fd);
+    uint64_t lastLsn = 0;
+    scanRecords(data, afterLsn, lastLsn, visit);
+    return std::max(lastLsn, afterLsn);
+}